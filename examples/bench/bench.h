@@ -0,0 +1,37 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+
+/* Protocol between keystone-bench and its eapp. The eapp asks for a
+ * bench_config, runs that benchmark, and sends its samples (in cycles)
+ * back in batches. */
+
+#define BENCH_OCALL_CONFIG  1
+#define BENCH_OCALL_NULL    2
+#define BENCH_OCALL_SAMPLES 3
+
+enum bench_mode {
+  BENCH_FIRST_RUN = 0,  // return right away, the host times the lifecycle
+  BENCH_NULL_OCALL,
+  BENCH_WRITE,          // proxied write() of size bytes to /dev/null
+  BENCH_READ,           // proxied read() of size bytes from /dev/zero
+  BENCH_ATTEST,
+  BENCH_SEALING_KEY,
+  BENCH_INTERRUPT,      // gaps over size cycles while spinning
+};
+
+struct bench_config {
+  uint64_t mode;
+  uint64_t iterations;
+  uint64_t size;
+};
+
+#define BENCH_SAMPLES_PER_OCALL 256
+#define BENCH_MAX_IO_SIZE       (16 * 1024)
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,125 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "app/eapp_utils.h"
+#include "app/string.h"
+#include "app/syscall.h"
+#include "edge/syscall_nums.h"
+
+#include "../bench.h"
+
+#define AT_FDCWD -100
+#define O_RDONLY 0
+#define O_WRONLY 1
+
+/* give up on BENCH_INTERRUPT if no interrupt shows up for this long */
+#define INTERRUPT_GIVE_UP (1UL << 34)
+
+static uint64_t samples[BENCH_SAMPLES_PER_OCALL];
+static unsigned long nsamples;
+static char io_buf[BENCH_MAX_IO_SIZE];
+static char report[2048];
+
+static inline uint64_t
+rdcycle(void) {
+  uint64_t cycles;
+  asm volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+
+static void
+flush_samples(void) {
+  if (nsamples)
+    ocall(BENCH_OCALL_SAMPLES, samples, nsamples * sizeof(uint64_t), 0, 0);
+  nsamples = 0;
+}
+
+static void
+record(uint64_t cycles) {
+  samples[nsamples++] = cycles;
+  if (nsamples == BENCH_SAMPLES_PER_OCALL) flush_samples();
+}
+
+static void
+bench_io(struct bench_config* config) {
+  int write = (config->mode == BENCH_WRITE);
+  const char* path = write ? "/dev/null" : "/dev/zero";
+  uint64_t i, start;
+  long fd;
+
+  if (config->size > sizeof(io_buf)) return;
+
+  fd = SYSCALL_4(SYS_openat, AT_FDCWD, path, write ? O_WRONLY : O_RDONLY, 0);
+  if (fd < 0) return;
+
+  for (i = 0; i < config->iterations; i++) {
+    start = rdcycle();
+    SYSCALL_3(write ? SYS_write : SYS_read, fd, io_buf, config->size);
+    record(rdcycle() - start);
+  }
+  SYSCALL_1(SYS_close, fd);
+}
+
+static void
+bench_interrupts(struct bench_config* config) {
+  uint64_t found = 0, prev = rdcycle(), last_found = prev, now;
+
+  while (found < config->iterations) {
+    now = rdcycle();
+    if (now - prev > config->size) {
+      record(now - prev);
+      found++;
+      last_found = now = rdcycle();
+    } else if (now - last_found > INTERRUPT_GIVE_UP) {
+      break;
+    }
+    prev = now;
+  }
+}
+
+void EAPP_ENTRY
+eapp_entry() {
+  struct bench_config config;
+  struct sealing_key key;
+  uint64_t i, start;
+
+  if (ocall(BENCH_OCALL_CONFIG, NULL, 0, &config, sizeof(config)) != 0)
+    EAPP_RETURN(1);
+
+  switch (config.mode) {
+    case BENCH_FIRST_RUN:
+      break;
+    case BENCH_NULL_OCALL:
+      for (i = 0; i < config.iterations; i++) {
+        start = rdcycle();
+        ocall(BENCH_OCALL_NULL, NULL, 0, NULL, 0);
+        record(rdcycle() - start);
+      }
+      break;
+    case BENCH_WRITE:
+    case BENCH_READ:
+      bench_io(&config);
+      break;
+    case BENCH_ATTEST:
+      for (i = 0; i < config.iterations; i++) {
+        start = rdcycle();
+        attest_enclave(report, "keystone-bench", 14);
+        record(rdcycle() - start);
+      }
+      break;
+    case BENCH_SEALING_KEY:
+      for (i = 0; i < config.iterations; i++) {
+        start = rdcycle();
+        get_sealing_key(&key, sizeof(key), "keystone-bench", 14);
+        record(rdcycle() - start);
+      }
+      break;
+    case BENCH_INTERRUPT:
+      bench_interrupts(&config);
+      break;
+  }
+
+  flush_samples();
+  EAPP_RETURN(0);
+}
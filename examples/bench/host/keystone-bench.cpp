@@ -0,0 +1,262 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <getopt.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../bench.h"
+#include "edge/edge_call.h"
+#include "host/keystone.h"
+
+using namespace Keystone;
+
+/* Runs every benchmark for --iterations samples and prints one record of
+ * statistics per benchmark, as JSON (default) or CSV. Host-side phases are
+ * in nanoseconds, everything timed inside the enclave is in cycles. */
+
+struct Result {
+  std::string name;
+  std::string unit;
+  std::vector<uint64_t> samples;
+};
+
+static const char *eappFile, *runtimeFile, *loaderFile;
+static size_t untrustedSize = 64 * 1024;
+static size_t freememSize   = 1024 * 1024;
+
+/* state of the enclave that is running, for the ocall handlers */
+static struct bench_config config;
+static std::vector<uint64_t>* eappSamples;
+static uint64_t firstOcallAt;
+
+static uint64_t
+now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void
+return_config(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  uintptr_t data_section      = edge_call_data_ptr();
+
+  if (!firstOcallAt) firstOcallAt = now_ns();
+
+  memcpy((void*)data_section, &config, sizeof(config));
+  if (edge_call_setup_ret(edge_call, (void*)data_section, sizeof(config)))
+    edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+  else
+    edge_call->return_data.call_status = CALL_STATUS_OK;
+}
+
+static void
+null_ocall(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+}
+
+static void
+collect_samples(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  uintptr_t args;
+  size_t len;
+
+  if (edge_call_args_ptr(edge_call, &args, &len) != 0) {
+    edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+    return;
+  }
+
+  const uint64_t* samples = (const uint64_t*)args;
+  eappSamples->insert(eappSamples->end(), samples, samples + len / sizeof(uint64_t));
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+}
+
+static bool
+init_enclave(Enclave* enclave) {
+  Params params;
+
+  params.setFreeMemSize(freememSize);
+  params.setUntrustedSize(untrustedSize);
+  if (enclave->init(eappFile, runtimeFile, loaderFile, params) != Error::Success)
+    return false;
+
+  enclave->registerOcallDispatch(incoming_call_dispatch);
+  register_call(BENCH_OCALL_CONFIG, return_config);
+  register_call(BENCH_OCALL_NULL, null_ocall);
+  register_call(BENCH_OCALL_SAMPLES, collect_samples);
+  edge_call_init_internals(
+      (uintptr_t)enclave->getSharedBuffer(), enclave->getSharedBufferSize());
+  return true;
+}
+
+/* init, first run and destroy, with a fresh enclave every iteration */
+static bool
+bench_lifecycle(std::vector<Result>* results, uint64_t iterations) {
+  Result create{"init.create", "ns"}, utm{"init.utm", "ns"}, copy{"init.copy", "ns"},
+      finalize{"init.finalize", "ns"}, map{"init.map", "ns"}, init{"init.total", "ns"},
+      firstRun{"run.first_ocall", "ns"}, run{"run.total", "ns"},
+      destroy{"destroy", "ns"};
+
+  config = {BENCH_FIRST_RUN, 0, 0};
+  for (uint64_t i = 0; i < iterations; i++) {
+    Enclave enclave;
+    uint64_t start = now_ns();
+
+    if (!init_enclave(&enclave)) return false;
+    init.samples.push_back(now_ns() - start);
+
+    const InitProfile& profile = enclave.getInitProfile();
+    create.samples.push_back(profile.create);
+    utm.samples.push_back(profile.utm);
+    copy.samples.push_back(profile.copy);
+    finalize.samples.push_back(profile.finalize);
+    map.samples.push_back(profile.map);
+
+    firstOcallAt = 0;
+    start        = now_ns();
+    if (enclave.run() != Error::Success || !firstOcallAt) return false;
+    run.samples.push_back(now_ns() - start);
+    firstRun.samples.push_back(firstOcallAt - start);
+
+    start = now_ns();
+    enclave.destroy();
+    destroy.samples.push_back(now_ns() - start);
+  }
+
+  for (Result* r : {&create, &utm, &copy, &finalize, &map, &init, &firstRun, &run, &destroy})
+    results->push_back(*r);
+  return true;
+}
+
+/* one enclave that takes all samples itself */
+static bool
+bench_eapp(
+    std::vector<Result>* results, const std::string& name, enum bench_mode mode,
+    uint64_t iterations, uint64_t size = 0) {
+  Enclave enclave;
+  uintptr_t ret;
+  Result result{name, "cycles"};
+
+  config      = {(uint64_t)mode, iterations, size};
+  eappSamples = &result.samples;
+  if (!init_enclave(&enclave) || enclave.run(&ret) != Error::Success || ret != 0) {
+    fprintf(stderr, "%s failed\n", name.c_str());
+    return false;
+  }
+
+  results->push_back(result);
+  return true;
+}
+
+static void
+print_results(std::vector<Result>& results, bool csv) {
+  if (csv)
+    printf("name,unit,n,min,median,mean,p99,max,stddev\n");
+  else
+    printf("[\n");
+
+  for (size_t i = 0; i < results.size(); i++) {
+    std::vector<uint64_t>& s = results[i].samples;
+    double mean = 0, var = 0;
+
+    if (s.empty()) {
+      fprintf(stderr, "%s: no samples\n", results[i].name.c_str());
+      continue;
+    }
+    std::sort(s.begin(), s.end());
+    for (uint64_t v : s) mean += v;
+    mean /= s.size();
+    for (uint64_t v : s) var += (v - mean) * (v - mean);
+
+    uint64_t median = s[s.size() / 2];
+    uint64_t p99    = s[std::min(s.size() - 1, s.size() * 99 / 100)];
+    double stddev   = std::sqrt(var / s.size());
+
+    printf(
+        csv ? "%s,%s,%zu,%lu,%lu,%.1f,%lu,%lu,%.1f\n"
+            : "  {\"name\": \"%s\", \"unit\": \"%s\", \"n\": %zu, \"min\": %lu, "
+              "\"median\": %lu, \"mean\": %.1f, \"p99\": %lu, \"max\": %lu, "
+              "\"stddev\": %.1f}",
+        results[i].name.c_str(), results[i].unit.c_str(), s.size(),
+        (unsigned long)s.front(), (unsigned long)median, mean, (unsigned long)p99,
+        (unsigned long)s.back(), stddev);
+    if (!csv) printf(i + 1 < results.size() ? ",\n" : "\n");
+  }
+
+  if (!csv) printf("]\n");
+}
+
+int
+main(int argc, char** argv) {
+  static const uint64_t ioSizes[] = {64, 1024, 4096, BENCH_MAX_IO_SIZE};
+  uint64_t iterations = 1000, lifecycleIterations = 20, interruptGap = 5000;
+  std::vector<Result> results;
+  int csv = 0;
+
+  if (argc < 4) {
+    printf(
+        "Usage: %s <eapp> <runtime> <loader> [--iterations N] "
+        "[--lifecycle-iterations N] [--interrupt-gap CYCLES] [--utm-size SIZE(K)] "
+        "[--freemem-size SIZE(K)] [--csv]\n",
+        argv[0]);
+    return 1;
+  }
+  eappFile    = argv[1];
+  runtimeFile = argv[2];
+  loaderFile  = argv[3];
+
+  static struct option options[] = {
+      {"iterations", required_argument, 0, 'i'},
+      {"lifecycle-iterations", required_argument, 0, 'l'},
+      {"interrupt-gap", required_argument, 0, 'g'},
+      {"utm-size", required_argument, 0, 'u'},
+      {"freemem-size", required_argument, 0, 'f'},
+      {"csv", no_argument, &csv, 1},
+      {0, 0, 0, 0}};
+
+  for (int c; (c = getopt_long(argc, argv, "", options, NULL)) != -1;) {
+    switch (c) {
+      case 'i':
+        iterations = strtoull(optarg, NULL, 0);
+        break;
+      case 'l':
+        lifecycleIterations = strtoull(optarg, NULL, 0);
+        break;
+      case 'g':
+        interruptGap = strtoull(optarg, NULL, 0);
+        break;
+      case 'u':
+        untrustedSize = strtoull(optarg, NULL, 0) * 1024;
+        break;
+      case 'f':
+        freememSize = strtoull(optarg, NULL, 0) * 1024;
+        break;
+    }
+  }
+
+  bool ok = bench_lifecycle(&results, lifecycleIterations);
+  ok = ok && bench_eapp(&results, "ocall.null", BENCH_NULL_OCALL, iterations);
+  for (uint64_t size : ioSizes) {
+    ok = ok && bench_eapp(&results, "syscall.write." + std::to_string(size),
+                          BENCH_WRITE, iterations, size);
+    ok = ok && bench_eapp(&results, "syscall.read." + std::to_string(size),
+                          BENCH_READ, iterations, size);
+  }
+  ok = ok && bench_eapp(&results, "attest", BENCH_ATTEST, iterations);
+  ok = ok && bench_eapp(&results, "sealing_key", BENCH_SEALING_KEY, iterations);
+  /* timer interrupts come at the scheduling tick, so fewer of them */
+  ok = ok && bench_eapp(&results, "interrupt.exit_resume", BENCH_INTERRUPT,
+                        std::min<uint64_t>(iterations, 100), interruptGap);
+
+  print_results(results, csv);
+  return ok ? 0 : 1;
+}
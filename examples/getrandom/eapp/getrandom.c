@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/random.h>
+
+/* Measures getrandom() throughput for a few request sizes.
+ * The numbers are in cycles, so they are comparable between runtimes built
+ * with and without the drbg plugin on the same platform. */
+
+#define TOTAL_BYTES (4 * 1024 * 1024)
+
+static unsigned char buf[64 * 1024];
+
+static inline uint64_t
+rdcycle(void) {
+  uint64_t cycles;
+  __asm__ volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+
+int
+main() {
+  static const size_t sizes[] = {16, 256, 4096, sizeof(buf)};
+  size_t i, done;
+
+  printf("size\tcalls\tcycles/call\tcycles/byte\n");
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    size_t calls  = TOTAL_BYTES / sizes[i];
+    uint64_t start = rdcycle();
+
+    for (done = 0; done < calls; done++) {
+      if (getrandom(buf, sizes[i], 0) != (ssize_t)sizes[i]) {
+        printf("getrandom(%zu) failed\n", sizes[i]);
+        return 1;
+      }
+    }
+
+    uint64_t cycles = rdcycle() - start;
+    printf(
+        "%zu\t%zu\t%lu\t%lu.%02lu\n", sizes[i], calls,
+        (unsigned long)(cycles / calls), (unsigned long)(cycles / TOTAL_BYTES),
+        (unsigned long)(cycles * 100 / TOTAL_BYTES % 100));
+  }
+  return 0;
+}
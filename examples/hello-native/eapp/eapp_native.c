@@ -3,23 +3,13 @@
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
 #include "eapp_utils.h"
-#include "string.h"
-#include "edge_call.h"
-#include <syscall.h>
-
-#define OCALL_PRINT_STRING 1
-
-unsigned long ocall_print_string(char* string);
+#include "hello_edge.h"
 
 int main(){
+  unsigned long retval;
 
-  ocall_print_string("Hello World");
+  /* generated from hello.edl, see hello_t.c in the build directory */
+  ocall_print_string(&retval, "Hello World");
 
   EAPP_RETURN(0);
 }
-
-unsigned long ocall_print_string(char* string){
-  unsigned long retval;
-  ocall(OCALL_PRINT_STRING, string, strlen(string)+1, &retval ,sizeof(unsigned long));
-  return retval;
-}
@@ -4,21 +4,16 @@
 //------------------------------------------------------------------------------
 #include <edge_call.h>
 #include <keystone.h>
-
-unsigned long
-print_string(char* str);
-void
-print_string_wrapper(void* buffer);
-#define OCALL_PRINT_STRING 1
+#include "hello_edge.h"
 
 /***
  * An example call that will be exposed to the enclave application as
- * an "ocall". This is performed by an edge_wrapper function (below,
- * print_string_wrapper) and by registering that wrapper with the
- * enclave object (below, main).
+ * an "ocall". It is declared in hello.edl, from which keystone-edger
+ * generates the enclave stub (ocall_print_string) and the host wrapper
+ * that unpacks the arguments and calls this function.
  ***/
 unsigned long
-print_string(char* str) {
+print_string(const char* str) {
   return printf("Enclave said: \"%s\"\n", str);
 }
 
@@ -34,9 +29,8 @@ main(int argc, char** argv) {
 
   enclave.registerOcallDispatch(incoming_call_dispatch);
 
-  /* We must specifically register functions we want to export to the
-     enclave. */
-  register_call(OCALL_PRINT_STRING, print_string_wrapper);
+  /* Registers the wrappers of every call in hello.edl */
+  hello_register_ocalls();
 
   edge_call_init_internals(
       (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize());
@@ -45,36 +39,3 @@ main(int argc, char** argv) {
 
   return 0;
 }
-
-/***
- * Example edge-wrapper function. These are currently hand-written
- * wrappers, but will have autogeneration tools in the future.
- ***/
-void
-print_string_wrapper(void* buffer) {
-  /* Parse and validate the incoming call data */
-  struct edge_call* edge_call = (struct edge_call*)buffer;
-  uintptr_t call_args;
-  unsigned long ret_val;
-  size_t arg_len;
-  if (edge_call_args_ptr(edge_call, &call_args, &arg_len) != 0) {
-    edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
-    return;
-  }
-
-  /* Pass the arguments from the eapp to the exported ocall function */
-  ret_val = print_string((char*)call_args);
-
-  /* Setup return data from the ocall function */
-  uintptr_t data_section = edge_call_data_ptr();
-  memcpy((void*)data_section, &ret_val, sizeof(unsigned long));
-  if (edge_call_setup_ret(
-          edge_call, (void*)data_section, sizeof(unsigned long))) {
-    edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
-  } else {
-    edge_call->return_data.call_status = CALL_STATUS_OK;
-  }
-
-  /* This will now eventually return control to the enclave */
-  return;
-}
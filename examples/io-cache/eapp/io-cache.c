@@ -0,0 +1,91 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "shared/eyrie_call.h"
+
+/* Reads a file sequentially in small blocks, once through the Eyrie
+ * io_cache and once with the cache turned off for the file, so every
+ * read() is proxied to the host. The numbers are in cycles. */
+
+#define FILE_NAME "io-cache.dat"
+#define FILE_SIZE (512 * 1024)
+
+static unsigned char buf[4096];
+
+static inline uint64_t
+rdcycle(void) {
+  uint64_t cycles;
+  __asm__ volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+
+static int
+create_file(void) {
+  size_t i, done;
+  int fd = open(FILE_NAME, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  if (fd < 0) return -1;
+  for (i = 0; i < sizeof(buf); i++) buf[i] = (unsigned char)i;
+  for (done = 0; done < FILE_SIZE; done += sizeof(buf)) {
+    if (write(fd, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+      close(fd);
+      return -1;
+    }
+  }
+  return close(fd);
+}
+
+/* returns the cycles it took to read the whole file, or 0 on error */
+static uint64_t
+read_file(size_t block, int cached) {
+  size_t total = 0;
+  ssize_t n;
+  uint64_t start;
+  int fd = open(FILE_NAME, O_RDONLY);
+
+  if (fd < 0) return 0;
+  if (!cached && fcntl(fd, EYRIE_F_SETCACHE, 0) != 0) {
+    close(fd);
+    return 0;
+  }
+
+  start = rdcycle();
+  while ((n = read(fd, buf, block)) > 0) total += n;
+  start = rdcycle() - start;
+
+  close(fd);
+  return (n == 0 && total == FILE_SIZE) ? start : 0;
+}
+
+int
+main() {
+  static const size_t blocks[] = {64, 512, 4096};
+  size_t i;
+
+  if (create_file() != 0) {
+    printf("cannot create %s\n", FILE_NAME);
+    return 1;
+  }
+
+  printf("block\tcached cycles/byte\tproxied cycles/byte\n");
+  for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+    uint64_t cached  = read_file(blocks[i], 1);
+    uint64_t proxied = read_file(blocks[i], 0);
+
+    if (!cached || !proxied) {
+      printf("reading %s in %zu byte blocks failed\n", FILE_NAME, blocks[i]);
+      return 1;
+    }
+    printf(
+        "%zu\t%lu.%02lu\t%lu.%02lu\n", blocks[i],
+        (unsigned long)(cached / FILE_SIZE),
+        (unsigned long)(cached * 100 / FILE_SIZE % 100),
+        (unsigned long)(proxied / FILE_SIZE),
+        (unsigned long)(proxied * 100 / FILE_SIZE % 100));
+  }
+
+  unlink(FILE_NAME);
+  return 0;
+}
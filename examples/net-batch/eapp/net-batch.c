@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Request/response round trips against the host's loopback echo server,
+ * once with a sendto/recvfrom pair per message and once in batches with
+ * sendmmsg/recvmmsg, which Eyrie proxies with a single host call per batch.
+ * The numbers are in cycles. */
+
+#define ECHO_PORT 7007
+#define MESSAGES  1024
+#define BATCH     32
+
+static unsigned char bufs[BATCH][512];
+
+static inline uint64_t
+rdcycle(void) {
+  uint64_t cycles;
+  __asm__ volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+
+/* returns the cycles for MESSAGES round trips, or 0 on error */
+static uint64_t
+one_by_one(int fd, size_t size) {
+  uint64_t start = rdcycle();
+  int i;
+
+  for (i = 0; i < MESSAGES; i++) {
+    if (send(fd, bufs[0], size, 0) != (ssize_t)size) return 0;
+    if (recv(fd, bufs[0], size, 0) != (ssize_t)size) return 0;
+  }
+  return rdcycle() - start;
+}
+
+static uint64_t
+batched(int fd, size_t size) {
+  struct mmsghdr msgs[BATCH];
+  struct iovec iovs[BATCH];
+  uint64_t start;
+  int i, got, n;
+
+  memset(msgs, 0, sizeof(msgs));
+  for (i = 0; i < BATCH; i++) {
+    iovs[i].iov_base           = bufs[i];
+    iovs[i].iov_len            = size;
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  start = rdcycle();
+  for (i = 0; i < MESSAGES; i += BATCH) {
+    if (sendmmsg(fd, msgs, BATCH, 0) != BATCH) return 0;
+    /* datagrams may still be in flight through the echo server */
+    for (got = 0; got < BATCH; got += n) {
+      n = recvmmsg(fd, msgs + got, BATCH - got, 0, NULL);
+      if (n <= 0) return 0;
+    }
+  }
+  return rdcycle() - start;
+}
+
+int
+main() {
+  static const size_t sizes[] = {16, 128, 512};
+  struct sockaddr_in addr;
+  size_t i;
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(ECHO_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    printf("cannot reach the echo server on port %d\n", ECHO_PORT);
+    return 1;
+  }
+
+  printf("size\tsendto/recvfrom cycles/msg\tmmsg x%d cycles/msg\n", BATCH);
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    uint64_t single = one_by_one(fd, sizes[i]);
+    uint64_t batch  = batched(fd, sizes[i]);
+
+    if (!single || !batch) {
+      printf("echoing %zu byte messages failed\n", sizes[i]);
+      return 1;
+    }
+    printf(
+        "%zu\t%lu\t%lu\n", sizes[i], (unsigned long)(single / MESSAGES),
+        (unsigned long)(batch / MESSAGES));
+  }
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,68 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "edge/edge_call.h"
+#include "host/keystone.h"
+
+using namespace Keystone;
+
+/* must match the eapp */
+#define ECHO_PORT 7007
+
+/* UDP echo server on the loopback interface for the eapp to talk to */
+static void*
+echo_server(void* arg) {
+  int fd = *(int*)arg;
+  char buf[2048];
+  struct sockaddr_in peer;
+  socklen_t peerlen;
+  ssize_t n;
+
+  for (;;) {
+    peerlen = sizeof(peer);
+    n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr*)&peer, &peerlen);
+    if (n >= 0) sendto(fd, buf, n, 0, (struct sockaddr*)&peer, peerlen);
+  }
+  return NULL;
+}
+
+int
+main(int argc, char** argv) {
+  Enclave enclave;
+  Params params;
+  struct sockaddr_in addr = {};
+  pthread_t echo;
+  int fd;
+
+  fd                   = socket(AF_INET, SOCK_DGRAM, 0);
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(ECHO_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      pthread_create(&echo, NULL, echo_server, &fd) != 0) {
+    perror("echo server");
+    return 1;
+  }
+
+  params.setFreeMemSize(256 * 1024);
+  params.setUntrustedSize(256 * 1024);
+
+  enclave.init(argv[1], argv[2], argv[3], params);
+
+  enclave.registerOcallDispatch(incoming_call_dispatch);
+  edge_call_init_internals(
+      (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize());
+
+  enclave.run();
+
+  return 0;
+}
@@ -0,0 +1,204 @@
+// examples/seal-common/seal_keystore.cpp
+#include "seal_keystore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <seal/randomgen.h>
+#include <seal/util/blake2.h>
+
+extern "C" {
+#include "app/syscall.h"
+}
+
+using namespace std;
+using namespace seal;
+
+namespace seal_common {
+
+static const char keystore_magic[8] = {'S', 'E', 'A', 'L', 'K', 'E', 'Y', '1'};
+static const char keystore_ident[] = "seal_common keystore";
+
+struct SealedHeader {
+    char magic[8];
+    uint64_t parms_id[4];  // the key level of the parameters the keys are for
+    uint8_t nonce[16];
+    uint64_t length;  // of the ciphertext that follows; the tag comes last
+};
+
+static const size_t key_half = SEALING_KEY_SIZE / 2;
+static const size_t tag_size = 32;
+
+static vector<int> normalized(vector<int> steps) {
+    sort(steps.begin(), steps.end());
+    steps.erase(unique(steps.begin(), steps.end()), steps.end());
+    return steps;
+}
+
+static bool keystore_key(struct sealing_key& key) {
+    return get_sealing_key(
+        &key, sizeof(key), const_cast<char*>(keystore_ident), sizeof(keystore_ident)) == 0;
+}
+
+// The first half of the sealing key keys the stream, the second the tag
+static void apply_stream(
+    const struct sealing_key& key, const uint8_t nonce[16], char* data, size_t length) {
+    prng_seed_type seed;
+    blake2b(seed.data(), sizeof(seed), nonce, 16, key.key, key_half);
+    Blake2xbPRNG prng(seed);
+    vector<seal_byte> stream(length);
+    prng.generate(length, stream.data());
+    for (size_t i = 0; i < length; i++) {
+        data[i] ^= static_cast<char>(stream[i]);
+    }
+}
+
+static void compute_tag(
+    const struct sealing_key& key, const string& sealed, uint8_t tag[tag_size]) {
+    blake2b(tag, tag_size, sealed.data(), sealed.size(), key.key + key_half, key_half);
+}
+
+KeySet create_keys(const SEALContext& context, const vector<int>& steps) {
+    KeySet keys;
+    keys.steps = normalized(steps);
+    KeyGenerator keygen(context);
+    keys.secret_key = keygen.secret_key();
+    keygen.create_public_key(keys.public_key);
+    keygen.create_relin_keys(keys.relin_keys);
+    keygen.create_galois_keys(keys.steps, keys.galois_keys);
+    return keys;
+}
+
+bool seal_keys(const KeySet& keys, const SEALContext& context, const string& path) {
+    struct sealing_key key;
+    if (!keystore_key(key)) {
+        return false;
+    }
+
+    stringstream plain;
+    uint64_t count = keys.steps.size();
+    plain.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    plain.write(reinterpret_cast<const char*>(keys.steps.data()), count * sizeof(int));
+    keys.secret_key.save(plain);
+    keys.public_key.save(plain);
+    keys.relin_keys.save(plain);
+    keys.galois_keys.save(plain);
+    string body = plain.str();
+
+    SealedHeader header;
+    memcpy(header.magic, keystore_magic, sizeof(header.magic));
+    parms_id_type parms_id = context.key_parms_id();
+    copy(parms_id.begin(), parms_id.end(), header.parms_id);
+    uint64_t nonce[2] = {random_uint64(), random_uint64()};
+    memcpy(header.nonce, nonce, sizeof(header.nonce));
+    header.length = body.size();
+
+    apply_stream(key, header.nonce, &body[0], body.size());
+    string sealed(reinterpret_cast<const char*>(&header), sizeof(header));
+    sealed += body;
+    uint8_t tag[tag_size];
+    compute_tag(key, sealed, tag);
+    memset(&key, 0, sizeof(key));
+
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(sealed.data(), sealed.size());
+    out.write(reinterpret_cast<const char*>(tag), tag_size);
+    return static_cast<bool>(out.flush());
+}
+
+bool unseal_keys(
+    const SEALContext& context, const vector<int>& steps, const string& path, KeySet& keys) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return false;
+    }
+    string sealed((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    SealedHeader header;
+    if (sealed.size() < sizeof(header) + tag_size) {
+        return false;
+    }
+    memcpy(&header, sealed.data(), sizeof(header));
+    parms_id_type parms_id = context.key_parms_id();
+    if (memcmp(header.magic, keystore_magic, sizeof(header.magic)) != 0 ||
+        !equal(parms_id.begin(), parms_id.end(), header.parms_id) ||
+        header.length != sealed.size() - sizeof(header) - tag_size) {
+        return false;
+    }
+
+    struct sealing_key key;
+    if (!keystore_key(key)) {
+        return false;
+    }
+    uint8_t tag[tag_size];
+    string stored_tag = sealed.substr(sealed.size() - tag_size);
+    sealed.resize(sealed.size() - tag_size);
+    compute_tag(key, sealed, tag);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < tag_size; i++) {
+        diff |= tag[i] ^ static_cast<uint8_t>(stored_tag[i]);
+    }
+    if (diff != 0) {
+        memset(&key, 0, sizeof(key));
+        return false;
+    }
+    string body = sealed.substr(sizeof(header));
+    apply_stream(key, header.nonce, &body[0], body.size());
+    memset(&key, 0, sizeof(key));
+
+    // an authentic file can still be for another kernel's rotations
+    KeySet loaded;
+    stringstream plain(body);
+    uint64_t count = 0;
+    plain.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!plain || count > body.size() / sizeof(int)) {
+        return false;
+    }
+    loaded.steps.resize(count);
+    plain.read(reinterpret_cast<char*>(loaded.steps.data()), count * sizeof(int));
+    if (!plain || loaded.steps != normalized(steps)) {
+        return false;
+    }
+    try {
+        loaded.secret_key.load(context, plain);
+        loaded.public_key.load(context, plain);
+        loaded.relin_keys.load(context, plain);
+        loaded.galois_keys.load(context, plain);
+    } catch (const exception&) {
+        return false;
+    }
+    keys = move(loaded);
+    return true;
+}
+
+KeySet load_or_create_keys(
+    const SEALContext& context, const vector<int>& steps, const string& path) {
+    using timer = chrono::steady_clock;
+    KeySet keys;
+
+    auto start = timer::now();
+    if (unseal_keys(context, steps, path, keys)) {
+        chrono::duration<double, milli> took = timer::now() - start;
+        cout << "Keys unsealed from " << path << " in " << took.count() << " ms ("
+             << keys.steps.size() << " rotation steps)" << endl;
+        return keys;
+    }
+
+    start = timer::now();
+    keys = create_keys(context, steps);
+    chrono::duration<double, milli> took = timer::now() - start;
+    cout << "Keys generated in " << took.count() << " ms ("
+         << keys.steps.size() << " rotation steps)";
+    if (seal_keys(keys, context, path)) {
+        cout << ", sealed to " << path;
+    }
+    cout << endl;
+    return keys;
+}
+
+}  // namespace seal_common
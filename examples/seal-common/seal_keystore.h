@@ -0,0 +1,53 @@
+// examples/seal-common/seal_keystore.h
+//
+// Key sets for the SEAL enclaves, sealed to host storage.
+//
+// Galois keys dominate both keygen time and key size, and a kernel only
+// needs the handful of rotation steps it actually performs (rotation_steps()
+// in seal_linalg.h), so create_keys() generates exactly those instead of
+// SEAL's default set of every power of two.
+//
+// A key set is sealed with a key the security monitor derives from the
+// enclave's measurement (get_sealing_key, see app/sealing.h), so only the
+// same eapp can unseal it, and the host only ever sees ciphertext. Later
+// runs unseal and load the keys instead of generating them again. The file
+// is encrypted with the Blake2xb stream of SEAL's PRNG, keyed by the
+// sealing key and a fresh nonce, and authenticated with keyed BLAKE2b over
+// the header (which binds the encryption parameters) and the ciphertext.
+#pragma once
+
+#include <string>
+#include <vector>
+#include <seal/seal.h>
+
+namespace seal_common {
+
+struct KeySet {
+    seal::SecretKey secret_key;
+    seal::PublicKey public_key;
+    seal::RelinKeys relin_keys;
+    seal::GaloisKeys galois_keys;
+    std::vector<int> steps;  // the rotation steps galois_keys covers
+};
+
+// Generates a key set with Galois keys for exactly steps.
+KeySet create_keys(const seal::SEALContext& context, const std::vector<int>& steps);
+
+// Seals keys to path. Returns false if the sealing key is not available
+// (outside an enclave) or the file cannot be written.
+bool seal_keys(const KeySet& keys, const seal::SEALContext& context, const std::string& path);
+
+// Unseals the keys at path into keys. Returns false if the file is missing,
+// was modified or sealed by another enclave, or holds keys for other
+// parameters or other rotation steps.
+bool unseal_keys(
+    const seal::SEALContext& context, const std::vector<int>& steps,
+    const std::string& path, KeySet& keys);
+
+// Unseals the keys at path, or generates them and seals them there, and
+// reports which it did and how long it took.
+KeySet load_or_create_keys(
+    const seal::SEALContext& context, const std::vector<int>& steps,
+    const std::string& path);
+
+}  // namespace seal_common
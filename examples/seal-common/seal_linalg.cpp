@@ -0,0 +1,405 @@
+// examples/seal-common/seal_linalg.cpp
+#include "seal_linalg.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace seal_common {
+
+size_t rotation_slots(const SEALContext& context) {
+    // CKKS rotates all N/2 slots, BFV/BGV each of the two rows of N/2
+    return context.first_context_data()->parms().poly_modulus_degree() / 2;
+}
+
+static void rotate_inplace(
+    const Evaluator& evaluator, Ciphertext& x, int steps,
+    const GaloisKeys& galois_keys, bool batched) {
+    if (batched) {
+        evaluator.rotate_rows_inplace(x, steps, galois_keys);
+    } else {
+        evaluator.rotate_vector_inplace(x, steps, galois_keys);
+    }
+}
+
+size_t packed_stride(size_t rows, size_t cols) {
+    size_t stride = 1;
+    while (stride < rows + cols - 1) {
+        stride <<= 1;
+    }
+    return stride;
+}
+
+// Splits M into its diagonals over the slots (R per rotation row), with
+// each block's copy in its first m slots and zeros elsewhere, and rotates
+// each diagonal right by its giant step within the rotation row.
+template <typename T>
+static vector<vector<T>> bsgs_diagonals(
+    const vector<vector<T>>& M, size_t R, size_t slots, size_t stride,
+    EncodedMatrix& out) {
+    if (M.empty() || M[0].empty()) {
+        throw invalid_argument("empty matrix");
+    }
+    size_t n = M.size();
+    size_t m = M[0].size();
+    for (const auto& row : M) {
+        if (row.size() != m) {
+            throw invalid_argument("matrix rows differ in length");
+        }
+    }
+    if (stride == 0) {
+        stride = R;
+    }
+    if ((stride & (stride - 1)) != 0 || stride > R) {
+        throw invalid_argument("stride must be a power of two of at most a rotation row");
+    }
+    // rot(v, i) must not leave the block for any result slot
+    if (n + m - 1 > stride) {
+        throw invalid_argument("matrix does not fit the stride");
+    }
+
+    out.rows = n;
+    out.cols = m;
+    out.baby = static_cast<size_t>(ceil(sqrt(static_cast<double>(n))));
+    out.giant = (n + out.baby - 1) / out.baby;
+    out.stride = stride;
+    out.blocks = slots / stride;
+
+    vector<vector<T>> diagonals(n, vector<T>(slots, T()));
+    for (size_t i = 0; i < n; i++) {
+        size_t shift = (i / out.baby) * out.baby;
+        for (size_t block = 0; block < slots; block += stride) {
+            size_t row = block - block % R;
+            for (size_t x = 0; x < m; x++) {
+                diagonals[i][row + (block - row + x + shift) % R] = M[(x + i) % n][x];
+            }
+        }
+    }
+    return diagonals;
+}
+
+// vs[p] repeated over block p, zeros past vs.size()
+template <typename T>
+static vector<T> pack_blocks(const vector<vector<T>>& vs, size_t slots, size_t stride) {
+    if (vs.size() > slots / stride) {
+        throw invalid_argument("more vectors than blocks");
+    }
+    vector<T> packed(slots, T());
+    for (size_t p = 0; p < vs.size(); p++) {
+        if (vs[p].empty()) {
+            throw invalid_argument("empty vector");
+        }
+        for (size_t x = 0; x < stride; x++) {
+            packed[p * stride + x] = vs[p][x % vs[p].size()];
+        }
+    }
+    return packed;
+}
+
+// bias at the start of every block of stride slots (or only the first)
+template <typename T>
+static vector<T> tile_bias(const vector<T>& bias, size_t slots, size_t stride) {
+    if (stride == 0) {
+        return bias;
+    }
+    if (bias.size() > stride) {
+        throw invalid_argument("bias is longer than the stride");
+    }
+    vector<T> tiled(slots, T());
+    for (size_t block = 0; block + stride <= slots; block += stride) {
+        copy(bias.begin(), bias.end(), tiled.begin() + block);
+    }
+    return tiled;
+}
+
+template <typename T>
+static vector<vector<T>> unpack_blocks(
+    const vector<T>& slots, size_t count, size_t length, size_t stride) {
+    if (count * stride > slots.size() || length > stride) {
+        throw invalid_argument("blocks out of range");
+    }
+    vector<vector<T>> out(count);
+    for (size_t p = 0; p < count; p++) {
+        out[p].assign(slots.begin() + p * stride, slots.begin() + p * stride + length);
+    }
+    return out;
+}
+
+template <typename T>
+static bool all_zero(const vector<T>& v) {
+    for (const T& x : v) {
+        if (x != T()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+EncodedMatrix encode_matrix(
+    const vector<vector<double>>& M,
+    const SEALContext& context,
+    const CKKSEncoder& encoder,
+    parms_id_type parms_id,
+    size_t stride) {
+    auto context_data = context.get_context_data(parms_id);
+    if (!context_data || !context_data->next_context_data()) {
+        throw invalid_argument("no level left to rescale the product");
+    }
+    // the product is rescaled by exactly this prime, so it keeps its scale
+    double scale = static_cast<double>(
+        context_data->parms().coeff_modulus().back().value());
+
+    EncodedMatrix out;
+    vector<vector<double>> diagonals =
+        bsgs_diagonals(M, rotation_slots(context), encoder.slot_count(), stride, out);
+    out.batched = false;
+    out.parms_id = parms_id;
+    out.diagonals.resize(out.rows);
+    out.nonzero.resize(out.rows);
+    for (size_t i = 0; i < out.rows; i++) {
+        out.nonzero[i] = !all_zero(diagonals[i]);
+        if (out.nonzero[i]) {
+            encoder.encode(diagonals[i], parms_id, scale, out.diagonals[i]);
+        }
+    }
+    return out;
+}
+
+EncodedMatrix encode_matrix(
+    const vector<vector<uint64_t>>& M,
+    const SEALContext& context,
+    const BatchEncoder& encoder,
+    const Evaluator& evaluator,
+    size_t stride) {
+    EncodedMatrix out;
+    vector<vector<uint64_t>> diagonals =
+        bsgs_diagonals(M, rotation_slots(context), encoder.slot_count(), stride, out);
+    out.batched = true;
+    out.parms_id = context.first_parms_id();
+    out.diagonals.resize(out.rows);
+    out.nonzero.resize(out.rows);
+    for (size_t i = 0; i < out.rows; i++) {
+        out.nonzero[i] = !all_zero(diagonals[i]);
+        if (out.nonzero[i]) {
+            // multiply() works in NTT form
+            encoder.encode(diagonals[i], out.diagonals[i]);
+            evaluator.transform_to_ntt_inplace(out.diagonals[i], out.parms_id);
+        }
+    }
+    return out;
+}
+
+vector<int> rotation_steps(const EncodedMatrix& M) {
+    vector<int> steps;
+    for (size_t j = 1; j < M.baby && j < M.rows; j++) {
+        steps.push_back(static_cast<int>(j));
+    }
+    for (size_t g = 1; g < M.giant; g++) {
+        steps.push_back(static_cast<int>(g * M.baby));
+    }
+    return steps;
+}
+
+Ciphertext encrypt_vector(
+    const vector<double>& v,
+    const SEALContext& context,
+    const CKKSEncoder& encoder,
+    const Encryptor& encryptor,
+    double scale) {
+    if (v.empty()) {
+        throw invalid_argument("empty vector");
+    }
+    vector<double> slots(encoder.slot_count());
+    for (size_t x = 0; x < slots.size(); x++) {
+        slots[x] = v[x % v.size()];
+    }
+    Plaintext plain;
+    encoder.encode(slots, context.first_parms_id(), scale, plain);
+    Ciphertext encrypted;
+    encryptor.encrypt(plain, encrypted);
+    return encrypted;
+}
+
+Ciphertext encrypt_vector(
+    const vector<uint64_t>& v,
+    const SEALContext& context,
+    const BatchEncoder& encoder,
+    const Encryptor& encryptor) {
+    if (v.empty()) {
+        throw invalid_argument("empty vector");
+    }
+    size_t R = rotation_slots(context);
+    vector<uint64_t> slots(encoder.slot_count());
+    for (size_t x = 0; x < slots.size(); x++) {
+        slots[x] = v[(x % R) % v.size()];
+    }
+    Plaintext plain;
+    encoder.encode(slots, plain);
+    Ciphertext encrypted;
+    encryptor.encrypt(plain, encrypted);
+    return encrypted;
+}
+
+Ciphertext encrypt_batch(
+    const vector<vector<double>>& vs,
+    const EncodedMatrix& M,
+    const CKKSEncoder& encoder,
+    const Encryptor& encryptor,
+    double scale) {
+    Plaintext plain;
+    encoder.encode(pack_blocks(vs, encoder.slot_count(), M.stride), M.parms_id, scale, plain);
+    Ciphertext encrypted;
+    encryptor.encrypt(plain, encrypted);
+    return encrypted;
+}
+
+Ciphertext encrypt_batch(
+    const vector<vector<uint64_t>>& vs,
+    const EncodedMatrix& M,
+    const BatchEncoder& encoder,
+    const Encryptor& encryptor) {
+    Plaintext plain;
+    encoder.encode(pack_blocks(vs, encoder.slot_count(), M.stride), plain);
+    Ciphertext encrypted;
+    encryptor.encrypt(plain, encrypted);
+    return encrypted;
+}
+
+Ciphertext multiply(
+    const Ciphertext& v,
+    const EncodedMatrix& M,
+    const Evaluator& evaluator,
+    const GaloisKeys& galois_keys) {
+    if (v.parms_id() != M.parms_id) {
+        throw invalid_argument("vector is not at the level of the matrix");
+    }
+
+    // baby steps, shared by all giant steps
+    size_t baby_count = min(M.baby, M.rows);
+    vector<Ciphertext> baby(baby_count, v);
+    for (size_t j = 1; j < baby_count; j++) {
+        rotate_inplace(evaluator, baby[j], static_cast<int>(j), galois_keys, M.batched);
+    }
+    if (M.batched) {
+        for (auto& b : baby) {
+            evaluator.transform_to_ntt_inplace(b);
+        }
+    }
+
+    Ciphertext result;
+    bool have_result = false;
+    for (size_t g = 0; g < M.giant; g++) {
+        Ciphertext partial;
+        bool have_partial = false;
+        for (size_t j = 0; j < baby_count; j++) {
+            size_t i = g * M.baby + j;
+            if (i >= M.rows) {
+                break;
+            }
+            if (!M.nonzero[i]) {
+                continue;
+            }
+            if (have_partial) {
+                Ciphertext product;
+                evaluator.multiply_plain(baby[j], M.diagonals[i], product);
+                evaluator.add_inplace(partial, product);
+            } else {
+                evaluator.multiply_plain(baby[j], M.diagonals[i], partial);
+                have_partial = true;
+            }
+        }
+        if (!have_partial) {
+            continue;
+        }
+
+        if (M.batched) {
+            evaluator.transform_from_ntt_inplace(partial);
+        }
+        if (g > 0) {
+            rotate_inplace(evaluator, partial, static_cast<int>(g * M.baby), galois_keys, M.batched);
+        }
+        if (have_result) {
+            evaluator.add_inplace(result, partial);
+        } else {
+            result = move(partial);
+            have_result = true;
+        }
+    }
+    if (!have_result) {
+        throw invalid_argument("matrix is zero");
+    }
+
+    // one rescale for the whole product
+    if (!M.batched) {
+        evaluator.rescale_to_next_inplace(result);
+    }
+    return result;
+}
+
+void add_bias_inplace(
+    Ciphertext& x,
+    const vector<double>& bias,
+    const CKKSEncoder& encoder,
+    const Evaluator& evaluator,
+    size_t stride) {
+    Plaintext plain;
+    encoder.encode(tile_bias(bias, encoder.slot_count(), stride), x.parms_id(), x.scale(), plain);
+    evaluator.add_plain_inplace(x, plain);
+}
+
+void add_bias_inplace(
+    Ciphertext& x,
+    const vector<uint64_t>& bias,
+    const BatchEncoder& encoder,
+    const Evaluator& evaluator,
+    size_t stride) {
+    Plaintext plain;
+    encoder.encode(tile_bias(bias, encoder.slot_count(), stride), plain);
+    evaluator.add_plain_inplace(x, plain);
+}
+
+vector<double> decrypt_vector(
+    const Ciphertext& x, size_t length,
+    Decryptor& decryptor, const CKKSEncoder& encoder) {
+    Plaintext plain;
+    decryptor.decrypt(x, plain);
+    vector<double> slots;
+    encoder.decode(plain, slots);
+    slots.resize(min(length, slots.size()));
+    return slots;
+}
+
+vector<uint64_t> decrypt_vector(
+    const Ciphertext& x, size_t length,
+    Decryptor& decryptor, const BatchEncoder& encoder) {
+    Plaintext plain;
+    decryptor.decrypt(x, plain);
+    vector<uint64_t> slots;
+    encoder.decode(plain, slots);
+    slots.resize(min(length, slots.size()));
+    return slots;
+}
+
+vector<vector<double>> decrypt_batch(
+    const Ciphertext& x, size_t count, size_t length, size_t stride,
+    Decryptor& decryptor, const CKKSEncoder& encoder) {
+    Plaintext plain;
+    decryptor.decrypt(x, plain);
+    vector<double> slots;
+    encoder.decode(plain, slots);
+    return unpack_blocks(slots, count, length, stride);
+}
+
+vector<vector<uint64_t>> decrypt_batch(
+    const Ciphertext& x, size_t count, size_t length, size_t stride,
+    Decryptor& decryptor, const BatchEncoder& encoder) {
+    Plaintext plain;
+    decryptor.decrypt(x, plain);
+    vector<uint64_t> slots;
+    encoder.decode(plain, slots);
+    return unpack_blocks(slots, count, length, stride);
+}
+
+}  // namespace seal_common
@@ -0,0 +1,150 @@
+// examples/seal-common/seal_linalg.h
+//
+// Encrypted linear algebra shared by the SEAL examples.
+//
+// A vector v of length n is encrypted replicated (v[0..n-1] repeated along
+// the slots a rotation cycles through), and v * M for an n x m matrix M is
+// computed with Halevi-Shoup diagonals:
+//
+//     (v * M)[x] = sum_i diag_i[x] * v[(x + i) % n],  diag_i[x] = M[(x + i) % n][x]
+//
+// The diagonals are encoded once as plaintexts and multiplied with
+// multiply_plain, so no ciphertext-ciphertext product (and no
+// relinearization) is needed. The n rotations of v are split into
+// baby-step/giant-step form, i = g * baby + j:
+//
+//     v * M = sum_g rot( sum_j rot(diag_i, -g * baby) * rot(v, j), g * baby )
+//
+// The baby-step rotations of v are computed once and shared by every giant
+// step, which brings the key switches from n - 1 down to about 2 * sqrt(n).
+// In CKKS the diagonals are encoded at the scale of the prime that the
+// product drops, so the result is rescaled once and keeps the scale of v.
+// Slots of the result past m are zero (in every block, see below).
+//
+// Packed layout: the slots are cut into blocks of stride slots (a power of
+// two of at least n + m - 1), each holding its own input vector replicated
+// within the block. The diagonals repeat in every block, so one multiply()
+// computes v_p * M for every block p at the cost of one vector, and block p
+// of the result holds v_p * M in its first m slots. BFV/BGV use the blocks
+// of both rows. The default stride is a whole rotation row (one block per
+// row, as encrypt_vector() lays it out).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <seal/seal.h>
+
+namespace seal_common {
+
+struct EncodedMatrix {
+    size_t rows = 0;   // length of the input vector
+    size_t cols = 0;   // length of the result
+    size_t baby = 0;   // baby steps: rotations of the input by 0..baby-1
+    size_t giant = 0;  // giant steps: rotations of the partial sums by g*baby
+    size_t stride = 0;  // slots per block
+    size_t blocks = 0;  // vectors one ciphertext carries
+    bool batched = false;  // BFV/BGV: rotate_rows over half of the slots
+    seal::parms_id_type parms_id;  // level of the input the matrix applies to
+    std::vector<seal::Plaintext> diagonals;  // diagonal g*baby+j, rotated by -g*baby
+    std::vector<bool> nonzero;  // zero diagonals are skipped
+};
+
+// Slots a rotation cycles through: all of them in CKKS, a row in BFV/BGV.
+size_t rotation_slots(const seal::SEALContext& context);
+
+// The smallest stride that packs inputs of length rows for a rows x cols
+// matrix: the most vectors per ciphertext.
+size_t packed_stride(size_t rows, size_t cols);
+
+// Encodes M (n x m) for CKKS inputs at parms_id. stride 0 is the default
+// layout, one block per rotation row.
+EncodedMatrix encode_matrix(
+    const std::vector<std::vector<double>>& M,
+    const seal::SEALContext& context,
+    const seal::CKKSEncoder& encoder,
+    seal::parms_id_type parms_id,
+    size_t stride = 0);
+
+// Encodes M (n x m) for BFV/BGV inputs at the first data level.
+EncodedMatrix encode_matrix(
+    const std::vector<std::vector<uint64_t>>& M,
+    const seal::SEALContext& context,
+    const seal::BatchEncoder& encoder,
+    const seal::Evaluator& evaluator,
+    size_t stride = 0);
+
+// The rotation steps multiply() uses with M, for create_galois_keys(steps).
+std::vector<int> rotation_steps(const EncodedMatrix& M);
+
+// Encrypts v replicated along the rotation slots.
+seal::Ciphertext encrypt_vector(
+    const std::vector<double>& v,
+    const seal::SEALContext& context,
+    const seal::CKKSEncoder& encoder,
+    const seal::Encryptor& encryptor,
+    double scale);
+
+seal::Ciphertext encrypt_vector(
+    const std::vector<uint64_t>& v,
+    const seal::SEALContext& context,
+    const seal::BatchEncoder& encoder,
+    const seal::Encryptor& encryptor);
+
+// Encrypts up to M.blocks vectors, vs[p] replicated in block p. Blocks
+// past vs.size() are zero.
+seal::Ciphertext encrypt_batch(
+    const std::vector<std::vector<double>>& vs,
+    const EncodedMatrix& M,
+    const seal::CKKSEncoder& encoder,
+    const seal::Encryptor& encryptor,
+    double scale);
+
+seal::Ciphertext encrypt_batch(
+    const std::vector<std::vector<uint64_t>>& vs,
+    const EncodedMatrix& M,
+    const seal::BatchEncoder& encoder,
+    const seal::Encryptor& encryptor);
+
+// v * M. v must be at M.parms_id; in CKKS the result is one level lower.
+seal::Ciphertext multiply(
+    const seal::Ciphertext& v,
+    const EncodedMatrix& M,
+    const seal::Evaluator& evaluator,
+    const seal::GaloisKeys& galois_keys);
+
+// Adds a plaintext bias to the first bias.size() slots of x, or of every
+// block of stride slots if stride is not 0.
+void add_bias_inplace(
+    seal::Ciphertext& x,
+    const std::vector<double>& bias,
+    const seal::CKKSEncoder& encoder,
+    const seal::Evaluator& evaluator,
+    size_t stride = 0);
+
+void add_bias_inplace(
+    seal::Ciphertext& x,
+    const std::vector<uint64_t>& bias,
+    const seal::BatchEncoder& encoder,
+    const seal::Evaluator& evaluator,
+    size_t stride = 0);
+
+// Decrypts the first length slots of x.
+std::vector<double> decrypt_vector(
+    const seal::Ciphertext& x, size_t length,
+    seal::Decryptor& decryptor, const seal::CKKSEncoder& encoder);
+
+std::vector<uint64_t> decrypt_vector(
+    const seal::Ciphertext& x, size_t length,
+    seal::Decryptor& decryptor, const seal::BatchEncoder& encoder);
+
+// Decrypts the first length slots of the first count blocks of x.
+std::vector<std::vector<double>> decrypt_batch(
+    const seal::Ciphertext& x, size_t count, size_t length, size_t stride,
+    seal::Decryptor& decryptor, const seal::CKKSEncoder& encoder);
+
+std::vector<std::vector<uint64_t>> decrypt_batch(
+    const seal::Ciphertext& x, size_t count, size_t length, size_t stride,
+    seal::Decryptor& decryptor, const seal::BatchEncoder& encoder);
+
+}  // namespace seal_common
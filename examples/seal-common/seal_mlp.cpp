@@ -0,0 +1,353 @@
+// examples/seal-common/seal_mlp.cpp
+#include "seal_mlp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace seal_common {
+
+Activation Activation::named(const string& name) {
+    if (name == "none") {
+        return { name, { 0.0, 1.0 } };
+    }
+    if (name == "square") {
+        return { name, { 0.0, 0.0, 1.0 } };
+    }
+    if (name == "relu") {
+        return { name, { 0.375, 0.5, 0.1171875 } };
+    }
+    if (name == "sigmoid") {
+        return { name, { 0.5, 0.198326, 0.0, -0.004473 } };
+    }
+    throw invalid_argument("unknown activation " + name);
+}
+
+// coefficient k, 0 past the degree
+static double coeff(const Activation& a, size_t k) {
+    return k < a.coeffs.size() ? a.coeffs[k] : 0.0;
+}
+
+size_t Activation::depth() const {
+    if (coeffs.size() > 4) {
+        throw invalid_argument("activations are of degree 3 at most");
+    }
+    if (coeff(*this, 2) == 0.0 && coeff(*this, 3) == 0.0) {
+        return coeff(*this, 1) == 1.0 ? 0 : 1;
+    }
+    if (coeff(*this, 1) == 0.0 && coeff(*this, 2) == 1.0 && coeff(*this, 3) == 0.0) {
+        return 1;
+    }
+    return 2;
+}
+
+double Activation::operator()(double x) const {
+    double y = 0;
+    for (size_t k = coeffs.size(); k-- > 0;) {
+        y = y * x + coeffs[k];
+    }
+    return y;
+}
+
+// The next token of in, skipping # comments; throws at the end
+static string next_token(istream& in) {
+    string token;
+    while (in >> token) {
+        if (token[0] != '#') {
+            return token;
+        }
+        in.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+    throw invalid_argument("network file ends early");
+}
+
+static double next_number(istream& in) {
+    string token = next_token(in);
+    size_t end;
+    double value = stod(token, &end);
+    if (end != token.size() || !isfinite(value)) {
+        throw invalid_argument("bad number " + token);
+    }
+    return value;
+}
+
+static size_t next_size(istream& in) {
+    double value = next_number(in);
+    if (value < 1 || value > 65536 || value != floor(value)) {
+        throw invalid_argument("bad layer size");
+    }
+    return static_cast<size_t>(value);
+}
+
+vector<DenseLayer> load_network(istream& in) {
+    vector<DenseLayer> layers;
+    string token;
+    while (in >> token) {
+        if (token[0] == '#') {
+            in.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+        if (token != "layer") {
+            throw invalid_argument("expected a layer, got " + token);
+        }
+
+        DenseLayer layer;
+        size_t inputs = next_size(in);
+        size_t outputs = next_size(in);
+        string activation = next_token(in);
+        if (activation == "poly") {
+            layer.activation.name = activation;
+            for (size_t k = 0; k < 4; k++) {
+                layer.activation.coeffs.push_back(next_number(in));
+            }
+        } else {
+            layer.activation = Activation::named(activation);
+        }
+
+        layer.weights.assign(inputs, vector<double>(outputs));
+        for (auto& row : layer.weights) {
+            for (auto& w : row) {
+                w = next_number(in);
+            }
+        }
+        layer.bias.resize(outputs);
+        for (auto& b : layer.bias) {
+            b = next_number(in);
+        }
+
+        if (!layers.empty() && layers.back().bias.size() != inputs) {
+            throw invalid_argument("layer inputs do not match the previous outputs");
+        }
+        layers.push_back(move(layer));
+    }
+    if (layers.empty()) {
+        throw invalid_argument("network has no layers");
+    }
+    return layers;
+}
+
+vector<DenseLayer> load_network(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("cannot open " + path);
+    }
+    return load_network(in);
+}
+
+size_t network_depth(const vector<DenseLayer>& layers) {
+    size_t depth = 0;
+    for (const auto& layer : layers) {
+        depth += 1 + layer.activation.depth();
+    }
+    return depth;
+}
+
+// Slots a replication of width values up to need slots fills: width
+// doubled until it covers need
+static size_t replicated_width(size_t width, size_t need) {
+    size_t covered = width;
+    while (covered < need) {
+        covered *= 2;
+    }
+    return covered;
+}
+
+size_t network_stride(const vector<DenseLayer>& layers) {
+    size_t widest = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        size_t n = layers[i].weights.size();
+        size_t need = n + layers[i].bias.size() - 1;
+        widest = max(widest, i == 0 ? need : replicated_width(n, need));
+    }
+    size_t stride = 1;
+    while (stride < widest) {
+        stride <<= 1;
+    }
+    return stride;
+}
+
+EncryptionParameters network_parameters(const vector<DenseLayer>& layers, int scale_bits) {
+    size_t depth = network_depth(layers);
+    size_t stride = network_stride(layers);
+
+    vector<int> bits(depth + 2, scale_bits);
+    bits.front() = 60;
+    bits.back() = 60;
+    int total = 0;
+    for (int b : bits) {
+        total += b;
+    }
+
+    for (size_t degree : { 8192, 16384, 32768 }) {
+        if (CoeffModulus::MaxBitCount(degree) >= total && degree / 2 >= stride) {
+            EncryptionParameters parms(scheme_type::ckks);
+            parms.set_poly_modulus_degree(degree);
+            parms.set_coeff_modulus(CoeffModulus::Create(degree, bits));
+            return parms;
+        }
+    }
+    throw invalid_argument("network is too deep or too wide for CKKS without bootstrapping");
+}
+
+vector<double> infer_plain(const vector<DenseLayer>& layers, vector<double> v) {
+    for (const auto& layer : layers) {
+        vector<double> out = layer.bias;
+        for (size_t r = 0; r < layer.weights.size(); r++) {
+            for (size_t c = 0; c < out.size(); c++) {
+                out[c] += v[r] * layer.weights[r][c];
+            }
+        }
+        for (auto& x : out) {
+            x = layer.activation(x);
+        }
+        v = move(out);
+    }
+    return v;
+}
+
+EncryptedNetwork::EncryptedNetwork(
+    const vector<DenseLayer>& layers, const SEALContext& context,
+    const CKKSEncoder& encoder, double scale)
+    : context_(context), encoder_(encoder), scale_(scale),
+      stride_(network_stride(layers)), layers_(layers) {
+    // each layer's weights at the level its input arrives at
+    parms_id_type level = context.first_parms_id();
+    for (const auto& layer : layers_) {
+        encoded_.push_back(encode_matrix(layer.weights, context, encoder, level, stride_));
+        for (size_t i = 0; i < 1 + layer.activation.depth(); i++) {
+            auto data = context.get_context_data(level);
+            if (!data || !data->next_context_data()) {
+                throw invalid_argument("modulus chain is too short for the network");
+            }
+            level = data->next_context_data()->parms_id();
+        }
+    }
+}
+
+vector<int> EncryptedNetwork::rotation_steps() const {
+    vector<int> steps;
+    for (size_t i = 0; i < encoded_.size(); i++) {
+        vector<int> layer_steps = seal_common::rotation_steps(encoded_[i]);
+        steps.insert(steps.end(), layer_steps.begin(), layer_steps.end());
+        if (i > 0) {
+            size_t n = encoded_[i].rows;
+            for (size_t covered = n; covered < n + encoded_[i].cols - 1; covered *= 2) {
+                steps.push_back(-static_cast<int>(covered));
+            }
+        }
+    }
+    sort(steps.begin(), steps.end());
+    steps.erase(unique(steps.begin(), steps.end()), steps.end());
+    return steps;
+}
+
+Ciphertext EncryptedNetwork::encrypt(
+    const vector<vector<double>>& samples, const Encryptor& encryptor) const {
+    return encrypt_batch(samples, encoded_.front(), encoder_, encryptor, scale_);
+}
+
+vector<vector<double>> EncryptedNetwork::decrypt(
+    const Ciphertext& y, size_t count, Decryptor& decryptor) const {
+    return decrypt_batch(y, count, outputs(), stride_, decryptor, encoder_);
+}
+
+// The primes are within a hair of the scale, so after a product of two
+// ciphertexts is rescaled its scale is set back to the network's; the
+// error this makes is far below the CKKS noise. Terms then add exactly.
+static void rescale_to(const Evaluator& evaluator, Ciphertext& x, double scale) {
+    evaluator.rescale_to_next_inplace(x);
+    x.scale() = scale;
+}
+
+// c * x, encoded at the prime the rescale drops: the result keeps the
+// scale of x, one level down
+static Ciphertext times_constant(
+    const Ciphertext& x, double c, const SEALContext& context,
+    const CKKSEncoder& encoder, const Evaluator& evaluator) {
+    double prime = static_cast<double>(
+        context.get_context_data(x.parms_id())->parms().coeff_modulus().back().value());
+    Plaintext plain;
+    encoder.encode(c, x.parms_id(), prime, plain);
+    Ciphertext out;
+    evaluator.multiply_plain(x, plain, out);
+    rescale_to(evaluator, out, x.scale());
+    return out;
+}
+
+static Ciphertext times(
+    const Ciphertext& a, const Ciphertext& b, double scale,
+    const Evaluator& evaluator, const RelinKeys& relin_keys) {
+    Ciphertext out;
+    evaluator.multiply(a, b, out);
+    evaluator.relinearize_inplace(out, relin_keys);
+    rescale_to(evaluator, out, scale);
+    return out;
+}
+
+void EncryptedNetwork::activate_inplace(
+    Ciphertext& x, const Activation& activation, size_t width,
+    const Evaluator& evaluator, const RelinKeys& relin_keys) const {
+    double c1 = coeff(activation, 1), c2 = coeff(activation, 2), c3 = coeff(activation, 3);
+    size_t depth = activation.depth();
+
+    if (depth == 1 && c2 == 1.0) {
+        x = times(x, x, scale_, evaluator, relin_keys);
+    } else if (depth == 1) {
+        x = times_constant(x, c1, context_, encoder_, evaluator);
+    } else if (depth == 2) {
+        // c1 x + (c2 x) x + (c3 x) x^2, every term two levels down
+        parms_id_type level1 = context_.get_context_data(x.parms_id())->next_context_data()->parms_id();
+        vector<Ciphertext> terms;
+        Ciphertext x1 = x;
+        evaluator.mod_switch_to_inplace(x1, level1);
+        if (c1 != 0.0) {
+            terms.push_back(times_constant(x, c1, context_, encoder_, evaluator));
+            evaluator.mod_switch_to_next_inplace(terms.back());
+        }
+        if (c2 != 0.0) {
+            Ciphertext c2x = times_constant(x, c2, context_, encoder_, evaluator);
+            terms.push_back(times(c2x, x1, scale_, evaluator, relin_keys));
+        }
+        if (c3 != 0.0) {
+            Ciphertext x2 = times(x, x, scale_, evaluator, relin_keys);
+            Ciphertext c3x = times_constant(x, c3, context_, encoder_, evaluator);
+            terms.push_back(times(c3x, x2, scale_, evaluator, relin_keys));
+        }
+        evaluator.add_many(terms, x);
+    }
+
+    // the constant only goes to the result slots: the others stay zero
+    // for the next layer's replication
+    if (coeff(activation, 0) != 0.0) {
+        add_bias_inplace(x, vector<double>(width, coeff(activation, 0)), encoder_, evaluator, stride_);
+    }
+}
+
+Ciphertext EncryptedNetwork::infer(
+    const Ciphertext& input, const Evaluator& evaluator,
+    const RelinKeys& relin_keys, const GaloisKeys& galois_keys) const {
+    Ciphertext x = input;
+    for (size_t i = 0; i < layers_.size(); i++) {
+        const EncodedMatrix& M = encoded_[i];
+        if (i > 0) {
+            // the previous outputs fill the first M.rows slots of each
+            // block: copy them along until the product can read them all
+            for (size_t covered = M.rows; covered < M.rows + M.cols - 1; covered *= 2) {
+                Ciphertext shifted;
+                evaluator.rotate_vector(x, -static_cast<int>(covered), galois_keys, shifted);
+                evaluator.add_inplace(x, shifted);
+            }
+        }
+        x = multiply(x, M, evaluator, galois_keys);
+        add_bias_inplace(x, layers_[i].bias, encoder_, evaluator, stride_);
+        activate_inplace(x, layers_[i].activation, M.cols, evaluator, relin_keys);
+    }
+    return x;
+}
+
+}  // namespace seal_common
@@ -0,0 +1,118 @@
+// examples/seal-common/seal_mlp.h
+//
+// Encrypted inference for small dense networks (CKKS), built on the
+// diagonal kernels of seal_linalg.h.
+//
+// A network is a list of dense layers, each v -> act(v * W + b) with a
+// polynomial activation of degree at most 3. Every operation that needs a
+// rescale takes one level of the modulus chain: the matrix product takes
+// one, a square activation one, and any other polynomial two. The network
+// knows its depth up front, so network_parameters() sizes the chain (and
+// the polynomial degree) for it, and each layer's weights are encoded at
+// the level its input arrives at, with inputs mod-switched down where two
+// terms of an activation meet.
+//
+// Samples are packed as in seal_linalg.h, one per block of stride slots,
+// so a ciphertext carries slot_count / stride samples through the whole
+// network. The result of a layer sits in the first m slots of its block;
+// before the next layer it is replicated along the block with rotations
+// (no level), and the stride is chosen so the copies never reach the next
+// block.
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+#include <seal/seal.h>
+
+#include "seal_linalg.h"
+
+namespace seal_common {
+
+// c[0] + c[1] x + c[2] x^2 + c[3] x^3
+struct Activation {
+    std::string name;
+    std::vector<double> coeffs;
+
+    // none, square, relu (a quadratic fit on [-4, 4]) or sigmoid (a cubic
+    // fit on [-5, 5]); throws for anything else
+    static Activation named(const std::string& name);
+
+    // Levels the activation takes: 0, 1 for x^2 alone, 2 otherwise
+    size_t depth() const;
+
+    double operator()(double x) const;
+};
+
+struct DenseLayer {
+    std::vector<std::vector<double>> weights;  // inputs x outputs
+    std::vector<double> bias;                  // outputs
+    Activation activation;
+};
+
+// Reads layers in the text format of the examples:
+//
+//     layer <inputs> <outputs> <activation> [<c0> <c1> <c2> <c3> for poly]
+//     <inputs> rows of <outputs> weights
+//     <outputs> bias values
+//
+// with # comments. Throws on malformed input or mismatched shapes.
+std::vector<DenseLayer> load_network(std::istream& in);
+std::vector<DenseLayer> load_network(const std::string& path);
+
+// Levels the whole network takes
+size_t network_depth(const std::vector<DenseLayer>& layers);
+
+// Slots per sample: fits every layer and every replication between layers
+size_t network_stride(const std::vector<DenseLayer>& layers);
+
+// CKKS parameters for the network: a special and a first prime of 60 bits
+// around one prime of scale_bits per level, at the smallest polynomial
+// degree whose security bound and slot count allow it
+seal::EncryptionParameters network_parameters(
+    const std::vector<DenseLayer>& layers, int scale_bits = 40);
+
+// The layers in the clear, for checking results
+std::vector<double> infer_plain(const std::vector<DenseLayer>& layers, std::vector<double> v);
+
+class EncryptedNetwork {
+  public:
+    // Encodes the weights for a context made by network_parameters()
+    EncryptedNetwork(
+        const std::vector<DenseLayer>& layers, const seal::SEALContext& context,
+        const seal::CKKSEncoder& encoder, double scale);
+
+    // The rotations infer() uses, for create_galois_keys(steps)
+    std::vector<int> rotation_steps() const;
+
+    // Samples one ciphertext carries
+    size_t batch_size() const { return encoded_.front().blocks; }
+    size_t inputs() const { return layers_.front().weights.size(); }
+    size_t outputs() const { return layers_.back().bias.size(); }
+
+    // Encrypts up to batch_size() samples
+    seal::Ciphertext encrypt(
+        const std::vector<std::vector<double>>& samples, const seal::Encryptor& encryptor) const;
+
+    seal::Ciphertext infer(
+        const seal::Ciphertext& x, const seal::Evaluator& evaluator,
+        const seal::RelinKeys& relin_keys, const seal::GaloisKeys& galois_keys) const;
+
+    std::vector<std::vector<double>> decrypt(
+        const seal::Ciphertext& y, size_t count, seal::Decryptor& decryptor) const;
+
+  private:
+    void activate_inplace(
+        seal::Ciphertext& x, const Activation& activation, size_t width,
+        const seal::Evaluator& evaluator, const seal::RelinKeys& relin_keys) const;
+
+    const seal::SEALContext& context_;
+    const seal::CKKSEncoder& encoder_;
+    double scale_;
+    size_t stride_;
+    std::vector<DenseLayer> layers_;
+    std::vector<EncodedMatrix> encoded_;
+};
+
+}  // namespace seal_common
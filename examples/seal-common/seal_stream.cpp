@@ -0,0 +1,91 @@
+// examples/seal-common/seal_stream.cpp
+#include "seal_stream.h"
+
+#include <stdexcept>
+
+using namespace std;
+using namespace seal;
+
+namespace seal_common {
+
+// A frame larger than this is a corrupt or hostile stream
+static const uint64_t max_frame = uint64_t(1) << 30;
+
+compr_mode_type stream_compr_mode() {
+    if (Serialization::IsSupportedComprMode(compr_mode_type::zstd)) {
+        return compr_mode_type::zstd;
+    }
+    return Serialization::compr_mode_default;
+}
+
+ObjectReader::ObjectReader(int fd, size_t half_size) {
+    if (edge_stream_open(&stream_, fd, EDGE_STREAM_INGEST, half_size) != 0) {
+        throw runtime_error("cannot open the input stream");
+    }
+    open_ = true;
+}
+
+ObjectReader::~ObjectReader() {
+    if (open_) {
+        edge_stream_close(&stream_);
+    }
+}
+
+bool ObjectReader::next_frame() {
+    uint64_t size;
+    ssize_t n = edge_stream_read(&stream_, &size, sizeof(size));
+    if (n == 0) {
+        return false;
+    }
+    if (n != sizeof(size) || size > max_frame) {
+        throw runtime_error("malformed input stream");
+    }
+    frame_.resize(static_cast<size_t>(size));
+    if (edge_stream_read(&stream_, frame_.data(), frame_.size()) != static_cast<ssize_t>(size)) {
+        throw runtime_error("truncated input stream");
+    }
+    bytes_ += sizeof(size) + size;
+    return true;
+}
+
+void ObjectReader::close() {
+    if (open_) {
+        open_ = false;
+        if (edge_stream_close(&stream_) != 0) {
+            throw runtime_error("reading the input stream failed");
+        }
+    }
+}
+
+ObjectWriter::ObjectWriter(int fd, size_t half_size) : compr_mode_(stream_compr_mode()) {
+    if (edge_stream_open(&stream_, fd, EDGE_STREAM_EGRESS, half_size) != 0) {
+        throw runtime_error("cannot open the output stream");
+    }
+    open_ = true;
+}
+
+ObjectWriter::~ObjectWriter() {
+    if (open_) {
+        edge_stream_close(&stream_);
+    }
+}
+
+void ObjectWriter::put_frame(size_t size) {
+    uint64_t header = size;
+    if (edge_stream_write(&stream_, &header, sizeof(header)) != sizeof(header) ||
+        edge_stream_write(&stream_, frame_.data(), size) != static_cast<ssize_t>(size)) {
+        throw runtime_error("writing the output stream failed");
+    }
+    bytes_ += sizeof(header) + size;
+}
+
+void ObjectWriter::close() {
+    if (open_) {
+        open_ = false;
+        if (edge_stream_close(&stream_) != 0) {
+            throw runtime_error("writing the output stream failed");
+        }
+    }
+}
+
+}  // namespace seal_common
@@ -0,0 +1,84 @@
+// examples/seal-common/seal_stream.h
+//
+// SEAL objects in and out of the enclave in bulk, over the shared-buffer
+// streams of app/stream.h: a host thread reads or writes the file while
+// the enclave (de)serializes, so there is no enclave exit per object.
+//
+// Each object is framed by its serialized size (uint64_t) and saved with
+// zstd when SEAL was built with it. The framing and the objects come from
+// the host and are not authenticated; load() checks that what it gets is
+// a valid object for the context, which is what ciphertexts need.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <seal/seal.h>
+
+#include "app/stream.h"
+
+namespace seal_common {
+
+// The compression mode the writers use: zstd if available
+seal::compr_mode_type stream_compr_mode();
+
+class ObjectReader {
+  public:
+    // fd is a host descriptor from the proxied open(); half_size 0 picks
+    // the stream default. Throws if the stream cannot be opened.
+    explicit ObjectReader(int fd, size_t half_size = 0);
+    ~ObjectReader();
+
+    // Loads the next object; false at the end of the stream
+    template <typename T>
+    bool read(const seal::SEALContext& context, T& object) {
+        if (!next_frame()) {
+            return false;
+        }
+        object.load(context, frame_.data(), frame_.size());
+        return true;
+    }
+
+    // Serialized bytes read so far, framing included
+    size_t bytes() const { return bytes_; }
+
+    void close();
+
+  private:
+    bool next_frame();
+
+    edge_stream stream_;
+    std::vector<seal::seal_byte> frame_;
+    size_t bytes_ = 0;
+    bool open_ = false;
+};
+
+class ObjectWriter {
+  public:
+    explicit ObjectWriter(int fd, size_t half_size = 0);
+    ~ObjectWriter();
+
+    template <typename T>
+    void write(const T& object) {
+        frame_.resize(static_cast<size_t>(object.save_size(compr_mode_)));
+        size_t size = static_cast<size_t>(
+            object.save(frame_.data(), frame_.size(), compr_mode_));
+        put_frame(size);
+    }
+
+    size_t bytes() const { return bytes_; }
+
+    // Waits for the host to write everything out; throws if it failed
+    void close();
+
+  private:
+    void put_frame(size_t size);
+
+    edge_stream stream_;
+    seal::compr_mode_type compr_mode_;
+    std::vector<seal::seal_byte> frame_;
+    size_t bytes_ = 0;
+    bool open_ = false;
+};
+
+}  // namespace seal_common
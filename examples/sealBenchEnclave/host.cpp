@@ -0,0 +1,47 @@
+#include "edge/edge_call.h"
+#include "host/keystone.h"
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Keystone;
+using namespace std;
+
+// Runs the benchmark natively first, then in the enclave, so both sets of
+// CSV rows end up on stdout, the native run's header first. The eapp is a
+// static Linux binary, so the host can run it as is.
+static bool run_native(const char* eapp) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl(eapp, eapp, (char*)NULL);
+        _exit(127);
+    }
+
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid &&
+           WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (!run_native(argv[1])) {
+        cerr << "native run of " << argv[1] << " failed" << endl;
+        return 1;
+    }
+
+    Enclave enclave;
+    Params params;
+    params.setFreeMemSize(1024 * 1024 * 256);  // MB, Galois keys for 16384
+    params.setUntrustedSize(1024 * 1024 * 4); // MB
+
+    enclave.init(argv[1], argv[2], argv[3], params);
+
+    enclave.registerOcallDispatch(incoming_call_dispatch);
+
+    edge_call_init_internals(
+        (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize()
+    );
+
+    enclave.run();
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include <seal/seal.h>
+#include "seal_linalg.h"
+
+using namespace std;
+using namespace seal;
+
+// Times every stage of a CKKS pipeline and of the diagonal matrix-vector
+// kernel, for each polynomial degree and matrix size, and prints one CSV
+// row per stage. The same static binary runs both on the host Linux and
+// in Eyrie (see host.cpp), which starts it with argc == 0; the env column
+// tells the two apart, so the outputs can simply be concatenated.
+
+// Samples per stage; context setup and keygen take fewer
+static const size_t kIterations = 10;
+static const size_t kSetupIterations = 3;
+
+static const size_t kDegrees[] = { 4096, 8192, 16384 };
+static const size_t kMatrixSizes[] = { 4, 16, 32 };
+
+static const char* env;
+
+// A coefficient modulus with room for a rescale for each degree, within the
+// 128-bit security bound, and the scale of its data primes
+static vector<int> modulus_bits(size_t degree, int& scale_bits) {
+    switch (degree) {
+    case 4096:
+        scale_bits = 30;
+        return { 38, 30, 30 };
+    case 8192:
+        scale_bits = 40;
+        return { 60, 40, 40, 60 };
+    default:
+        scale_bits = 40;
+        return { 60, 40, 40, 40, 40, 60 };
+    }
+}
+
+// Runs setup and then stage iterations times, timing only stage
+static void time_stage(
+    size_t degree, const string& matrix, const char* stage, size_t iterations,
+    const function<void()>& setup, const function<void()>& run) {
+    vector<double> us;
+    for (size_t i = 0; i < iterations; i++) {
+        setup();
+        auto start = chrono::steady_clock::now();
+        run();
+        us.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+
+    sort(us.begin(), us.end());
+    double mean = 0;
+    for (double t : us) {
+        mean += t;
+    }
+    mean /= us.size();
+    printf("%s,ckks,%zu,%s,%s,%zu,%.1f,%.1f,%.1f,%.1f\n",
+           env, degree, matrix.c_str(), stage, us.size(),
+           us.front(), us[us.size() / 2], mean, us.back());
+}
+
+static vector<double> random_vector(size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<double> v(n);
+    for (auto& x : v) {
+        x = dist(rng);
+    }
+    return v;
+}
+
+static void bench_degree(size_t degree) {
+    int scale_bits;
+    vector<int> bits = modulus_bits(degree, scale_bits);
+    double scale = pow(2.0, scale_bits);
+    mt19937_64 rng(degree);
+    auto nop = [] {};
+
+    EncryptionParameters parms(scheme_type::ckks);
+    parms.set_poly_modulus_degree(degree);
+    parms.set_coeff_modulus(CoeffModulus::Create(degree, bits));
+
+    time_stage(degree, "", "context", kSetupIterations, nop, [&] { SEALContext context(parms); });
+    SEALContext context(parms);
+
+    // Key generation: the key pair, relinearization keys and the one
+    // rotation the rotate stage uses
+    SecretKey secret_key;
+    PublicKey public_key;
+    RelinKeys relin_keys;
+    GaloisKeys galois_keys;
+    time_stage(degree, "", "keygen", kSetupIterations, nop, [&] {
+        KeyGenerator keygen(context);
+        secret_key = keygen.secret_key();
+        keygen.create_public_key(public_key);
+        keygen.create_relin_keys(relin_keys);
+        keygen.create_galois_keys(vector<int>{ 1 }, galois_keys);
+    });
+
+    CKKSEncoder encoder(context);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+    Decryptor decryptor(context, secret_key);
+
+    vector<double> values = random_vector(encoder.slot_count(), rng);
+    Plaintext plain;
+    Ciphertext x, y, product, result;
+
+    time_stage(degree, "", "encode", kIterations, nop, [&] { encoder.encode(values, scale, plain); });
+    time_stage(degree, "", "encrypt", kIterations, nop, [&] { encryptor.encrypt(plain, x); });
+    encryptor.encrypt(plain, y);
+    time_stage(degree, "", "multiply", kIterations, nop, [&] { evaluator.multiply(x, y, product); });
+    time_stage(degree, "", "relinearize", kIterations,
+               [&] { result = product; }, [&] { evaluator.relinearize_inplace(result, relin_keys); });
+    evaluator.relinearize_inplace(product, relin_keys);
+    time_stage(degree, "", "rescale", kIterations,
+               [&] { result = product; }, [&] { evaluator.rescale_to_next_inplace(result); });
+    time_stage(degree, "", "rotate", kIterations, nop, [&] { evaluator.rotate_vector(x, 1, galois_keys, result); });
+    time_stage(degree, "", "decrypt", kIterations, nop, [&] { decryptor.decrypt(x, plain); });
+    time_stage(degree, "", "decode", kIterations, nop, [&] { encoder.decode(plain, values); });
+
+    // The matrix-vector kernel of the MatMul and MLP examples, with the
+    // Galois keys for exactly the rotations each matrix needs
+    for (size_t n : kMatrixSizes) {
+        string matrix = to_string(n) + "x" + to_string(n);
+        vector<vector<double>> M(n);
+        for (auto& row : M) {
+            row = random_vector(n, rng);
+        }
+        size_t stride = seal_common::packed_stride(n, n);
+
+        seal_common::EncodedMatrix encoded;
+        time_stage(degree, matrix, "encode_matrix", kSetupIterations, nop, [&] {
+            encoded = seal_common::encode_matrix(M, context, encoder, context.first_parms_id(), stride);
+        });
+
+        GaloisKeys matrix_keys;
+        KeyGenerator keygen(context, secret_key);
+        time_stage(degree, matrix, "galois_keygen", kSetupIterations, nop, [&] {
+            keygen.create_galois_keys(seal_common::rotation_steps(encoded), matrix_keys);
+        });
+
+        vector<vector<double>> batch(encoded.blocks, random_vector(n, rng));
+        time_stage(degree, matrix, "encrypt_batch", kIterations, nop, [&] {
+            x = seal_common::encrypt_batch(batch, encoded, encoder, encryptor, scale);
+        });
+        time_stage(degree, matrix, "matvec", kIterations, nop, [&] {
+            result = seal_common::multiply(x, encoded, evaluator, matrix_keys);
+        });
+        time_stage(degree, matrix, "decrypt_batch", kIterations, nop, [&] {
+            seal_common::decrypt_batch(result, encoded.blocks, n, stride, decryptor, encoder);
+        });
+    }
+}
+
+int main(int argc, char**) {
+    // Eyrie starts the eapp without arguments, not even argv[0]. The
+    // header comes with the native run, which the runner starts first.
+    env = argc == 0 ? "enclave" : "native";
+
+    if (argc > 0) {
+        printf("env,scheme,poly_modulus_degree,matrix,stage,n,min_us,median_us,mean_us,max_us\n");
+    }
+    for (size_t degree : kDegrees) {
+        bench_degree(degree);
+        fflush(stdout);
+    }
+    return 0;
+}
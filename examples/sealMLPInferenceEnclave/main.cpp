@@ -0,0 +1,99 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <seal/seal.h>
+#include "seal_keystore.h"
+#include "seal_mlp.h"
+
+using namespace std;
+using namespace seal;
+
+// Ciphertexts of samples pushed through the network
+static const size_t kBatches = 8;
+
+static double ms_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    vector<seal_common::DenseLayer> layers = seal_common::load_network("network.txt");
+
+    // The chain and the degree follow from the network
+    int scale_bits = 40;
+    EncryptionParameters parms = seal_common::network_parameters(layers, scale_bits);
+    double scale = pow(2.0, scale_bits);
+    SEALContext context(parms);
+
+    Evaluator evaluator(context);
+    CKKSEncoder encoder(context);
+
+    cout << "Network:";
+    for (const auto& layer : layers) {
+        cout << " " << layer.weights.size() << "-" << layer.bias.size() << " " << layer.activation.name;
+    }
+    cout << endl << "Depth " << seal_common::network_depth(layers)
+         << ", poly_modulus_degree " << parms.poly_modulus_degree()
+         << ", " << parms.coeff_modulus().size() << " primes" << endl;
+
+    auto start = chrono::steady_clock::now();
+    seal_common::EncryptedNetwork network(layers, context, encoder, scale);
+    cout << "Weights encoded in " << ms_since(start) << " ms, "
+         << network.batch_size() << " samples per ciphertext" << endl;
+
+    seal_common::KeySet keys = seal_common::load_or_create_keys(
+        context, network.rotation_steps(), "sealMLPInferenceEnclave.keys");
+    Encryptor encryptor(context, keys.public_key);
+    Decryptor decryptor(context, keys.secret_key);
+
+    mt19937_64 rng(46);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    double encrypt_ms = 0, infer_ms = 0, decrypt_ms = 0, max_error = 0;
+    size_t samples = 0;
+
+    for (size_t b = 0; b < kBatches; b++) {
+        vector<vector<double>> batch(network.batch_size(), vector<double>(network.inputs()));
+        for (auto& sample : batch) {
+            for (auto& x : sample) {
+                x = dist(rng);
+            }
+        }
+
+        start = chrono::steady_clock::now();
+        Ciphertext x = network.encrypt(batch, encryptor);
+        encrypt_ms += ms_since(start);
+
+        start = chrono::steady_clock::now();
+        Ciphertext y = network.infer(x, evaluator, keys.relin_keys, keys.galois_keys);
+        infer_ms += ms_since(start);
+
+        start = chrono::steady_clock::now();
+        vector<vector<double>> result = network.decrypt(y, batch.size(), decryptor);
+        decrypt_ms += ms_since(start);
+
+        for (size_t p = 0; p < batch.size(); p++) {
+            vector<double> expected = seal_common::infer_plain(layers, batch[p]);
+            for (size_t c = 0; c < expected.size(); c++) {
+                max_error = max(max_error, fabs(result[p][c] - expected[c]));
+            }
+        }
+        samples += batch.size();
+    }
+
+    double total_ms = encrypt_ms + infer_ms + decrypt_ms;
+    cout << fixed << setprecision(3)
+         << "Samples: " << samples << " in " << kBatches << " ciphertexts" << endl
+         << "Latency per ciphertext: encrypt " << encrypt_ms / kBatches
+         << " ms, inference " << infer_ms / kBatches
+         << " ms, decrypt " << decrypt_ms / kBatches << " ms" << endl
+         << "Amortized latency per sample: " << total_ms / samples << " ms ("
+         << infer_ms / samples << " ms inference)" << endl
+         << setprecision(1) << "Throughput: " << samples / (total_ms / 1000) << " samples/s ("
+         << samples / (infer_ms / 1000) << " samples/s inference)" << endl
+         << scientific << setprecision(3) << "Max error against the plaintext network: "
+         << max_error << endl;
+
+    return 0;
+}
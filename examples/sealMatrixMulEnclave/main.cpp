@@ -2,6 +2,8 @@
 #include <vector>
 #include <seal/seal.h>
 #include <iomanip>
+#include "seal_keystore.h"
+#include "seal_linalg.h"
 
 using namespace std;
 using namespace seal;
@@ -17,78 +19,23 @@ void print_matrix(const vector<vector<uint64_t>>& matrix, const string& label) {
     }
 }
 
-// Set the diagonals of the matrix 
-vector<vector<uint64_t>> prepare_matrix_diagonals(const vector<vector<uint64_t>>& M, size_t slot_count) {
-    size_t rows = M.size();
-    size_t cols = M[0].size();
-    vector<vector<uint64_t>> diagonals(rows, vector<uint64_t>(slot_count, 0ULL));
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < slot_count; ++j) {
-            diagonals[i][j] = M[(j + i) % rows][j % cols];
-        }
-    }
-    return diagonals;
-}
-
-// Pad and encrypt a vector row-wise
-Ciphertext prepare_vector(const vector<uint64_t>& v, const BatchEncoder& batch_encoder, const Encryptor& encryptor) {
-    size_t slot_count = batch_encoder.slot_count();
-    vector<uint64_t> padded_v(slot_count, 0ULL);
-    for (size_t i = 0; i < slot_count; ++i) {
-        padded_v[i] = v[i % v.size()];
-    }
-    Plaintext plain_v;
-    batch_encoder.encode(padded_v, plain_v);
-    Ciphertext encrypted_v;
-    encryptor.encrypt(plain_v, encrypted_v);
-    return encrypted_v;
-}
-
+// A * B with the rows of A packed B_encoded.blocks to a ciphertext, so
+// each multiply() handles a whole batch of rows
 vector<Ciphertext> fhe_matrix_matrix_multiplication(
     const vector<vector<uint64_t>>& A,
-    const vector<vector<uint64_t>>& B,
+    const seal_common::EncodedMatrix& B_encoded,
     const BatchEncoder& batch_encoder,
     const Encryptor& encryptor,
     const Evaluator& evaluator,
     const GaloisKeys& galois_keys) {
     
     vector<Ciphertext> result;
-    vector<vector<uint64_t>> B_diagonals = prepare_matrix_diagonals(B, batch_encoder.slot_count());
-
-    size_t A_rows = A.size();
-    size_t B_rows = B.size();
-    size_t B_cols = B[0].size();
-
-    for (size_t row_index = 0; row_index < A_rows; row_index++) {
-        Ciphertext encrypted_row = prepare_vector(A[row_index], batch_encoder, encryptor);
-        Ciphertext row_result;
-
-        // Vector-matrix multiplication logic
-        for (size_t i = 0; i < B_rows; ++i) {
-            //encrypt the diagonal
-            Plaintext plain_diag;
-            batch_encoder.encode(B_diagonals[i], plain_diag);
-            Ciphertext encrypted_diag;
-            encryptor.encrypt(plain_diag, encrypted_diag);
-
-            // Multiply the encrypted vector with the encrypted diagonal
-            Ciphertext temp;
-            evaluator.multiply(encrypted_row, encrypted_diag, temp);
-
-            // Add the result of the multiplication to the accumulator
-            if (i == 0) {
-                row_result = temp;
-            } else {
-                evaluator.add_inplace(row_result, temp);
-            }
-
-            // Rotate the encrypted vector
-            if (i < B_rows - 1) {
-                evaluator.rotate_rows_inplace(encrypted_row, 1, galois_keys);
-            }
-        }
 
-        result.push_back(row_result);
+    for (size_t first = 0; first < A.size(); first += B_encoded.blocks) {
+        size_t last = min(A.size(), first + B_encoded.blocks);
+        vector<vector<uint64_t>> rows(A.begin() + first, A.begin() + last);
+        Ciphertext encrypted_rows = seal_common::encrypt_batch(rows, B_encoded, batch_encoder, encryptor);
+        result.push_back(seal_common::multiply(encrypted_rows, B_encoded, evaluator, galois_keys));
     }
 
     return result;
@@ -102,18 +49,7 @@ int main() {
     parms.set_plain_modulus(PlainModulus::Batching(poly_modulus_degree, 20));
     SEALContext context(parms);
 
-    KeyGenerator keygen(context);
-    SecretKey secret_key = keygen.secret_key();
-    PublicKey public_key;
-    keygen.create_public_key(public_key);
-    RelinKeys relin_keys;
-    keygen.create_relin_keys(relin_keys);
-    GaloisKeys galois_keys;
-    keygen.create_galois_keys(galois_keys);
-
-    Encryptor encryptor(context, public_key);
     Evaluator evaluator(context);
-    Decryptor decryptor(context, secret_key);
     BatchEncoder batch_encoder(context);
 
     // Example matrices
@@ -138,18 +74,30 @@ int main() {
 
     cout << "\nPerforming encrypted matrix-matrix multiplication..." << endl;
 
-    vector<Ciphertext> encrypted_result = fhe_matrix_matrix_multiplication(A, B, batch_encoder, encryptor, evaluator, galois_keys);
+    // B's diagonals are encoded once, for blocks just wide enough for a row
+    size_t stride = seal_common::packed_stride(B.size(), B[0].size());
+    seal_common::EncodedMatrix B_encoded =
+        seal_common::encode_matrix(B, context, batch_encoder, evaluator, stride);
+    cout << "Rows of A per ciphertext: " << B_encoded.blocks << endl;
+
+    // Only the rotations B needs get Galois keys, and the key set is sealed
+    // to the host so later runs skip keygen
+    seal_common::KeySet keys = seal_common::load_or_create_keys(
+        context, seal_common::rotation_steps(B_encoded), "sealMatrixMulEnclave.keys");
+    Encryptor encryptor(context, keys.public_key);
+    Decryptor decryptor(context, keys.secret_key);
+
+    vector<Ciphertext> encrypted_result = fhe_matrix_matrix_multiplication(A, B_encoded, batch_encoder, encryptor, evaluator, keys.galois_keys);
     
     cout << "\nEncrypted computation complete." << endl;
 
     // Decrypt and print the result
     vector<vector<uint64_t>> final_result;
-    for (const auto& enc_row : encrypted_result) {
-        Plaintext plain_row;
-        decryptor.decrypt(enc_row, plain_row);
-        vector<uint64_t> dec_row;
-        batch_encoder.decode(plain_row, dec_row);
-        final_result.push_back(vector<uint64_t>(dec_row.begin(), dec_row.begin() + B[0].size()));
+    for (size_t k = 0; k < encrypted_result.size(); k++) {
+        size_t count = min(A.size() - k * B_encoded.blocks, B_encoded.blocks);
+        vector<vector<uint64_t>> rows = seal_common::decrypt_batch(
+            encrypted_result[k], count, B[0].size(), B_encoded.stride, decryptor, batch_encoder);
+        final_result.insert(final_result.end(), rows.begin(), rows.end());
     }
 
     cout << "\nFinal result of A * B:" << endl;
@@ -88,8 +88,9 @@ int main()
     encryptor.encrypt(plain_matrix, encrypted_matrix);
     cout << "    + Noise budget in fresh encryption: " << decryptor.invariant_noise_budget(encrypted_matrix) << " bits" << endl << endl;
 
+    // Keys for just the rotations below; step 0 is the column swap
     GaloisKeys galois_keys;
-    keygen.create_galois_keys(galois_keys);
+    keygen.create_galois_keys(vector<int>{ 3, -4, 0 }, galois_keys);
 
     cout << "Rotate rows 3 steps left." << endl;
     evaluator.rotate_rows_inplace(encrypted_matrix, 3, galois_keys);
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cmath>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include <seal/seal.h>
+#include "seal_keystore.h"
+#include "seal_linalg.h"
+#include "seal_stream.h"
+
+using namespace std;
+using namespace seal;
+
+// Encrypted batches pushed through the layer
+static const size_t kCiphertexts = 2048;
+// Bytes per half of the stream rings
+static const size_t kHalfSize = 1024 * 1024;
+
+static const char* kInputs = "inputs.ct";
+static const char* kOutputs = "outputs.ct";
+
+static double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* label, size_t bytes_in, size_t bytes_out, size_t count, double seconds) {
+    double mb = (bytes_in + bytes_out) / (1024.0 * 1024.0);
+    cout << fixed << setprecision(2) << label << ": "
+         << bytes_in / (1024.0 * 1024.0) << " MB in, "
+         << bytes_out / (1024.0 * 1024.0) << " MB out, "
+         << count << " ciphertexts in " << seconds << " s ("
+         << mb / seconds << " MB/s, " << count / seconds << " ciphertexts/s)" << endl;
+}
+
+static int open_or_die(const char* path, int flags) {
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        cerr << "cannot open " << path << endl;
+        exit(1);
+    }
+    return fd;
+}
+
+// Input batch i: deterministic, so the results can be checked afterwards
+static vector<vector<double>> make_batch(size_t i, size_t count, size_t length) {
+    mt19937_64 rng(i);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<vector<double>> batch(count, vector<double>(length));
+    for (auto& v : batch) {
+        for (auto& x : v) {
+            x = dist(rng);
+        }
+    }
+    return batch;
+}
+
+int main() {
+    EncryptionParameters parms(scheme_type::ckks);
+    size_t poly_modulus_degree = 8192;
+    parms.set_poly_modulus_degree(poly_modulus_degree);
+    parms.set_coeff_modulus(CoeffModulus::Create(poly_modulus_degree, { 60, 40, 60 }));
+    double scale = pow(2.0, 40);
+    SEALContext context(parms);
+
+    Evaluator evaluator(context);
+    CKKSEncoder encoder(context);
+
+    // The layer of sealMLPsmallEnclave
+    vector<vector<double>> weights = {
+        {1.0, 2.0, 3.0, 4.0, 5.0},
+        {3.0, 4.0, 5.0, 6.0, 7.0},
+        {5.0, 6.0, 7.0, 8.0, 9.0}
+    };
+    vector<double> bias = {0.1, 0.2, 0.3, 0.4, 0.5};
+    size_t rows = weights.size(), cols = weights[0].size();
+
+    size_t stride = seal_common::packed_stride(rows, cols);
+    seal_common::EncodedMatrix encoded_weights =
+        seal_common::encode_matrix(weights, context, encoder, context.first_parms_id(), stride);
+    size_t per_ct = encoded_weights.blocks;
+
+    seal_common::KeySet keys = seal_common::load_or_create_keys(
+        context, seal_common::rotation_steps(encoded_weights), "sealStreamEnclave.keys");
+    Encryptor encryptor(context, keys.public_key);
+    Decryptor decryptor(context, keys.secret_key);
+
+    cout << "Compression: "
+         << (seal_common::stream_compr_mode() == compr_mode_type::zstd ? "zstd" : "none")
+         << ", " << per_ct << " inputs per ciphertext" << endl;
+
+    // 1. Encrypt the inputs and stream them out to the host
+    {
+        int fd = open_or_die(kInputs, O_WRONLY | O_CREAT | O_TRUNC);
+        auto start = chrono::steady_clock::now();
+        seal_common::ObjectWriter writer(fd, kHalfSize);
+        for (size_t i = 0; i < kCiphertexts; i++) {
+            writer.write(seal_common::encrypt_batch(make_batch(i, per_ct, rows), encoded_weights, encoder, encryptor, scale));
+        }
+        writer.close();
+        report("Encrypt and egress", 0, writer.bytes(), kCiphertexts, seconds_since(start));
+        close(fd);
+    }
+
+    // 2. Ingest alone, for the raw rate of the stream
+    {
+        int fd = open_or_die(kInputs, O_RDONLY);
+        auto start = chrono::steady_clock::now();
+        seal_common::ObjectReader reader(fd, kHalfSize);
+        Ciphertext x;
+        size_t count = 0;
+        while (reader.read(context, x)) {
+            count++;
+        }
+        reader.close();
+        report("Ingest", reader.bytes(), 0, count, seconds_since(start));
+        close(fd);
+    }
+
+    // 3. Stream the inputs through the layer and the results back out
+    {
+        int in = open_or_die(kInputs, O_RDONLY);
+        int out = open_or_die(kOutputs, O_WRONLY | O_CREAT | O_TRUNC);
+        auto start = chrono::steady_clock::now();
+        seal_common::ObjectReader reader(in, kHalfSize);
+        seal_common::ObjectWriter writer(out, kHalfSize);
+        Ciphertext x;
+        size_t count = 0;
+        while (reader.read(context, x)) {
+            Ciphertext y = seal_common::multiply(x, encoded_weights, evaluator, keys.galois_keys);
+            seal_common::add_bias_inplace(y, bias, encoder, evaluator, stride);
+            writer.write(y);
+            count++;
+        }
+        // the rings are freed in the reverse order of opening
+        writer.close();
+        reader.close();
+        report("Ingest, layer and egress", reader.bytes(), writer.bytes(), count, seconds_since(start));
+        close(out);
+        close(in);
+    }
+
+    // 4. Check the first results against the layer in the clear
+    {
+        int fd = open_or_die(kOutputs, O_RDONLY);
+        seal_common::ObjectReader reader(fd, kHalfSize);
+        Ciphertext y;
+        double max_error = 0;
+        for (size_t i = 0; i < 4 && reader.read(context, y); i++) {
+            vector<vector<double>> batch = make_batch(i, per_ct, rows);
+            vector<vector<double>> result = seal_common::decrypt_batch(y, per_ct, cols, stride, decryptor, encoder);
+            for (size_t p = 0; p < per_ct; p++) {
+                for (size_t c = 0; c < cols; c++) {
+                    double expected = bias[c];
+                    for (size_t r = 0; r < rows; r++) {
+                        expected += batch[p][r] * weights[r][c];
+                    }
+                    max_error = max(max_error, fabs(result[p][c] - expected));
+                }
+            }
+        }
+        reader.close();
+        close(fd);
+        cout << scientific << setprecision(3) << "Max error: " << max_error << endl;
+    }
+
+    return 0;
+}
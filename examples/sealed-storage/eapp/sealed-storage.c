@@ -0,0 +1,149 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "app/sealed_storage.h"
+
+/* Seals and unseals DATA_SIZE bytes in enclave memory for a few chunk
+ * sizes, then through a sealed file: streamed out and back in, and single
+ * chunks read at random offsets. Throughput is in GB/s at BENCH_CPU_MHZ. */
+
+#define FILE_NAME "sealed-storage.dat"
+#define DATA_SIZE (8 * 1024 * 1024)
+#define RANDOM_READS 64
+
+#ifndef BENCH_CPU_MHZ
+#define BENCH_CPU_MHZ 1000
+#endif
+
+static inline uint64_t
+rdcycle(void) {
+  uint64_t cycles;
+  __asm__ volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+
+static void
+print_rate(const char* what, size_t bytes, uint64_t cycles) {
+  // hundredths of a GB/s
+  uint64_t rate = (uint64_t)bytes * BENCH_CPU_MHZ / (cycles ? cycles * 10 : 1);
+  printf(
+      "%s\t%lu.%02lu GB/s\t%lu.%02lu cycles/byte\n", what,
+      (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+      (unsigned long)(cycles / bytes),
+      (unsigned long)(cycles * 100 / bytes % 100));
+}
+
+static int
+bench_memory(
+    const struct sealed_key* key, size_t chunk_size, const uint8_t* data,
+    uint8_t* sealed, uint8_t* out) {
+  size_t size = sealed_size(DATA_SIZE, chunk_size);
+  char what[32];
+  uint64_t cycles;
+
+  cycles = rdcycle();
+  if (sealed_seal(key, chunk_size, data, DATA_SIZE, sealed) != 0) return -1;
+  cycles = rdcycle() - cycles;
+  snprintf(what, sizeof(what), "seal %zuK", chunk_size / 1024);
+  print_rate(what, DATA_SIZE, cycles);
+
+  cycles = rdcycle();
+  if (sealed_unseal(key, sealed, size, out, DATA_SIZE) != DATA_SIZE) return -1;
+  cycles = rdcycle() - cycles;
+  snprintf(what, sizeof(what), "unseal %zuK", chunk_size / 1024);
+  print_rate(what, DATA_SIZE, cycles);
+
+  return memcmp(data, out, DATA_SIZE) == 0 ? 0 : -1;
+}
+
+static int
+bench_file(const struct sealed_key* key, const uint8_t* data, uint8_t* out) {
+  struct sealed_writer writer;
+  struct sealed_reader reader;
+  struct sealed_object obj;
+  uint64_t cycles, index;
+  ssize_t n;
+  size_t done;
+  int i, fd = open(FILE_NAME, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  if (fd < 0) return -1;
+
+  cycles = rdcycle();
+  if (sealed_writer_open(&writer, key, fd, SEALED_CHUNK_DEFAULT) != 0 ||
+      sealed_writer_write(&writer, data, DATA_SIZE) != DATA_SIZE ||
+      sealed_writer_close(&writer) != 0)
+    goto fail;
+  cycles = rdcycle() - cycles;
+  print_rate("file write", DATA_SIZE, cycles);
+
+  if (lseek(fd, 0, SEEK_SET) != 0) goto fail;
+  cycles = rdcycle();
+  if (sealed_reader_open(&reader, key, fd) != 0) goto fail;
+  for (done = 0; (n = sealed_reader_read(&reader, out + done, 1024 * 1024)) > 0;)
+    done += n;
+  if (sealed_reader_close(&reader) != 0 || n < 0 || done != DATA_SIZE) goto fail;
+  cycles = rdcycle() - cycles;
+  print_rate("file read", DATA_SIZE, cycles);
+  if (memcmp(data, out, DATA_SIZE) != 0) goto fail;
+
+  if (sealed_open_file(&obj, key, fd) != 0) goto fail;
+  cycles = rdcycle();
+  for (i = 0, index = 7; i < RANDOM_READS; i++) {
+    index = (index * 6364136223846793005ULL + 1442695040888963407ULL);
+    if (sealed_read_chunk(&obj, fd, (index >> 33) % obj.chunks, out) !=
+        SEALED_CHUNK_DEFAULT)
+      goto fail;
+  }
+  cycles = rdcycle() - cycles;
+  print_rate("chunk read", RANDOM_READS * SEALED_CHUNK_DEFAULT, cycles);
+  sealed_close(&obj);
+
+  close(fd);
+  return unlink(FILE_NAME);
+
+fail:
+  close(fd);
+  unlink(FILE_NAME);
+  return -1;
+}
+
+int
+main() {
+  static const size_t chunks[] = {4096, SEALED_CHUNK_DEFAULT, 1024 * 1024};
+  static const char ident[]    = "sealed-storage";
+  struct sealed_key key;
+  uint8_t *data, *sealed, *out;
+  size_t i;
+
+  data   = malloc(DATA_SIZE);
+  sealed = malloc(sealed_size(DATA_SIZE, chunks[0]));
+  out    = malloc(DATA_SIZE + SEALED_TAG_SIZE);
+  if (!data || !sealed || !out) {
+    printf("out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < DATA_SIZE; i++) data[i] = (uint8_t)(i * 31 + 7);
+
+  if (sealed_key_init(&key, ident, sizeof(ident)) != 0) {
+    printf("no sealing key\n");
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+    if (bench_memory(&key, chunks[i], data, sealed, out) != 0) {
+      printf("sealing in %zu byte chunks failed\n", chunks[i]);
+      return 1;
+    }
+  }
+  if (bench_file(&key, data, out) != 0) {
+    printf("sealing %s failed\n", FILE_NAME);
+    return 1;
+  }
+
+  sealed_key_clear(&key);
+  return 0;
+}
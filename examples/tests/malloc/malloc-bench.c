@@ -0,0 +1,209 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "app/eapp_utils.h"
+#include "app/malloc.h"
+#include "app/string.h"
+#include "app/syscall.h"
+
+/* Allocator microbenchmark. test-malloc-bench runs it on the allocator of
+ * libkeystone-eapp, test-malloc-bench-tiny on the tiny-malloc it replaced
+ * (tiny-malloc.c here, built with -DBENCH_TINY_MALLOC), so the two runs
+ * print comparable lines:
+ *
+ *   <allocator> <workload>: <ops/s> ops/s, peak <bytes> for <bytes> live
+ *
+ * ops/s counts cycles at BENCH_CPU_MHZ. The peak is the highest address a
+ * workload's blocks reach above __malloc_start: the tests' runtime has no
+ * mmap, so every block comes from the zone.
+ *
+ * BenchMalloc and BenchMallocTiny in sdk/tests build the same workloads
+ * for the build machine, see malloc_bench_host.c there. */
+
+#define OCALL_PRINT_BUFFER 1
+
+#ifndef BENCH_CPU_MHZ
+#define BENCH_CPU_MHZ 1000
+#endif
+
+#ifdef BENCH_TINY_MALLOC
+#define ALLOCATOR "tiny"
+#else
+#define ALLOCATOR "slab"
+#endif
+
+#define SLOTS 1024
+
+extern char* __malloc_start;
+
+static void* slot[SLOTS];
+static size_t slot_size[SLOTS];
+static size_t live, peak_live;
+static char* peak_end;
+static unsigned long rng = 88172645463325252UL;
+
+#ifdef __riscv
+static unsigned long
+read_cycles(void) {
+  unsigned long cycles;
+  asm volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+#else
+/* nanoseconds, which count as cycles at the default BENCH_CPU_MHZ */
+unsigned long
+read_cycles(void);
+#endif
+
+static unsigned long
+next_random(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return rng;
+}
+
+static void
+track_alloc(void* p, size_t size) {
+  if (!p) {
+    ocall(OCALL_PRINT_BUFFER, "allocation failed\n", 19, 0, 0);
+    EAPP_RETURN(1);
+  }
+  live += size;
+  if (live > peak_live) peak_live = live;
+  if ((char*)p + size > peak_end) peak_end = (char*)p + size;
+}
+
+static void
+set_slot(int i, void* p, size_t size) {
+  if (slot[i]) live -= slot_size[i];
+  track_alloc(p, size);
+  slot[i]      = p;
+  slot_size[i] = size;
+}
+
+static void
+free_slots(void) {
+  int i;
+  for (i = 0; i < SLOTS; i++) {
+    free(slot[i]);
+    slot[i] = NULL;
+  }
+  live = 0;
+}
+
+static char*
+append(char* out, const char* s) {
+  while (*s) *out++ = *s++;
+  return out;
+}
+
+static char*
+append_number(char* out, unsigned long n) {
+  char digits[20];
+  int len = 0;
+  do {
+    digits[len++] = '0' + n % 10;
+    n /= 10;
+  } while (n);
+  while (len) *out++ = digits[--len];
+  return out;
+}
+
+static void
+report(const char* workload, unsigned long ops, unsigned long cycles) {
+  char line[128];
+  char* out = line;
+
+  out = append(out, ALLOCATOR " ");
+  out = append(out, workload);
+  out = append(out, ": ");
+  out = append_number(out, ops * BENCH_CPU_MHZ * 1000000 / (cycles ? cycles : 1));
+  out = append(out, " ops/s, peak ");
+  out = append_number(out, peak_end - (char*)&__malloc_start);
+  out = append(out, " for ");
+  out = append_number(out, peak_live);
+  out = append(out, " live\n");
+  *out++ = '\0';
+  ocall(OCALL_PRINT_BUFFER, line, out - line, 0, 0);
+
+  peak_live = live;
+  peak_end  = (char*)&__malloc_start;
+}
+
+/* 1000 objects of one size, allocated and freed in order */
+static unsigned long
+churn(void) {
+  int round, i;
+  for (round = 0; round < 200; round++) {
+    for (i = 0; i < 1000; i++) set_slot(i, malloc(48), 48);
+    free_slots();
+  }
+  return 200 * 2000;
+}
+
+/* random sizes up to 1KB replacing each other in random slots */
+static unsigned long
+mixed(void) {
+  int op;
+  for (op = 0; op < 100000; op++) {
+    int i       = next_random() % SLOTS;
+    size_t size = 16 + next_random() % 1008;
+    free(slot[i]);
+    set_slot(i, malloc(size), size);
+  }
+  free_slots();
+  return 100000;
+}
+
+/* buffers grown by doubling, as vectors and strings are */
+static unsigned long
+grow(void) {
+  int round, i;
+  unsigned long ops = 0;
+  for (round = 0; round < 50; round++) {
+    for (i = 0; i < 8; i++) {
+      size_t size;
+      for (size = 16; size <= 64 * 1024; size *= 2) {
+        set_slot(i, realloc(slot[i], size), size);
+        ops++;
+      }
+    }
+    free_slots();
+  }
+  return ops;
+}
+
+/* blocks of 16KB to 256KB, a few alive at a time */
+static unsigned long
+large(void) {
+  int op;
+  for (op = 0; op < 2000; op++) {
+    int i       = next_random() % 8;
+    size_t size = 16 * 1024 + next_random() % (240 * 1024);
+    free(slot[i]);
+    set_slot(i, malloc(size), size);
+  }
+  free_slots();
+  return 2000;
+}
+
+void EAPP_ENTRY
+eapp_entry() {
+  struct {
+    const char* name;
+    unsigned long (*run)(void);
+  } workloads[] = {
+      {"churn", churn}, {"mixed", mixed}, {"grow", grow}, {"large", large}};
+  unsigned int w;
+
+  peak_end = (char*)&__malloc_start;
+  for (w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+    unsigned long start = read_cycles();
+    unsigned long ops   = workloads[w].run();
+    report(workloads[w].name, ops, read_cycles() - start);
+  }
+
+  EAPP_RETURN(0);
+}
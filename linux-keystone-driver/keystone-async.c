@@ -0,0 +1,222 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <linux/eventfd.h>
+#include <linux/ktime.h>
+#include <linux/poll.h>
+#include <linux/version.h>
+#include <linux/timex.h>
+#include <linux/workqueue.h>
+#include "keystone.h"
+#include "keystone-sbi.h"
+#include "keystone_user.h"
+
+/* Asynchronous run/resume.
+ * Instead of blocking the calling thread in the SBI call, the ioctl queues
+ * it on an unbound workqueue and returns. Once the enclave stops (edge call,
+ * interrupt or exit) the result is parked in the enclave, the enclave file
+ * becomes readable for poll(), and the registered eventfd (if any) is
+ * signaled. The host then collects the result with ENCLAVE_EVENT. */
+static struct workqueue_struct *keystone_run_wq;
+
+int keystone_async_init(void)
+{
+  keystone_run_wq = alloc_workqueue("keystone_run", WQ_UNBOUND, 0);
+  if (!keystone_run_wq)
+    return -ENOMEM;
+  return 0;
+}
+
+void keystone_async_exit(void)
+{
+  if (keystone_run_wq)
+    destroy_workqueue(keystone_run_wq);
+}
+
+static void keystone_run_work(struct work_struct *work)
+{
+  struct sbiret ret;
+  struct enclave_async *async = container_of(work, struct enclave_async, work);
+  struct enclave *enclave = container_of(async, struct enclave, async);
+  u64 start = ktime_get_ns();
+  u64 stop_ticks;
+
+  if (async->resume)
+    ret = sbi_sm_resume_enclave(enclave->eid);
+  else
+    ret = sbi_sm_run_enclave(enclave->eid);
+  stop_ticks = get_cycles64();
+  keystone_stats_run(enclave, async->resume, ret, start);
+
+  /* signaled under the lock, so that the eventfd cannot be replaced and
+   * put in the meantime */
+  spin_lock(&async->lock);
+  async->error = ret.error;
+  async->value = ret.value;
+  async->stop_ticks = stop_ticks;
+  async->state = ENCLAVE_RUN_DONE;
+  if (async->eventfd) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+    eventfd_signal(async->eventfd);
+#else
+    eventfd_signal(async->eventfd, 1);
+#endif
+  }
+  spin_unlock(&async->lock);
+
+  wake_up_interruptible(&async->wq);
+}
+
+void enclave_async_init(struct enclave *enclave)
+{
+  struct enclave_async *async = &enclave->async;
+
+  INIT_WORK(&async->work, keystone_run_work);
+  init_waitqueue_head(&async->wq);
+  spin_lock_init(&async->lock);
+  async->eventfd = NULL;
+  async->state = ENCLAVE_RUN_IDLE;
+}
+
+void enclave_async_destroy(struct enclave *enclave)
+{
+  /* the SM cannot destroy an enclave while it is running */
+  flush_work(&enclave->async.work);
+
+  if (enclave->async.eventfd)
+    eventfd_ctx_put(enclave->async.eventfd);
+  enclave->async.eventfd = NULL;
+}
+
+bool enclave_async_busy(struct enclave *enclave)
+{
+  return READ_ONCE(enclave->async.state) == ENCLAVE_RUN_BUSY;
+}
+
+int keystone_run_enclave_async(unsigned long data, bool resume)
+{
+  struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
+  struct enclave *enclave;
+  struct enclave_async *async;
+
+  /* the workqueue could not be created when the module was loaded */
+  if (!keystone_run_wq)
+    return -ENODEV;
+
+  enclave = get_enclave_by_id(arg->eid);
+  if (!enclave) {
+    keystone_err("invalid enclave id\n");
+    return -EINVAL;
+  }
+
+  if (enclave->eid < 0) {
+    keystone_err("real enclave does not exist\n");
+    return -EINVAL;
+  }
+
+  async = &enclave->async;
+
+  /* the previous event must be collected first */
+  spin_lock(&async->lock);
+  if (async->state != ENCLAVE_RUN_IDLE) {
+    spin_unlock(&async->lock);
+    return -EBUSY;
+  }
+  async->state = ENCLAVE_RUN_BUSY;
+  async->resume = resume;
+  spin_unlock(&async->lock);
+
+  queue_work(keystone_run_wq, &async->work);
+  return 0;
+}
+
+int keystone_get_enclave_event(unsigned long data)
+{
+  struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
+  struct enclave *enclave;
+  struct enclave_async *async;
+  int ret = 0;
+
+  enclave = get_enclave_by_id(arg->eid);
+  if (!enclave) {
+    keystone_err("invalid enclave id\n");
+    return -EINVAL;
+  }
+
+  async = &enclave->async;
+
+  spin_lock(&async->lock);
+  switch (async->state) {
+    case ENCLAVE_RUN_DONE:
+      arg->error = async->error;
+      arg->value = async->value;
+      arg->stop_ticks = async->stop_ticks;
+      async->state = ENCLAVE_RUN_IDLE;
+      break;
+    case ENCLAVE_RUN_BUSY:
+      ret = -EAGAIN;
+      break;
+    default:
+      ret = -EINVAL;
+      break;
+  }
+  spin_unlock(&async->lock);
+
+  return ret;
+}
+
+int keystone_set_enclave_eventfd(unsigned long data)
+{
+  struct keystone_ioctl_eventfd *arg = (struct keystone_ioctl_eventfd*) data;
+  struct enclave *enclave;
+  struct enclave_async *async;
+  struct eventfd_ctx *ctx = NULL, *old;
+
+  enclave = get_enclave_by_id(arg->eid);
+  if (!enclave) {
+    keystone_err("invalid enclave id\n");
+    return -EINVAL;
+  }
+
+  /* a negative fd unregisters the current eventfd */
+  if ((long) arg->fd >= 0) {
+    ctx = eventfd_ctx_fdget(arg->fd);
+    if (IS_ERR(ctx))
+      return PTR_ERR(ctx);
+  }
+
+  async = &enclave->async;
+  spin_lock(&async->lock);
+  if (async->state == ENCLAVE_RUN_BUSY) {
+    spin_unlock(&async->lock);
+    if (ctx)
+      eventfd_ctx_put(ctx);
+    return -EBUSY;
+  }
+  old = async->eventfd;
+  async->eventfd = ctx;
+  spin_unlock(&async->lock);
+
+  /* the worker only uses the eventfd under the lock, and it is not
+   * running, so nothing can still hold the old one */
+  if (old)
+    eventfd_ctx_put(old);
+
+  return 0;
+}
+
+__poll_t keystone_poll(struct file *filep, poll_table *wait)
+{
+  struct enclave *enclave;
+
+  enclave = get_enclave_by_id((unsigned long) filep->private_data);
+  if (!enclave)
+    return EPOLLERR;
+
+  poll_wait(filep, &enclave->async.wq, wait);
+
+  if (READ_ONCE(enclave->async.state) == ENCLAVE_RUN_DONE)
+    return EPOLLIN | EPOLLRDNORM;
+  return 0;
+}
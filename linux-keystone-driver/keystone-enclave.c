@@ -22,6 +22,11 @@ int destroy_enclave(struct enclave* enclave)
   epm = enclave->epm;
   utm = enclave->utm;
 
+  enclave_async_destroy(enclave);
+  enclave_stats_destroy(enclave);
+  if (enclave->shared)
+    keystone_put_shared_region(enclave->shared);
+
   if (epm)
   {
     epm_destroy(epm);
@@ -48,10 +53,17 @@ struct enclave* create_enclave(unsigned long min_pages)
 
   enclave->eid = -1;
   enclave->utm = NULL;
+  enclave->shared = NULL;
   enclave->close_on_pexit = 1;
+  enclave_async_init(enclave);
 
-  enclave->epm = kmalloc(sizeof(struct epm), GFP_KERNEL);
+  enclave->epm = kzalloc(sizeof(struct epm), GFP_KERNEL);
   enclave->is_init = true;
+  if (enclave_stats_init(enclave))
+  {
+    keystone_err("failed to allocate enclave stats\n");
+    goto error_destroy_enclave;
+  }
   if (!enclave->epm)
   {
     keystone_err("failed to allocate epm\n");
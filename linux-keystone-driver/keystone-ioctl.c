@@ -8,6 +8,8 @@
 #include <asm/sbi.h>
 #include <linux/uaccess.h>
 #include <linux/string.h>
+#include <linux/ktime.h>
+#include <linux/timex.h>
 
 int __keystone_destroy_enclave(unsigned int ueid);
 
@@ -17,6 +19,7 @@ int keystone_create_enclave(struct file *filep, unsigned long arg)
   struct keystone_ioctl_create_enclave *enclp = (struct keystone_ioctl_create_enclave *) arg;
 
   struct enclave *enclave;
+  u64 start = ktime_get_ns();
   enclave = create_enclave(enclp->min_pages);
 
   if (enclave == NULL) {
@@ -32,6 +35,9 @@ int keystone_create_enclave(struct file *filep, unsigned long arg)
 
   filep->private_data = (void *) enclp->eid;
 
+  enclave_stats_register(enclave, enclp->eid);
+  keystone_stats_latency(KEYSTONE_LAT_CREATE, start);
+
   return 0;
 }
 
@@ -42,6 +48,7 @@ int keystone_finalize_enclave(unsigned long arg)
   struct enclave *enclave;
   struct utm *utm;
   struct keystone_sbi_create_t create_args;
+  u64 start = ktime_get_ns();
 
   struct keystone_ioctl_create_enclave *enclp = (struct keystone_ioctl_create_enclave *) arg;
 
@@ -60,7 +67,7 @@ int keystone_finalize_enclave(unsigned long arg)
   utm = enclave->utm;
 
   if (utm) {
-    create_args.utm_region.paddr = __pa(utm->ptr);
+    create_args.utm_region.paddr = utm->pa;
     create_args.utm_region.size = utm->size;
   } else {
     create_args.utm_region.paddr = 0;
@@ -72,6 +79,16 @@ int keystone_finalize_enclave(unsigned long arg)
   create_args.user_paddr = enclp->user_paddr;
   create_args.free_paddr = enclp->free_paddr;
   create_args.free_requested = enclp->free_requested;
+  create_args.shared_region_id = enclp->shared_region_id;
+
+  /* the driver keeps the region until every enclave using it is gone */
+  if (enclp->shared_region_id != SHARED_REGION_NONE) {
+    enclave->shared = keystone_get_shared_region(enclp->shared_region_id);
+    if (!enclave->shared) {
+      keystone_err("keystone_create_enclave: invalid shared region id\n");
+      goto error_destroy_enclave;
+    }
+  }
 
   ret = sbi_sm_create_enclave(&create_args);
 
@@ -81,6 +98,7 @@ int keystone_finalize_enclave(unsigned long arg)
   }
 
   enclave->eid = ret.value;
+  keystone_stats_latency(KEYSTONE_LAT_FINALIZE, start);
 
   return 0;
 
@@ -97,6 +115,7 @@ int keystone_run_enclave(unsigned long data)
   struct sbiret ret;
   unsigned long ueid;
   struct enclave* enclave;
+  u64 start;
   struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
 
   ueid = arg->eid;
@@ -112,7 +131,13 @@ int keystone_run_enclave(unsigned long data)
     return -EINVAL;
   }
 
+  if (enclave_async_busy(enclave))
+    return -EBUSY;
+
+  start = ktime_get_ns();
   ret = sbi_sm_run_enclave(enclave->eid);
+  arg->stop_ticks = get_cycles64();
+  keystone_stats_run(enclave, false, ret, start);
 
   arg->error = ret.error;
   arg->value = ret.value;
@@ -146,7 +171,7 @@ int utm_init_ioctl(struct file *filp, unsigned long arg)
   /* prepare for mmap */
   enclave->utm = utm;
 
-  enclp->utm_paddr = __pa(utm->ptr);
+  enclp->utm_paddr = utm->pa;
 
   return ret;
 }
@@ -169,6 +194,7 @@ int __keystone_destroy_enclave(unsigned int ueid)
 {
   struct sbiret ret;
   struct enclave *enclave;
+  u64 start = ktime_get_ns();
   enclave = get_enclave_by_id(ueid);
 
   if (!enclave) {
@@ -176,12 +202,16 @@ int __keystone_destroy_enclave(unsigned int ueid)
     return -EINVAL;
   }
 
+  /* wait for an asynchronous run to stop */
+  flush_work(&enclave->async.work);
+
   if (enclave->eid >= 0) {
     ret = sbi_sm_destroy_enclave(enclave->eid);
     if (ret.error) {
       keystone_err("fatal: cannot destroy enclave: SBI failed with error code %ld\n", ret.error);
       return -EINVAL;
     }
+    enclave->epm->scrubbed = true;
   } else {
     keystone_warn("keystone_destroy_enclave: skipping (enclave does not exist)\n");
   }
@@ -189,6 +219,7 @@ int __keystone_destroy_enclave(unsigned int ueid)
 
   destroy_enclave(enclave);
   enclave_idr_remove(ueid);
+  keystone_stats_latency(KEYSTONE_LAT_DESTROY, start);
 
   return 0;
 }
@@ -199,6 +230,7 @@ int keystone_resume_enclave(unsigned long data)
   struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
   unsigned long ueid = arg->eid;
   struct enclave* enclave;
+  u64 start;
   enclave = get_enclave_by_id(ueid);
 
   if (!enclave)
@@ -212,7 +244,13 @@ int keystone_resume_enclave(unsigned long data)
     return -EINVAL;
   }
 
+  if (enclave_async_busy(enclave))
+    return -EBUSY;
+
+  start = ktime_get_ns();
   ret = sbi_sm_resume_enclave(enclave->eid);
+  arg->stop_ticks = get_cycles64();
+  keystone_stats_run(enclave, true, ret, start);
 
   arg->error = ret.error;
   arg->value = ret.value;
@@ -252,6 +290,18 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
     case KEYSTONE_IOC_RESUME_ENCLAVE:
       ret = keystone_resume_enclave((unsigned long) data);
       break;
+    case KEYSTONE_IOC_RUN_ENCLAVE_ASYNC:
+      ret = keystone_run_enclave_async((unsigned long) data, false);
+      break;
+    case KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC:
+      ret = keystone_run_enclave_async((unsigned long) data, true);
+      break;
+    case KEYSTONE_IOC_ENCLAVE_EVENT:
+      ret = keystone_get_enclave_event((unsigned long) data);
+      break;
+    case KEYSTONE_IOC_SET_EVENTFD:
+      ret = keystone_set_enclave_eventfd((unsigned long) data);
+      break;
     /* Note that following commands could have been implemented as a part of ADD_PAGE ioctl.
      * However, there was a weird bug in compiler that generates a wrong control flow
      * that ends up with an illegal instruction if we combine switch-case and if statements.
@@ -259,6 +309,12 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
     case KEYSTONE_IOC_UTM_INIT:
       ret = utm_init_ioctl(filep, (unsigned long) data);
       break;
+    case KEYSTONE_IOC_CREATE_SHARED_REGION:
+      ret = keystone_create_shared_region(filep, (unsigned long) data);
+      break;
+    case KEYSTONE_IOC_DESTROY_SHARED_REGION:
+      ret = keystone_destroy_shared_region(filep, (unsigned long) data);
+      break;
     default:
       return -ENOSYS;
   }
@@ -273,6 +329,8 @@ int keystone_release(struct inode *inode, struct file *file) {
   unsigned long ueid = (unsigned long)(file->private_data);
   struct enclave *enclave;
 
+  keystone_release_shared_regions(file);
+
   /* enclave has been already destroyed */
   if (!ueid) {
     return 0;
@@ -6,8 +6,90 @@
 #include <linux/kernel.h>
 #include "keystone.h"
 #include <linux/dma-mapping.h>
+#include <linux/genalloc.h>
 #include <linux/version.h>
 
+/* Optional pool of physically contiguous memory reserved at module load.
+ * EPMs and UTMs are carved out of it at page granularity instead of being
+ * rounded up to a power-of-two buddy order. The gen_pool manages physical
+ * addresses so that alignment requests are physical alignments. */
+static struct gen_pool* keystone_pool;
+static vaddr_t pool_vaddr;
+static paddr_t pool_pa;
+static size_t pool_size;
+/* pool EPMs are naturally aligned powers of two, as buddy EPMs are */
+static bool pool_napot;
+
+int keystone_pool_init(size_t size, bool napot)
+{
+  dma_addr_t pa;
+
+  size = PAGE_UP(size);
+  if (!size)
+    return 0;
+
+  pool_vaddr = (vaddr_t) dma_alloc_coherent(keystone_dev.this_device,
+      size, &pa, GFP_KERNEL | __GFP_NOWARN);
+  if (!pool_vaddr) {
+    keystone_err("failed to reserve a %zu byte pool, falling back to per-enclave allocation\n", size);
+    return -ENOMEM;
+  }
+
+  keystone_pool = gen_pool_create(PAGE_SHIFT, -1);
+  if (!keystone_pool || gen_pool_add(keystone_pool, pa, size, -1)) {
+    if (keystone_pool)
+      gen_pool_destroy(keystone_pool);
+    keystone_pool = NULL;
+    dma_free_coherent(keystone_dev.this_device, size, (void*) pool_vaddr, pa);
+    return -ENOMEM;
+  }
+
+  /* EPMs from the pool are not zeroed when they are handed out */
+  memset((void*) pool_vaddr, 0, size);
+  pool_pa = pa;
+  pool_size = size;
+  pool_napot = napot;
+  keystone_info("reserved a %zu MB pool at 0x%llx\n", size >> 20, (unsigned long long) pa);
+  return 0;
+}
+
+void keystone_pool_destroy(void)
+{
+  if (!keystone_pool)
+    return;
+
+  gen_pool_destroy(keystone_pool);
+  dma_free_coherent(keystone_dev.this_device, pool_size, (void*) pool_vaddr, pool_pa);
+  keystone_pool = NULL;
+}
+
+/* Allocates size bytes (page granularity) from the pool.
+ * If align is non-zero, the physical address is aligned to it. */
+static vaddr_t pool_alloc(size_t size, size_t align, paddr_t* pa)
+{
+  struct genpool_data_align data = { .align = align };
+  unsigned long addr;
+
+  if (!keystone_pool)
+    return 0;
+
+  if (align)
+    addr = gen_pool_alloc_algo(keystone_pool, size, gen_pool_first_fit_align, &data);
+  else
+    addr = gen_pool_alloc(keystone_pool, size);
+
+  if (!addr)
+    return 0;
+
+  *pa = addr;
+  return pool_vaddr + (addr - pool_pa);
+}
+
+static void pool_free(paddr_t pa, size_t size)
+{
+  gen_pool_free(keystone_pool, pa, size);
+}
+
 /* Destroy all memory associated with an EPM */
 int epm_destroy(struct epm* epm) {
 
@@ -15,7 +97,13 @@ int epm_destroy(struct epm* epm) {
     return 0;
 
   /* free the EPM hold by the enclave */
-  if (epm->is_cma) {
+  if (epm->is_pool) {
+    /* the pool hands memory out without zeroing it, so it has to go
+     * back clean */
+    if (!epm->scrubbed)
+      memset((void*) epm->ptr, 0, epm->size);
+    pool_free(epm->pa, epm->size);
+  } else if (epm->is_cma) {
     dma_free_coherent(keystone_dev.this_device,
         epm->size,
         (void*) epm->ptr,
@@ -35,9 +123,27 @@ int epm_init(struct epm* epm, unsigned int min_pages)
   unsigned long count = min_pages;
   phys_addr_t device_phys_addr = 0;
 
-  /* try to allocate contiguous memory */
   epm->is_cma = 0;
+  epm->is_pool = 0;
+  epm->scrubbed = 0;
+
   order = ilog2(min_pages - 1) + 1;
+
+  /* The reserved pool gives us exactly what was asked for. Unless it is
+   * a naturally aligned power of two, the SM needs a TOR PMP entry (two
+   * registers) for it, so pool_napot rounds it up like the buddy path. */
+  if (pool_napot) {
+    count = 0x1 << order;
+    epm_vaddr = pool_alloc(count << PAGE_SHIFT, count << PAGE_SHIFT, &device_phys_addr);
+  } else {
+    epm_vaddr = pool_alloc(min_pages << PAGE_SHIFT, 0, &device_phys_addr);
+  }
+  if (epm_vaddr) {
+    epm->is_pool = 1;
+    goto found;
+  }
+
+  /* try to allocate contiguous memory */
   count = 0x1 << order;
 
   /* prevent kernel from complaining about an invalid argument */
@@ -69,11 +175,15 @@ int epm_init(struct epm* epm, unsigned int min_pages)
     return -ENOMEM;
   }
 
-  /* zero out */
+  /* The host can map the EPM until the enclave is finalized, so memory
+   * fresh from the kernel must not carry anything over. Pool memory is
+   * already clean: the pool starts zeroed and takes back only EPMs that
+   * the SM or epm_destroy() scrubbed. */
   memset((void*)epm_vaddr, 0, PAGE_SIZE*count);
 
+found:
   epm->root_page_table = (void*)epm_vaddr;
-  epm->pa = (epm->is_cma) ? device_phys_addr : __pa(epm_vaddr);
+  epm->pa = (epm->is_cma || epm->is_pool) ? device_phys_addr : __pa(epm_vaddr);
   epm->order = order;
   epm->size = count << PAGE_SHIFT;
   epm->ptr = epm_vaddr;
@@ -83,9 +193,13 @@ int epm_init(struct epm* epm, unsigned int min_pages)
 
 int utm_destroy(struct utm* utm){
 
-  if(utm->ptr != NULL){
+  if(utm->ptr == NULL)
+    return 0;
+
+  if (utm->is_pool)
+    pool_free(utm->pa, utm->size);
+  else
     free_pages((vaddr_t)utm->ptr, utm->order);
-  }
 
   return 0;
 }
@@ -100,13 +214,23 @@ int utm_init(struct utm* utm, size_t untrusted_size)
   count = 0x1 << order;
 
   utm->order = order;
-
-  /* Currently, UTM does not utilize CMA.
-   * It is always allocated from the buddy allocator */
-  utm->ptr = (void*) __get_free_pages(GFP_HIGHUSER, order);
-  if (!utm->ptr) {
-    keystone_err("failed to allocate UTM (size = %i bytes)\n",(1<<order));
-    return -ENOMEM;
+  utm->is_pool = 0;
+
+  /* The SM protects the UTM with a single lowest-priority NAPOT PMP entry,
+   * so it has to stay a naturally aligned power of two even in the pool */
+  utm->ptr = (void*) pool_alloc(count * PAGE_SIZE, count * PAGE_SIZE, &utm->pa);
+  if (utm->ptr) {
+    utm->is_pool = 1;
+    memset(utm->ptr, 0, count * PAGE_SIZE);
+  } else {
+    /* Currently, UTM does not utilize CMA.
+     * Outside of the pool it is always allocated from the buddy allocator */
+    utm->ptr = (void*) __get_free_pages(GFP_HIGHUSER | __GFP_ZERO, order);
+    if (!utm->ptr) {
+      keystone_err("failed to allocate UTM (size = %i bytes)\n",(1<<order));
+      return -ENOMEM;
+    }
+    utm->pa = __pa(utm->ptr);
   }
 
   utm->size = count * PAGE_SIZE;
@@ -23,3 +23,15 @@ struct sbiret sbi_sm_resume_enclave(unsigned long eid) {
       SBI_SM_RESUME_ENCLAVE,
       eid, 0, 0, 0, 0, 0);
 }
+
+struct sbiret sbi_sm_create_shared_region(unsigned long base, unsigned long size) {
+  return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
+      SBI_SM_CREATE_SHARED_REGION,
+      base, size, 0, 0, 0, 0);
+}
+
+struct sbiret sbi_sm_destroy_shared_region(unsigned long sid) {
+  return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
+      SBI_SM_DESTROY_SHARED_REGION,
+      sid, 0, 0, 0, 0, 0);
+}
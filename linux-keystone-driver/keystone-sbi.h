@@ -14,5 +14,7 @@ struct sbiret sbi_sm_create_enclave(struct keystone_sbi_create_t* args);
 struct sbiret sbi_sm_destroy_enclave(unsigned long eid);
 struct sbiret sbi_sm_run_enclave(unsigned long eid);
 struct sbiret sbi_sm_resume_enclave(unsigned long eid);
+struct sbiret sbi_sm_create_shared_region(unsigned long base, unsigned long size);
+struct sbiret sbi_sm_destroy_shared_region(unsigned long sid);
 
 #endif
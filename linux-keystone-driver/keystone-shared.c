@@ -0,0 +1,169 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include "keystone.h"
+#include "keystone-sbi.h"
+#include "keystone_user.h"
+
+/* Read-only regions measured by the SM and shared by many enclaves.
+ * A region belongs to the file that created it: only that file can
+ * destroy it, and closing the file destroys it. One that enclaves still
+ * use when its file is closed goes away with the last of them. */
+static LIST_HEAD(shared_region_list);
+static DEFINE_MUTEX(shared_region_lock);
+
+/* large enough for any library an enclave would share */
+#define SHARED_REGION_MAX_SIZE (256UL << 20)
+
+struct shared_region {
+  unsigned long sid;
+  struct file *owner;  // NULL once the owner closed its file
+  unsigned int users;  // enclaves attached
+  struct epm mem;
+  struct list_head list;
+};
+
+int keystone_create_shared_region(struct file *filep, unsigned long arg)
+{
+  struct sbiret ret;
+  struct shared_region *region;
+  struct keystone_ioctl_shared_region *shp = (struct keystone_ioctl_shared_region *) arg;
+  size_t size;
+
+  if (!shp->image_size || shp->image_size > SHARED_REGION_MAX_SIZE)
+    return -EINVAL;
+
+  size = PAGE_UP(shp->image_size);
+  if ((size >> PAGE_SHIFT) > UINT_MAX)
+    return -EINVAL;
+
+  region = kmalloc(sizeof(struct shared_region), GFP_KERNEL);
+  if (!region)
+    return -ENOMEM;
+
+  if (epm_init(&region->mem, size >> PAGE_SHIFT)) {
+    kfree(region);
+    return -ENOMEM;
+  }
+
+  /* the tail of the last page stays zero, the SDK measures it that way */
+  if (copy_from_user((void *) region->mem.ptr,
+        (void __user *) shp->image_ptr, shp->image_size)) {
+    epm_destroy(&region->mem);
+    kfree(region);
+    return -EFAULT;
+  }
+
+  /* only the page-rounded image is handed to the SM (and measured);
+   * any buddy allocator padding beyond it stays with the driver */
+  ret = sbi_sm_create_shared_region(region->mem.pa, size);
+  if (ret.error) {
+    keystone_err("keystone_create_shared_region: SBI call failed with error code %ld\n", ret.error);
+    epm_destroy(&region->mem);
+    kfree(region);
+    return -EINVAL;
+  }
+
+  region->sid = ret.value;
+  region->owner = filep;
+  region->users = 0;
+  shp->sid = region->sid;
+
+  mutex_lock(&shared_region_lock);
+  list_add(&region->list, &shared_region_list);
+  mutex_unlock(&shared_region_lock);
+
+  return 0;
+}
+
+static int __destroy_shared_region(struct shared_region *region)
+{
+  struct sbiret ret;
+
+  if (region->users)
+    return -EBUSY;
+
+  ret = sbi_sm_destroy_shared_region(region->sid);
+  if (ret.error) {
+    keystone_err("cannot destroy shared region: SBI failed with error code %ld\n", ret.error);
+    return -EBUSY;
+  }
+
+  list_del(&region->list);
+  epm_destroy(&region->mem);
+  kfree(region);
+  return 0;
+}
+
+int keystone_destroy_shared_region(struct file *filep, unsigned long arg)
+{
+  int ret = -EINVAL;
+  struct shared_region *region;
+  struct keystone_ioctl_shared_region *shp = (struct keystone_ioctl_shared_region *) arg;
+
+  mutex_lock(&shared_region_lock);
+  list_for_each_entry(region, &shared_region_list, list) {
+    if (region->sid == shp->sid) {
+      ret = region->owner == filep ? __destroy_shared_region(region) : -EPERM;
+      break;
+    }
+  }
+  mutex_unlock(&shared_region_lock);
+
+  return ret;
+}
+
+void keystone_release_shared_regions(struct file *filep)
+{
+  struct shared_region *region, *tmp;
+
+  mutex_lock(&shared_region_lock);
+  list_for_each_entry_safe(region, tmp, &shared_region_list, list) {
+    if (region->owner != filep)
+      continue;
+    /* still in use: the last enclave to go destroys it */
+    if (__destroy_shared_region(region))
+      region->owner = NULL;
+  }
+  mutex_unlock(&shared_region_lock);
+}
+
+struct shared_region* keystone_get_shared_region(unsigned long sid)
+{
+  struct shared_region *region, *found = NULL;
+
+  mutex_lock(&shared_region_lock);
+  list_for_each_entry(region, &shared_region_list, list) {
+    if (region->sid == sid && region->owner) {
+      region->users++;
+      found = region;
+      break;
+    }
+  }
+  mutex_unlock(&shared_region_lock);
+
+  return found;
+}
+
+/* Called once the SM no longer maps the region into the enclave */
+void keystone_put_shared_region(struct shared_region* region)
+{
+  mutex_lock(&shared_region_lock);
+  if (!--region->users && !region->owner)
+    __destroy_shared_region(region);
+  mutex_unlock(&shared_region_lock);
+}
+
+void keystone_destroy_all_shared_regions(void)
+{
+  struct shared_region *region, *tmp;
+
+  mutex_lock(&shared_region_lock);
+  list_for_each_entry_safe(region, tmp, &shared_region_list, list) {
+    __destroy_shared_region(region);
+  }
+  mutex_unlock(&shared_region_lock);
+}
@@ -0,0 +1,172 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include "keystone.h"
+#include "keystone_user.h"
+
+/* Enclave statistics under <debugfs>/keystone.
+ * Counters are per-CPU and only summed when read, so they are cheap
+ * enough to stay on in production:
+ *   keystone/latency      create/finalize/destroy latency histograms
+ *   keystone/<ueid>/stats per-enclave memory, run and exit counters */
+static struct dentry *keystone_debugfs;
+
+static const char *latency_names[KEYSTONE_LAT_MAX] = {
+  [KEYSTONE_LAT_CREATE]   = "create",
+  [KEYSTONE_LAT_FINALIZE] = "finalize",
+  [KEYSTONE_LAT_DESTROY]  = "destroy",
+};
+
+/* log2(us) buckets: [0] < 2us, [1] < 4us, ..., the last one is open ended */
+static DEFINE_PER_CPU(u64 [KEYSTONE_LAT_MAX][KEYSTONE_LAT_BUCKETS], latency_hist);
+
+void keystone_stats_latency(enum keystone_latency type, u64 start_ns)
+{
+  u64 us = (ktime_get_ns() - start_ns) / NSEC_PER_USEC;
+  unsigned int bucket = us > 1 ? ilog2(us) : 0;
+
+  if (bucket >= KEYSTONE_LAT_BUCKETS)
+    bucket = KEYSTONE_LAT_BUCKETS - 1;
+  this_cpu_inc(latency_hist[type][bucket]);
+}
+
+void keystone_stats_run(struct enclave *enclave, bool resume,
+    struct sbiret ret, u64 start_ns)
+{
+  struct enclave_counters __percpu *c = enclave->stats;
+  unsigned long exit;
+
+  if (!c)
+    return;
+
+  switch (ret.error) {
+    case SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST:
+      exit = KEYSTONE_EXIT_EDGE_CALL;
+      break;
+    case SBI_ERR_SM_ENCLAVE_INTERRUPTED:
+      exit = KEYSTONE_EXIT_INTERRUPT;
+      break;
+    case SBI_ERR_SM_ENCLAVE_SUCCESS:
+      exit = KEYSTONE_EXIT_DONE;
+      break;
+    default:
+      exit = KEYSTONE_EXIT_ERROR;
+      break;
+  }
+
+  if (resume)
+    this_cpu_inc(c->resumes);
+  else
+    this_cpu_inc(c->runs);
+  this_cpu_inc(c->exits[exit]);
+  this_cpu_add(c->sbi_ns, ktime_get_ns() - start_ns);
+}
+
+static int latency_show(struct seq_file *s, void *unused)
+{
+  int type, bucket, cpu;
+
+  seq_puts(s, "us");
+  for (type = 0; type < KEYSTONE_LAT_MAX; type++)
+    seq_printf(s, "\t%s", latency_names[type]);
+  seq_puts(s, "\n");
+
+  for (bucket = 0; bucket < KEYSTONE_LAT_BUCKETS; bucket++) {
+    if (bucket == KEYSTONE_LAT_BUCKETS - 1)
+      seq_printf(s, ">=%lu", 1UL << bucket);
+    else
+      seq_printf(s, "<%lu", 2UL << bucket);
+
+    for (type = 0; type < KEYSTONE_LAT_MAX; type++) {
+      u64 sum = 0;
+      for_each_possible_cpu(cpu)
+        sum += per_cpu(latency_hist, cpu)[type][bucket];
+      seq_printf(s, "\t%llu", sum);
+    }
+    seq_puts(s, "\n");
+  }
+  return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(latency);
+
+static const char *epm_source(struct epm *epm)
+{
+  if (epm->is_pool)
+    return "pool";
+  return epm->is_cma ? "cma" : "buddy";
+}
+
+static int enclave_stats_show(struct seq_file *s, void *unused)
+{
+  struct enclave *enclave = s->private;
+  struct enclave_counters sum = {0};
+  int cpu, i;
+
+  for_each_possible_cpu(cpu) {
+    struct enclave_counters *c = per_cpu_ptr(enclave->stats, cpu);
+    sum.runs += c->runs;
+    sum.resumes += c->resumes;
+    sum.sbi_ns += c->sbi_ns;
+    for (i = 0; i < KEYSTONE_EXIT_MAX; i++)
+      sum.exits[i] += c->exits[i];
+  }
+
+  if (enclave->epm && enclave->epm->ptr)
+    seq_printf(s, "epm_bytes: %zu\nepm_source: %s\n",
+        enclave->epm->size, epm_source(enclave->epm));
+  if (enclave->utm && enclave->utm->ptr)
+    seq_printf(s, "utm_bytes: %zu\nutm_source: %s\n",
+        enclave->utm->size, enclave->utm->is_pool ? "pool" : "buddy");
+
+  seq_printf(s, "runs: %llu\nresumes: %llu\n", sum.runs, sum.resumes);
+  seq_printf(s, "exits_edge_call: %llu\nexits_interrupt: %llu\n",
+      sum.exits[KEYSTONE_EXIT_EDGE_CALL], sum.exits[KEYSTONE_EXIT_INTERRUPT]);
+  seq_printf(s, "exits_done: %llu\nexits_error: %llu\n",
+      sum.exits[KEYSTONE_EXIT_DONE], sum.exits[KEYSTONE_EXIT_ERROR]);
+  seq_printf(s, "sbi_run_ns: %llu\n", sum.sbi_ns);
+  return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(enclave_stats);
+
+void keystone_stats_init(void)
+{
+  keystone_debugfs = debugfs_create_dir("keystone", NULL);
+  debugfs_create_file("latency", 0444, keystone_debugfs, NULL, &latency_fops);
+}
+
+void keystone_stats_exit(void)
+{
+  debugfs_remove_recursive(keystone_debugfs);
+}
+
+int enclave_stats_init(struct enclave *enclave)
+{
+  enclave->stats_dir = NULL;
+  enclave->stats = alloc_percpu(struct enclave_counters);
+  return enclave->stats ? 0 : -ENOMEM;
+}
+
+void enclave_stats_register(struct enclave *enclave, unsigned int ueid)
+{
+  char name[16];
+
+  snprintf(name, sizeof(name), "%u", ueid);
+  enclave->stats_dir = debugfs_create_dir(name, keystone_debugfs);
+  debugfs_create_file("stats", 0444, enclave->stats_dir, enclave, &enclave_stats_fops);
+}
+
+void enclave_stats_destroy(struct enclave *enclave)
+{
+  /* waits for readers of the stats file to go away */
+  debugfs_remove_recursive(enclave->stats_dir);
+  enclave->stats_dir = NULL;
+
+  free_percpu(enclave->stats);
+  enclave->stats = NULL;
+}
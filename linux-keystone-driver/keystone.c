@@ -22,10 +22,23 @@ MODULE_AUTHOR("Dayeol Lee <dayeol@berkeley.edu>");
 MODULE_VERSION(DRV_VERSION);
 MODULE_LICENSE("Dual BSD/GPL");
 
+/* Size of the contiguous pool reserved at load time for EPMs and UTMs.
+ * 0 disables the pool; large pools need a big enough CMA area (cma=). */
+static unsigned long pool_size_mb;
+module_param(pool_size_mb, ulong, 0444);
+MODULE_PARM_DESC(pool_size_mb, "Contiguous memory pool for enclaves in MB (0 = disabled)");
+
+/* Round pool EPMs up to naturally aligned powers of two, which the SM
+ * protects with one PMP register instead of two */
+static bool pool_napot;
+module_param(pool_napot, bool, 0444);
+MODULE_PARM_DESC(pool_napot, "Allocate pool EPMs as naturally aligned powers of two (one PMP entry each)");
+
 static const struct file_operations keystone_fops = {
     .owner          = THIS_MODULE,
     .mmap           = keystone_mmap,
     .unlocked_ioctl = keystone_ioctl,
+    .poll           = keystone_poll,
     .release        = keystone_release
 };
 
@@ -54,7 +67,8 @@ int keystone_mmap(struct file* filp, struct vm_area_struct *vma)
   vsize = vma->vm_end - vma->vm_start;
 
   if(enclave->is_init){
-    if (vsize > PAGE_SIZE)
+    if (vsize > PAGE_SIZE ||
+        vma->vm_pgoff >= (epm->size >> PAGE_SHIFT))
       return -EINVAL;
     paddr = epm->pa + (vma->vm_pgoff << PAGE_SHIFT);
     remap_pfn_range(vma,
@@ -69,7 +83,7 @@ int keystone_mmap(struct file* filp, struct vm_area_struct *vma)
       return -EINVAL;
     remap_pfn_range(vma,
                     vma->vm_start,
-                    __pa(utm->ptr) >> PAGE_SHIFT,
+                    utm->pa >> PAGE_SHIFT,
                     vsize, vma->vm_page_prot);
   }
   return 0;
@@ -88,6 +102,14 @@ static int __init keystone_dev_init(void)
 
   keystone_dev.this_device->coherent_dma_mask = DMA_BIT_MASK(32);
 
+  keystone_stats_init();
+
+  if (keystone_async_init())
+    pr_err("keystone_enclave: failed to create the run workqueue\n");
+
+  /* not fatal: without a pool every enclave is allocated on its own */
+  keystone_pool_init(pool_size_mb << 20, pool_napot);
+
   pr_info("keystone_enclave: " DRV_DESCRIPTION " v" DRV_VERSION "\n");
   return ret;
 }
@@ -95,7 +117,11 @@ static int __init keystone_dev_init(void)
 static void __exit keystone_dev_exit(void)
 {
   pr_info("keystone_enclave: keystone_dev_exit()\n");
+  keystone_destroy_all_shared_regions();
+  keystone_pool_destroy();
   misc_deregister(&keystone_dev);
+  keystone_async_exit();
+  keystone_stats_exit();
   return;
 }
 
@@ -16,6 +16,10 @@
 #include <linux/fs.h>
 #include <linux/miscdevice.h>
 #include <linux/idr.h>
+#include <linux/poll.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include <linux/file.h>
 
@@ -32,6 +36,7 @@ extern struct miscdevice keystone_dev;
 long keystone_ioctl(struct file* filep, unsigned int cmd, unsigned long arg);
 int keystone_release(struct inode *inode, struct file *file);
 int keystone_mmap(struct file *filp, struct vm_area_struct *vma);
+__poll_t keystone_poll(struct file *filep, poll_table *wait);
 
 /* enclave private memory */
 struct epm {
@@ -41,6 +46,8 @@ struct epm {
   unsigned long order;
   paddr_t pa;
   bool is_cma;
+  bool is_pool;
+  bool scrubbed; /* zeroed by the SM when the enclave was destroyed */
 };
 
 struct utm {
@@ -48,8 +55,56 @@ struct utm {
   void* ptr;
   size_t size;
   unsigned long order;
+  paddr_t pa;
+  bool is_pool;
+};
+
+
+/* asynchronous run/resume state, see keystone-async.c */
+enum enclave_run_state {
+  ENCLAVE_RUN_IDLE = 0,
+  ENCLAVE_RUN_BUSY,
+  ENCLAVE_RUN_DONE,
+};
+
+struct enclave_async {
+  struct work_struct work;
+  wait_queue_head_t wq;
+  spinlock_t lock;
+  struct eventfd_ctx* eventfd;
+  enum enclave_run_state state;
+  bool resume;
+  unsigned long error;
+  unsigned long value;
+  u64 stop_ticks;
+};
+
+/* statistics, see keystone-stats.c */
+enum keystone_exit {
+  KEYSTONE_EXIT_EDGE_CALL = 0,
+  KEYSTONE_EXIT_INTERRUPT,
+  KEYSTONE_EXIT_DONE,
+  KEYSTONE_EXIT_ERROR,
+  KEYSTONE_EXIT_MAX,
+};
+
+enum keystone_latency {
+  KEYSTONE_LAT_CREATE = 0,
+  KEYSTONE_LAT_FINALIZE,
+  KEYSTONE_LAT_DESTROY,
+  KEYSTONE_LAT_MAX,
+};
+
+#define KEYSTONE_LAT_BUCKETS 24
+
+struct enclave_counters {
+  u64 runs;
+  u64 resumes;
+  u64 exits[KEYSTONE_EXIT_MAX];
+  u64 sbi_ns;
 };
 
+struct shared_region;
 
 struct enclave
 {
@@ -57,7 +112,11 @@ struct enclave
   int close_on_pexit;
   struct utm* utm;
   struct epm* epm;
+  struct shared_region* shared;  // attached shared region, if any
   bool is_init;
+  struct enclave_async async;
+  struct enclave_counters __percpu* stats;
+  struct dentry* stats_dir;
 };
 
 
@@ -84,6 +143,33 @@ static inline uintptr_t  epm_satp(struct epm* epm) {
   return ((uintptr_t)epm->root_page_table >> RISCV_PGSHIFT | SATP_MODE_CHOICE);
 }
 
+int keystone_create_shared_region(struct file *filep, unsigned long arg);
+int keystone_destroy_shared_region(struct file *filep, unsigned long arg);
+void keystone_release_shared_regions(struct file *filep);
+struct shared_region* keystone_get_shared_region(unsigned long sid);
+void keystone_put_shared_region(struct shared_region* region);
+void keystone_destroy_all_shared_regions(void);
+
+void keystone_stats_init(void);
+void keystone_stats_exit(void);
+int enclave_stats_init(struct enclave* enclave);
+void enclave_stats_register(struct enclave* enclave, unsigned int ueid);
+void enclave_stats_destroy(struct enclave* enclave);
+void keystone_stats_run(struct enclave* enclave, bool resume,
+    struct sbiret ret, u64 start_ns);
+void keystone_stats_latency(enum keystone_latency type, u64 start_ns);
+
+int keystone_async_init(void);
+void keystone_async_exit(void);
+void enclave_async_init(struct enclave* enclave);
+void enclave_async_destroy(struct enclave* enclave);
+bool enclave_async_busy(struct enclave* enclave);
+int keystone_run_enclave_async(unsigned long data, bool resume);
+int keystone_get_enclave_event(unsigned long data);
+int keystone_set_enclave_eventfd(unsigned long data);
+
+int keystone_pool_init(size_t size, bool napot);
+void keystone_pool_destroy(void);
 int epm_destroy(struct epm* epm);
 int epm_init(struct epm* epm, unsigned int count);
 int utm_destroy(struct utm* utm);
@@ -11,7 +11,7 @@ include $(KEYSTONE)/mkutils/pkg-keystone.mk
 endif
 
 define KEYSTONE_BOOTROM_BUILD_CMDS
-	$(MAKE) $(TARGET_CONFIGURE_OPTS) -C $(@D) all
+	$(MAKE) $(TARGET_CONFIGURE_OPTS) KEYSTONE_SDK=$(KEYSTONE_SDK) -C $(@D) all
 endef
 
 KEYSTONE_BOOTROM_INSTALL_IMAGES = YES
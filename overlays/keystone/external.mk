@@ -19,6 +19,7 @@ ifeq ($(KEYSTONE_PLATFORM),hifive_unmatched)
 # U-Boot
 define UBOOT_COPY_HIFIVE_SOURCES
 	cp -ar $(KEYSTONE)/overlays/keystone/board/sifive/hifive-unmatched/src/uboot/keystone $(@D)/arch/riscv/lib
+	cp -a $(KEYSTONE_SDK)/include/shared/keccak.h $(@D)/arch/riscv/lib/keystone/sha3
 	cp -ar $(KEYSTONE)/overlays/keystone/board/sifive/hifive-unmatched/src/uboot/keystone.h $(@D)/arch/riscv/include/asm
 	cp -ar $(KEYSTONE)/overlays/keystone/board/sifive/hifive-unmatched/src/uboot/u-boot-spl-sanctum.lds $(@D)/arch/riscv/cpu
 endef
@@ -0,0 +1,306 @@
+#ifdef USE_FILE_MMAP
+
+#define _GNU_SOURCE
+#include <asm/csr.h>
+#include <fcntl.h>
+#include "call/file_mmap.h"
+#include "call/io_wrap.h"
+#include "call/syscall.h"
+#include "crypto/sha256.h"
+#include "mm/common.h"
+#include "mm/freemem.h"
+#include "mm/mm.h"
+#include "mm/vm.h"
+#include "uaccess.h"
+#include "util/rt_util.h"
+#include "util/string.h"
+#ifdef USE_IO_CACHE
+#include "call/io_cache.h"
+#endif
+
+/* A file mapping only reserves its VA range (PTE_LAZY). The first access
+ * to a page faults, and the page is read from the host together with the
+ * following untouched pages of the mapping, up to FILE_MMAP_CLUSTER, with a
+ * single proxied pread. If the eapp attached a hash list, every page is
+ * checked before it becomes accessible, and a mismatch kills the enclave. */
+
+#define FILE_MMAP_REGIONS 32
+#define PAGE_HASH_SIZE    SHA256_BLOCK_SIZE
+
+struct file_map {
+  uintptr_t start;   /* 0 if the slot is free */
+  uintptr_t end;
+  int fd;            /* host duplicate, shared by the pieces of a split map */
+  off_t offset;      /* file offset of start */
+  int pte_flags;
+  uintptr_t hashes;  /* user array, one hash per page from start, or 0 */
+};
+
+static struct file_map maps[FILE_MMAP_REGIONS];
+
+/* the handlers that were in the trap table before, for faults elsewhere */
+static uintptr_t next_fault_handler[RISCV_EXCP_STORE_PAGE_FAULT + 1];
+extern uintptr_t rt_trap_table;
+
+/* A fault taken in the runtime (e.g., copy_from_user on a mapped buffer)
+ * may hit while the shared buffer holds a call being set up or its
+ * results. Those faults bring in a single page and put back the part of
+ * the buffer the pread used. */
+static uint8_t shared_stash[RISCV_PAGE_SIZE + 256];
+
+static struct file_map* find_map(uintptr_t va){
+  int i;
+
+  for(i = 0; i < FILE_MMAP_REGIONS; i++){
+    if(maps[i].start && va >= maps[i].start && va < maps[i].end)
+      return &maps[i];
+  }
+  return 0;
+}
+
+static int map_alloc(void){
+  int i;
+
+  for(i = 0; i < FILE_MMAP_REGIONS; i++){
+    if(!maps[i].start)
+      return i;
+  }
+  return -1;
+}
+
+/* splits the mapping around va so that a mapping starts there */
+static int split_at(uintptr_t va){
+  struct file_map* m = find_map(va);
+  int i;
+
+  if(!m || m->start == va)
+    return 0;
+  if((i = map_alloc()) < 0)
+    return -1;
+
+  maps[i] = *m;
+  maps[i].start = va;
+  maps[i].offset += va - m->start;
+  if(maps[i].hashes)
+    maps[i].hashes += vpn(va - m->start) * PAGE_HASH_SIZE;
+  m->end = va;
+  return 0;
+}
+
+static void release_fd(int fd){
+  int i;
+
+  for(i = 0; i < FILE_MMAP_REGIONS; i++){
+    if(maps[i].start && maps[i].fd == fd)
+      return;
+  }
+  io_syscall_close(fd);
+}
+
+static int verify_page(struct file_map* m, uintptr_t page){
+  uint8_t expected[PAGE_HASH_SIZE], hash[PAGE_HASH_SIZE];
+  SHA256_CTX hasher;
+
+  copy_from_user(expected,
+                 (void*)(m->hashes + vpn(page - m->start) * PAGE_HASH_SIZE),
+                 PAGE_HASH_SIZE);
+
+  sha256_init(&hasher);
+  sha256_update(&hasher, (BYTE*)__va(translate(page)), RISCV_PAGE_SIZE);
+  sha256_final(&hasher, hash);
+
+  return memcmp(hash, expected, PAGE_HASH_SIZE) ? -1 : 0;
+}
+
+static int fault_in(struct file_map* m, uintptr_t va, int in_runtime){
+  uintptr_t data = edge_call_data_ptr() + sizeof(struct edge_syscall) +
+                   sizeof(sargs_SYS_pread64);
+  size_t max = in_runtime ? 1 : FILE_MMAP_CLUSTER;
+  size_t stash_len = 0, count, i;
+  uintptr_t ret;
+
+  /* the untouched pages from va on that fit the shared buffer */
+  for(count = 0; count < max; count++){
+    uintptr_t page = va + count * RISCV_PAGE_SIZE;
+    pte* entry = pte_of_va(page);
+
+    if(page >= m->end || !entry || !(*entry & PTE_LAZY))
+      break;
+    if(data + (count + 1) * RISCV_PAGE_SIZE > shared_buffer + shared_buffer_size)
+      break;
+  }
+  if(count > spa_available())
+    count = spa_available();
+  if(count == 0)
+    return -1;
+
+  if(in_runtime){
+    stash_len = data + RISCV_PAGE_SIZE - shared_buffer;
+    if(stash_len > sizeof(shared_stash))
+      return -1;
+    memcpy(shared_stash, (void*)shared_buffer, stash_len);
+  }
+
+  /* writable while the data comes in, the mapping's permissions are only
+   * set once the pages are checked */
+  for(i = 0; i < count; i++)
+    alloc_page(vpn(va) + i, PTE_U | PTE_R | PTE_W);
+  tlb_flush();
+
+  ret = io_syscall_pread(m->fd, (void*)va, count * RISCV_PAGE_SIZE,
+                         m->offset + (va - m->start));
+
+  if(stash_len)
+    memcpy((void*)shared_buffer, shared_stash, stash_len);
+  if((intptr_t)ret < 0)
+    return -1;
+
+  for(i = 0; i < count; i++){
+    uintptr_t page = va + i * RISCV_PAGE_SIZE;
+
+    if(m->hashes && verify_page(m, page) != 0){
+      print_strace("[runtime] file mmap hash mismatch at 0x%lx\r\n", page);
+      return -1;
+    }
+    realloc_page(vpn(page), m->pte_flags);
+  }
+  tlb_flush();
+
+  print_strace("[runtime] file mmap paged in %lu pages at 0x%lx\r\n", count, va);
+  return 0;
+}
+
+static void file_mmap_fault(struct encl_ctx* ctx){
+  uintptr_t va = ctx->sbadaddr;
+  struct file_map* m;
+  pte* entry;
+
+  va = PAGE_DOWN(va);
+  m = find_map(va);
+  entry = m ? pte_of_va(va) : 0;
+
+  /* not a file mapping, or a permission fault on a page that is in */
+  if(!entry || !(*entry & PTE_LAZY)){
+    ((void (*)(struct encl_ctx*))next_fault_handler[ctx->scause])(ctx);
+    return;
+  }
+
+  if(fault_in(m, va, (ctx->sstatus & SR_SPP) != 0) != 0)
+    rt_page_fault(ctx);
+}
+
+static void install_fault_handler(void){
+  uintptr_t* trap_table = &rt_trap_table;
+
+  if(next_fault_handler[RISCV_EXCP_LOAD_PAGE_FAULT])
+    return;
+
+  next_fault_handler[RISCV_EXCP_INST_PAGE_FAULT] = trap_table[RISCV_EXCP_INST_PAGE_FAULT];
+  next_fault_handler[RISCV_EXCP_LOAD_PAGE_FAULT] = trap_table[RISCV_EXCP_LOAD_PAGE_FAULT];
+  next_fault_handler[RISCV_EXCP_STORE_PAGE_FAULT] = trap_table[RISCV_EXCP_STORE_PAGE_FAULT];
+
+  trap_table[RISCV_EXCP_INST_PAGE_FAULT] = (uintptr_t) file_mmap_fault;
+  trap_table[RISCV_EXCP_LOAD_PAGE_FAULT] = (uintptr_t) file_mmap_fault;
+  trap_table[RISCV_EXCP_STORE_PAGE_FAULT] = (uintptr_t) file_mmap_fault;
+}
+
+uintptr_t file_mmap(size_t length, int pte_flags, int fd, off_t offset){
+  uintptr_t pages = vpn(PAGE_UP(length));
+  uintptr_t starting_vpn = vpn(EYRIE_ANON_REGION_START);
+  uintptr_t i;
+  int slot, host_fd;
+
+  if(!length || offset < 0 || RISCV_PAGE_OFFSET(offset) ||
+     (slot = map_alloc()) < 0)
+    return -1;
+
+#ifdef USE_IO_CACHE
+  io_cache_flush(fd);
+#endif
+
+  /* the mapping outlives fd, so it needs its own host descriptor */
+  host_fd = io_syscall_fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if(host_fd < 0)
+    return -1;
+
+  while((starting_vpn + pages) <= vpn(EYRIE_ANON_REGION_END)){
+    uintptr_t valid_pages = test_va_range(starting_vpn, pages);
+    if(valid_pages == pages)
+      break;
+    starting_vpn += valid_pages + 1;
+  }
+  if((starting_vpn + pages) > vpn(EYRIE_ANON_REGION_END)){
+    io_syscall_close(host_fd);
+    return -1;
+  }
+
+  for(i = 0; i < pages; i++){
+    if(!reserve_page(starting_vpn + i)){
+      /* out of page-table pages: drop what was reserved so far */
+      while(i--)
+        free_page(starting_vpn + i);
+      io_syscall_close(host_fd);
+      return -1;
+    }
+  }
+  install_fault_handler();
+
+  maps[slot].start = starting_vpn << RISCV_PAGE_BITS;
+  maps[slot].end = (starting_vpn + pages) << RISCV_PAGE_BITS;
+  maps[slot].fd = host_fd;
+  maps[slot].offset = offset;
+  maps[slot].pte_flags = pte_flags;
+  maps[slot].hashes = 0;
+
+  return maps[slot].start;
+}
+
+int file_munmap(uintptr_t addr, size_t length){
+  uintptr_t end = addr + PAGE_UP(length);
+  int i;
+
+  if(split_at(addr) != 0 || split_at(end) != 0)
+    return -1;
+
+  for(i = 0; i < FILE_MMAP_REGIONS; i++){
+    if(maps[i].start >= addr && maps[i].end <= end && maps[i].start){
+      maps[i].start = 0;
+      release_fd(maps[i].fd);
+    }
+  }
+  return 0;
+}
+
+int file_mprotect(uintptr_t addr, size_t length, int pte_flags){
+  uintptr_t end = addr + PAGE_UP(length);
+  int i;
+
+  if(split_at(addr) != 0 || split_at(end) != 0)
+    return -1;
+
+  for(i = 0; i < FILE_MMAP_REGIONS; i++){
+    if(maps[i].start >= addr && maps[i].end <= end && maps[i].start)
+      maps[i].pte_flags = pte_flags;
+  }
+  return 0;
+}
+
+uintptr_t file_mmap_hashes(uintptr_t addr, size_t length, uintptr_t hashes){
+  struct file_map* m = find_map(addr);
+  uintptr_t va;
+
+  if(!m || m->start != addr || m->end != addr + PAGE_UP(length) || !hashes)
+    return -1;
+
+  /* pages that are already in were never checked */
+  for(va = m->start; va < m->end; va += RISCV_PAGE_SIZE){
+    pte* entry = pte_of_va(va);
+    if(!entry || !(*entry & PTE_LAZY))
+      return -1;
+  }
+
+  m->hashes = hashes;
+  return 0;
+}
+
+#endif /* USE_FILE_MMAP */
@@ -0,0 +1,663 @@
+#if defined(USE_IO_SYSCALL) && defined(USE_IO_CACHE)
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "call/io_cache.h"
+#include "call/io_wrap.h"
+#include "call/syscall.h"
+#include "mm/freemem.h"
+#include "mm/vm_defs.h"
+#include "uaccess.h"
+#include "util/string.h"
+#include "edge_syscall.h"
+
+/* Every proxied read costs an enclave exit, so small sequential reads are
+ * served from enclave pages filled in readahead windows, and writes are
+ * kept in the same pages until the file is synced, closed, truncated or a
+ * dirty page is evicted. Runs of dirty pages go out as a single pwrite.
+ *
+ * Pages come from the free memory pool on first use and are kept for reuse;
+ * at most IO_CACHE_PAGES of them are ever allocated. */
+
+#define IO_CACHE_FILES   16
+#define IO_CACHE_BUCKETS 64
+
+#define PAGE_INDEX(off)  ((uintptr_t)(off) >> RISCV_PAGE_BITS)
+#define PAGE_OFFSET(off) ((uintptr_t)(off) & (RISCV_PAGE_SIZE - 1))
+
+struct cache_file {
+  int fd;             /* -1 if the slot is free */
+  int flags;          /* access mode and O_APPEND */
+  int error;          /* a write-back failed since the last flush */
+  off_t pos;          /* the host file offset is not kept in sync */
+  off_t size;
+  uintptr_t ra_next;  /* page after the last readahead window */
+  size_t ra_pages;    /* current readahead window */
+};
+
+struct cache_page {
+  uintptr_t va;       /* 0 until the slot is first used */
+  int file;           /* -1 if the slot is free */
+  uintptr_t index;
+  uint16_t dirty_lo;  /* dirty bytes are [dirty_lo, dirty_hi) */
+  uint16_t dirty_hi;
+  uint8_t valid;      /* bytes outside the dirty range match the file */
+  uint8_t referenced;
+  uint8_t busy;       /* being filled, not hashed nor evictable */
+  int next;
+};
+
+static struct cache_file files[IO_CACHE_FILES];
+static struct cache_page pages[IO_CACHE_PAGES];
+static int buckets[IO_CACHE_BUCKETS];
+static size_t clock_hand;
+static int initialized;
+
+static void cache_init(void){
+  int i;
+
+  if(initialized)
+    return;
+
+  for(i = 0; i < IO_CACHE_FILES; i++)
+    files[i].fd = -1;
+  for(i = 0; i < IO_CACHE_PAGES; i++){
+    pages[i].file = -1;
+    pages[i].next = -1;
+  }
+  for(i = 0; i < IO_CACHE_BUCKETS; i++)
+    buckets[i] = -1;
+  initialized = 1;
+}
+
+static int find_file(int fd){
+  int i;
+
+  if(!initialized || fd < 0)
+    return -1;
+
+  for(i = 0; i < IO_CACHE_FILES; i++){
+    if(files[i].fd == fd)
+      return i;
+  }
+  return -1;
+}
+
+static inline int page_dirty(struct cache_page* pg){
+  return pg->dirty_lo != pg->dirty_hi;
+}
+
+static inline int bucket_of(int file, uintptr_t index){
+  return (index * 31 + file) % IO_CACHE_BUCKETS;
+}
+
+static int page_lookup(int file, uintptr_t index){
+  int p;
+
+  for(p = buckets[bucket_of(file, index)]; p >= 0; p = pages[p].next){
+    if(pages[p].file == file && pages[p].index == index)
+      return p;
+  }
+  return -1;
+}
+
+static void page_hash(int p){
+  int b = bucket_of(pages[p].file, pages[p].index);
+
+  pages[p].next = buckets[b];
+  buckets[b] = p;
+}
+
+static void page_release(int p){
+  int* link = &buckets[bucket_of(pages[p].file, pages[p].index)];
+
+  while(*link >= 0){
+    if(*link == p){
+      *link = pages[p].next;
+      break;
+    }
+    link = &pages[*link].next;
+  }
+
+  pages[p].file = -1;
+  pages[p].next = -1;
+  pages[p].dirty_lo = pages[p].dirty_hi = 0;
+}
+
+/* Proxied pread/pwrite working directly on the shared buffer, so the data is
+ * copied only once between it and the cache pages. These must not go through
+ * io_syscall_pread/pwrite, which are redirected back into the cache. */
+static unsigned char* host_buffer(void){
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  return ((sargs_SYS_pread64*)edge_syscall->data)->buf;
+}
+
+static size_t host_capacity(void){
+  uintptr_t buf = (uintptr_t)host_buffer();
+
+  if(buf >= shared_buffer + shared_buffer_size)
+    return 0;
+  return shared_buffer + shared_buffer_size - buf;
+}
+
+static uintptr_t host_rw(unsigned long syscall_num, int fd,
+                         size_t len, off_t offset){
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_SYS_pread64* args = (sargs_SYS_pread64*)edge_syscall->data;
+
+  if(edge_call_check_ptr_valid((uintptr_t)args->buf, len) != 0)
+    return -1;
+
+  edge_syscall->syscall_num = syscall_num;
+  args->fd = fd;
+  args->len = len;
+  args->offset = offset;
+
+  return dispatch_edgecall_syscall(edge_syscall,
+                                   sizeof(struct edge_syscall) +
+                                   sizeof(sargs_SYS_pread64) + len);
+}
+
+/* Writes back every dirty page of the file, lowest offset first. Dirty bytes
+ * that continue across page boundaries are coalesced into one pwrite. */
+static void flush_file(int file){
+  struct cache_file* f = &files[file];
+
+  while(1){
+    int first = -1, p;
+
+    for(p = 0; p < IO_CACHE_PAGES; p++){
+      if(pages[p].file == file && page_dirty(&pages[p]) &&
+         (first < 0 || pages[p].index < pages[first].index))
+        first = p;
+    }
+    if(first < 0)
+      break;
+
+    unsigned char* buf = host_buffer();
+    size_t cap = host_capacity();
+    off_t start = (off_t)pages[first].index * RISCV_PAGE_SIZE +
+                  pages[first].dirty_lo;
+    size_t len = 0;
+
+    for(p = first; p >= 0; ){
+      struct cache_page* pg = &pages[p];
+      size_t lo = pg->dirty_lo, hi = pg->dirty_hi;
+
+      if(len + (hi - lo) > cap)
+        break;
+
+      memcpy(buf + len, (void*)(pg->va + lo), hi - lo);
+      len += hi - lo;
+      pg->dirty_lo = pg->dirty_hi = 0;
+
+      if(hi != RISCV_PAGE_SIZE)
+        break;
+      p = page_lookup(file, pg->index + 1);
+      if(p >= 0 && (!page_dirty(&pages[p]) || pages[p].dirty_lo != 0))
+        break;
+    }
+
+    if(host_rw(SYS_pwrite64, f->fd, len, start) != len)
+      f->error = 1;
+    print_strace("[runtime] io cache wrote back %lu bytes at %li to %i\r\n",
+                 len, start, f->fd);
+  }
+}
+
+/* Returns a page slot that is not in use, evicting with a clock if the
+ * budget is exhausted. Evicting a dirty page writes back its whole file,
+ * so nothing may be pending in the shared buffer when this is called. */
+static int page_alloc(void){
+  int p, spare = -1;
+  size_t scanned;
+
+  for(p = 0; p < IO_CACHE_PAGES; p++){
+    if(pages[p].file >= 0)
+      continue;
+    if(pages[p].va)
+      return p;
+    if(spare < 0)
+      spare = p;
+  }
+
+  if(spare >= 0){
+    pages[spare].va = spa_get();
+    if(pages[spare].va)
+      return spare;
+  }
+
+  /* two rounds clear every reference bit */
+  for(scanned = 0; scanned < 2 * IO_CACHE_PAGES; scanned++){
+    struct cache_page* pg = &pages[clock_hand];
+
+    p = clock_hand;
+    clock_hand = (clock_hand + 1) % IO_CACHE_PAGES;
+
+    if(pg->file < 0 || pg->busy)
+      continue;
+    if(pg->referenced){
+      pg->referenced = 0;
+      continue;
+    }
+
+    if(page_dirty(pg))
+      flush_file(pg->file);
+    page_release(p);
+    return p;
+  }
+  return -1;
+}
+
+/* Copies [lo, hi) of the page from src, of which only avail bytes were
+ * returned by the host; the rest is past the end of the file. */
+static void fill_bytes(uintptr_t va, size_t lo, size_t hi,
+                       unsigned char* src, size_t avail){
+  if(avail < lo)
+    avail = lo;
+  if(avail > hi)
+    avail = hi;
+
+  memcpy((void*)(va + lo), src + lo, avail - lo);
+  memset((void*)(va + avail), 0, hi - avail);
+}
+
+/* Reads count consecutive pages of the file starting at index with a single
+ * proxied pread. Bytes already dirty in a page are kept. */
+static int page_fill(int file, int* slots, size_t count, uintptr_t index){
+  size_t len = count * RISCV_PAGE_SIZE;
+  uintptr_t ret = host_rw(SYS_pread64, files[file].fd, len,
+                          (off_t)index * RISCV_PAGE_SIZE);
+  unsigned char* buf = host_buffer();
+  size_t i;
+
+  if((intptr_t)ret < 0)
+    return -1;
+
+  for(i = 0; i < count; i++){
+    struct cache_page* pg = &pages[slots[i]];
+    unsigned char* src = buf + i * RISCV_PAGE_SIZE;
+    size_t avail = ret > i * RISCV_PAGE_SIZE ? ret - i * RISCV_PAGE_SIZE : 0;
+
+    if(page_dirty(pg)){
+      fill_bytes(pg->va, 0, pg->dirty_lo, src, avail);
+      fill_bytes(pg->va, pg->dirty_hi, RISCV_PAGE_SIZE, src, avail);
+    }
+    else{
+      fill_bytes(pg->va, 0, RISCV_PAGE_SIZE, src, avail);
+    }
+    pg->valid = 1;
+  }
+  return 0;
+}
+
+/* Returns the slot of a valid page, reading it (and the pages after it on a
+ * sequential miss) from the host if needed. */
+static int page_get(int file, uintptr_t index){
+  struct cache_file* f = &files[file];
+  int slots[IO_CACHE_READAHEAD];
+  size_t count, filled = 0, i;
+  uintptr_t eof;
+  int p = page_lookup(file, index);
+
+  if(p >= 0){
+    pages[p].referenced = 1;
+    if(pages[p].valid || page_fill(file, &p, 1, index) == 0)
+      return p;
+    return -1;
+  }
+
+  /* double the window on sequential misses, start over on random ones */
+  if(index == f->ra_next)
+    f->ra_pages = f->ra_pages * 2 > IO_CACHE_READAHEAD ?
+                  IO_CACHE_READAHEAD : f->ra_pages * 2;
+  else
+    f->ra_pages = 1;
+
+  count = f->ra_pages;
+  eof = PAGE_INDEX(f->size + RISCV_PAGE_SIZE - 1);
+  if(index + count > eof)
+    count = eof > index ? eof - index : 1;
+  if(count > host_capacity() / RISCV_PAGE_SIZE)
+    count = host_capacity() / RISCV_PAGE_SIZE;
+  if(count > IO_CACHE_PAGES / 2)
+    count = IO_CACHE_PAGES / 2;
+  if(count == 0)
+    count = 1;
+
+  /* allocate the whole window first, eviction may use the shared buffer */
+  for(i = 0; i < count; i++){
+    if(i > 0 && page_lookup(file, index + i) >= 0)
+      break;
+    if((p = page_alloc()) < 0)
+      break;
+
+    pages[p].file = file;
+    pages[p].index = index + i;
+    pages[p].dirty_lo = pages[p].dirty_hi = 0;
+    pages[p].valid = 0;
+    pages[p].referenced = 1;
+    pages[p].busy = 1;
+    slots[filled++] = p;
+  }
+
+  if(filled == 0)
+    return -1;
+
+  int ret = page_fill(file, slots, filled, index);
+
+  for(i = 0; i < filled; i++){
+    pages[slots[i]].busy = 0;
+    if(ret == 0)
+      page_hash(slots[i]);
+    else
+      pages[slots[i]].file = -1;
+  }
+
+  f->ra_next = index + filled;
+  print_strace("[runtime] io cache read %lu pages at %lu from %i\r\n",
+               filled, index, f->fd);
+  return ret == 0 ? slots[0] : -1;
+}
+
+static uintptr_t cache_pread(int file, void* buf, size_t len, off_t offset){
+  struct cache_file* f = &files[file];
+  size_t done = 0;
+
+  if(offset >= f->size)
+    return 0;
+  if(len > f->size - offset)
+    len = f->size - offset;
+
+  while(done < len){
+    off_t pos = offset + done;
+    size_t pgoff = PAGE_OFFSET(pos);
+    size_t chunk = RISCV_PAGE_SIZE - pgoff;
+    int p = page_get(file, PAGE_INDEX(pos));
+
+    if(p < 0)
+      return done ? done : (uintptr_t)-1;
+    if(chunk > len - done)
+      chunk = len - done;
+
+    copy_to_user((char*)buf + done, (void*)(pages[p].va + pgoff), chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+static uintptr_t cache_pwrite(int file, void* buf, size_t len, off_t offset){
+  struct cache_file* f = &files[file];
+  size_t done = 0;
+
+  while(done < len){
+    off_t pos = offset + done;
+    uintptr_t index = PAGE_INDEX(pos);
+    size_t lo = PAGE_OFFSET(pos);
+    size_t hi = lo + len - done > RISCV_PAGE_SIZE ? RISCV_PAGE_SIZE : lo + len - done;
+    int p = page_lookup(file, index);
+
+    if(p < 0){
+      if((p = page_alloc()) < 0)
+        break;
+
+      pages[p].file = file;
+      pages[p].index = index;
+      pages[p].dirty_lo = pages[p].dirty_hi = 0;
+      /* there is nothing to read past the end of the file */
+      pages[p].valid = (off_t)index * RISCV_PAGE_SIZE >= f->size;
+      if(pages[p].valid)
+        memset((void*)pages[p].va, 0, RISCV_PAGE_SIZE);
+      page_hash(p);
+    }
+
+    struct cache_page* pg = &pages[p];
+    pg->referenced = 1;
+
+    /* the bytes between two disjoint writes to a page that was never read
+     * are unknown, so the earlier one has to go out first */
+    if(!pg->valid && page_dirty(pg) && (hi < pg->dirty_lo || lo > pg->dirty_hi))
+      flush_file(file);
+
+    copy_from_user((void*)(pg->va + lo), (char*)buf + done, hi - lo);
+
+    if(page_dirty(pg)){
+      pg->dirty_lo = lo < pg->dirty_lo ? lo : pg->dirty_lo;
+      pg->dirty_hi = hi > pg->dirty_hi ? hi : pg->dirty_hi;
+    }
+    else{
+      pg->dirty_lo = lo;
+      pg->dirty_hi = hi;
+    }
+    if(pg->dirty_lo == 0 && pg->dirty_hi == RISCV_PAGE_SIZE)
+      pg->valid = 1;
+
+    done += hi - lo;
+    if(offset + (off_t)done > f->size)
+      f->size = offset + done;
+  }
+
+  return done == 0 && len ? (uintptr_t)-1 : done;
+}
+
+static void drop_pages(int file, uintptr_t from){
+  int p;
+
+  for(p = 0; p < IO_CACHE_PAGES; p++){
+    if(pages[p].file == file && pages[p].index >= from)
+      page_release(p);
+  }
+}
+
+static uintptr_t track(int fd, int flags, off_t pos){
+  struct stat st;
+  int i;
+
+  cache_init();
+
+  if(host_capacity() < RISCV_PAGE_SIZE)
+    return -1;
+  if(io_syscall_fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    return -1;
+
+  for(i = 0; i < IO_CACHE_FILES; i++){
+    if(files[i].fd >= 0)
+      continue;
+
+    files[i].fd = fd;
+    files[i].flags = flags & (O_ACCMODE | O_APPEND);
+    files[i].error = 0;
+    files[i].pos = pos;
+    files[i].size = st.st_size;
+    files[i].ra_next = PAGE_INDEX(pos);
+    files[i].ra_pages = 1;
+    print_strace("[runtime] io cache tracking %i (size %li)\r\n", fd, st.st_size);
+    return 0;
+  }
+  return -1;
+}
+
+int io_cache_owns(int fd){
+  return find_file(fd) >= 0;
+}
+
+void io_cache_opened(int fd, int flags){
+  int file = find_file(fd);
+
+  if(fd < 0)
+    return;
+
+  /* the host reused a descriptor that was closed behind our back */
+  if(file >= 0){
+    drop_pages(file, 0);
+    files[file].fd = -1;
+  }
+
+  if((flags & O_ACCMODE) == O_RDONLY)
+    track(fd, flags, 0);
+}
+
+uintptr_t io_cache_set(int fd, int enable){
+  int file = find_file(fd);
+
+  if(!enable){
+    if(file < 0)
+      return 0;
+
+    off_t pos = files[file].pos;
+    int err = io_cache_close(fd);
+
+    /* hand the file back with the host offset where the enclave left it */
+    if(io_syscall_lseek(fd, pos, SEEK_SET) != pos)
+      err = -1;
+    return err;
+  }
+
+  if(file >= 0)
+    return 0;
+
+  int flags = io_syscall_fcntl(fd, F_GETFL, 0);
+  off_t pos = io_syscall_lseek(fd, 0, SEEK_CUR);
+
+  if(flags < 0 || pos < 0)
+    return -1;
+  return track(fd, flags, pos);
+}
+
+void io_cache_setfl(int fd, int flags){
+  int file = find_file(fd);
+
+  if(file >= 0)
+    files[file].flags = (files[file].flags & O_ACCMODE) | (flags & O_APPEND);
+}
+
+uintptr_t io_cache_read(int fd, void* buf, size_t len){
+  struct cache_file* f = &files[find_file(fd)];
+  uintptr_t ret = -1;
+
+  if((f->flags & O_ACCMODE) != O_WRONLY)
+    ret = cache_pread(f - files, buf, len, f->pos);
+  if((intptr_t)ret > 0)
+    f->pos += ret;
+
+  print_strace("[runtime] cached read from %i (size: %lu) = %li\r\n", fd, len, ret);
+  return ret;
+}
+
+uintptr_t io_cache_write(int fd, void* buf, size_t len){
+  struct cache_file* f = &files[find_file(fd)];
+  uintptr_t ret = -1;
+
+  if((f->flags & O_ACCMODE) != O_RDONLY){
+    if(f->flags & O_APPEND)
+      f->pos = f->size;
+    ret = cache_pwrite(f - files, buf, len, f->pos);
+  }
+  if((intptr_t)ret > 0)
+    f->pos += ret;
+
+  print_strace("[runtime] cached write to %i (size: %lu) = %li\r\n", fd, len, ret);
+  return ret;
+}
+
+uintptr_t io_cache_pread(int fd, void* buf, size_t len, off_t offset){
+  int file = find_file(fd);
+
+  if(offset < 0 || (files[file].flags & O_ACCMODE) == O_WRONLY)
+    return -1;
+  return cache_pread(file, buf, len, offset);
+}
+
+uintptr_t io_cache_pwrite(int fd, void* buf, size_t len, off_t offset){
+  int file = find_file(fd);
+
+  if(offset < 0 || (files[file].flags & O_ACCMODE) == O_RDONLY)
+    return -1;
+  return cache_pwrite(file, buf, len, offset);
+}
+
+uintptr_t io_cache_lseek(int fd, off_t offset, int whence){
+  struct cache_file* f = &files[find_file(fd)];
+  off_t pos;
+
+  switch(whence){
+  case(SEEK_SET):
+    pos = offset;
+    break;
+  case(SEEK_CUR):
+    pos = f->pos + offset;
+    break;
+  case(SEEK_END):
+    pos = f->size + offset;
+    break;
+  default:
+    return -1;
+  }
+
+  if(pos < 0)
+    return -1;
+
+  f->pos = pos;
+  print_strace("[runtime] cached lseek (on fd:%i to %li from %i) = %li\r\n",
+               fd, offset, whence, pos);
+  return pos;
+}
+
+int io_cache_flush(int fd){
+  int file = find_file(fd);
+  int err;
+
+  if(file < 0)
+    return 0;
+
+  flush_file(file);
+  err = files[file].error;
+  files[file].error = 0;
+  return err ? -1 : 0;
+}
+
+int io_cache_flush_all(void){
+  int i, err = 0;
+
+  for(i = 0; initialized && i < IO_CACHE_FILES; i++){
+    if(files[i].fd >= 0 && io_cache_flush(files[i].fd) != 0)
+      err = -1;
+  }
+  return err;
+}
+
+int io_cache_truncate(int fd, off_t length){
+  int file = find_file(fd);
+  int err, p;
+
+  if(file < 0 || length < 0)
+    return 0;
+
+  err = io_cache_flush(fd);
+  drop_pages(file, PAGE_INDEX(length + RISCV_PAGE_SIZE - 1));
+
+  /* the tail of the last page reads back as zeroes if the file grows again */
+  p = page_lookup(file, PAGE_INDEX(length));
+  if(p >= 0 && PAGE_OFFSET(length))
+    memset((void*)(pages[p].va + PAGE_OFFSET(length)), 0,
+           RISCV_PAGE_SIZE - PAGE_OFFSET(length));
+
+  files[file].size = length;
+  return err;
+}
+
+int io_cache_close(int fd){
+  int file = find_file(fd);
+  int err;
+
+  if(file < 0)
+    return 0;
+
+  err = io_cache_flush(fd);
+  drop_pages(file, 0);
+  files[file].fd = -1;
+  return err;
+}
+
+#endif /* USE_IO_SYSCALL && USE_IO_CACHE */
@@ -1,6 +1,7 @@
 #ifdef USE_IO_SYSCALL
 #include <stdint.h>
 #include "call/io_wrap.h"
+#include "call/io_cache.h"
 #include <alloca.h>
 #include "uaccess.h"
 #include "call/syscall.h"
@@ -23,6 +24,9 @@
 #define MAX_STRACE_PRINT 20
 
 uintptr_t io_syscall_sync(){
+#ifdef USE_IO_CACHE
+  io_cache_flush_all();
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
 
   edge_syscall->syscall_num = SYS_sync;
@@ -35,6 +39,9 @@ uintptr_t io_syscall_sync(){
 }
 
 uintptr_t io_syscall_ftruncate(int fd, off_t offset){
+#ifdef USE_IO_CACHE
+  int flush_err = io_cache_truncate(fd, offset);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_ftruncate* args = (sargs_SYS_ftruncate*)edge_syscall->data;
   edge_syscall->syscall_num = SYS_ftruncate;
@@ -46,10 +53,19 @@ uintptr_t io_syscall_ftruncate(int fd, off_t offset){
                       sizeof(sargs_SYS_ftruncate));
 
   uintptr_t ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
+#ifdef USE_IO_CACHE
+  // the dirty pages written back before truncating may have failed
+  if(flush_err && ret == 0)
+    ret = -1;
+#endif
   print_strace("[runtime] proxied ftruncate (%i) = %li\r\n", fd, ret);
   return ret;
 }
 uintptr_t io_syscall_fsync(int fd){
+#ifdef USE_IO_CACHE
+  if(io_cache_flush(fd) != 0)
+    return -1;
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_fsync* args = (sargs_SYS_fsync*)edge_syscall->data;
   edge_syscall->syscall_num = SYS_fsync;
@@ -65,6 +81,10 @@ uintptr_t io_syscall_fsync(int fd){
 }
 
 uintptr_t io_syscall_lseek(int fd, off_t offset, int whence){
+#ifdef USE_IO_CACHE
+  if(io_cache_owns(fd))
+    return io_cache_lseek(fd, offset, whence);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_lseek* args = (sargs_SYS_lseek*)edge_syscall->data;
   edge_syscall->syscall_num = SYS_lseek;
@@ -83,6 +103,9 @@ uintptr_t io_syscall_lseek(int fd, off_t offset, int whence){
 }
 
 uintptr_t io_syscall_close(int fd){
+#ifdef USE_IO_CACHE
+  int flush_err = io_cache_close(fd);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_close* args = (sargs_SYS_close*)edge_syscall->data;
   edge_syscall->syscall_num = SYS_close;
@@ -93,11 +116,20 @@ uintptr_t io_syscall_close(int fd){
                       sizeof(sargs_SYS_close));
 
   uintptr_t ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
+#ifdef USE_IO_CACHE
+  // Like Linux, a failed write-back is reported by close
+  if(flush_err && ret == 0)
+    ret = -1;
+#endif
   print_strace("[runtime] proxied close (%i) = %li\r\n", fd, ret);
   return ret;
 }
 
 uintptr_t io_syscall_read(int fd, void* buf, size_t len){
+#ifdef USE_IO_CACHE
+  if(io_cache_owns(fd))
+    return io_cache_read(fd, buf, len);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_read* args = (sargs_SYS_read*)edge_syscall->data;
   uintptr_t ret = -1;
@@ -129,6 +161,10 @@ uintptr_t io_syscall_read(int fd, void* buf, size_t len){
 }
 
 uintptr_t io_syscall_write(int fd, void* buf, size_t len){
+#ifdef USE_IO_CACHE
+  if(io_cache_owns(fd))
+    return io_cache_write(fd, buf, len);
+#endif
   /* print_strace("[write] len :%lu\r\n", len); */
   /* if(len > 0){ */
   /*   size_t stracelen = len > MAX_STRACE_PRINT? MAX_STRACE_PRINT:len; */
@@ -164,6 +200,76 @@ uintptr_t io_syscall_write(int fd, void* buf, size_t len){
   return ret;
 }
 
+uintptr_t io_syscall_pread(int fd, void* buf, size_t len, off_t offset){
+#ifdef USE_IO_CACHE
+  if(io_cache_owns(fd))
+    return io_cache_pread(fd, buf, len, offset);
+#endif
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_SYS_pread64* args = (sargs_SYS_pread64*)edge_syscall->data;
+  uintptr_t ret = -1;
+
+  edge_syscall->syscall_num = SYS_pread64;
+  args->fd = fd;
+  args->len = len;
+  args->offset = offset;
+
+  // Sanity check that the read buffer will fit in the shared memory
+  if(edge_call_check_ptr_valid((uintptr_t)args->buf, len) != 0){
+    goto done;
+  }
+
+  size_t totalsize = (sizeof(struct edge_syscall) +
+                      sizeof(sargs_SYS_pread64) +
+                      len);
+
+  ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
+
+  if((int)ret < 0){
+    goto done;
+  }
+
+  copy_to_user(buf, args->buf, ret > len? len: ret);
+
+ done:
+  print_strace("[runtime] proxied pread from %i (size: %lu, offset %li) = %li\r\n",
+               fd, len, offset, ret);
+  return ret;
+}
+
+uintptr_t io_syscall_pwrite(int fd, void* buf, size_t len, off_t offset){
+#ifdef USE_IO_CACHE
+  if(io_cache_owns(fd))
+    return io_cache_pwrite(fd, buf, len, offset);
+#endif
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_SYS_pwrite64* args = (sargs_SYS_pwrite64*)edge_syscall->data;
+  uintptr_t ret = -1;
+
+  edge_syscall->syscall_num = SYS_pwrite64;
+  args->fd = fd;
+  args->len = len;
+  args->offset = offset;
+
+  // Sanity check that the write buffer will fit in the shared memory
+  if(edge_call_check_ptr_valid((uintptr_t)args->buf, len) != 0){
+    goto done;
+  }
+
+  copy_from_user(args->buf, buf, len);
+
+  size_t totalsize = (sizeof(struct edge_syscall) +
+                      sizeof(sargs_SYS_pwrite64) +
+                      len);
+
+  ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
+
+ done:
+  print_strace("[runtime] proxied pwrite to %i (size: %lu, offset %li) = %li\r\n",
+               fd, len, offset, ret);
+  return ret;
+}
+
 uintptr_t io_syscall_openat(int dirfd, char* path,
                             int flags, mode_t mode){
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
@@ -195,6 +301,10 @@ uintptr_t io_syscall_openat(int dirfd, char* path,
   print_strace("[runtime] proxied openat(path: %.*s) = %li\r\n",
                pathlen>MAX_STRACE_PRINT?MAX_STRACE_PRINT:pathlen,args->path, ret);
 
+#ifdef USE_IO_CACHE
+  io_cache_opened((int)ret, flags);
+#endif
+
   return ret;
 }
 
@@ -356,6 +466,10 @@ uintptr_t io_syscall_epoll_ctl(int epfd, int op, int fd, uintptr_t event){
 }
 
 uintptr_t io_syscall_fcntl(int fd, int cmd, uintptr_t arg){ 
+#ifdef USE_IO_CACHE
+  if(cmd == EYRIE_F_SETCACHE)
+    return io_cache_set(fd, (int)arg);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_fcntl* args = (sargs_SYS_fcntl*)edge_syscall->data;
   uintptr_t ret = -1;
@@ -388,6 +502,11 @@ uintptr_t io_syscall_fcntl(int fd, int cmd, uintptr_t arg){
 
   ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
 
+#ifdef USE_IO_CACHE
+  if(cmd == F_SETFL && ret == 0)
+    io_cache_setfl(fd, (int)arg);
+#endif
+
  done: 
   print_strace("[runtime] proxied fcntl = %li\r\n", ret);
   return ret;
@@ -490,6 +609,9 @@ uintptr_t io_syscall_umask(int mask){
 }
   
 uintptr_t io_syscall_fstat(int fd, struct stat *statbuf){
+#ifdef USE_IO_CACHE
+  io_cache_flush(fd);
+#endif
   struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
   sargs_SYS_fstat* args = (sargs_SYS_fstat*)edge_syscall->data;
   uintptr_t ret = -1;
@@ -6,6 +6,8 @@
 #include <signal.h>
 #include <sys/mman.h>
 #include <sys/utsname.h>
+#include <errno.h>
+#include <sys/time.h>
 #include <time.h>
 
 #include "mm/freemem.h"
@@ -13,21 +15,143 @@
 #include "util/rt_util.h"
 #include "call/syscall.h"
 #include "uaccess.h"
+#include "mm/vm.h"
+#include "time_page.h"
+#ifdef USE_FILE_MMAP
+#include "call/file_mmap.h"
+#endif
 
 #define CLOCK_FREQ 1000000000
+#define NSEC_PER_SEC 1000000000UL
+
+static inline uint64_t rdtime(void){
+#if __riscv_xlen == 32
+  uint32_t hi, lo, hi2;
+  do {
+    __asm__ __volatile__("rdtimeh %0" : "=r"(hi));
+    __asm__ __volatile__("rdtime %0" : "=r"(lo));
+    __asm__ __volatile__("rdtimeh %0" : "=r"(hi2));
+  } while(hi != hi2);
+  return ((uint64_t) hi << 32) | lo;
+#else
+  uint64_t ticks;
+  __asm__ __volatile__("rdtime %0" : "=r"(ticks));
+  return ticks;
+#endif
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t hz){
+  /* split to avoid overflowing ticks * NSEC_PER_SEC */
+  return (ticks / hz) * NSEC_PER_SEC + (ticks % hz) * NSEC_PER_SEC / hz;
+}
+
+/* NULL until the host has published the time page */
+static struct keystone_time_page* published_time_page(void){
+  struct keystone_time_page* page = (struct keystone_time_page*) time_page;
+
+  if(!page || page->timebase_hz == 0)
+    return NULL;
+  return page;
+}
+
+/* Copies the time page so the host cannot change it while it is used, and
+ * checks the copy rather than the shared page */
+static int read_time_page(struct keystone_time_page* tp){
+  struct keystone_time_page* page = published_time_page();
+
+  if(!page)
+    return -EINVAL;
+  copy_from_user(tp, page, sizeof(*tp));
+  if(tp->timebase_hz == 0)
+    return -EINVAL;
+  return 0;
+}
+
+/* Computes the clocks from the time CSR and the host-published time page,
+ * so reading the time does not exit the enclave */
+static int clock_read_ns(__clockid_t clock, uint64_t* ns){
+  struct keystone_time_page tp;
+  uint64_t now = rdtime();
+
+  if(read_time_page(&tp) != 0)
+    return -EINVAL;
+
+  switch(clock){
+  case CLOCK_MONOTONIC:
+  case CLOCK_MONOTONIC_RAW:
+  case CLOCK_MONOTONIC_COARSE:
+  case CLOCK_BOOTTIME:
+    *ns = ticks_to_ns(now, tp.timebase_hz);
+    return 0;
+  case CLOCK_REALTIME:
+  case CLOCK_REALTIME_COARSE:
+    *ns = ticks_to_ns(now, tp.timebase_hz) + tp.realtime_offset_ns;
+    return 0;
+  case CLOCK_PROCESS_CPUTIME_ID:
+  case CLOCK_THREAD_CPUTIME_ID:
+    /* time since the first run, minus the time the enclave was stopped */
+    if(now < tp.start_ticks + tp.stopped_ticks)
+      now = tp.start_ticks + tp.stopped_ticks;
+    *ns = ticks_to_ns(now - tp.start_ticks - tp.stopped_ticks, tp.timebase_hz);
+    return 0;
+  default:
+    return -EINVAL;
+  }
+}
 
-//TODO we should check which clock this is
 uintptr_t linux_clock_gettime(__clockid_t clock, struct timespec *tp){
-  print_strace("[runtime] clock_gettime not fully supported (clock %x, assuming)\r\n", clock);
-  unsigned long cycles;
-  __asm__ __volatile__("rdcycle %0" : "=r"(cycles));
+  struct timespec ts;
+  uint64_t ns;
+
+  if(!published_time_page()){
+    /* no time page: fall back to counting cycles at an assumed 1GHz */
+    print_strace("[runtime] clock_gettime without a time page (clock %x, assuming)\r\n", clock);
+    unsigned long cycles;
+    __asm__ __volatile__("rdcycle %0" : "=r"(cycles));
+    ts.tv_sec = cycles / CLOCK_FREQ;
+    ts.tv_nsec = cycles % CLOCK_FREQ;
+  }
+  else if(clock_read_ns(clock, &ns) == 0){
+    ts.tv_sec = ns / NSEC_PER_SEC;
+    ts.tv_nsec = ns % NSEC_PER_SEC;
+  }
+  else {
+    return -EINVAL;
+  }
+
+  copy_to_user(tp, &ts, sizeof(ts));
+  return 0;
+}
 
-  unsigned long sec = cycles / CLOCK_FREQ;
-  unsigned long nsec = (cycles % CLOCK_FREQ);
+uintptr_t linux_clock_getres(__clockid_t clock, struct timespec *res){
+  struct keystone_time_page tp;
+  struct timespec ts = {0, 1};
+  uint64_t ns;
 
-  copy_to_user(&(tp->tv_sec), &sec, sizeof(unsigned long));
-  copy_to_user(&(tp->tv_nsec), &nsec, sizeof(unsigned long));
+  if(clock_read_ns(clock, &ns) != 0 || read_time_page(&tp) != 0)
+    return -EINVAL;
 
+  if(res){
+    ts.tv_nsec = (NSEC_PER_SEC + tp.timebase_hz - 1) / tp.timebase_hz;
+    copy_to_user(res, &ts, sizeof(ts));
+  }
+  return 0;
+}
+
+uintptr_t linux_gettimeofday(struct timeval *tv, struct timezone *tz){
+  struct timezone utc = {0, 0};
+  struct timeval tval;
+  uint64_t ns;
+
+  if(tv){
+    if(clock_read_ns(CLOCK_REALTIME, &ns) != 0)
+      return -EINVAL;
+    tval.tv_sec = ns / NSEC_PER_SEC;
+    tval.tv_usec = (ns % NSEC_PER_SEC) / 1000;
+    copy_to_user(tv, &tval, sizeof(tval));
+  }
+  if(tz)
+    copy_to_user(tz, &utc, sizeof(utc));
   return 0;
 }
 
@@ -102,6 +226,10 @@ uintptr_t linux_uname(void* buf){
 uintptr_t syscall_munmap(void *addr, size_t length){
   uintptr_t ret = (uintptr_t)((void*)-1);
 
+#ifdef USE_FILE_MMAP
+  if(file_munmap((uintptr_t)addr, length) != 0)
+    return ret;
+#endif
   free_pages(vpn((uintptr_t)addr), length/RISCV_PAGE_SIZE);
   ret = 0;
   tlb_flush();
@@ -114,11 +242,6 @@ uintptr_t syscall_mmap(void *addr, size_t length, int prot, int flags,
 
   int pte_flags = PTE_U | PTE_A;
 
-  if(flags != (MAP_ANONYMOUS | MAP_PRIVATE) || fd != -1){
-    // we don't support mmaping any other way yet
-    goto done;
-  }
-
   // Set flags
   if(prot & PROT_READ)
     pte_flags |= PTE_R;
@@ -127,6 +250,18 @@ uintptr_t syscall_mmap(void *addr, size_t length, int prot, int flags,
   if(prot & PROT_EXEC)
     pte_flags |= PTE_X;
 
+#ifdef USE_FILE_MMAP
+  if(flags == MAP_PRIVATE && fd >= 0){
+    ret = file_mmap(length, pte_flags, fd, offset);
+    goto done;
+  }
+#endif
+
+  if(flags != (MAP_ANONYMOUS | MAP_PRIVATE) || fd != -1){
+    // we don't support mmaping any other way yet
+    goto done;
+  }
+
 
 
   // Find a continuous VA space that will fit the req. size
@@ -175,8 +310,19 @@ uintptr_t syscall_mprotect(void *addr, size_t len, int prot) {
   if(prot & PROT_EXEC)
     pte_flags |= PTE_X;
 
+#ifdef USE_FILE_MMAP
+  if(file_mprotect((uintptr_t) addr, len, pte_flags) != 0)
+    return -1;
+#endif
+
   for(i = 0; i < pages; i++) {
     ret = realloc_page(vpn((uintptr_t) addr) + i, pte_flags);
+#ifdef USE_FILE_MMAP
+    // File pages that were never touched take the new flags when faulted in
+    pte* entry = pte_of_va((uintptr_t) addr + i * RISCV_PAGE_SIZE);
+    if(!ret && entry && (*entry & PTE_LAZY))
+      continue;
+#endif
     if(!ret)
       return -1;
   }
@@ -1,4 +1,5 @@
 #ifdef USE_NET_SYSCALL
+#define _GNU_SOURCE
 #include <stdint.h>
 #include "call/io_wrap.h"
 #include <alloca.h>
@@ -6,6 +7,7 @@
 #include "call/syscall.h"
 #include "util/string.h"
 #include "edge_syscall.h"
+#include "mm/vm.h"
 #include <sys/epoll.h>
 #include <sys/time.h>
 #include <sys/select.h>
@@ -240,6 +242,219 @@ uintptr_t io_syscall_sendto(int sockfd, uintptr_t buf, size_t len, int flags,
 		return ret; 
 }
 
+/* Messages proxied per exit; a longer batch is cut short */
+#define PROXY_MSGS_MAX 64
+
+/* The layout of each packed message, kept here so that unpacking does not
+ * trust the copy in shared memory, which the host can change */
+struct msg_layout {
+	socklen_t namecap;
+	socklen_t namelen;  // msg_namelen the eapp passed
+	size_t cap;
+};
+
+static struct msg_layout msg_layout[PROXY_MSGS_MAX];
+
+/* Packs the messages of sendmsg/recvmsg/sendmmsg/recvmmsg into the shared
+ * buffer (see sargs_msg), so a whole batch costs one exit. msgvec points to
+ * msghdrs for the single-message calls and to mmsghdrs for the batched ones.
+ * Returns the number of messages that fit. */
+static unsigned int pack_msgs(sargs_SYS_sendmmsg* args, uintptr_t msgvec,
+                              size_t stride, unsigned int vlen, int send) {
+	unsigned char* pos = args->msgs;
+	unsigned int i;
+
+	if (vlen > PROXY_MSGS_MAX)
+		vlen = PROXY_MSGS_MAX;
+
+	for (i = 0; i < vlen; i++) {
+		sargs_msg* entry = (sargs_msg*) pos;
+		struct msghdr hdr;
+		struct iovec iov;
+		socklen_t namecap;
+		size_t cap = 0, space, left, j;
+
+		if ((uintptr_t) pos >= shared_buffer + shared_buffer_size)
+			break;
+		space = shared_buffer + shared_buffer_size - (uintptr_t) pos;
+
+		copy_from_user(&hdr, (void*) (msgvec + i * stride), sizeof(struct msghdr));
+
+		/* Ancillary data is not proxied */
+		if (send && hdr.msg_controllen)
+			break;
+
+		/* a message whose iovecs wrap around or cannot fit is not packed */
+		for (j = 0; j < hdr.msg_iovlen; j++) {
+			copy_from_user(&iov, &hdr.msg_iov[j], sizeof(struct iovec));
+			if (cap + iov.iov_len < cap || cap + iov.iov_len > space)
+				break;
+			cap += iov.iov_len;
+		}
+		if (j < hdr.msg_iovlen)
+			break;
+
+		namecap = hdr.msg_name ? hdr.msg_namelen : 0;
+		if (namecap > sizeof(struct sockaddr_storage))
+			namecap = sizeof(struct sockaddr_storage);
+
+		if(edge_call_check_ptr_valid((uintptr_t)entry, SARGS_MSG_SIZE(namecap, cap)) != 0)
+			break;
+
+		msg_layout[i].namecap = namecap;
+		msg_layout[i].namelen = hdr.msg_name ? hdr.msg_namelen : 0;
+		msg_layout[i].cap = cap;
+
+		entry->namecap = namecap;
+		entry->namelen = namecap;
+		entry->cap = cap;
+		entry->len = send ? cap : 0;
+		entry->flags = 0;
+
+		if (send) {
+			unsigned char* data = entry->buf + SARGS_MSG_PAD(namecap);
+			if (namecap)
+				copy_from_user(entry->buf, hdr.msg_name, namecap);
+			/* the eapp may have changed its iovecs since they were sized */
+			left = cap;
+			for (j = 0; j < hdr.msg_iovlen && left > 0; j++) {
+				copy_from_user(&iov, &hdr.msg_iov[j], sizeof(struct iovec));
+				if (iov.iov_len > left)
+					iov.iov_len = left;
+				copy_from_user(data, iov.iov_base, iov.iov_len);
+				data += iov.iov_len;
+				left -= iov.iov_len;
+			}
+		}
+
+		pos += SARGS_MSG_SIZE(namecap, cap);
+	}
+
+	args->msgs_len = pos - args->msgs;
+	return i;
+}
+
+/* Copies the results of the first count messages back to the eapp */
+static void unpack_msgs(sargs_SYS_sendmmsg* args, uintptr_t msgvec,
+                        size_t stride, unsigned int count, int recv, int batched) {
+	unsigned char* pos = args->msgs;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		sargs_msg* entry = (sargs_msg*) pos;
+		uintptr_t user_msg = msgvec + i * stride;
+		const struct msg_layout* layout = &msg_layout[i];
+		size_t len = entry->len;
+
+		if (len > layout->cap)
+			len = layout->cap;
+
+		if (recv) {
+			unsigned char* data = entry->buf + SARGS_MSG_PAD(layout->namecap);
+			socklen_t namelen = entry->namelen;
+			size_t left = len;
+			struct msghdr hdr;
+			struct iovec iov;
+			size_t j;
+
+			copy_from_user(&hdr, (void*) user_msg, sizeof(struct msghdr));
+			for (j = 0; j < hdr.msg_iovlen && left > 0; j++) {
+				copy_from_user(&iov, &hdr.msg_iov[j], sizeof(struct iovec));
+				if (iov.iov_len > left)
+					iov.iov_len = left;
+				copy_to_user(iov.iov_base, data, iov.iov_len);
+				data += iov.iov_len;
+				left -= iov.iov_len;
+			}
+
+			if (namelen > layout->namelen)
+				namelen = layout->namelen;
+			if (layout->namecap)
+				copy_to_user(hdr.msg_name, entry->buf,
+				             namelen > layout->namecap ? layout->namecap : namelen);
+			hdr.msg_namelen = namelen;
+			hdr.msg_flags = entry->flags;
+			hdr.msg_controllen = 0;
+			copy_to_user((void*) user_msg, &hdr, sizeof(struct msghdr));
+		}
+
+		if (batched) {
+			unsigned int msg_len = len;
+			copy_to_user(&((struct mmsghdr*) user_msg)->msg_len, &msg_len, sizeof(unsigned int));
+		}
+
+		pos += SARGS_MSG_SIZE(layout->namecap, layout->cap);
+	}
+}
+
+static uintptr_t proxy_msgs(unsigned long syscall_num, int sockfd, uintptr_t msgvec,
+                            unsigned int vlen, int flags, uintptr_t timeout) {
+	int batched = (syscall_num == SYS_sendmmsg || syscall_num == SYS_recvmmsg);
+	int recv = (syscall_num == SYS_recvmsg || syscall_num == SYS_recvmmsg);
+	size_t stride = batched ? sizeof(struct mmsghdr) : sizeof(struct msghdr);
+	uintptr_t ret = -1;
+	unsigned int packed = 0;
+	struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+	edge_syscall->syscall_num = syscall_num;
+
+	sargs_SYS_sendmmsg *args = (sargs_SYS_sendmmsg *) edge_syscall->data;
+
+	if(edge_call_check_ptr_valid((uintptr_t)args, sizeof(sargs_SYS_sendmmsg)) != 0){
+		goto done;
+	}
+
+	args->sockfd = sockfd;
+	args->flags = flags;
+	args->timeout_is_null = (timeout == 0);
+	if (timeout != 0) {
+		copy_from_user(&args->timeout, (void *) timeout, sizeof(struct timespec));
+	}
+
+	/* A batch is cut short after PROXY_MSGS_MAX messages or where the
+	 * shared buffer fills up, but at least one message has to fit */
+	packed = pack_msgs(args, msgvec, stride, vlen, !recv);
+	args->vlen = packed;
+	if (packed == 0 && vlen > 0) {
+		goto done;
+	}
+
+	size_t totalsize = sizeof(struct edge_syscall) + sizeof(sargs_SYS_sendmmsg) + args->msgs_len;
+	ret = dispatch_edgecall_syscall(edge_syscall, totalsize);
+
+	if ((int) ret >= 0) {
+		/* the host cannot report more messages, or more bytes, than were
+		 * packed */
+		if (batched && ret > packed)
+			ret = packed;
+		if (!batched && packed && ret > msg_layout[0].cap)
+			ret = msg_layout[0].cap;
+		if (packed)
+			unpack_msgs(args, msgvec, stride, batched ? ret : 1, recv, batched);
+	}
+
+	done:
+		print_strace("[runtime] proxied msg syscall %lu (%u of %u messages): %li \r\n",
+		             syscall_num, packed, vlen, ret);
+		return ret;
+}
+
+uintptr_t io_syscall_sendmsg(int sockfd, uintptr_t msg, int flags) {
+	return proxy_msgs(SYS_sendmsg, sockfd, msg, 1, flags, 0);
+}
+
+uintptr_t io_syscall_recvmsg(int sockfd, uintptr_t msg, int flags) {
+	return proxy_msgs(SYS_recvmsg, sockfd, msg, 1, flags, 0);
+}
+
+uintptr_t io_syscall_sendmmsg(int sockfd, uintptr_t msgvec, unsigned int vlen, int flags) {
+	return proxy_msgs(SYS_sendmmsg, sockfd, msgvec, vlen, flags, 0);
+}
+
+uintptr_t io_syscall_recvmmsg(int sockfd, uintptr_t msgvec, unsigned int vlen, int flags,
+                              uintptr_t timeout) {
+	return proxy_msgs(SYS_recvmmsg, sockfd, msgvec, vlen, flags, timeout);
+}
+
 uintptr_t io_syscall_sendfile(int out_fd, int in_fd, uintptr_t offset, int count) {
 	uintptr_t ret = -1;
 	struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
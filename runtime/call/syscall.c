@@ -26,6 +26,18 @@
 #include "call/net_wrap.h"
 #endif /* USE_NET_SYSCALL */
 
+#ifdef USE_FILE_MMAP
+#include "call/file_mmap.h"
+#endif /* USE_FILE_MMAP */
+
+#ifdef USE_PROFILER
+#include "sys/profiler.h"
+#endif /* USE_PROFILER */
+
+#if defined(USE_IO_SYSCALL) && defined(USE_IO_CACHE)
+#include "call/io_cache.h"
+#endif /* USE_IO_SYSCALL && USE_IO_CACHE */
+
 extern void exit_enclave(uintptr_t arg0);
 
 uintptr_t dispatch_edgecall_syscall(struct edge_syscall* syscall_data_ptr, size_t data_len){
@@ -127,20 +139,156 @@ uintptr_t dispatch_edgecall_ocall( unsigned long call_id,
   return 1;
 }
 
+/* User mapping of the shared buffer for generated edge calls, which lay
+ * out their arguments there directly instead of having them copied in */
+static uintptr_t shared_user_va;
+/* Bytes at the top of the shared buffer that the eapp keeps buffers in
+ * across calls. They are cut off shared_buffer_size, so the runtime never
+ * lays out a call over them. */
+static size_t shared_pinned;
+
+uintptr_t map_shared_to_user(size_t* size){
+  size_t mapped_size = shared_buffer_size + shared_pinned;
+  uintptr_t pages = vpn(PAGE_UP(mapped_size));
+  uintptr_t starting_vpn = vpn(EYRIE_ANON_REGION_START);
+  uintptr_t i;
+
+  if(!shared_user_va){
+    while((starting_vpn + pages) <= vpn(EYRIE_ANON_REGION_END)){
+      uintptr_t valid_pages = test_va_range(starting_vpn, pages);
+      if(valid_pages == pages)
+        break;
+      starting_vpn += valid_pages + 1;
+    }
+    if((starting_vpn + pages) > vpn(EYRIE_ANON_REGION_END))
+      return 0;
+
+    for(i = 0; i < pages; i++){
+      uintptr_t pa = translate(shared_buffer + (i << RISCV_PAGE_BITS));
+      map_page(starting_vpn + i, ppn(pa), PTE_U | PTE_R | PTE_W);
+    }
+    tlb_flush();
+    shared_user_va = starting_vpn << RISCV_PAGE_BITS;
+  }
+
+  copy_to_user(size, &mapped_size, sizeof(size_t));
+  return shared_user_va;
+}
+
+uintptr_t pin_shared_top(size_t size){
+  size_t total = shared_buffer_size + shared_pinned;
+
+  /* proxied calls still need room below the pinned buffers */
+  if(!shared_user_va || size > total || total - size < RISCV_PAGE_SIZE)
+    return 1;
+
+  shared_pinned = size;
+  shared_buffer_size = total - size;
+  init_edge_internals();
+  return 0;
+}
+
+/* Reads or writes a pinned eapp buffer on the host side directly, so data
+ * that needs no protection (e.g., ciphertexts) never passes through enclave
+ * memory. */
+static int in_pinned(uintptr_t buf, size_t len){
+  uintptr_t pinned_va = shared_user_va + shared_buffer_size;
+
+  return shared_pinned && buf >= pinned_va && len <= shared_pinned &&
+         buf - pinned_va <= shared_pinned - len;
+}
+
+uintptr_t dispatch_shared_io(unsigned long op, int fd, uintptr_t buf,
+                             size_t len, int flags){
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_SHARED_IO* args = (sargs_SHARED_IO*)edge_syscall->data;
+  uintptr_t ret = -1;
+
+  if(!in_pinned(buf, len))
+    goto done;
+  if(op != SYS_read && op != SYS_write && op != SYS_recvfrom && op != SYS_sendto)
+    goto done;
+
+  edge_syscall->syscall_num = EDGE_SYSCALL_SHARED_IO;
+  args->op = op;
+  args->fd = fd;
+  args->flags = flags;
+  args->offset = buf - shared_user_va;
+  args->len = len;
+  ret = dispatch_edgecall_syscall(edge_syscall,
+                                  sizeof(struct edge_syscall) + sizeof(sargs_SHARED_IO));
+
+ done:
+  print_strace("[runtime] shared io %lu on fd %d (%lu bytes): %ld\r\n", op, fd, len, ret);
+  return ret;
+}
+
+/* Opens, waits on or closes a stream whose ring the eapp keeps in the
+ * pinned buffers. The data itself never passes through the runtime: the
+ * host thread and the eapp hand the halves of the ring back and forth. */
+uintptr_t dispatch_stream(unsigned long op, int fd, uintptr_t ring,
+                          size_t half_size, int arg){
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_STREAM* args = (sargs_STREAM*)edge_syscall->data;
+  uintptr_t ret = -1;
+
+  if(half_size > shared_pinned || !in_pinned(ring, EDGE_STREAM_RING_SIZE(half_size)))
+    goto done;
+
+  edge_syscall->syscall_num = EDGE_SYSCALL_STREAM;
+  args->op = op;
+  args->fd = fd;
+  args->arg = arg;
+  args->offset = ring - shared_user_va;
+  args->half_size = half_size;
+  ret = dispatch_edgecall_syscall(edge_syscall,
+                                  sizeof(struct edge_syscall) + sizeof(sargs_STREAM));
+
+ done:
+  print_strace("[runtime] stream %lu on fd %d: %ld\r\n", op, fd, ret);
+  return ret;
+}
+
+/* The arguments are already in the shared buffer (see map_shared_to_user).
+ * The host handler reads them and writes results back in place. */
+uintptr_t dispatch_edgecall_ocall_shared(unsigned long call_id,
+                                         uintptr_t args, size_t args_len){
+  struct edge_call* edge_call = (struct edge_call*)shared_buffer;
+  uintptr_t data_start = edge_call_data_ptr();
+  uintptr_t ret;
+
+  if(!shared_user_va || args < shared_user_va)
+    return 1;
+
+  /* the edge_call header itself is not part of the arguments */
+  args = args - shared_user_va + shared_buffer;
+  if(args < data_start || edge_call_check_ptr_valid(args, args_len) != 0)
+    return 1;
+
+  edge_call->call_id = call_id;
+  if(edge_call_setup_call(edge_call, (void*)args, args_len) != 0)
+    return 1;
+
+  ret = sbi_stop_enclave(STOP_EDGE_CALL_HOST);
+  if(ret != 0 || edge_call->return_data.call_status != CALL_STATUS_OK)
+    return 1;
+
+  return 0;
+}
+
 uintptr_t handle_copy_from_shared(void* dst, uintptr_t offset, size_t size){
 
   /* This is where we would handle cache side channels for a given
      platform */
 
   /* The only safety check we do is to confirm all data comes from the
-   * shared region. */
-  uintptr_t src_ptr;
-  if(edge_call_get_ptr_from_offset(offset, size,
-				   &src_ptr) != 0){
+   * shared region, including the part the eapp pinned. */
+  size_t total = shared_buffer_size + shared_pinned;
+  if(offset > total || size > total - offset){
     return 1;
   }
 
-  return copy_to_user(dst, (void*)src_ptr, size);
+  return copy_to_user(dst, (void*)(shared_buffer + offset), size);
 }
 
 void init_edge_internals(){
@@ -166,11 +314,43 @@ void handle_syscall(struct encl_ctx* ctx)
 
   switch (n) {
   case(RUNTIME_SYSCALL_EXIT):
+#if defined(USE_IO_SYSCALL) && defined(USE_IO_CACHE)
+    /* dirty cached pages are lost with the enclave */
+    io_cache_flush_all();
+#endif /* USE_IO_SYSCALL && USE_IO_CACHE */
+#ifdef USE_PROFILER
+    profiler_flush();
+#endif /* USE_PROFILER */
     sbi_exit_enclave(arg0);
     break;
   case(RUNTIME_SYSCALL_OCALL):
     ret = dispatch_edgecall_ocall(arg0, (void*)arg1, arg2, (void*)arg3, arg4);
     break;
+  case(RUNTIME_SYSCALL_MAP_SHARED):
+    ret = map_shared_to_user((size_t*)arg0);
+    break;
+  case(RUNTIME_SYSCALL_OCALL_SHARED):
+    ret = dispatch_edgecall_ocall_shared(arg0, arg1, arg2);
+    break;
+  case(RUNTIME_SYSCALL_PIN_SHARED):
+    ret = pin_shared_top((size_t)arg0);
+    break;
+  case(RUNTIME_SYSCALL_SHARED_IO):
+    ret = dispatch_shared_io(arg0, (int)arg1, arg2, (size_t)arg3, (int)arg4);
+    break;
+  case(RUNTIME_SYSCALL_STREAM):
+    ret = dispatch_stream(arg0, (int)arg1, arg2, (size_t)arg3, (int)arg4);
+    break;
+#ifdef USE_PROFILER
+  case(RUNTIME_SYSCALL_PROFILE_FLUSH):
+    ret = profiler_flush();
+    break;
+#endif /* USE_PROFILER */
+#ifdef USE_FILE_MMAP
+  case(RUNTIME_SYSCALL_MMAP_HASHES):
+    ret = file_mmap_hashes(arg0, (size_t)arg1, arg2);
+    break;
+#endif /* USE_FILE_MMAP */
   case(RUNTIME_SYSCALL_SHAREDCOPY):
     ret = handle_copy_from_shared((void*)arg0, arg1, arg2);
     break;
@@ -215,6 +395,14 @@ void handle_syscall(struct encl_ctx* ctx)
     ret = linux_clock_gettime((__clockid_t)arg0, (struct timespec*)arg1);
     break;
 
+  case(SYS_clock_getres):
+    ret = linux_clock_getres((__clockid_t)arg0, (struct timespec*)arg1);
+    break;
+
+  case(SYS_gettimeofday):
+    ret = linux_gettimeofday((struct timeval*)arg0, (struct timezone*)arg1);
+    break;
+
   case(SYS_getrandom):
     ret = linux_getrandom((void*)arg0, (size_t)arg1, (unsigned int)arg2);
     break;
@@ -263,6 +451,12 @@ case(SYS_futex):
   case(SYS_exit):
   case(SYS_exit_group):
     print_strace("[runtime] exit or exit_group (%lu)\r\n",n);
+#if defined(USE_IO_SYSCALL) && defined(USE_IO_CACHE)
+    io_cache_flush_all();
+#endif /* USE_IO_SYSCALL && USE_IO_CACHE */
+#ifdef USE_PROFILER
+    profiler_flush();
+#endif /* USE_PROFILER */
     sbi_exit_enclave(arg0);
     break;
 #endif /* USE_LINUX_SYSCALL */
@@ -274,6 +468,12 @@ case(SYS_futex):
   case(SYS_write):
     ret = io_syscall_write((int)arg0, (void*)arg1, (size_t)arg2);
     break;
+  case(SYS_pread64):
+    ret = io_syscall_pread((int)arg0, (void*)arg1, (size_t)arg2, (off_t)arg3);
+    break;
+  case(SYS_pwrite64):
+    ret = io_syscall_pwrite((int)arg0, (void*)arg1, (size_t)arg2, (off_t)arg3);
+    break;
   case(SYS_writev):
     ret = io_syscall_writev((int)arg0, (const struct iovec*)arg1, (int)arg2);
     break;
@@ -362,6 +562,18 @@ case(SYS_futex):
   case(SYS_sendto):
     ret = io_syscall_sendto((int) arg0, (uintptr_t) arg1, (int) arg2, (int) arg3, (uintptr_t) arg4, (int) arg5);
     break;
+  case(SYS_sendmsg):
+    ret = io_syscall_sendmsg((int) arg0, (uintptr_t) arg1, (int) arg2);
+    break;
+  case(SYS_recvmsg):
+    ret = io_syscall_recvmsg((int) arg0, (uintptr_t) arg1, (int) arg2);
+    break;
+  case(SYS_sendmmsg):
+    ret = io_syscall_sendmmsg((int) arg0, (uintptr_t) arg1, (unsigned int) arg2, (int) arg3);
+    break;
+  case(SYS_recvmmsg):
+    ret = io_syscall_recvmmsg((int) arg0, (uintptr_t) arg1, (unsigned int) arg2, (int) arg3, (uintptr_t) arg4);
+    break;
   case(SYS_sendfile):
     ret = io_syscall_sendfile((int) arg0, (int) arg1, (uintptr_t) arg2, (int) arg3);
     break;
@@ -0,0 +1,51 @@
+#ifdef USE_DRBG
+
+#include "crypto/chacha20.h"
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d) \
+  do {                           \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d, 8);  \
+    c += d; b ^= c; b = ROTL32(b, 7);  \
+  } while (0)
+
+void
+chacha20_block(
+    const uint32_t key[CHACHA20_KEY_WORDS], uint32_t counter,
+    const uint32_t nonce[CHACHA20_NONCE_WORDS],
+    uint32_t out[CHACHA20_BLOCK_WORDS]) {
+  uint32_t in[CHACHA20_BLOCK_WORDS];
+  uint32_t x[CHACHA20_BLOCK_WORDS];
+  int i;
+
+  /* "expand 32-byte k" */
+  in[0] = 0x61707865;
+  in[1] = 0x3320646e;
+  in[2] = 0x79622d32;
+  in[3] = 0x6b206574;
+  for (i = 0; i < CHACHA20_KEY_WORDS; i++) in[4 + i] = key[i];
+  in[12] = counter;
+  for (i = 0; i < CHACHA20_NONCE_WORDS; i++) in[13 + i] = nonce[i];
+
+  for (i = 0; i < CHACHA20_BLOCK_WORDS; i++) x[i] = in[i];
+
+  for (i = 0; i < 10; i++) {
+    /* column rounds */
+    QUARTERROUND(x[0], x[4], x[8], x[12]);
+    QUARTERROUND(x[1], x[5], x[9], x[13]);
+    QUARTERROUND(x[2], x[6], x[10], x[14]);
+    QUARTERROUND(x[3], x[7], x[11], x[15]);
+    /* diagonal rounds */
+    QUARTERROUND(x[0], x[5], x[10], x[15]);
+    QUARTERROUND(x[1], x[6], x[11], x[12]);
+    QUARTERROUND(x[2], x[7], x[8], x[13]);
+    QUARTERROUND(x[3], x[4], x[9], x[14]);
+  }
+
+  for (i = 0; i < CHACHA20_BLOCK_WORDS; i++) out[i] = x[i] + in[i];
+}
+
+#endif  // USE_DRBG
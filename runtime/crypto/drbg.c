@@ -0,0 +1,87 @@
+#if defined(USE_DRBG)
+
+#include "crypto/drbg.h"
+
+#include <stdbool.h>
+
+#include "call/sbi.h"
+#include "crypto/chacha20.h"
+#include "uaccess.h"
+#include "util/string.h"
+
+/* ChaCha20 DRBG with fast key erasure.
+ * The key is seeded from sbi_random() on first use and whenever
+ * DRBG_RESEED_INTERVAL bytes have been generated since the last seed, or
+ * on every call if DRBG_RESEED_INTERVAL is 0.
+ * After every request the key is replaced with fresh keystream, so past
+ * output cannot be recomputed from the current state. */
+
+#define DRBG_CHUNK_BLOCKS 4
+
+static struct {
+  uint32_t key[CHACHA20_KEY_WORDS];
+  size_t since_seed;
+  bool seeded;
+} drbg;
+
+static const uint32_t drbg_nonce[CHACHA20_NONCE_WORDS] = {0};
+
+static void
+drbg_rekey(uint32_t counter) {
+  uint32_t block[CHACHA20_BLOCK_WORDS];
+
+  chacha20_block(drbg.key, counter, drbg_nonce, block);
+  memcpy(drbg.key, block, sizeof(drbg.key));
+  memset(block, 0, sizeof(block));
+}
+
+static void
+drbg_reseed(void) {
+  uintptr_t seed[sizeof(drbg.key) / sizeof(uintptr_t)];
+  uint32_t* words = (uint32_t*)seed;
+  unsigned int i;
+
+  for (i = 0; i < sizeof(seed) / sizeof(seed[0]); i++) seed[i] = sbi_random();
+  for (i = 0; i < CHACHA20_KEY_WORDS; i++) drbg.key[i] ^= words[i];
+  memset(seed, 0, sizeof(seed));
+
+  drbg_rekey(0);
+  drbg.since_seed = 0;
+  drbg.seeded     = true;
+}
+
+size_t
+drbg_getrandom(void* buf, size_t buflen) {
+  uint32_t block[DRBG_CHUNK_BLOCKS][CHACHA20_BLOCK_WORDS];
+  char* next         = (char*)buf;
+  size_t remaining   = buflen;
+  uint32_t counter   = 0;
+  int i;
+
+  if (!drbg.seeded || drbg.since_seed >= DRBG_RESEED_INTERVAL) drbg_reseed();
+
+  while (remaining > 0) {
+    size_t len = remaining < sizeof(block) ? remaining : sizeof(block);
+
+    for (i = 0; i < DRBG_CHUNK_BLOCKS; i++)
+      chacha20_block(drbg.key, counter++, drbg_nonce, block[i]);
+    copy_to_user(next, block, len);
+
+    next += len;
+    remaining -= len;
+    drbg.since_seed += len;
+
+    /* an interval of 0 reseeds once per call, above */
+    if (DRBG_RESEED_INTERVAL > 0 && remaining > 0 &&
+        drbg.since_seed >= DRBG_RESEED_INTERVAL) {
+      drbg_reseed();
+      counter = 0;
+    }
+  }
+
+  drbg_rekey(counter);
+  memset(block, 0, sizeof(block));
+  return buflen;
+}
+
+#endif  // USE_DRBG
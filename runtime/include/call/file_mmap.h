@@ -0,0 +1,24 @@
+#ifdef USE_FILE_MMAP
+#ifndef _FILE_MMAP_H_
+#define _FILE_MMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* MAP_PRIVATE file mappings, paged in lazily from the host */
+
+#ifndef FILE_MMAP_CLUSTER
+#define FILE_MMAP_CLUSTER 16
+#endif
+
+uintptr_t file_mmap(size_t length, int pte_flags, int fd, off_t offset);
+/* the range is split out of any mapping it overlaps and then dropped or
+ * reprotected; these return 0, or -1 if the table has no room to split */
+int file_munmap(uintptr_t addr, size_t length);
+int file_mprotect(uintptr_t addr, size_t length, int pte_flags);
+/* attaches a list of SHA-256 page hashes to a whole, untouched mapping */
+uintptr_t file_mmap_hashes(uintptr_t addr, size_t length, uintptr_t hashes);
+
+#endif /* _FILE_MMAP_H_ */
+#endif /* USE_FILE_MMAP */
@@ -0,0 +1,39 @@
+#if defined(USE_IO_SYSCALL) && defined(USE_IO_CACHE)
+#ifndef _IO_CACHE_H_
+#define _IO_CACHE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Enclave-side page cache for proxied file IO.
+ * Regular files opened O_RDONLY are cached automatically; any other regular
+ * file can be opted in (or out) with fcntl(fd, EYRIE_F_SETCACHE, 1/0).
+ * The cache assumes the enclave is the only writer of a cached file. */
+
+#ifndef IO_CACHE_PAGES
+#define IO_CACHE_PAGES 64
+#endif
+
+#ifndef IO_CACHE_READAHEAD
+#define IO_CACHE_READAHEAD 16
+#endif
+
+int io_cache_owns(int fd);
+void io_cache_opened(int fd, int flags);
+uintptr_t io_cache_set(int fd, int enable);
+void io_cache_setfl(int fd, int flags);
+
+uintptr_t io_cache_read(int fd, void* buf, size_t len);
+uintptr_t io_cache_write(int fd, void* buf, size_t len);
+uintptr_t io_cache_pread(int fd, void* buf, size_t len, off_t offset);
+uintptr_t io_cache_pwrite(int fd, void* buf, size_t len, off_t offset);
+uintptr_t io_cache_lseek(int fd, off_t offset, int whence);
+
+/* write back dirty pages; these return 0 or -1 on a write-back error */
+int io_cache_flush(int fd);
+int io_cache_flush_all(void);
+int io_cache_truncate(int fd, off_t length);
+int io_cache_close(int fd);
+
+#endif /* _IO_CACHE_H_ */
+#endif /* USE_IO_SYSCALL && USE_IO_CACHE */
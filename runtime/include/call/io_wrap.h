@@ -8,6 +8,8 @@
 
 uintptr_t io_syscall_read(int fd, void* buf, size_t len);
 uintptr_t io_syscall_write(int fd, void* buf, size_t len);
+uintptr_t io_syscall_pread(int fd, void* buf, size_t len, off_t offset);
+uintptr_t io_syscall_pwrite(int fd, void* buf, size_t len, off_t offset);
 uintptr_t io_syscall_writev(int fd, const struct iovec *iov, int iovcnt);
 uintptr_t io_syscall_readv(int fd, const struct iovec *iov, int iovcnt);
 uintptr_t io_syscall_openat(int dirfd, char* path,
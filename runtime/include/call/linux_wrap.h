@@ -7,9 +7,13 @@
 #include <stdint.h>
 
 struct timespec;
+struct timeval;
+struct timezone;
 
 uintptr_t linux_uname(void* buf);
 uintptr_t linux_clock_gettime(__clockid_t clock, struct timespec *tp);
+uintptr_t linux_clock_getres(__clockid_t clock, struct timespec *res);
+uintptr_t linux_gettimeofday(struct timeval *tv, struct timezone *tz);
 uintptr_t linux_rt_sigprocmask(int how, const sigset_t *set, sigset_t *oldset);
 uintptr_t linux_getrandom(void *buf, size_t buflen, unsigned int flags);
 uintptr_t linux_getpid();
@@ -19,6 +19,11 @@ uintptr_t io_syscall_recvfrom(int sockfd, uintptr_t buf, size_t len, int flags,
                 				uintptr_t src_addr, uintptr_t addrlen);
 uintptr_t io_syscall_sendto(int sockfd, uintptr_t buf, size_t len, int flags,
                 				uintptr_t dest_addr, int addrlen);
+uintptr_t io_syscall_sendmsg(int sockfd, uintptr_t msg, int flags);
+uintptr_t io_syscall_recvmsg(int sockfd, uintptr_t msg, int flags);
+uintptr_t io_syscall_sendmmsg(int sockfd, uintptr_t msgvec, unsigned int vlen, int flags);
+uintptr_t io_syscall_recvmmsg(int sockfd, uintptr_t msgvec, unsigned int vlen, int flags,
+                              uintptr_t timeout);
 uintptr_t io_syscall_sendfile(int out_fd, int in_fd, uintptr_t offset, int count);
 uintptr_t io_syscall_getuid();
 uintptr_t io_syscall_pselect(int nfds, uintptr_t readfds, uintptr_t writefds, uintptr_t exceptfds, uintptr_t timeout, uintptr_t sigmask);
@@ -28,5 +28,7 @@ uintptr_t
 sbi_attest_enclave(void* report, void* buf, uintptr_t len);
 uintptr_t
 sbi_get_sealing_key(uintptr_t key_struct, uintptr_t key_ident, uintptr_t len);
+uintptr_t
+sbi_get_shared_region(struct keystone_sbi_pregion_t* region);
 
 #endif
@@ -0,0 +1,19 @@
+#ifndef _CHACHA20_H_
+#define _CHACHA20_H_
+
+#include <stdint.h>
+
+#define CHACHA20_KEY_WORDS 8
+#define CHACHA20_NONCE_WORDS 3
+#define CHACHA20_BLOCK_WORDS 16
+#define CHACHA20_BLOCK_SIZE (CHACHA20_BLOCK_WORDS * sizeof(uint32_t))
+
+/* ChaCha20 block function (RFC 8439, section 2.3).
+ * Produces one 64-byte keystream block for the given key, block counter and
+ * nonce. Words are in host order, which on RISC-V is the RFC byte order. */
+void chacha20_block(
+    const uint32_t key[CHACHA20_KEY_WORDS], uint32_t counter,
+    const uint32_t nonce[CHACHA20_NONCE_WORDS],
+    uint32_t out[CHACHA20_BLOCK_WORDS]);
+
+#endif  // _CHACHA20_H_
@@ -0,0 +1,15 @@
+#ifndef _DRBG_H_
+#define _DRBG_H_
+
+#include <stddef.h>
+
+/* Bytes generated before fresh entropy from the SM is mixed into the key.
+ * 0 reseeds on every call. */
+#ifndef DRBG_RESEED_INTERVAL
+#define DRBG_RESEED_INTERVAL (1024 * 1024)
+#endif
+
+/* Fills buf (user or runtime memory) from the ChaCha20 DRBG */
+size_t drbg_getrandom(void* buf, size_t buflen);
+
+#endif  // _DRBG_H_
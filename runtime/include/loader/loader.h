@@ -1,3 +1,4 @@
 #include "loader/elf.h"
 
 int loadElf(elf_t* elf, bool user);
+int loadSharedElf(elf_t* elf, bool user);
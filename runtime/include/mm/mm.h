@@ -11,6 +11,7 @@ uintptr_t map_page(uintptr_t vpn, uintptr_t ppn, int flags);
 uintptr_t alloc_page(uintptr_t vpn, int flags);
 uintptr_t realloc_page(uintptr_t vpn, int flags);
 void free_page(uintptr_t vpn);
+uintptr_t reserve_page(uintptr_t vpn);
 size_t alloc_pages(uintptr_t vpn, size_t count, int flags);
 void free_pages(uintptr_t vpn, size_t count);
 size_t test_va_range(uintptr_t vpn, size_t count);
@@ -30,6 +30,8 @@ extern size_t freemem_size;
 /* shared buffer */
 extern uintptr_t shared_buffer;
 extern uintptr_t shared_buffer_size;
+/* host-published struct keystone_time_page, 0 if the host did not opt in */
+extern uintptr_t time_page;
 
 #endif
 
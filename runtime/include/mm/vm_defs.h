@@ -37,6 +37,7 @@
 #define EYRIE_LOAD_START 0xffffffff00000000
 #define EYRIE_PAGING_START 0xffffffff40000000
 #define EYRIE_UNTRUSTED_START 0xffffffff80000000
+#define EYRIE_SHARED_START 0xfffffffec0000000
 #define EYRIE_USER_STACK_START 0x0000000040000000
 #define EYRIE_ANON_REGION_START \
   0x0000002000000000  // Arbitrary VA to start looking for large mappings
@@ -45,6 +46,7 @@
 #define EYRIE_LOAD_START 0xf0000000
 #define EYRIE_PAGING_START 0x40000000
 #define EYRIE_UNTRUSTED_START 0x80000000
+#define EYRIE_SHARED_START 0xd0000000
 #define EYRIE_USER_STACK_START 0x40000000
 #define EYRIE_ANON_REGION_START \
   0x20000000  // Arbitrary VA to start looking for large mappings
@@ -62,6 +64,7 @@
 #define PTE_G 0x020  // Global
 #define PTE_A 0x040  // Accessed
 #define PTE_D 0x080  // Dirty
+#define PTE_LAZY 0x100  // Software: reserved, filled in on first access
 #define PTE_FLAG_MASK 0x3ff
 #define PTE_PPN_SHIFT 10
 
@@ -0,0 +1,30 @@
+#ifdef USE_PROFILER
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+#include "util/regs.h"
+
+/* Timer-driven sampling profiler. Samples are kept in enclave memory and
+ * only leave the enclave as a batch, at exit or on request from the eapp. */
+
+/* timer ticks between samples, independent of DEFAULT_CLOCK_DELAY */
+#ifndef PROFILER_INTERVAL
+#define PROFILER_INTERVAL 2000
+#endif
+
+#ifndef PROFILER_SAMPLES
+#define PROFILER_SAMPLES 4096
+#endif
+
+/* PCs per sample: the interrupted PC and up to PROFILER_DEPTH - 1 callers */
+#ifndef PROFILER_DEPTH
+#define PROFILER_DEPTH 8
+#endif
+
+void profiler_sample(struct encl_ctx* ctx);
+/* sends all buffered samples to the host; returns 0, or -1 on error */
+uintptr_t profiler_flush(void);
+
+#endif /* _PROFILER_H_ */
+#endif /* USE_PROFILER */
@@ -14,7 +14,10 @@ static inline int pt_mode_from_elf(int elf_pt_mode) {
   ;
 }
 
-int loadElf(elf_t* elf, bool user) {
+/* If shared is set, the image lives in the SM's read-only shared region
+ * rather than in the EPM. Read-only pages are still mapped in place, but
+ * writable pages get a private copy since the region can't be written. */
+static int __loadElf(elf_t* elf, bool user, bool shared) {
   for (unsigned int i = 0; i < elf_getNumProgramHeaders(elf); i++) {
     if (elf_getProgramHeaderType(elf, i) != PT_LOAD) {
       continue;
@@ -44,9 +47,16 @@ int loadElf(elf_t* elf, bool user) {
 
     /* first load all pages that do not include .bss segment */
     while (va + RISCV_PAGE_SIZE <= file_end) {
-      uintptr_t src_pa = __pa((uintptr_t) src);
-      if (!map_page(vpn(va), ppn(src_pa), pt_mode))
-        return -1;
+      if (shared && (pt_mode & PTE_W)) {
+        uintptr_t new_page = alloc_page(vpn(va), pt_mode);
+        if (!new_page)
+          return -1;
+        memcpy((void*) new_page, src, RISCV_PAGE_SIZE);
+      } else {
+        uintptr_t src_pa = shared ? translate((uintptr_t) src) : __pa((uintptr_t) src);
+        if (!map_page(vpn(va), ppn(src_pa), pt_mode))
+          return -1;
+      }
       src += RISCV_PAGE_SIZE;
       va += RISCV_PAGE_SIZE;
     }
@@ -67,6 +77,14 @@ int loadElf(elf_t* elf, bool user) {
    return 0;
 }
 
+int loadElf(elf_t* elf, bool user) {
+  return __loadElf(elf, user, false);
+}
+
+int loadSharedElf(elf_t* elf, bool user) {
+  return __loadElf(elf, user, true);
+}
+
 // assumes beginning and next file are page-aligned
 static inline void freeUnusedElf(elf_t* elf) {
   assert(false); // TODO: needs free to be implemented properly
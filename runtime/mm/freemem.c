@@ -13,9 +13,15 @@
  * Thus, each of the free pages contains the pointer to the next free page
  * which can be dereferenced by NEXT_PAGE() macro.
  * spa_free_pages will only hold the head and the tail pages so that
- * SPA can allocate/free a page in constant time. */
+ * SPA can allocate/free a page in constant time.
+
+ * The SM hands over the free memory zeroed, so pages that have never been
+ * allocated are handed out from [spa_fresh_base, spa_fresh_end) without
+ * touching them, and only recycled pages (spa_put) need a memset. */
 
 static struct pg_list spa_free_pages;
+static uintptr_t spa_fresh_base;
+static uintptr_t spa_fresh_end;
 
 /* get a free page from the simple page allocator */
 uintptr_t
@@ -23,6 +29,13 @@ __spa_get(bool zero)
 {
   uintptr_t free_page;
 
+  if (LIST_EMPTY(spa_free_pages) && spa_fresh_base < spa_fresh_end) {
+    /* never handed out before, so still zero */
+    free_page = spa_fresh_base;
+    spa_fresh_base += RISCV_PAGE_SIZE;
+    return free_page;
+  }
+
   if (LIST_EMPTY(spa_free_pages)) {
     /* try evict a page */
 #ifdef USE_PAGING
@@ -84,28 +97,24 @@ spa_put(uintptr_t page_addr)
 
 unsigned int
 spa_available(){
+  unsigned int fresh = (spa_fresh_end - spa_fresh_base) / RISCV_PAGE_SIZE;
 #ifndef USE_PAGING
-  return spa_free_pages.count;
+  return spa_free_pages.count + fresh;
 #else
-  return spa_free_pages.count + paging_remaining_pages();
+  return spa_free_pages.count + fresh + paging_remaining_pages();
 #endif
 }
 
 void
 spa_init(uintptr_t base, size_t size)
 {
-  uintptr_t cur;
-
   LIST_INIT(spa_free_pages);
 
   // both base and size must be page-aligned
   assert(IS_ALIGNED(base, RISCV_PAGE_BITS));
   assert(IS_ALIGNED(size, RISCV_PAGE_BITS));
 
-  /* put all free pages in freemem (base) into spa_free_pages */
-  for(cur = base;
-      cur < base + size;
-      cur += RISCV_PAGE_SIZE) {
-    spa_put(cur);
-  }
+  /* freemem (base) is zero and untouched; pages are carved from it lazily */
+  spa_fresh_base = base;
+  spa_fresh_end = base + size;
 }
@@ -1,7 +1,6 @@
 #include "mm/freemem.h"
 #include "mm/common.h"
 #include "mm/vm_defs.h"
-#include "util/string.h"
 
 static uintptr_t freeBase;
 static uintptr_t freeEnd;
@@ -22,8 +21,9 @@ uintptr_t spa_get_zero()
   if (freeBase >= freeEnd) {
     return 0;
   }
+  /* the SM zeroes the free memory on create, and the loader never
+   * hands a page out twice */
   uintptr_t new_page = freeBase;
-  memset((void *) new_page, 0, RISCV_PAGE_SIZE);
 
   freeBase += RISCV_PAGE_SIZE;
   return new_page;
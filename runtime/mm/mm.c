@@ -132,9 +132,16 @@ free_page(uintptr_t vpn)
 
   pte* pte = __walk(root_page_table, vpn << RISCV_PAGE_BITS);
 
-  // No such PTE, or invalid
-  if(!pte || !(*pte & PTE_V))
+  // No such PTE
+  if(!pte)
+    return;
+
+  // Invalid, but drop the reservation if it was never faulted in
+  if(!(*pte & PTE_V)){
+    if(*pte & PTE_LAZY)
+      *pte = 0;
     return;
+  }
 
   assert(*pte & PTE_U);
 
@@ -153,6 +160,21 @@ free_page(uintptr_t vpn)
 
 }
 
+/* reserve a vpn without backing it, so that test_va_range skips it.
+ * The PTE stays invalid until alloc_page replaces it on first access.
+ * returns 1 on success, 0 if the vpn is already in use */
+uintptr_t
+reserve_page(uintptr_t vpn)
+{
+  pte* pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS);
+
+  if(!pte || *pte)
+    return 0;
+
+  *pte = PTE_LAZY;
+  return 1;
+}
+
 /* allocate n new pages from a given vpn
  * returns the number of pages allocated */
 size_t
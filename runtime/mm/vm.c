@@ -53,6 +53,7 @@ size_t freemem_size;
 /* shared buffer */
 uintptr_t shared_buffer;
 uintptr_t shared_buffer_size;
+uintptr_t time_page;
 
 uintptr_t kernel_offset;
 uintptr_t load_pa_start;
@@ -12,6 +12,8 @@
 #include "mm/paging.h"
 #include "loader/elf.h"
 #include "loader/loader.h"
+#include "time_page.h"
+#include "uaccess.h"
 
 /* defined in vm.h */
 extern uintptr_t shared_buffer;
@@ -24,7 +26,7 @@ size_t utm_size;
 /* defined in entry.S */
 extern void* encl_trap_handler;
 
-int verify_and_load_elf_file(uintptr_t ptr, size_t file_size, bool is_eapp) {
+int verify_and_load_elf_file(uintptr_t ptr, size_t file_size, bool is_eapp, bool shared) {
   int ret = 0;
   // validate elf 
   if (((void*) ptr == NULL) || (file_size <= 0)) {
@@ -39,7 +41,7 @@ int verify_and_load_elf_file(uintptr_t ptr, size_t file_size, bool is_eapp) {
   }
 
   // parse and load elf file
-  ret = loadElf(&elf_file, 1);
+  ret = shared ? loadSharedElf(&elf_file, 1) : loadElf(&elf_file, 1);
 
   if (is_eapp) { // setup entry point
     uintptr_t entry = elf_getEntryPoint(&elf_file);
@@ -55,6 +57,26 @@ init_freemem()
   spa_init(freemem_va_start, freemem_size);
 }
 
+/* map the read-only region shared with other enclaves, if there is one.
+ * returns the size of the region, 0 if not attached */
+size_t
+map_shared_region()
+{
+  struct keystone_sbi_pregion_t region;
+  uintptr_t va = EYRIE_SHARED_START;
+
+  if (sbi_get_shared_region(&region) || !region.size)
+    return 0;
+
+  debug("SHARED: 0x%lx-0x%lx (%u KB)", region.paddr, region.paddr + region.size, region.size/1024);
+
+  for (uintptr_t pa = region.paddr; pa < region.paddr + region.size;
+       pa += RISCV_PAGE_SIZE, va += RISCV_PAGE_SIZE) {
+    assert(map_page(vpn(va), ppn(pa), PTE_R | PTE_X | PTE_A));
+  }
+  return region.size;
+}
+
 /* initialize user stack */
 void
 init_user_stack_and_env(ELF(Ehdr) *hdr)
@@ -92,6 +114,18 @@ eyrie_boot(uintptr_t dummy, // $a0 contains the return value from the SBI
   root_page_table = (pte*) __va(csr_read(satp) << RISCV_PAGE_BITS);
   shared_buffer = EYRIE_UNTRUSTED_START;
   shared_buffer_size = utm_size;
+  /* the last page of the UTM is the time page if the host marked it so,
+   * see time_page.h */
+  if (utm_size >= 2 * KEYSTONE_TIME_PAGE_SIZE) {
+    uintptr_t page = shared_buffer + utm_size - KEYSTONE_TIME_PAGE_SIZE;
+    uint64_t magic;
+
+    copy_from_user(&magic, &((struct keystone_time_page*) page)->magic, sizeof(magic));
+    if (magic == KEYSTONE_TIME_PAGE_MAGIC) {
+      shared_buffer_size -= KEYSTONE_TIME_PAGE_SIZE;
+      time_page = page;
+    }
+  }
   runtime_va_start = (uintptr_t) &rt_base;
   kernel_offset = runtime_va_start - runtime_paddr;
 
@@ -110,8 +144,15 @@ eyrie_boot(uintptr_t dummy, // $a0 contains the return value from the SBI
   /* initialize free memory */
   init_freemem();
 
-  /* load eapp elf */
-  assert(!verify_and_load_elf_file(__va(user_paddr), free_paddr-user_paddr, true));
+  /* load eapp elf, either from the shared region or from the EPM */
+  uintptr_t eapp_va = __va(user_paddr);
+  size_t eapp_size = free_paddr - user_paddr;
+  size_t shared_size = map_shared_region();
+  if (shared_size) {
+    eapp_va = EYRIE_SHARED_START;
+    eapp_size = shared_size;
+  }
+  assert(!verify_and_load_elf_file(eapp_va, eapp_size, true, shared_size > 0));
 
   /* free leaking memory */
   // TODO: clean up after loader -- entire file no longer needed
@@ -126,7 +167,7 @@ eyrie_boot(uintptr_t dummy, // $a0 contains the return value from the SBI
   #endif /* USE_PAGING */
 
   /* initialize user stack */
-  init_user_stack_and_env((ELF(Ehdr) *) __va(user_paddr));
+  init_user_stack_and_env((ELF(Ehdr) *) eapp_va);
 
   /* prepare edge & system calls */
   init_edge_internals();
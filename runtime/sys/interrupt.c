@@ -8,21 +8,61 @@
 #include "sys/interrupt.h"
 #include "util/printf.h"
 #include <asm/csr.h>
+#ifdef USE_PROFILER
+#include "sys/profiler.h"
+#endif
 
 #define DEFAULT_CLOCK_DELAY 10000
 
+#ifdef USE_PROFILER
+/* The one timer serves two deadlines: the scheduling tick, which gives the
+ * core back to the host, and the next profiler sample, which does not. */
+static unsigned long next_tick;
+static unsigned long next_sample;
+
+static void set_next_timer(void)
+{
+  sbi_set_timer(next_tick < next_sample ? next_tick : next_sample);
+}
+#endif
+
 void init_timer(void)
 {
+#ifdef USE_PROFILER
+  next_tick = get_cycles64() + DEFAULT_CLOCK_DELAY;
+  next_sample = get_cycles64() + PROFILER_INTERVAL;
+  set_next_timer();
+#else
   sbi_set_timer(get_cycles64() + DEFAULT_CLOCK_DELAY);
+#endif
   csr_set(sstatus, SR_SPIE);
   csr_set(sie, SIE_STIE | SIE_SSIE);
 }
 
-void handle_timer_interrupt()
+void handle_timer_interrupt(struct encl_ctx* regs)
 {
+#ifdef USE_PROFILER
+  unsigned long now = get_cycles64();
+
+  if(now >= next_sample)
+    profiler_sample(regs);
+
+  if(now >= next_tick) {
+    sbi_stop_enclave(0);
+    now = get_cycles64();
+    next_tick = now + DEFAULT_CLOCK_DELAY;
+  }
+
+  /* time spent outside the enclave is not sampled */
+  if(next_sample <= now)
+    next_sample = now + PROFILER_INTERVAL;
+
+  set_next_timer();
+#else
   sbi_stop_enclave(0);
   unsigned long next_cycle = get_cycles64() + DEFAULT_CLOCK_DELAY;
   sbi_set_timer(next_cycle);
+#endif
   csr_set(sstatus, SR_SPIE);
   return;
 }
@@ -33,7 +73,7 @@ void handle_interrupts(struct encl_ctx* regs)
 
   switch(cause) {
     case INTERRUPT_CAUSE_TIMER:
-      handle_timer_interrupt();
+      handle_timer_interrupt(regs);
       break;
     /* ignore other interrupts */
     case INTERRUPT_CAUSE_SOFTWARE:
@@ -0,0 +1,120 @@
+#ifdef USE_PROFILER
+
+#include <asm/csr.h>
+#include "call/syscall.h"
+#include "mm/mm.h"
+#include "mm/vm.h"
+#include "sys/profiler.h"
+#include "uaccess.h"
+#include "util/string.h"
+
+/* Every sample holds the interrupted PC. Samples of the eapp also hold the
+ * return addresses found by following its frame pointers (s0), which needs
+ * the eapp to be built with -fno-omit-frame-pointer; otherwise the walk
+ * stops at the first frame that does not look like one. When the buffer is
+ * full, samples are counted as dropped until the next flush. */
+
+struct profile_sample {
+  uint32_t flags;
+  uint32_t depth;
+  uint64_t pcs[PROFILER_DEPTH];
+};
+_Static_assert(sizeof(struct profile_sample) == PROFILE_SAMPLE_SIZE(PROFILER_DEPTH),
+               "profile_sample does not match the host's layout");
+
+static struct profile_sample samples[PROFILER_SAMPLES];
+static size_t sample_count;
+static uint32_t dropped;
+
+static int user_readable(uintptr_t va){
+  pte* entry = pte_of_va(va);
+
+  return entry && (*entry & PTE_V) && (*entry & PTE_U) && (*entry & PTE_R);
+}
+
+/* On RISC-V, fp points just above the saved ra and the caller's fp. Frames
+ * have to stay on the user stack and move strictly up it. */
+static void unwind_user(struct profile_sample* s, uintptr_t fp, uintptr_t sp){
+  uintptr_t frame[2];
+
+  while(s->depth < PROFILER_DEPTH){
+    if(fp & (sizeof(uintptr_t) - 1) || fp <= sp ||
+       fp > EYRIE_USER_STACK_START ||
+       fp < EYRIE_USER_STACK_END + sizeof(frame))
+      break;
+    if(!user_readable(fp - sizeof(frame)) || !user_readable(fp - 1))
+      break;
+
+    copy_from_user(frame, (void*)(fp - sizeof(frame)), sizeof(frame));
+    if(!frame[1])
+      break;
+
+    s->pcs[s->depth++] = frame[1];
+    sp = fp;
+    fp = frame[0];
+  }
+}
+
+void profiler_sample(struct encl_ctx* ctx){
+  struct profile_sample* s;
+
+  if(sample_count == PROFILER_SAMPLES){
+    dropped++;
+    return;
+  }
+
+  s = &samples[sample_count++];
+  s->pcs[0] = ctx->regs.sepc;
+  s->depth = 1;
+
+  if(ctx->sstatus & SR_SPP){
+    s->flags = PROFILE_SAMPLE_RUNTIME;
+    return;
+  }
+  s->flags = 0;
+  unwind_user(s, ctx->regs.s0, ctx->regs.sp);
+}
+
+uintptr_t profiler_flush(void){
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)edge_call_data_ptr();
+  sargs_PROFILE* args = (sargs_PROFILE*)edge_syscall->data;
+  uintptr_t buffer_end = shared_buffer + shared_buffer_size;
+  size_t room, batch, done = 0;
+
+  if(!sample_count && !dropped)
+    return 0;
+  if((uintptr_t)args->samples >= buffer_end)
+    return -1;
+  room = (buffer_end - (uintptr_t)args->samples) / sizeof(struct profile_sample);
+  if(!room)
+    return -1;
+
+  edge_syscall->syscall_num = EDGE_SYSCALL_PROFILE;
+  do{
+    batch = sample_count - done;
+    if(batch > room)
+      batch = room;
+
+    args->magic = PROFILE_MAGIC;
+    args->version = PROFILE_VERSION;
+    args->depth = PROFILER_DEPTH;
+    args->count = batch;
+    args->dropped = done ? 0 : dropped;
+    args->interval = PROFILER_INTERVAL;
+    memcpy(args->samples, &samples[done], batch * sizeof(struct profile_sample));
+
+    if(dispatch_edgecall_syscall(edge_syscall, sizeof(struct edge_syscall) +
+                                 sizeof(sargs_PROFILE) +
+                                 batch * sizeof(struct profile_sample)) != batch)
+      return -1;
+    done += batch;
+  } while(done < sample_count);
+
+  print_strace("[runtime] profiler flushed %lu samples, %u dropped\r\n",
+               sample_count, dropped);
+  sample_count = 0;
+  dropped = 0;
+  return 0;
+}
+
+#endif /* USE_PROFILER */
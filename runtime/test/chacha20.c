@@ -0,0 +1,50 @@
+#include "crypto/chacha20.h"
+
+#include <string.h>
+
+#include "mock.h"
+
+/* RFC 8439, section 2.3.2 */
+static void
+test_block_vector(void** ctx) {
+  uint32_t key[CHACHA20_KEY_WORDS];
+  uint32_t nonce[CHACHA20_NONCE_WORDS] = {0x09000000, 0x4a000000, 0x00000000};
+  uint32_t out[CHACHA20_BLOCK_WORDS];
+  const uint32_t expected[CHACHA20_BLOCK_WORDS] = {
+      0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3, 0xc7f4d1c7, 0x0368c033,
+      0x9aaa2204, 0x4e6cd4c3, 0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+      0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2};
+  int i;
+
+  for (i = 0; i < CHACHA20_KEY_WORDS; i++)
+    key[i] = (4 * i) | (4 * i + 1) << 8 | (4 * i + 2) << 16 | (4 * i + 3) << 24;
+
+  chacha20_block(key, 1, nonce, out);
+  assert_memory_equal(out, expected, sizeof(expected));
+}
+
+/* the key and counter must both change the whole block */
+static void
+test_block_inputs(void** ctx) {
+  uint32_t key[CHACHA20_KEY_WORDS]     = {0};
+  uint32_t nonce[CHACHA20_NONCE_WORDS] = {0};
+  uint32_t a[CHACHA20_BLOCK_WORDS], b[CHACHA20_BLOCK_WORDS];
+
+  chacha20_block(key, 0, nonce, a);
+  chacha20_block(key, 1, nonce, b);
+  assert_memory_not_equal(a, b, sizeof(a));
+
+  key[7] = 1;
+  chacha20_block(key, 0, nonce, b);
+  assert_memory_not_equal(a, b, sizeof(a));
+}
+
+int
+main() {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_block_vector),
+      cmocka_unit_test(test_block_inputs),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -7,12 +7,18 @@
 #include "util/printf.h"
 #include "uaccess.h"
 #include "mm/vm.h"
+#ifdef USE_DRBG
+#include "crypto/drbg.h"
+#endif
 
 // Statically allocated copy-buffer
 unsigned char rt_copy_buffer_1[RISCV_PAGE_SIZE];
 unsigned char rt_copy_buffer_2[RISCV_PAGE_SIZE];
 
 size_t rt_util_getrandom(void* vaddr, size_t buflen){
+#ifdef USE_DRBG
+  return drbg_getrandom(vaddr, buflen);
+#else
   size_t remaining = buflen;
   uintptr_t rnd;
   uintptr_t* next = (uintptr_t*)vaddr;
@@ -30,6 +36,7 @@ size_t rt_util_getrandom(void* vaddr, size_t buflen){
   }
   size_t ret = buflen;
   return ret;
+#endif
 }
 
 void rt_util_misc_fatal(){
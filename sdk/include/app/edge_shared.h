@@ -0,0 +1,45 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __EDGE_SHARED_H__
+#define __EDGE_SHARED_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "edge_common.h"
+
+/* Eapp-side view of the untrusted shared buffer, used by the stubs that
+ * keystone-edger generates. A call lays out its argument struct and
+ * [in]/[out] buffers in a frame at the start of the buffer, so the data
+ * crosses the boundary without intermediate copies. Buffers that outlive a
+ * call (for [user_check] arguments) are reserved from the top instead. */
+
+struct edge_frame {
+  uintptr_t next;
+  uintptr_t end;
+};
+
+/* Starts a frame for one call; returns -1 if the buffer cannot be mapped */
+int
+edge_frame_begin(struct edge_frame* frame);
+
+/* Allocates size bytes, 8-byte aligned; returns NULL if the frame is full */
+void*
+edge_frame_alloc(struct edge_frame* frame, size_t size);
+
+/* Reserves size bytes that stay valid across calls; NULL if out of space.
+ * The runtime keeps proxied syscalls out of reserved space. */
+void*
+edge_shared_reserve(size_t size);
+
+/* Gives back the most recent reservation; returns -1 if ptr is not it */
+int
+edge_shared_release(void* ptr, size_t size);
+
+/* Returns 0 and the host-side offset of [ptr, ptr+size) if it lies in the
+ * shared buffer */
+int
+edge_shared_offset(const void* ptr, size_t size, edge_data_offset* offset);
+
+#endif /* __EDGE_SHARED_H__ */
@@ -3,6 +3,23 @@
 
 #include <stddef.h>
 
+/* mallopt() parameters */
+#define M_MMAP_THRESHOLD -3
+
+/* The fields of glibc's mallinfo, as size_t */
+struct mallinfo {
+  size_t arena;     /* bytes of the heap zone */
+  size_t ordblks;   /* free page runs in the zone */
+  size_t smblks;    /* slabs of small objects */
+  size_t hblks;     /* mmapped allocations */
+  size_t hblkhd;    /* bytes mmapped */
+  size_t usmblks;   /* peak bytes of zone and mappings */
+  size_t fsmblks;   /* bytes of free small objects */
+  size_t uordblks;  /* bytes allocated */
+  size_t fordblks;  /* bytes free in the zone */
+  size_t keepcost;  /* releasable bytes at the top (always 0) */
+};
+
 void* malloc(size_t);
 void
 free(void*);
@@ -17,16 +34,9 @@ cfree(void*);
 int malloc_trim(size_t);
 size_t
 malloc_usable_size(void*);
-void
-malloc_stats(void);
 int
 mallopt(int, int);
 struct mallinfo
 mallinfo(void);
 
-typedef struct freelist_entry {
-  size_t size;
-  struct freelist_entry* next;
-} * fle;
-
 #endif
@@ -0,0 +1,186 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __SEALED_STORAGE_H__
+#define __SEALED_STORAGE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "stream.h"
+
+/* Data sealed to the enclave, for the host to keep.
+ *
+ * A sealed object is a 64-byte header followed by chunks of chunk_size
+ * bytes (the last one shorter), each encrypted with ChaCha20-Poly1305 and
+ * followed by its 16-byte tag:
+ *
+ *   header | chunk 0 | tag 0 | chunk 1 | tag 1 | ... | last chunk | tag
+ *
+ * The key of an object is derived with HKDF-SHA3-512, as the security
+ * monitor derives sealing keys: the eapp's sealing key is extracted into a
+ * sealed_key once, and each object expands it with the random id in its
+ * header. A chunk's nonce is its index, with a flag on the last chunk, and
+ * the header is its associated data, so chunks cannot be moved, dropped
+ * from the end or swapped between objects without the tag failing.
+ * Any chunk can be opened on its own.
+ *
+ * An object is written once: the nonces repeat under its key, so
+ * rewriting a chunk in place would reuse them. Seal a new object instead;
+ * it gets a new id, and so a new key. Ids come from getrandom, which
+ * Eyrie provides with the linux_syscall plugin. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEALED_HEADER_SIZE 64
+#define SEALED_TAG_SIZE 16
+#define SEALED_ID_SIZE 32
+#define SEALED_CHUNK_DEFAULT (64 * 1024)
+#define SEALED_CHUNK_MAX (16 * 1024 * 1024)
+
+struct sealed_header {
+  char magic[8];
+  uint32_t chunk_size;
+  uint32_t flags;  // 0
+  uint8_t id[SEALED_ID_SIZE];
+  uint8_t reserved[16];  // 0
+};
+
+/* The key objects are derived from */
+struct sealed_key {
+  uint8_t prk[64];
+};
+
+struct sealed_object {
+  struct sealed_header header;
+  uint8_t key[32];
+  uint64_t chunks;  // opened objects: how many there are
+  uint64_t size;    // opened objects: the sealed size
+};
+
+/* Derives the key from the sealing key for key_ident (see
+ * get_sealing_key); returns 0, or -1 if the runtime gives no key */
+int
+sealed_key_init(struct sealed_key* key, const void* key_ident, size_t ident_size);
+
+void
+sealed_key_clear(struct sealed_key* key);
+
+/* Sealed size of length bytes in chunks of chunk_size */
+uint64_t
+sealed_size(uint64_t length, size_t chunk_size);
+
+/* Starts a new object with a fresh id; header goes first in its sealed
+ * form. Returns -1 for a chunk size out of range or without randomness. */
+int
+sealed_create(
+    struct sealed_object* obj, const struct sealed_key* key, size_t chunk_size);
+
+/* Opens an object of size sealed bytes from its header */
+int
+sealed_open(
+    struct sealed_object* obj, const struct sealed_key* key,
+    const void* header, uint64_t size);
+
+void
+sealed_close(struct sealed_object* obj);
+
+/* Where chunk index starts in the sealed object */
+uint64_t
+sealed_chunk_offset(const struct sealed_object* obj, uint64_t index);
+
+/* Plaintext length of an opened object */
+uint64_t
+sealed_length(const struct sealed_object* obj);
+
+/* Seals len bytes (chunk_size, or less for the last chunk) as chunk index
+ * into out, which takes len + SEALED_TAG_SIZE bytes */
+void
+sealed_seal_chunk(
+    const struct sealed_object* obj, uint64_t index, int last, const void* in,
+    size_t len, void* out);
+
+/* Opens chunk index of an opened object from its sealed bytes (in_len
+ * includes the tag; in must be in enclave memory); returns the plaintext
+ * length, or -1 if the chunk is not the one sealed there */
+ssize_t
+sealed_open_chunk(
+    const struct sealed_object* obj, uint64_t index, const void* in,
+    size_t in_len, void* out);
+
+/* Seals len bytes into out, which takes sealed_size(len, chunk_size) */
+int
+sealed_seal(
+    const struct sealed_key* key, size_t chunk_size, const void* in,
+    size_t len, void* out);
+
+/* Unseals a whole object of in_len bytes into out; returns its length, or
+ * -1 if out_len is too small or the object does not open */
+ssize_t
+sealed_unseal(
+    const struct sealed_key* key, const void* in, size_t in_len, void* out,
+    size_t out_len);
+
+/* Sealed files, through the proxied IO: streams for whole files and pread
+ * for single chunks. fd is a host descriptor from the proxied open(). */
+
+struct sealed_writer {
+  struct sealed_object obj;
+  struct edge_stream stream;
+  uint64_t index;
+  uint8_t* chunk;  // chunk_size + SEALED_TAG_SIZE
+  size_t fill;
+};
+
+struct sealed_reader {
+  struct sealed_object obj;
+  struct edge_stream stream;
+  uint64_t index;
+  uint8_t* chunk;  // chunk_size + SEALED_TAG_SIZE
+  size_t pos, len;
+  int peeked;  // the first byte of the next chunk is in peek
+  uint8_t peek;
+  int end;
+};
+
+/* Seals everything written to the writer into fd */
+int
+sealed_writer_open(
+    struct sealed_writer* w, const struct sealed_key* key, int fd,
+    size_t chunk_size);
+ssize_t
+sealed_writer_write(struct sealed_writer* w, const void* data, size_t len);
+/* Seals the last chunk; returns -1 if anything could not be written */
+int
+sealed_writer_close(struct sealed_writer* w);
+
+/* Unseals fd from its current position to the end */
+int
+sealed_reader_open(struct sealed_reader* r, const struct sealed_key* key, int fd);
+/* Returns the bytes read, 0 at the end, or -1 if the object does not open
+ * (including if it was cut short) */
+ssize_t
+sealed_reader_read(struct sealed_reader* r, void* buf, size_t len);
+int
+sealed_reader_close(struct sealed_reader* r);
+
+/* Opens the object in fd from its header, for sealed_read_chunk() */
+int
+sealed_open_file(
+    struct sealed_object* obj, const struct sealed_key* key, int fd);
+
+/* Reads chunk index of the object in fd into out, which takes chunk_size +
+ * SEALED_TAG_SIZE bytes, and opens it in place; returns its length or -1.
+ * The chunk passes through the edge call buffer, which has to hold it. */
+ssize_t
+sealed_read_chunk(
+    const struct sealed_object* obj, int fd, uint64_t index, void* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SEALED_STORAGE_H__ */
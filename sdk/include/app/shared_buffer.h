@@ -0,0 +1,40 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __SHARED_BUFFER_H__
+#define __SHARED_BUFFER_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Buffers in the untrusted shared memory (UTM) for data that needs no
+ * confidentiality inside the enclave, such as ciphertexts. The host reads
+ * and writes them in place, so payloads are never copied into enclave
+ * memory on the way in or out. The host can change their contents at any
+ * time: data that has to be trusted, even just to parse it, must be brought
+ * in with shared_buffer_import() first. */
+
+/* Allocates size bytes of shared memory; NULL if there is no room left */
+void*
+shared_buffer_alloc(size_t size);
+
+/* Frees the most recent allocation; returns -1 if buf is not it */
+int
+shared_buffer_free(void* buf, size_t size);
+
+/* Like recv/read/send/write, with buf inside a shared buffer */
+ssize_t
+recv_into_shared(int fd, void* buf, size_t len, int flags);
+ssize_t
+read_into_shared(int fd, void* buf, size_t len);
+ssize_t
+send_from_shared(int fd, const void* buf, size_t len, int flags);
+ssize_t
+write_from_shared(int fd, const void* buf, size_t len);
+
+/* Copies len bytes from a shared buffer into trusted memory; 0 or -1 */
+int
+shared_buffer_import(void* dst, const void* src, size_t len);
+
+#endif /* __SHARED_BUFFER_H__ */
@@ -0,0 +1,62 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "edge_syscall.h"
+
+/* Bulk data between a host file (or socket, or pipe) and the eapp, without
+ * an enclave exit per chunk. The stream keeps a ring of two halves in the
+ * pinned shared buffer (see shared_buffer.h); a host thread reads the file
+ * into one half, or writes one out, while the eapp copies the other. The
+ * eapp only exits to wait when it gets ahead of the host.
+ *
+ * Everything read comes from untrusted memory and is copied into the
+ * caller's buffer before it is returned, so it can be parsed safely; it is
+ * not authenticated. Rings come from shared_buffer_alloc(), so streams
+ * must be closed in the reverse order of opening. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EDGE_STREAM_DEFAULT_HALF (256 * 1024)
+
+struct edge_stream {
+  struct edge_stream_ring* ring;
+  size_t half_size;
+  int fd;
+  int dir;   // EDGE_STREAM_INGEST or EDGE_STREAM_EGRESS
+  int half;  // the half being copied from or into
+  size_t pos;
+  int end;  // ingest: the last half has been reached
+};
+
+/* fd is a host descriptor, as the proxied open() and socket() return;
+ * returns -1 if there is no room for the ring or the host refuses */
+int
+edge_stream_open(struct edge_stream* s, int fd, int dir, size_t half_size);
+
+/* Reads len bytes unless the stream ends first; returns the bytes read,
+ * 0 at the end, or -1 if the host failed to read the file */
+ssize_t
+edge_stream_read(struct edge_stream* s, void* buf, size_t len);
+
+/* Returns len, or -1 if the host failed to write earlier data */
+ssize_t
+edge_stream_write(struct edge_stream* s, const void* buf, size_t len);
+
+/* Egress streams hand over what is left and wait for the host to write
+ * it. Returns -1 if any host read or write failed. fd stays open. */
+int
+edge_stream_close(struct edge_stream* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STREAM_H__ */
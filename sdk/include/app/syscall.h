@@ -11,6 +11,18 @@
 
 #include "shared/eyrie_call.h"
 
+#ifdef KEYSTONE_SIM
+/* simulation builds run on the host and call the emulation in sim.c */
+uintptr_t
+keystone_sim_syscall(
+    uintptr_t which, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2,
+    uintptr_t arg3, uintptr_t arg4);
+
+#define SYSCALL(which, arg0, arg1, arg2, arg3, arg4)                  \
+  keystone_sim_syscall(                                               \
+      (uintptr_t)(which), (uintptr_t)(arg0), (uintptr_t)(arg1),       \
+      (uintptr_t)(arg2), (uintptr_t)(arg3), (uintptr_t)(arg4))
+#else
 #define SYSCALL(which, arg0, arg1, arg2, arg3, arg4)           \
   ({                                                           \
     register uintptr_t a0 asm("a0") = (uintptr_t)(arg0);       \
@@ -25,6 +37,7 @@
                  : "memory");                                  \
     a0;                                                        \
   })
+#endif /* KEYSTONE_SIM */
 
 #define SYSCALL_0(which) SYSCALL(which, 0, 0, 0, 0, 0)
 #define SYSCALL_1(which, arg0) SYSCALL(which, arg0, 0, 0, 0, 0)
@@ -53,4 +66,40 @@ get_sealing_key(
     struct sealing_key* sealing_key_struct, size_t sealing_key_struct_size,
     void* key_ident, size_t key_ident_size);
 
+/* Maps the untrusted shared buffer into the eapp and returns its address
+ * (0 on failure). Used by generated edge calls, see edge_shared.h */
+uintptr_t
+map_shared(size_t* size);
+
+/* Runs an ocall whose arguments are already in the mapped shared buffer */
+int
+ocall_shared(unsigned long call_id, void* args, size_t args_len);
+
+/* Keeps the top size bytes of the mapped shared buffer for the eapp */
+int
+pin_shared(size_t size);
+
+/* Runs read/write/recvfrom/sendto (op is the Linux syscall number) on a
+ * buffer in the pinned part of the shared buffer, see shared_buffer.h */
+intptr_t
+shared_io(unsigned long op, int fd, void* buf, size_t len, int flags);
+
+/* Opens, waits on or closes a stream whose ring lies in the pinned part
+ * of the shared buffer (op is EDGE_STREAM_*), see stream.h */
+int
+stream_call(unsigned long op, int fd, void* ring, size_t half_size, int arg);
+
+/* Attaches SHA-256 hashes (one per 4 KiB page, the last page zero-padded)
+ * to a whole file mapping before any of it is touched. Pages that do not
+ * match when they are read in terminate the enclave. The hashes must stay
+ * valid for the lifetime of the mapping. Needs the file_mmap plugin. */
+int
+mmap_hashes(void* addr, size_t length, const void* hashes);
+
+/* Sends the samples the Eyrie profiler has buffered so far to the host, so
+ * that a long-running eapp does not lose samples to a full buffer. Needs a
+ * runtime built with PROFILER; returns 0 on success. */
+int
+profile_flush(void);
+
 #endif /* syscall.h */
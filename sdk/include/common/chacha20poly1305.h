@@ -0,0 +1,58 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __CHACHA20POLY1305_H__
+#define __CHACHA20POLY1305_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ChaCha20, Poly1305 and the AEAD built from them, as in RFC 8439. Plain
+ * C without tables, so the time they take does not depend on the key or
+ * the data; this is the fast choice on cores without AES instructions. */
+
+#define CHACHA20POLY1305_KEY_SIZE 32
+#define CHACHA20POLY1305_NONCE_SIZE 12
+#define CHACHA20POLY1305_TAG_SIZE 16
+
+typedef struct {
+#ifdef __SIZEOF_INT128__
+  uint64_t r[3], h[3], pad[2];
+#else
+  uint32_t r[5], h[5], pad[4];
+#endif
+  size_t leftover;
+  uint8_t buffer[16];
+  int final;
+} poly1305_ctx_t;
+
+// XORs len bytes of the key stream, from block counter on, into in
+void
+chacha20_xor(
+    const uint8_t key[32], const uint8_t nonce[12], uint32_t counter,
+    const uint8_t* in, uint8_t* out, size_t len);
+
+void
+poly1305_init(poly1305_ctx_t* ctx, const uint8_t key[32]);
+void
+poly1305_update(poly1305_ctx_t* ctx, const uint8_t* data, size_t len);
+void
+poly1305_final(poly1305_ctx_t* ctx, uint8_t tag[16]);
+
+// Encrypts len bytes (out may be in) and computes the tag over aad and them
+void
+chacha20poly1305_encrypt(
+    const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad,
+    size_t aad_len, const uint8_t* in, size_t len, uint8_t* out,
+    uint8_t tag[16]);
+
+// Checks the tag before decrypting anything: returns 0, or -1 with out
+// untouched if it does not match
+int
+chacha20poly1305_decrypt(
+    const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad,
+    size_t aad_len, const uint8_t* in, size_t len, const uint8_t tag[16],
+    uint8_t* out);
+
+#endif /* __CHACHA20POLY1305_H__ */
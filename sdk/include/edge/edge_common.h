@@ -14,9 +14,10 @@ typedef size_t edge_data_offset;
 
 typedef void (*edgecallwrapper)(void*);
 
-#define MAX_EDGE_CALL 10
-
-extern edgecallwrapper edge_call_table[MAX_EDGE_CALL];
+/* Handlers indexed by call id. The table grows as calls are registered,
+ * so ids should be dense (generated ids start at 0). */
+extern edgecallwrapper* edge_call_table;
+extern size_t edge_call_table_size;
 
 /* Call status indicates if the wrapper code, pointers, offsets, etc went OK
  * It has no bearing on data contained in the returns. */
@@ -15,8 +15,8 @@
 extern "C" {
 #endif
 
-// Special call number
-#define EDGECALL_SYSCALL MAX_EDGE_CALL + 1
+// Special call number, outside of the range of registered calls
+#define EDGECALL_SYSCALL ((unsigned long)-1)
 
 struct edge_syscall {
   size_t syscall_num;
@@ -42,6 +42,16 @@ typedef struct sargs_SYS_write {
 // Read uses the same args as write
 typedef sargs_SYS_write sargs_SYS_read;
 
+typedef struct sargs_SYS_pread64 {
+  int fd;
+  size_t len;
+  off_t offset;
+  unsigned char buf[];
+} sargs_SYS_pread64;
+
+// pwrite uses the same args as pread
+typedef sargs_SYS_pread64 sargs_SYS_pwrite64;
+
 struct _sargs_fd_only {
   int fd;
 };
@@ -213,9 +223,128 @@ typedef struct sargs_SYS_sendfile {
   size_t count;
 } sargs_SYS_sendfile;
 
+/* sendmsg/recvmsg and sendmmsg/recvmmsg pack all of their messages into a
+ * single exchange: the header below is followed by vlen sargs_msg entries.
+ * Each entry holds the address and then the data of one message, with the
+ * iovecs flattened, both padded to SARGS_MSG_ALIGN. Ancillary data is not
+ * proxied. */
+#define SARGS_MSG_ALIGN 8
+#define SARGS_MSG_PAD(n) (((n) + SARGS_MSG_ALIGN - 1) & ~((size_t)SARGS_MSG_ALIGN - 1))
+#define SARGS_MSG_SIZE(namecap, cap) \
+  (sizeof(sargs_msg) + SARGS_MSG_PAD(namecap) + SARGS_MSG_PAD(cap))
+
+typedef struct sargs_msg {
+  socklen_t namecap;  // bytes reserved for the address
+  socklen_t namelen;  // address length, updated by receives
+  size_t cap;         // bytes reserved for the data
+  size_t len;         // data length, updated with the bytes transferred
+  int flags;          // msg_flags of receives
+  unsigned char buf[];
+} sargs_msg;
+
+typedef struct sargs_SYS_sendmmsg {
+  int sockfd;
+  int flags;
+  unsigned int vlen;
+  int timeout_is_null;
+  struct timespec timeout;  // recvmmsg only
+  size_t msgs_len;          // bytes of entries that follow
+  unsigned char msgs[];
+} sargs_SYS_sendmmsg;
+
+// recvmmsg and the single-message calls use the same args
+typedef sargs_SYS_sendmmsg sargs_SYS_recvmmsg;
+typedef sargs_SYS_sendmmsg sargs_SYS_sendmsg;
+typedef sargs_SYS_sendmmsg sargs_SYS_recvmsg;
+
+/* read/write/recvfrom/sendto on a buffer the eapp keeps in the shared
+ * region, given by its offset, so the host moves the data in place. The
+ * call number is outside of the Linux range. */
+#define EDGE_SYSCALL_SHARED_IO 0x1000
+
+typedef struct sargs_SHARED_IO {
+  size_t op;  // SYS_read, SYS_write, SYS_recvfrom or SYS_sendto
+  int fd;
+  int flags;  // recvfrom/sendto only
+  edge_data_offset offset;
+  size_t len;
+} sargs_SHARED_IO;
+
+/* A batch of samples from the Eyrie profiler (see runtime/sys/profiler.c),
+ * which the host appends as is to the file named by $KEYSTONE_PROFILE.
+ * Each sample is a uint32_t flags, a uint32_t frame count and depth
+ * uint64_t PCs, innermost first. */
+#define EDGE_SYSCALL_PROFILE 0x1001
+
+#define PROFILE_MAGIC 0x464f5250  // "PROF"
+#define PROFILE_VERSION 1
+#define PROFILE_SAMPLE_RUNTIME 0x1  // interrupted the runtime, not the eapp
+
+typedef struct sargs_PROFILE {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t depth;     // PC slots per sample
+  uint32_t count;     // samples in this batch
+  uint32_t dropped;   // samples lost to a full buffer since the last batch
+  uint64_t interval;  // timer ticks between samples
+  unsigned char samples[];
+} sargs_PROFILE;
+
+#define PROFILE_SAMPLE_SIZE(depth) (2 * sizeof(uint32_t) + (depth) * sizeof(uint64_t))
+
+/* Streams between a host file descriptor and the eapp through a double
+ * buffer in the pinned part of the shared region (see app/stream.h). A
+ * host thread fills or drains one half while the eapp works on the other;
+ * the state word of a half says whose turn it is. The eapp only stops to
+ * wait (EDGE_STREAM_WAIT) when the half it needs is not ready yet. */
+#define EDGE_SYSCALL_STREAM 0x1002
+
+#define EDGE_STREAM_OPEN 0
+#define EDGE_STREAM_WAIT 1
+#define EDGE_STREAM_CLOSE 2
+
+#define EDGE_STREAM_INGEST 0  // host fd -> eapp
+#define EDGE_STREAM_EGRESS 1  // eapp -> host fd
+
+#define EDGE_STREAM_EMPTY 0  // the producer may fill the half
+#define EDGE_STREAM_FULL 1   // the consumer may drain the half
+#define EDGE_STREAM_END 0x1  // half flag: the last data of the stream
+
+struct edge_stream_half {
+  uint32_t state;
+  uint32_t flags;
+  uint64_t len;
+};
+
+struct edge_stream_ring {
+  struct edge_stream_half half[2];
+  int64_t error;  // errno of a failed host read or write, 0 if none
+  unsigned char data[];  // half i starts at data + i * half_size
+};
+
+#define EDGE_STREAM_RING_SIZE(half_size) \
+  (sizeof(struct edge_stream_ring) + 2 * (half_size))
+
+typedef struct sargs_STREAM {
+  size_t op;
+  int fd;   // OPEN: the descriptor to stream from or to
+  int arg;  // OPEN: EDGE_STREAM_INGEST/EGRESS; WAIT: the half to wait for
+  edge_data_offset offset;  // the ring, which also names the stream
+  size_t half_size;
+} sargs_STREAM;
+
 void
 incoming_syscall(struct edge_call* buffer);
 
+/* Handles EDGE_SYSCALL_STREAM, see edge_stream.c */
+int64_t
+incoming_stream(sargs_STREAM* args);
+
+/* Stops the threads of all open streams; they use the shared buffer, so
+ * the host library calls this before the enclave goes away */
+void
+edge_stream_release_all(void);
+
 #ifdef __cplusplus
 }
 #endif
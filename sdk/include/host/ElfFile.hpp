@@ -39,6 +39,7 @@ class ElfFile {
   size_t getProgramHeaderType(size_t ph);
   size_t getProgramHeaderFileSize(size_t ph);
   size_t getProgramHeaderMemorySize(size_t ph);
+  size_t getProgramHeaderFlags(size_t ph);
   uintptr_t getProgramHeaderVaddr(size_t ph);
   uintptr_t getEntryPoint();
   void* getProgramSegment(size_t ph);
@@ -53,6 +54,9 @@ class ElfFile {
   void* ptr;
   size_t fileSize;
 
+  /* parsed as an ELF with page-aligned segments */
+  bool valid;
+
   /* is this runtime binary */
   bool isRuntime;
 
@@ -19,6 +19,7 @@
 #include "./common.h"
 extern "C" {
 #include "common/sha3.h"
+#include "shared/time_page.h"
 }
 #include "ElfFile.hpp"
 #include "Error.hpp"
@@ -30,6 +31,15 @@ namespace Keystone {
 
 typedef std::function<void(void*)> OcallFunc;
 
+/* Time spent in the phases of Enclave::init(), in nanoseconds */
+struct InitProfile {
+  uint64_t create;    // EPM allocation (create ioctl)
+  uint64_t utm;       // untrusted memory allocation
+  uint64_t copy;      // copying the loader, runtime and eapp into the EPM
+  uint64_t finalize;  // finalize ioctl; the SM checks and measures the EPM
+  uint64_t map;       // mapping the untrusted buffer
+};
+
 class Enclave {
  private:
   Params params;
@@ -40,7 +50,13 @@ class Enclave {
   void* shared_buffer;
   size_t shared_buffer_size;
   OcallFunc oFuncDispatch;
+  /* last page of the untrusted buffer, NULL if it is too small */
+  struct keystone_time_page* timePage;
+  uint64_t stoppedAt;
+  InitProfile initProfile;
   bool mapUntrusted(size_t size);
+  void publishTime(bool resume);
+  void markStopped();
   void copyFile(uintptr_t filePtr, size_t fileSize);
   void allocUninitialized(ElfFile* elfFile);
   void loadElf(ElfFile* elfFile);
@@ -49,16 +65,21 @@ class Enclave {
   bool initDevice();
   bool prepareEnclaveMemory(size_t requiredPages, uintptr_t alternatePhysAddr);
   bool initMemory();
+  Error initSimulated(const char* eapppath);
 
  public:
   Enclave();
   ~Enclave();
-  static Error measure(char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath);
+  static Error measure(
+      char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath,
+      bool sharedEapp = false);
   void* getSharedBuffer();
   size_t getSharedBufferSize();
   Memory* getMemory();
   uintptr_t getRuntimeElfAddr() { return runtimeElfAddr; }
   uintptr_t getEnclaveElfAddr() { return enclaveElfAddr; }
+  /* phases of the last successful init() */
+  const InitProfile& getInitProfile() { return initProfile; }
   Error registerOcallDispatch(OcallFunc func);
   Error init(const char* filepath, const char* runtime, const char* loaderpath, Params parameters);
   Error init(
@@ -66,9 +87,19 @@ class Enclave {
       uintptr_t alternatePhysAddr);
   Error destroy();
   Error run(uintptr_t* ret = nullptr);
+  /* non-blocking execution, normally driven by an EnclaveScheduler:
+   * runAsync() starts the enclave, and once getPollFd() is readable
+   * handleEvent() dispatches the ocall and resumes it. handleEvent()
+   * returns EdgeCallHost or EnclaveInterrupted while the enclave keeps
+   * running, and Success with the return value once it exits. */
+  Error runAsync();
+  Error handleEvent(uintptr_t* ret = nullptr);
+  int getPollFd();
 };
 
 uint64_t
-calculate_required_pages(ElfFile** elfFiles, size_t numElfFiles);
+calculate_required_pages(
+    ElfFile* runtimeFile, ElfFile* loaderFile, ElfFile* eappFile,
+    Params& params, bool sharedEapp);
 
 }  // namespace Keystone
@@ -0,0 +1,67 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./common.h"
+#include "Enclave.hpp"
+#include "Error.hpp"
+
+namespace Keystone {
+
+/* Drives many enclaves from a small pool of threads.
+ * Enclaves run asynchronously in the driver. A single poller thread waits
+ * on all of their device fds, and the worker threads dispatch ocalls and
+ * resume the enclaves as they stop. The ocall handlers of one enclave are
+ * never run concurrently, but handlers of different enclaves may be.
+ * Programs using it must link with -pthread. */
+class EnclaveScheduler {
+ public:
+  typedef std::function<void(Enclave*, Error, uintptr_t)> DoneFunc;
+
+  explicit EnclaveScheduler(size_t numThreads = 2);
+  /* waits for all submitted enclaves to exit */
+  ~EnclaveScheduler();
+
+  /* starts an initialized enclave; done is called from a worker thread
+   * with the result once the enclave exits (or fails) */
+  Error submit(Enclave* enclave, DoneFunc done = nullptr);
+  /* blocks until every submitted enclave has exited */
+  void wait();
+
+ private:
+  struct Job {
+    Enclave* enclave;
+    DoneFunc done;
+  };
+
+  std::mutex lock;
+  std::condition_variable readyCond;
+  std::condition_variable idleCond;
+  /* stopped enclaves waiting for a worker */
+  std::deque<Job*> readyQueue;
+  /* enclaves running in the driver, watched by the poller */
+  std::vector<Job*> running;
+  size_t outstanding;
+  bool stopping;
+
+  /* self-pipe used to wake the poller when running changes */
+  int wakeFds[2];
+  std::thread poller;
+  std::vector<std::thread> workers;
+
+  void pollLoop();
+  void workerLoop();
+  void wakePoller();
+  void enqueueLocked(Job* job);
+};
+
+}  // namespace Keystone
@@ -13,12 +13,17 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
 
 #include "./common.h"
 #include "Error.hpp"
 #include "Params.hpp"
+#include "shared/keystone_sim.h"
 #include "shared/keystone_user.h"
 
 namespace Keystone {
@@ -27,10 +32,14 @@ class KeystoneDevice {
  protected:
   int eid;
   uintptr_t physAddr;
+  uint64_t stopTicks;
 
  private:
   int fd;
   Error __run(bool resume, uintptr_t* ret);
+  Error runResult(
+      struct keystone_ioctl_run_enclave* encl, Error error, const char* op,
+      uintptr_t* ret);
 
  public:
   virtual uintptr_t getPhysAddr() { return physAddr; }
@@ -42,11 +51,22 @@ class KeystoneDevice {
   virtual uintptr_t initUTM(size_t size);
   virtual Error finalize(
       uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-      uintptr_t freeRequested);
+      uintptr_t freeRequested, uintptr_t sharedRegion = SHARED_REGION_NONE);
   virtual Error destroy();
+  virtual Error createSharedRegion(
+      const void* image, size_t size, uintptr_t* sharedRegion);
+  virtual Error destroySharedRegion(uintptr_t sharedRegion);
   virtual Error run(uintptr_t* ret);
   virtual Error resume(uintptr_t* ret);
+  /* start run/resume without blocking; the device fd becomes readable
+   * when the enclave stops, and getEvent() returns why */
+  virtual Error runAsync(bool resume);
+  virtual Error getEvent(uintptr_t* ret);
+  virtual int getPollFd() { return fd; }
   virtual void* map(uintptr_t addr, size_t size);
+  /* time CSR when the enclave last stopped, as stamped by the driver; 0 if
+   * unknown */
+  uint64_t getStopTicks() { return stopTicks; }
 };
 
 class MockKeystoneDevice : public KeystoneDevice {
@@ -62,10 +82,64 @@ class MockKeystoneDevice : public KeystoneDevice {
   uintptr_t initUTM(size_t size);
   Error finalize(
       uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-      uintptr_t freeRequested);
+      uintptr_t freeRequested, uintptr_t sharedRegion = SHARED_REGION_NONE);
   Error destroy();
+  Error createSharedRegion(
+      const void* image, size_t size, uintptr_t* sharedRegion);
+  Error destroySharedRegion(uintptr_t sharedRegion);
   Error run(uintptr_t* ret);
   Error resume(uintptr_t* ret);
+  Error runAsync(bool resume);
+  Error getEvent(uintptr_t* ret);
+  int getPollFd() { return -1; }
+  void* map(uintptr_t addr, size_t size);
+};
+
+/* Runs an eapp built for the host (KEYSTONE_SIM) on a thread of the host
+ * process, for profiling and debugging. The eapp is a shared object with a
+ * main(); the runtime and loader are not used. Edge calls stop the thread
+ * and come back through run()/resume() or the poll fd like on hardware. */
+class SimulatedKeystoneDevice : public KeystoneDevice {
+ private:
+  enum class State { Idle, Running, Stopped, Exited };
+
+  std::string eappPath;
+  void* handle;
+  int (*entry)(int, char**);
+  keystone_sim_run_t simRun;
+  void* sharedBuffer;
+  struct keystone_sim_ctx ctx;
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable cond;
+  State state;
+  bool destroying;
+  uintptr_t retval;
+  int eventFd;
+
+  static int stop(void* device);
+  void threadMain();
+  void setState(State next);
+  Error result(uintptr_t* ret);
+
+ public:
+  explicit SimulatedKeystoneDevice(const char* eapppath);
+  ~SimulatedKeystoneDevice();
+  bool initDevice(Params params);
+  Error create(uint64_t minPages);
+  uintptr_t initUTM(size_t size);
+  Error finalize(
+      uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
+      uintptr_t freeRequested, uintptr_t sharedRegion = SHARED_REGION_NONE);
+  Error destroy();
+  Error createSharedRegion(
+      const void* image, size_t size, uintptr_t* sharedRegion);
+  Error destroySharedRegion(uintptr_t sharedRegion);
+  Error run(uintptr_t* ret);
+  Error resume(uintptr_t* ret);
+  Error runAsync(bool resume);
+  Error getEvent(uintptr_t* ret);
+  int getPollFd() { return eventFd; }
   void* map(uintptr_t addr, size_t size);
 };
 
@@ -6,20 +6,25 @@
 
 #include <cstdio>
 
+#include "shared/sm_call.h"
+
 #if __riscv_xlen == 64
 #define DEFAULT_FREEMEM_SIZE 1024 * 1024  // 1 MB
 #define DEFAULT_UNTRUSTED_PTR 0xffffffff80000000
-#define DEFAULT_STACK_SIZE 1024 * 16  // 16k
+#define DEFAULT_SHARED_PTR 0xfffffffec0000000
+#define DEFAULT_STACK_SIZE 1024 * 128  // 128k
 #define DEFAULT_STACK_START 0x0000000040000000
 #elif __riscv_xlen == 32
 #define DEFAULT_FREEMEM_SIZE 1024 * 512  // 512 KiB
 #define DEFAULT_UNTRUSTED_PTR 0x80000000
-#define DEFAULT_STACK_SIZE 1024 * 8  // 3 KiB
+#define DEFAULT_SHARED_PTR 0xd0000000
+#define DEFAULT_STACK_SIZE 1024 * 128  // 128 KiB
 #define DEFAULT_STACK_START 0x40000000
 #else                                     // for x86 tests
 #define DEFAULT_FREEMEM_SIZE 1024 * 1024  // 1 MB
 #define DEFAULT_UNTRUSTED_PTR 0xffffffff80000000
-#define DEFAULT_STACK_SIZE 1024 * 16  // 16k
+#define DEFAULT_SHARED_PTR 0xfffffffec0000000
+#define DEFAULT_STACK_SIZE 1024 * 128  // 128k
 #define DEFAULT_STACK_START 0x0000000040000000
 #endif
 
@@ -33,16 +38,33 @@ class Params {
   Params() {
     untrusted_size = DEFAULT_UNTRUSTED_SIZE;
     freemem_size   = DEFAULT_FREEMEM_SIZE;
+    shared_region  = SHARED_REGION_NONE;
+    in_process_sim = false;
+    time_page      = false;
   }
 
   void setUntrustedSize(uint64_t size) { untrusted_size = size; }
   void setFreeMemSize(uint64_t size) { freemem_size = size; }
   uintptr_t getUntrustedSize() { return untrusted_size; }
   uintptr_t getFreeMemSize() { return freemem_size; }
+  /* load the eapp from a SharedRegion instead of the private EPM */
+  void setSharedRegion(uintptr_t id) { shared_region = id; }
+  uintptr_t getSharedRegion() { return shared_region; }
+  /* run a host build of the eapp in-process, see SimulatedKeystoneDevice;
+   * to only measure an enclave, use Enclave::measure() */
+  void setInProcessSimulation(bool _sim) { in_process_sim = _sim; }
+  bool isInProcessSimulation() { return in_process_sim; }
+  /* give up the last page of the untrusted buffer to publish the time,
+   * so clock_gettime() does not exit the enclave; see time_page.h */
+  void setTimePage(bool _time_page) { time_page = _time_page; }
+  bool hasTimePage() { return time_page; }
 
  private:
   uint64_t untrusted_size;
   uint64_t freemem_size;
+  uintptr_t shared_region;
+  bool in_process_sim;
+  bool time_page;
 };
 
 }  // namespace Keystone
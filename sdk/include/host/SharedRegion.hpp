@@ -0,0 +1,30 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "./common.h"
+#include "Error.hpp"
+#include "KeystoneDevice.hpp"
+
+namespace Keystone {
+
+/* An eapp image that is measured once by the SM and mapped read+execute
+ * into every enclave created with Params::setSharedRegion(getId()).
+ * The region must outlive all enclaves that use it. */
+class SharedRegion {
+ private:
+  KeystoneDevice* pDevice;
+  uintptr_t id;
+
+ public:
+  SharedRegion();
+  ~SharedRegion();
+  static Error measure(char* hash, const char* eapppath);
+  Error init(const char* eapppath);
+  Error destroy();
+  uintptr_t getId() { return id; }
+};
+
+}  // namespace Keystone
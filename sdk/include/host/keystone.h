@@ -1 +1,3 @@
 #include "Enclave.hpp"
+#include "SharedRegion.hpp"
+#include "EnclaveScheduler.hpp"
@@ -26,6 +26,18 @@
   _IOR(KEYSTONE_IOC_MAGIC, 0x06, struct keystone_ioctl_create_enclave)
 #define KEYSTONE_IOC_UTM_INIT \
   _IOR(KEYSTONE_IOC_MAGIC, 0x07, struct keystone_ioctl_create_enclave)
+#define KEYSTONE_IOC_CREATE_SHARED_REGION \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x08, struct keystone_ioctl_shared_region)
+#define KEYSTONE_IOC_DESTROY_SHARED_REGION \
+  _IOW(KEYSTONE_IOC_MAGIC, 0x09, struct keystone_ioctl_shared_region)
+#define KEYSTONE_IOC_RUN_ENCLAVE_ASYNC \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0a, struct keystone_ioctl_run_enclave)
+#define KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0b, struct keystone_ioctl_run_enclave)
+#define KEYSTONE_IOC_ENCLAVE_EVENT \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0c, struct keystone_ioctl_run_enclave)
+#define KEYSTONE_IOC_SET_EVENTFD \
+  _IOW(KEYSTONE_IOC_MAGIC, 0x0d, struct keystone_ioctl_eventfd)
 
 #define RT_NOEXEC 0
 #define USER_NOEXEC 1
@@ -45,6 +57,7 @@ struct keystone_ioctl_create_enclave {
   uintptr_t user_paddr;
   uintptr_t free_paddr;
   uintptr_t free_requested;
+  uintptr_t shared_region_id;
 
   // driver -> host
   uintptr_t epm_paddr;
@@ -52,10 +65,27 @@ struct keystone_ioctl_create_enclave {
   uintptr_t utm_paddr;
 };
 
+struct keystone_ioctl_shared_region {
+  // driver -> host
+  uintptr_t sid;
+
+  // host -> driver
+  uintptr_t image_ptr;
+  uintptr_t image_size;
+};
+
 struct keystone_ioctl_run_enclave {
   uintptr_t eid;
   uintptr_t error;
   uintptr_t value;
+  // time CSR right after the enclave stopped
+  __u64 stop_ticks;
+};
+
+struct keystone_ioctl_eventfd {
+  uintptr_t eid;
+  // signaled when an asynchronous run stops, negative to unregister
+  uintptr_t fd;
 };
 
 #endif
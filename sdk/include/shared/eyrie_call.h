@@ -6,6 +6,17 @@
 #define RUNTIME_SYSCALL_SHAREDCOPY          1002
 #define RUNTIME_SYSCALL_ATTEST_ENCLAVE      1003
 #define RUNTIME_SYSCALL_GET_SEALING_KEY     1004
+#define RUNTIME_SYSCALL_MAP_SHARED          1005
+#define RUNTIME_SYSCALL_OCALL_SHARED        1006
+#define RUNTIME_SYSCALL_MMAP_HASHES         1007
+#define RUNTIME_SYSCALL_PIN_SHARED          1008
+#define RUNTIME_SYSCALL_SHARED_IO           1009
+#define RUNTIME_SYSCALL_PROFILE_FLUSH       1010
+#define RUNTIME_SYSCALL_STREAM              1011
 #define RUNTIME_SYSCALL_EXIT                1101
 
+/* fcntl(fd, EYRIE_F_SETCACHE, 1/0) moves a file in or out of the Eyrie
+ * io_cache; 1536 is past the Linux F_LINUX_SPECIFIC_BASE commands */
+#define EYRIE_F_SETCACHE                    1536
+
 #endif  // __EYRIE_CALL_H__
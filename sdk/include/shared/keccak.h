@@ -0,0 +1,308 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __KECCAK_H__
+#define __KECCAK_H__
+
+/* Keccak-f[1600] and the absorb loop behind every sha3.c in the tree: the
+ * SDK's, the security monitor's, the bootrom's and the one U-Boot builds for
+ * secure boot. Each of them includes this file after its sha3.h, which
+ * brings in uint8_t, uint64_t and size_t the way that tree does.
+ *
+ * The rounds are unrolled and run two at a time, from the lanes in A to the
+ * lanes in E and back, so no lane is moved between rounds. Where the target
+ * has no and-not instruction, as on RISC-V without Zbb or x86 without BMI,
+ * six lanes are kept complemented while the permutation runs, which takes
+ * chi from 25 NOTs a round down to 5. Targets with one (AArch64, RISC-V with
+ * Zbb) use the plain chi. Define KECCAK_COMPLEMENT_LANES to 0 or 1 to choose.
+ *
+ * The state is the little-endian byte string of FIPS 202. On little-endian
+ * targets, input that lines up with a lane is absorbed a lane at a time;
+ * pages do, so hashing enclave memory takes that path. */
+
+#ifndef KECCAKF_ROUNDS
+#define KECCAKF_ROUNDS 24
+#endif
+
+#if KECCAKF_ROUNDS % 2
+#error "KECCAKF_ROUNDS must be even"
+#endif
+
+#ifndef KECCAK_COMPLEMENT_LANES
+#if defined(__aarch64__) || defined(__riscv_zbb) || defined(__BMI__)
+#define KECCAK_COMPLEMENT_LANES 0
+#else
+#define KECCAK_COMPLEMENT_LANES 1
+#endif
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define KECCAK_LANE_ABSORB 1
+#else
+#define KECCAK_LANE_ABSORB 0
+#endif
+
+/* lanes read straight from the input; targets that handle misaligned loads
+ * in hardware take any input, the rest only aligned input */
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+typedef uint64_t __attribute__((may_alias, aligned(1))) keccak_lane_t;
+#define KECCAK_LANE_ALIGNED(p) 1
+#else
+typedef uint64_t __attribute__((may_alias)) keccak_lane_t;
+#define KECCAK_LANE_ALIGNED(p) (((unsigned long)(p)&7) == 0)
+#endif
+
+#define KECCAK_ROTL(x, y) (((x) << (y)) | ((x) >> (64 - (y))))
+
+static const uint64_t keccakf_rndc[24] = {
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+    0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+    0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+    0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+    0x8000000000008080, 0x0000000080000001, 0x8000000080008008};
+
+/* Lane x + 5y is named after its row y (b, g, k, m, s) and column x (a, e,
+ * i, o, u). Chi on one row: B0..B4 are its lanes after theta, rho and pi. */
+
+#if KECCAK_COMPLEMENT_LANES
+
+/* lanes be, bi, go, ki, mi and sa are complemented, and chi is written so
+ * that each round leaves the same six complemented */
+#define KECCAK_LANE_MASK(i) ((0x121106UL >> (i)) & 1 ? ~(uint64_t)0 : 0)
+
+#define KECCAK_CHI_b(E, B0, B1, B2, B3, B4) \
+  do {                                      \
+    E##ba = B0 ^ (B1 | B2);                 \
+    E##be = B1 ^ (~B2 | B3);                \
+    E##bi = B2 ^ (B3 & B4);                 \
+    E##bo = B3 ^ (B4 | B0);                 \
+    E##bu = B4 ^ (B0 & B1);                 \
+  } while (0)
+#define KECCAK_CHI_g(E, B0, B1, B2, B3, B4) \
+  do {                                      \
+    E##ga = B0 ^ (B1 | B2);                 \
+    E##ge = B1 ^ (B2 & B3);                 \
+    E##gi = B2 ^ (B3 | ~B4);                \
+    E##go = B3 ^ (B4 | B0);                 \
+    E##gu = B4 ^ (B0 & B1);                 \
+  } while (0)
+#define KECCAK_CHI_k(E, B0, B1, B2, B3, B4) \
+  do {                                      \
+    uint64_t n3 = ~B3;                      \
+    E##ka       = B0 ^ (B1 | B2);           \
+    E##ke       = B1 ^ (B2 & B3);           \
+    E##ki       = B2 ^ (n3 & B4);           \
+    E##ko       = n3 ^ (B4 | B0);           \
+    E##ku       = B4 ^ (B0 & B1);           \
+  } while (0)
+#define KECCAK_CHI_m(E, B0, B1, B2, B3, B4) \
+  do {                                      \
+    uint64_t n3 = ~B3;                      \
+    E##ma       = B0 ^ (B1 & B2);           \
+    E##me       = B1 ^ (B2 | B3);           \
+    E##mi       = B2 ^ (n3 | B4);           \
+    E##mo       = n3 ^ (B4 & B0);           \
+    E##mu       = B4 ^ (B0 | B1);           \
+  } while (0)
+#define KECCAK_CHI_s(E, B0, B1, B2, B3, B4) \
+  do {                                      \
+    uint64_t n1 = ~B1;                      \
+    E##sa       = B0 ^ (n1 & B2);           \
+    E##se       = n1 ^ (B2 | B3);           \
+    E##si       = B2 ^ (B3 & B4);           \
+    E##so       = B3 ^ (B4 | B0);           \
+    E##su       = B4 ^ (B0 & B1);           \
+  } while (0)
+
+#else
+
+#define KECCAK_LANE_MASK(i) 0
+
+#define KECCAK_CHI(E, y, B0, B1, B2, B3, B4) \
+  do {                                       \
+    E##y##a = B0 ^ (~B1 & B2);               \
+    E##y##e = B1 ^ (~B2 & B3);               \
+    E##y##i = B2 ^ (~B3 & B4);               \
+    E##y##o = B3 ^ (~B4 & B0);               \
+    E##y##u = B4 ^ (~B0 & B1);               \
+  } while (0)
+#define KECCAK_CHI_b(E, ...) KECCAK_CHI(E, b, __VA_ARGS__)
+#define KECCAK_CHI_g(E, ...) KECCAK_CHI(E, g, __VA_ARGS__)
+#define KECCAK_CHI_k(E, ...) KECCAK_CHI(E, k, __VA_ARGS__)
+#define KECCAK_CHI_m(E, ...) KECCAK_CHI(E, m, __VA_ARGS__)
+#define KECCAK_CHI_s(E, ...) KECCAK_CHI(E, s, __VA_ARGS__)
+
+#endif
+
+/* one round from the lanes in A to the lanes in E */
+#define KECCAK_ROUND(A, E, rc)                                               \
+  do {                                                                       \
+    uint64_t c0, c1, c2, c3, c4, d0, d1, d2, d3, d4, b0, b1, b2, b3, b4;     \
+    c0 = A##ba ^ A##ga ^ A##ka ^ A##ma ^ A##sa;                              \
+    c1 = A##be ^ A##ge ^ A##ke ^ A##me ^ A##se;                              \
+    c2 = A##bi ^ A##gi ^ A##ki ^ A##mi ^ A##si;                              \
+    c3 = A##bo ^ A##go ^ A##ko ^ A##mo ^ A##so;                              \
+    c4 = A##bu ^ A##gu ^ A##ku ^ A##mu ^ A##su;                              \
+    d0 = c4 ^ KECCAK_ROTL(c1, 1);                                            \
+    d1 = c0 ^ KECCAK_ROTL(c2, 1);                                            \
+    d2 = c1 ^ KECCAK_ROTL(c3, 1);                                            \
+    d3 = c2 ^ KECCAK_ROTL(c4, 1);                                            \
+    d4 = c3 ^ KECCAK_ROTL(c0, 1);                                            \
+                                                                             \
+    b0 = A##ba ^ d0;                                                         \
+    b1 = A##ge ^ d1;                                                         \
+    b2 = A##ki ^ d2;                                                         \
+    b3 = A##mo ^ d3;                                                         \
+    b4 = A##su ^ d4;                                                         \
+    b1 = KECCAK_ROTL(b1, 44);                                                \
+    b2 = KECCAK_ROTL(b2, 43);                                                \
+    b3 = KECCAK_ROTL(b3, 21);                                                \
+    b4 = KECCAK_ROTL(b4, 14);                                                \
+    KECCAK_CHI_b(E, b0, b1, b2, b3, b4);                                     \
+    E##ba ^= (rc);                                                           \
+                                                                             \
+    b0 = A##bo ^ d3;                                                         \
+    b1 = A##gu ^ d4;                                                         \
+    b2 = A##ka ^ d0;                                                         \
+    b3 = A##me ^ d1;                                                         \
+    b4 = A##si ^ d2;                                                         \
+    b0 = KECCAK_ROTL(b0, 28);                                                \
+    b1 = KECCAK_ROTL(b1, 20);                                                \
+    b2 = KECCAK_ROTL(b2, 3);                                                 \
+    b3 = KECCAK_ROTL(b3, 45);                                                \
+    b4 = KECCAK_ROTL(b4, 61);                                                \
+    KECCAK_CHI_g(E, b0, b1, b2, b3, b4);                                     \
+                                                                             \
+    b0 = A##be ^ d1;                                                         \
+    b1 = A##gi ^ d2;                                                         \
+    b2 = A##ko ^ d3;                                                         \
+    b3 = A##mu ^ d4;                                                         \
+    b4 = A##sa ^ d0;                                                         \
+    b0 = KECCAK_ROTL(b0, 1);                                                 \
+    b1 = KECCAK_ROTL(b1, 6);                                                 \
+    b2 = KECCAK_ROTL(b2, 25);                                                \
+    b3 = KECCAK_ROTL(b3, 8);                                                 \
+    b4 = KECCAK_ROTL(b4, 18);                                                \
+    KECCAK_CHI_k(E, b0, b1, b2, b3, b4);                                     \
+                                                                             \
+    b0 = A##bu ^ d4;                                                         \
+    b1 = A##ga ^ d0;                                                         \
+    b2 = A##ke ^ d1;                                                         \
+    b3 = A##mi ^ d2;                                                         \
+    b4 = A##so ^ d3;                                                         \
+    b0 = KECCAK_ROTL(b0, 27);                                                \
+    b1 = KECCAK_ROTL(b1, 36);                                                \
+    b2 = KECCAK_ROTL(b2, 10);                                                \
+    b3 = KECCAK_ROTL(b3, 15);                                                \
+    b4 = KECCAK_ROTL(b4, 56);                                                \
+    KECCAK_CHI_m(E, b0, b1, b2, b3, b4);                                     \
+                                                                             \
+    b0 = A##bi ^ d2;                                                         \
+    b1 = A##go ^ d3;                                                         \
+    b2 = A##ku ^ d4;                                                         \
+    b3 = A##ma ^ d0;                                                         \
+    b4 = A##se ^ d1;                                                         \
+    b0 = KECCAK_ROTL(b0, 62);                                                \
+    b1 = KECCAK_ROTL(b1, 55);                                                \
+    b2 = KECCAK_ROTL(b2, 39);                                                \
+    b3 = KECCAK_ROTL(b3, 41);                                                \
+    b4 = KECCAK_ROTL(b4, 2);                                                 \
+    KECCAK_CHI_s(E, b0, b1, b2, b3, b4);                                     \
+  } while (0)
+
+#define KECCAK_LANES(X)                                                     \
+  X(ba, 0), X(be, 1), X(bi, 2), X(bo, 3), X(bu, 4), X(ga, 5), X(ge, 6),     \
+      X(gi, 7), X(go, 8), X(gu, 9), X(ka, 10), X(ke, 11), X(ki, 12),        \
+      X(ko, 13), X(ku, 14), X(ma, 15), X(me, 16), X(mi, 17), X(mo, 18),     \
+      X(mu, 19), X(sa, 20), X(se, 21), X(si, 22), X(so, 23), X(su, 24)
+
+#define KECCAK_LOAD(lane, i) A##lane = st[i] ^ KECCAK_LANE_MASK(i)
+#define KECCAK_STORE(lane, i) st[i] = A##lane ^ KECCAK_LANE_MASK(i)
+#define KECCAK_DECLARE(lane, i) A##lane, E##lane
+
+static void
+keccakf1600(uint64_t st[25]) {
+  uint64_t KECCAK_LANES(KECCAK_DECLARE);
+  int r;
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  uint8_t* v;
+  uint64_t t;
+
+  // endianess conversion. this is redundant on little-endian targets
+  for (r = 0; r < 25; r++) {
+    v     = (uint8_t*)&st[r];
+    st[r] = ((uint64_t)v[0]) | (((uint64_t)v[1]) << 8) |
+            (((uint64_t)v[2]) << 16) | (((uint64_t)v[3]) << 24) |
+            (((uint64_t)v[4]) << 32) | (((uint64_t)v[5]) << 40) |
+            (((uint64_t)v[6]) << 48) | (((uint64_t)v[7]) << 56);
+  }
+#endif
+
+  KECCAK_LANES(KECCAK_LOAD);
+  for (r = 0; r < KECCAKF_ROUNDS; r += 2) {
+    KECCAK_ROUND(A, E, keccakf_rndc[r]);
+    KECCAK_ROUND(E, A, keccakf_rndc[r + 1]);
+  }
+  KECCAK_LANES(KECCAK_STORE);
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  // endianess conversion. this is redundant on little-endian targets
+  for (r = 0; r < 25; r++) {
+    v    = (uint8_t*)&st[r];
+    t    = st[r];
+    v[0] = t & 0xFF;
+    v[1] = (t >> 8) & 0xFF;
+    v[2] = (t >> 16) & 0xFF;
+    v[3] = (t >> 24) & 0xFF;
+    v[4] = (t >> 32) & 0xFF;
+    v[5] = (t >> 40) & 0xFF;
+    v[6] = (t >> 48) & 0xFF;
+    v[7] = (t >> 56) & 0xFF;
+  }
+#endif
+}
+
+/* XORs len bytes of in into the state from byte pt on, permuting every
+ * rate bytes; returns where the next byte goes */
+static unsigned int
+keccak_absorb(
+    uint64_t st[25], unsigned int rate, unsigned int pt, const uint8_t* in,
+    size_t len) {
+  uint8_t* b = (uint8_t*)st;
+
+#if KECCAK_LANE_ABSORB
+  if (!(rate & 7)) {
+    for (; len && (pt & 7); len--) b[pt++] ^= *in++;
+    if (pt == rate) {
+      keccakf1600(st);
+      pt = 0;
+    }
+    if (!(pt & 7) && KECCAK_LANE_ALIGNED(in)) {
+      for (; len >= 8; len -= 8, in += 8) {
+        st[pt / 8] ^= *(const keccak_lane_t*)in;
+        pt += 8;
+        if (pt == rate) {
+          keccakf1600(st);
+          pt = 0;
+        }
+      }
+    }
+  }
+#endif
+
+  for (; len; len--) {
+    b[pt++] ^= *in++;
+    if (pt == rate) {
+      keccakf1600(st);
+      pt = 0;
+    }
+  }
+  return pt;
+}
+
+#endif /* __KECCAK_H__ */
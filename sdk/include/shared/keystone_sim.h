@@ -0,0 +1,28 @@
+#ifndef __KEYSTONE_SIM_H__
+#define __KEYSTONE_SIM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Interface between the simulation device of the host library and an eapp
+ * built for the host (KEYSTONE_SIM). The eapp is a shared object that the
+ * device loads into the host process and runs on a thread of its own. The
+ * eapp library emulates the Eyrie calls in-process; Linux syscalls go
+ * straight to the host kernel. Nothing here is isolated or measured. */
+struct keystone_sim_ctx {
+  /* the untrusted buffer, without the time page */
+  void* shared_buffer;
+  size_t shared_size;
+  /* hands the edge call in the shared buffer to the host and returns once
+   * it has been handled; nonzero if the enclave is being destroyed */
+  int (*stop)(void* device);
+  void* device;
+};
+
+/* Exported by the eapp library; runs entry and returns its exit value */
+#define KEYSTONE_SIM_RUN "keystone_sim_run"
+typedef uintptr_t (*keystone_sim_run_t)(
+    struct keystone_sim_ctx* ctx, int (*entry)(int, char**), int argc,
+    char** argv);
+
+#endif  // __KEYSTONE_SIM_H__
@@ -15,6 +15,8 @@
 #define SBI_SM_DESTROY_ENCLAVE   2002
 #define SBI_SM_RUN_ENCLAVE       2003
 #define SBI_SM_RESUME_ENCLAVE    2005
+#define SBI_SM_CREATE_SHARED_REGION  2006
+#define SBI_SM_DESTROY_SHARED_REGION 2007
 #define FID_RANGE_HOST           2999
 
 /* 3000-3999 are called by enclave */
@@ -23,6 +25,7 @@
 #define SBI_SM_GET_SEALING_KEY   3003
 #define SBI_SM_STOP_ENCLAVE      3004
 #define SBI_SM_EXIT_ENCLAVE      3006
+#define SBI_SM_GET_SHARED_REGION 3007
 #define FID_RANGE_ENCLAVE        3999
 
 /* 4000-4999 are experimental */
@@ -39,6 +42,9 @@
 #define STOP_EDGE_CALL_HOST   1
 #define STOP_EXIT_ENCLAVE     2
 
+/* No shared read-only region attached to the enclave */
+#define SHARED_REGION_NONE ((uintptr_t)-1)
+
 /* Structs for interfacing into the SM */
 struct runtime_params_t {
   uintptr_t dram_base;
@@ -64,6 +70,9 @@ struct keystone_sbi_create_t {
   uintptr_t user_paddr;
   uintptr_t free_paddr;
   uintptr_t free_requested;
+
+  // id returned by SBI_SM_CREATE_SHARED_REGION, or SHARED_REGION_NONE
+  uintptr_t shared_region_id;
 };
 
 #endif  // __SM_CALL_H__
@@ -0,0 +1,30 @@
+#ifndef __TIME_PAGE_H__
+#define __TIME_PAGE_H__
+
+#include <stdint.h>
+
+/* Clock information published by the host in the last page of the
+ * untrusted buffer, so the runtime can answer clock_gettime() from the
+ * time CSR without leaving the enclave. The host opts in with
+ * Params::setTimePage(); the runtime only reserves the page if it finds
+ * the magic there at boot. The host only writes it while the
+ * enclave is stopped (before run and every resume). All values are
+ * untrusted: the host could lie about wall time through an ocall anyway,
+ * and the monotonic clocks only take the tick rate from it. */
+struct keystone_time_page {
+  /* frequency of the time CSR; 0 if nothing has been published */
+  uint64_t timebase_hz;
+  /* CLOCK_REALTIME minus CLOCK_MONOTONIC, in nanoseconds */
+  int64_t realtime_offset_ns;
+  /* time CSR value when the enclave was first run */
+  uint64_t start_ticks;
+  /* ticks the enclave has spent stopped (ocalls and interrupts) since */
+  uint64_t stopped_ticks;
+  /* KEYSTONE_TIME_PAGE_MAGIC if the host publishes the page */
+  uint64_t magic;
+};
+
+#define KEYSTONE_TIME_PAGE_SIZE 4096
+#define KEYSTONE_TIME_PAGE_MAGIC 0x454d4954  // "TIME"
+
+#endif  // __TIME_PAGE_H__
@@ -33,6 +33,7 @@ struct report_t {
 class Report {
  private:
   struct report_t report;
+  friend class ReportVerifier;
 
  public:
   std::string BytesToHex(byte* bytes, size_t len);
@@ -0,0 +1,62 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Report.hpp"
+
+/* Checks reports as Report::verify() and Report::checkSignaturesOnly() do,
+ * for verifiers that check many of them.
+ *
+ * A device signs its security monitor's hash and public key once per boot,
+ * so every report from that boot carries the same SM report. SM reports
+ * whose signature checked out are cached, and only the enclave signature
+ * of a report from a known SM is checked. The enclave signatures of
+ * reports checked together go through ed25519 batch verification, which
+ * can accept a signature that the signing SM tweaked by a point of small
+ * order (see ed25519_verify_batch()); SM signatures are always checked
+ * one by one before they are cached.
+ *
+ * A ReportVerifier can be shared by any number of threads. */
+class ReportVerifier {
+ public:
+  // cache_size SM reports are kept, the least recently used are dropped
+  explicit ReportVerifier(size_t cache_size = 1024);
+
+  int verify(
+      const Report& report, const byte* expected_enclave_hash,
+      const byte* expected_sm_hash, const byte* dev_public_key);
+  int checkSignaturesOnly(const Report& report, const byte* dev_public_key);
+
+  /* The same for many reports: (*valid)[i] is the result for reports[i],
+   * and 1 is returned if all of them pass */
+  int verify(
+      const std::vector<const Report*>& reports,
+      const byte* expected_enclave_hash, const byte* expected_sm_hash,
+      const byte* dev_public_key, std::vector<int>* valid);
+  int checkSignaturesOnly(
+      const std::vector<const Report*>& reports, const byte* dev_public_key,
+      std::vector<int>* valid);
+
+  size_t getCacheHits();
+  size_t getCacheMisses();
+  void clearCache();
+
+ private:
+  std::string smKey(const Report& report, const byte* dev_public_key);
+  bool isCached(const std::string& key);
+  void addToCache(const std::string& key);
+
+  size_t cache_size;
+  size_t hits;
+  size_t misses;
+  std::mutex cache_lock;
+  std::list<std::string> lru;  // most recently used first
+  std::unordered_map<std::string, std::list<std::string>::iterator> cache;
+};
@@ -158,3 +158,33 @@ macro(add_keystone_package target_name package_name package_script) # files are
     )
 
 endmacro(add_keystone_package)
+
+# CMake macro for typed edge calls
+# Runs keystone-edger on an EDL file and sets ${name}_EDGE_TRUSTED (stubs for
+# the eapp), ${name}_EDGE_UNTRUSTED (wrappers for the host) and
+# ${name}_EDGE_INCLUDE (directory of ${name}_edge.h)
+macro(add_edge_calls name edl)
+  set(edge_out ${CMAKE_CURRENT_BINARY_DIR}/edge-${name})
+  set(edger ${KEYSTONE_SDK_DIR}/scripts/keystone-edger)
+  get_filename_component(edl_path ${edl} ABSOLUTE)
+
+  add_custom_command(
+    OUTPUT ${edge_out}/${name}_edge.h ${edge_out}/${name}_t.c ${edge_out}/${name}_u.c
+    DEPENDS ${edl_path} ${edger}
+    COMMAND ${edger} --name ${name} --output-dir ${edge_out} ${ARGN} ${edl_path})
+
+  set(${name}_EDGE_TRUSTED ${edge_out}/${name}_t.c ${edge_out}/${name}_edge.h)
+  set(${name}_EDGE_UNTRUSTED ${edge_out}/${name}_u.c ${edge_out}/${name}_edge.h)
+  set(${name}_EDGE_INCLUDE ${edge_out})
+endmacro(add_edge_calls)
+
+# CMake macro for eapps run in simulation (an SDK built with KEYSTONE_SIM)
+# Builds ${target_name}.so for the build machine; a host application loads
+# it through Enclave::init() with Params::setInProcessSimulation(true) and
+# links ${KEYSTONE_LIB_HOST} with -ldl and -pthread
+macro(add_sim_eapp target_name) # sources are passed via ${ARGN}
+  add_library(${target_name} MODULE ${ARGN})
+  target_compile_definitions(${target_name} PRIVATE KEYSTONE_SIM)
+  target_link_libraries(${target_name} ${KEYSTONE_LIB_EAPP} ${KEYSTONE_LIB_EDGE})
+  set_target_properties(${target_name} PROPERTIES PREFIX "")
+endmacro(add_sim_eapp)
@@ -0,0 +1,91 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "edge_shared.h"
+#include "syscall.h"
+
+#define EDGE_ALIGN(x) (((x) + 7) & ~(uintptr_t)7)
+
+static uintptr_t shared_base;
+static size_t shared_size;
+/* frames use [base + edge_call header, top), reservations [top, end) */
+static uintptr_t shared_top;
+
+static int
+edge_shared_init() {
+  if (shared_base) return 0;
+
+  shared_base = map_shared(&shared_size);
+  if (!shared_base) return -1;
+
+  shared_top = (shared_base + shared_size) & ~(uintptr_t)7;
+  return 0;
+}
+
+int
+edge_frame_begin(struct edge_frame* frame) {
+  if (edge_shared_init() != 0) return -1;
+
+  frame->next = EDGE_ALIGN(shared_base + sizeof(struct edge_call));
+  frame->end  = shared_top;
+  return 0;
+}
+
+void*
+edge_frame_alloc(struct edge_frame* frame, size_t size) {
+  uintptr_t ptr = frame->next;
+
+  if (size > frame->end - ptr) return NULL;
+
+  frame->next = EDGE_ALIGN(ptr + size);
+  if (frame->next > frame->end) frame->next = frame->end;
+  return (void*)ptr;
+}
+
+void*
+edge_shared_reserve(size_t size) {
+  uintptr_t bottom, top;
+
+  if (edge_shared_init() != 0) return NULL;
+
+  bottom = EDGE_ALIGN(shared_base + sizeof(struct edge_call));
+  if (size > shared_top - bottom) return NULL;
+
+  top = (shared_top - size) & ~(uintptr_t)7;
+  /* the runtime must stop laying out proxied calls over the buffer */
+  if (top < bottom || pin_shared(shared_base + shared_size - top) != 0)
+    return NULL;
+
+  shared_top = top;
+  return (void*)shared_top;
+}
+
+int
+edge_shared_release(void* ptr, size_t size) {
+  uintptr_t top;
+
+  if (!shared_base || (uintptr_t)ptr != shared_top) return -1;
+
+  top = EDGE_ALIGN(shared_top + size);
+  if (top > shared_base + shared_size ||
+      pin_shared(shared_base + shared_size - top) != 0)
+    return -1;
+
+  shared_top = top;
+  return 0;
+}
+
+int
+edge_shared_offset(const void* ptr, size_t size, edge_data_offset* offset) {
+  uintptr_t p = (uintptr_t)ptr;
+
+  if (edge_shared_init() != 0) return -1;
+
+  if (p < shared_base || p > shared_base + shared_size ||
+      size > shared_base + shared_size - p)
+    return -1;
+
+  *offset = p - shared_base;
+  return 0;
+}
@@ -0,0 +1,555 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "malloc.h"
+#include "string.h"
+#include "syscall.h"
+#include "syscall_nums.h"
+
+/* The allocator of eapps built on libkeystone-eapp.
+ *
+ * The heap is carved from the zone the linker script starts at
+ * __malloc_start, growing up towards the stack, in runs of whole pages.
+ * Each run starts with a page header, and the header of the run before it
+ * is found through its length, so freed runs merge with both neighbours
+ * in O(1), and a free run at the top goes back to the zone.
+ *
+ * - Small objects (up to MALLOC_SMALL_MAX) come from one-page slabs of a
+ *   single size class. A slab keeps its free objects in a list, and
+ *   free() finds the slab from the address alone, so both are O(1).
+ * - Larger allocations are runs of their own. From the mmap threshold up
+ *   (M_MMAP_THRESHOLD), they are mapped with Eyrie's mmap and unmapped
+ *   when freed, so big buffers do not pin the zone; without the
+ *   linux_syscall plugin the zone serves them too.
+ *
+ * The header of the run holding a pointer is at the start of its page,
+ * or a page before it if the pointer is page-aligned (no small object or
+ * ordinary run starts there).
+ *
+ * Eapps are single threaded. The slab lists are kept per heap and each
+ * slab records its heap, so per-thread heaps only need current_heap() to
+ * return the thread's own (and a lock around the page runs). */
+
+#define MALLOC_PAGE 4096
+#define MALLOC_HEADER 64  // keeps the objects 16-byte aligned
+#define MALLOC_SMALL_MAX 2016
+#define MALLOC_CLASSES 23
+
+/* This is the minimum gap allowed between the end of the heap and the
+   top of the stack. If the stack grows into the heap instead, silent data
+   corruption will result. */
+#define MALLOC_MINIMUM_GAP 32
+#define MALLOC_LIMIT __builtin_frame_address(0)
+
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define MAP_PRIVATE 0x02
+#define MAP_ANONYMOUS 0x20
+
+enum page_kind {
+  // 0 to MALLOC_CLASSES - 1: a slab of that class
+  PAGE_FREE = 0xff0,  // a free run
+  PAGE_RUN,           // one allocation in the zone
+  PAGE_MMAP,          // one allocation mapped on its own
+};
+
+struct malloc_heap;
+
+struct page {
+  uint16_t kind;
+  uint16_t capacity;  // slab: objects it holds
+  uint32_t used;      // slab: objects handed out
+  size_t pages;       // length of the run (1 for a slab)
+  size_t prev_pages;  // zone: length of the run before, 0 for the first
+  void* free;         // slab: freed objects
+  char* fresh;        // slab: the first object never handed out
+  struct malloc_heap* heap;  // slab: the heap whose lists it is on
+  struct page* next;  // slab: partial list; free run: free list
+  struct page* prev;
+};
+
+_Static_assert(sizeof(struct page) <= MALLOC_HEADER, "page header too big");
+
+struct malloc_heap {
+  struct page* partial[MALLOC_CLASSES];  // slabs with free objects
+};
+
+/* Steps of 16 bytes, then of an eighth to a fifth, sized from 288 bytes on
+ * so a whole number of objects fills the page after the header */
+static const uint16_t class_size[MALLOC_CLASSES] = {
+    16,  32,  48,  64,  80,  96,  112, 128, 160, 192,  224,  256,
+    288, 336, 400, 448, 496, 576, 672, 800, 1008, 1344, 2016};
+static uint8_t class_of[MALLOC_SMALL_MAX / 16 + 1];  // by (size + 15) / 16
+
+static struct malloc_heap main_heap;
+
+extern char* __malloc_start;
+static char* zone_start;
+static char* zone_end;
+static struct page* zone_last;  // the top run
+static struct page* free_runs;
+static size_t mmap_threshold = 64 * 1024;
+static int mmap_failed;  // Eyrie refused an mmap, see mmap_pages()
+
+static struct {
+  size_t in_use;     // usable bytes handed out
+  size_t slabs;
+  size_t slab_free;  // bytes of the free objects in slabs
+  size_t free_runs;
+  size_t free_run_bytes;
+  size_t mapped;
+  size_t mapped_bytes;
+  size_t peak;  // most bytes of zone and mappings at once
+} stats;
+
+static struct malloc_heap*
+current_heap(void) {
+  return &main_heap;
+}
+
+static void
+init(void) {
+  int c = 0;
+  size_t i;
+
+  zone_start = zone_end =
+      (char*)(((uintptr_t)&__malloc_start + MALLOC_PAGE - 1) &
+              ~(uintptr_t)(MALLOC_PAGE - 1));
+  for (i = 0; i < sizeof(class_of); i++) {
+    while (class_size[c] < i * 16) c++;
+    class_of[i] = c;
+  }
+}
+
+static void
+update_peak(void) {
+  size_t footprint = (zone_end - zone_start) + stats.mapped_bytes;
+  if (footprint > stats.peak) stats.peak = footprint;
+}
+
+static void
+list_push(struct page** head, struct page* p) {
+  p->prev = NULL;
+  p->next = *head;
+  if (*head) (*head)->prev = p;
+  *head = p;
+}
+
+static void
+list_remove(struct page** head, struct page* p) {
+  if (p->prev)
+    p->prev->next = p->next;
+  else
+    *head = p->next;
+  if (p->next) p->next->prev = p->prev;
+  p->next = p->prev = NULL;
+}
+
+static struct page*
+page_of(void* ptr) {
+  uintptr_t addr = (uintptr_t)ptr;
+  if ((addr & (MALLOC_PAGE - 1)) == 0)
+    return (struct page*)(addr - MALLOC_PAGE);
+  return (struct page*)(addr & ~(uintptr_t)(MALLOC_PAGE - 1));
+}
+
+/* The run after r in the zone, or NULL at the top */
+static struct page*
+next_run(struct page* r) {
+  char* next = (char*)r + r->pages * MALLOC_PAGE;
+  return next < zone_end ? (struct page*)next : NULL;
+}
+
+static struct page*
+prev_run(struct page* r) {
+  if (!r->prev_pages) return NULL;
+  return (struct page*)((char*)r - r->prev_pages * MALLOC_PAGE);
+}
+
+/* Sets the length of r, which the next run (or the top) depends on */
+static void
+set_pages(struct page* r, size_t pages) {
+  struct page* next;
+
+  r->pages = pages;
+  next     = next_run(r);
+  if (next)
+    next->prev_pages = pages;
+  else
+    zone_last = r;
+}
+
+static void
+free_list_push(struct page* r) {
+  r->kind = PAGE_FREE;
+  list_push(&free_runs, r);
+  stats.free_runs++;
+  stats.free_run_bytes += r->pages * MALLOC_PAGE;
+}
+
+static void
+free_list_remove(struct page* r) {
+  list_remove(&free_runs, r);
+  stats.free_runs--;
+  stats.free_run_bytes -= r->pages * MALLOC_PAGE;
+}
+
+/* Cuts r after pages pages and returns the rest, as a PAGE_RUN */
+static struct page*
+split(struct page* r, size_t pages) {
+  struct page* rest = (struct page*)((char*)r + pages * MALLOC_PAGE);
+  size_t total      = r->pages;
+
+  r->pages         = pages;
+  rest->kind       = PAGE_RUN;
+  rest->prev_pages = pages;
+  set_pages(rest, total - pages);
+  return rest;
+}
+
+static void
+release_run(struct page* r) {
+  struct page* next = next_run(r);
+  struct page* prev = prev_run(r);
+
+  if (next && next->kind == PAGE_FREE) {
+    free_list_remove(next);
+    set_pages(r, r->pages + next->pages);
+  }
+  if (prev && prev->kind == PAGE_FREE) {
+    free_list_remove(prev);
+    set_pages(prev, prev->pages + r->pages);
+    r = prev;
+  }
+
+  if ((char*)r + r->pages * MALLOC_PAGE == zone_end) {
+    // the top of the zone: the next run to grow takes it
+    zone_end  = (char*)r;
+    zone_last = prev_run(r);
+  } else {
+    free_list_push(r);
+  }
+}
+
+static int
+zone_can_grow(size_t bytes) {
+  size_t limit = (size_t)MALLOC_LIMIT;
+  return limit >= (size_t)zone_end + MALLOC_MINIMUM_GAP &&
+         limit - (size_t)zone_end - MALLOC_MINIMUM_GAP >= bytes;
+}
+
+/* A run of pages from the free runs (the lowest that fits, which keeps
+ * the zone compact), or from the top */
+static struct page*
+alloc_run(size_t pages) {
+  struct page *r, *lowest = NULL;
+
+  for (r = free_runs; r; r = r->next)
+    if (r->pages >= pages && (!lowest || r < lowest)) lowest = r;
+  if (lowest) {
+    free_list_remove(lowest);
+    lowest->kind = PAGE_RUN;
+    if (lowest->pages > pages) free_list_push(split(lowest, pages));
+    return lowest;
+  }
+
+  if (pages > SIZE_MAX / MALLOC_PAGE || !zone_can_grow(pages * MALLOC_PAGE))
+    return NULL;
+  r             = (struct page*)zone_end;
+  r->kind       = PAGE_RUN;
+  r->prev_pages = zone_last ? zone_last->pages : 0;
+  zone_end += pages * MALLOC_PAGE;
+  set_pages(r, pages);
+  update_peak();
+  return r;
+}
+
+/* Grows or shrinks a PAGE_RUN in place; 0 if it could not grow */
+static int
+resize_run(struct page* r, size_t pages) {
+  struct page* next;
+
+  if (pages < r->pages) {
+    release_run(split(r, pages));
+    return 1;
+  }
+  if (pages == r->pages) return 1;
+
+  next = next_run(r);
+  if (!next) {
+    size_t more = (pages - r->pages) * MALLOC_PAGE;
+    if (!zone_can_grow(more)) return 0;
+    zone_end += more;
+    set_pages(r, pages);
+    update_peak();
+    return 1;
+  }
+  if (next->kind == PAGE_FREE && r->pages + next->pages >= pages) {
+    free_list_remove(next);
+    set_pages(r, r->pages + next->pages);
+    if (r->pages > pages) release_run(split(r, pages));
+    return 1;
+  }
+  return 0;
+}
+
+static void*
+malloc_small(int cls) {
+  struct malloc_heap* heap = current_heap();
+  struct page* slab        = heap->partial[cls];
+  void* obj;
+
+  if (!slab) {
+    slab = alloc_run(1);
+    if (!slab) return NULL;
+    slab->kind     = cls;
+    slab->capacity = (MALLOC_PAGE - MALLOC_HEADER) / class_size[cls];
+    slab->used     = 0;
+    slab->free     = NULL;
+    slab->fresh    = (char*)slab + MALLOC_HEADER;
+    slab->heap     = heap;
+    list_push(&heap->partial[cls], slab);
+    stats.slabs++;
+    stats.slab_free += slab->capacity * class_size[cls];
+  }
+
+  if (slab->free) {
+    obj        = slab->free;
+    slab->free = *(void**)obj;
+  } else {
+    obj = slab->fresh;
+    slab->fresh += class_size[cls];
+  }
+  if (++slab->used == slab->capacity) list_remove(&heap->partial[cls], slab);
+
+  stats.in_use += class_size[cls];
+  stats.slab_free -= class_size[cls];
+  return obj;
+}
+
+static void
+free_small(struct page* slab, void* obj) {
+  struct page** partial = &slab->heap->partial[slab->kind];
+
+  *(void**)obj = slab->free;
+  slab->free   = obj;
+  if (slab->used-- == slab->capacity) list_push(partial, slab);
+  stats.in_use -= class_size[slab->kind];
+  stats.slab_free += class_size[slab->kind];
+
+  /* an empty slab goes back at once: kept, it would pin a page wherever
+   * the zone grew to */
+  if (slab->used == 0) {
+    list_remove(partial, slab);
+    stats.slabs--;
+    stats.slab_free -= slab->capacity * class_size[slab->kind];
+    release_run(slab);
+  }
+}
+
+/* Eyrie returns -1 both on failure and when it has no mmap at all (no
+ * linux_syscall plugin). The two look the same, so after the first
+ * failure large blocks come from the zone instead of trapping into the
+ * runtime for an mmap that fails every time. */
+static void*
+mmap_pages(size_t pages) {
+  uintptr_t addr;
+
+  if (mmap_failed) return NULL;
+  addr = SYSCALL_5(
+      SYS_mmap, 0, pages * MALLOC_PAGE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1);
+  if (addr == 0 || addr >= (uintptr_t)-MALLOC_PAGE) {
+    mmap_failed = 1;
+    return NULL;
+  }
+  return (void*)addr;
+}
+
+/* size bytes aligned to align (a power of two), in a run of their own */
+static void*
+malloc_large(size_t size, size_t align) {
+  size_t offset = align <= MALLOC_HEADER ? MALLOC_HEADER : align;
+  size_t pages;
+  struct page* r;
+  char* ptr;
+
+  if (size > SIZE_MAX - 2 * MALLOC_PAGE - offset) return NULL;
+
+  if (align < MALLOC_PAGE) {
+    pages = (offset + size + MALLOC_PAGE - 1) / MALLOC_PAGE;
+    if (size >= mmap_threshold && (r = mmap_pages(pages))) {
+      r->kind       = PAGE_MMAP;
+      r->pages      = pages;
+      r->prev_pages = 0;
+      stats.mapped++;
+      stats.mapped_bytes += pages * MALLOC_PAGE;
+      update_peak();
+    } else if (!(r = alloc_run(pages))) {
+      return NULL;
+    }
+    stats.in_use += (char*)r + r->pages * MALLOC_PAGE - ((char*)r + offset);
+    return (char*)r + offset;
+  }
+
+  /* page-aligned: the header takes the page before the pointer, and the
+   * pages in front of it are cut off again */
+  pages = (align + size + MALLOC_PAGE - 1) / MALLOC_PAGE;
+  if (!(r = alloc_run(pages))) return NULL;
+  ptr = (char*)(((uintptr_t)r + MALLOC_PAGE + align - 1) & ~(uintptr_t)(align - 1));
+  if (ptr - MALLOC_PAGE > (char*)r) {
+    struct page* head = r;
+    r = split(head, (ptr - MALLOC_PAGE - (char*)head) / MALLOC_PAGE);
+    release_run(head);
+  }
+  resize_run(r, (MALLOC_PAGE + size + MALLOC_PAGE - 1) / MALLOC_PAGE);
+  stats.in_use += (char*)r + r->pages * MALLOC_PAGE - ptr;
+  return ptr;
+}
+
+void*
+malloc(size_t size) {
+  if (!zone_start) init();
+  if (size <= MALLOC_SMALL_MAX) return malloc_small(class_of[(size + 15) / 16]);
+  return malloc_large(size, 1);
+}
+
+size_t
+malloc_usable_size(void* ptr) {
+  struct page* r;
+
+  if (!ptr) return 0;
+  r = page_of(ptr);
+  if (r->kind < MALLOC_CLASSES) return class_size[r->kind];
+  return (char*)r + r->pages * MALLOC_PAGE - (char*)ptr;
+}
+
+void
+free(void* ptr) {
+  struct page* r;
+
+  if (!ptr) return;
+  r = page_of(ptr);
+  if (r->kind < MALLOC_CLASSES) {
+    free_small(r, ptr);
+    return;
+  }
+
+  stats.in_use -= malloc_usable_size(ptr);
+  if (r->kind == PAGE_MMAP) {
+    stats.mapped--;
+    stats.mapped_bytes -= r->pages * MALLOC_PAGE;
+    SYSCALL_2(SYS_munmap, r, r->pages * MALLOC_PAGE);
+  } else if (r->kind == PAGE_RUN) {
+    release_run(r);
+  }
+}
+
+void
+cfree(void* ptr) {
+  free(ptr);
+}
+
+void*
+realloc(void* ptr, size_t size) {
+  size_t usable;
+  struct page* r;
+  void* result;
+
+  if (!ptr) return malloc(size);
+
+  usable = malloc_usable_size(ptr);
+  r      = page_of(ptr);
+  if (r->kind == PAGE_RUN && size > MALLOC_SMALL_MAX) {
+    // grow into the next run or the top, or give pages back
+    size_t offset = (char*)ptr - (char*)r;
+    if (size <= SIZE_MAX - offset - MALLOC_PAGE &&
+        resize_run(r, (offset + size + MALLOC_PAGE - 1) / MALLOC_PAGE)) {
+      stats.in_use += malloc_usable_size(ptr) - usable;
+      return ptr;
+    }
+  } else if (size <= usable && (r->kind >= MALLOC_CLASSES || size > usable / 2)) {
+    return ptr;
+  }
+
+  result = malloc(size);
+  if (!result) return NULL;
+  memcpy(result, ptr, usable < size ? usable : size);
+  free(ptr);
+  return result;
+}
+
+void*
+calloc(size_t n, size_t elem_size) {
+  void* result;
+  size_t size;
+
+  if (elem_size && n > SIZE_MAX / elem_size) return NULL;
+  size   = n * elem_size;
+  result = malloc(size);
+  if (result) memset(result, 0, size);
+  return result;
+}
+
+void*
+memalign(size_t align, size_t size) {
+  int cls;
+
+  if (align == 0 || (align & (align - 1)) != 0) return NULL;
+  if (!zone_start) init();
+  if (align <= 16) return malloc(size);
+
+  // objects of a class that is a multiple of align are aligned to it
+  if (align <= MALLOC_HEADER && size <= MALLOC_SMALL_MAX) {
+    for (cls = class_of[(size + 15) / 16]; cls < MALLOC_CLASSES; cls++)
+      if (class_size[cls] % align == 0) return malloc_small(cls);
+  }
+  return malloc_large(size, align);
+}
+
+void*
+valloc(size_t size) {
+  return memalign(MALLOC_PAGE, size);
+}
+
+void*
+pvalloc(size_t size) {
+  return memalign(MALLOC_PAGE, (size + MALLOC_PAGE - 1) & ~(size_t)(MALLOC_PAGE - 1));
+}
+
+int
+malloc_trim(size_t pad) {
+  (void)pad;
+  // free runs at the top already went back to the zone
+  return 0;
+}
+
+int
+mallopt(int param, int value) {
+  if (param == M_MMAP_THRESHOLD && value > MALLOC_SMALL_MAX) {
+    mmap_threshold = value;
+    return 1;
+  }
+  return 0;
+}
+
+struct mallinfo
+mallinfo(void) {
+  struct mallinfo info;
+
+  memset(&info, 0, sizeof(info));
+  info.arena    = zone_end - zone_start;
+  info.ordblks  = stats.free_runs;
+  info.smblks   = stats.slabs;
+  info.hblks    = stats.mapped;
+  info.hblkhd   = stats.mapped_bytes;
+  info.usmblks  = stats.peak;
+  info.fsmblks  = stats.slab_free;
+  info.uordblks = stats.in_use;
+  info.fordblks = stats.free_run_bytes + stats.slab_free;
+  info.keepcost = 0;
+  return info;
+}
@@ -0,0 +1,458 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <string.h>
+#include "common/chacha20poly1305.h"
+#include "common/hkdf_sha3_512.h"
+#include "common/hmac_sha3.h"
+#include "malloc.h"
+#include "sealed_storage.h"
+#include "syscall.h"
+#include "syscall_nums.h"
+
+#define SEEK_END 2
+
+static const char sealed_magic[8] = {'K', 'S', 'S', 'E', 'A', 'L', '0', '1'};
+static const char sealed_salt[]   = "keystone sealed storage";
+static const char sealed_info[]   = "keystone sealed object";
+
+// Sealed bytes per full chunk
+static size_t
+chunk_stride(const struct sealed_object* obj) {
+  return obj->header.chunk_size + SEALED_TAG_SIZE;
+}
+
+static void
+chunk_nonce(uint64_t index, int last, uint8_t nonce[12]) {
+  int i;
+  for (i = 0; i < 8; i++) nonce[i] = index >> (8 * i);
+  nonce[8]  = last ? 1 : 0;
+  nonce[9]  = 0;
+  nonce[10] = 0;
+  nonce[11] = 0;
+}
+
+// The object key: the sealed key expanded with the id
+static void
+object_key(
+    struct sealed_object* obj, const struct sealed_key* key) {
+  uint8_t info[sizeof(sealed_info) - 1 + SEALED_ID_SIZE];
+
+  memcpy(info, sealed_info, sizeof(sealed_info) - 1);
+  memcpy(info + sizeof(sealed_info) - 1, obj->header.id, SEALED_ID_SIZE);
+  hkdf_expand(
+      key->prk, sizeof(key->prk), info, sizeof(info), obj->key,
+      sizeof(obj->key));
+}
+
+static int
+open_header(
+    struct sealed_object* obj, const struct sealed_key* key,
+    const void* header) {
+  static const uint8_t zeros[16];
+
+  memcpy(&obj->header, header, sizeof(obj->header));
+  if (memcmp(obj->header.magic, sealed_magic, sizeof(sealed_magic)) != 0 ||
+      obj->header.chunk_size == 0 ||
+      obj->header.chunk_size > SEALED_CHUNK_MAX || obj->header.flags != 0 ||
+      memcmp(obj->header.reserved, zeros, sizeof(zeros)) != 0)
+    return -1;
+
+  object_key(obj, key);
+  obj->chunks = 0;
+  obj->size   = 0;
+  return 0;
+}
+
+static int
+open_chunk(
+    const struct sealed_object* obj, uint64_t index, int last,
+    const uint8_t* in, size_t len, uint8_t* out) {
+  uint8_t nonce[12];
+
+  chunk_nonce(index, last, nonce);
+  return chacha20poly1305_decrypt(
+      obj->key, nonce, (const uint8_t*)&obj->header, sizeof(obj->header), in,
+      len, in + len, out);
+}
+
+int
+sealed_key_init(
+    struct sealed_key* key, const void* key_ident, size_t ident_size) {
+  struct sealing_key sealing_key;
+
+  if (get_sealing_key(
+          &sealing_key, sizeof(sealing_key), (void*)key_ident, ident_size) != 0)
+    return -1;
+
+  hkdf_extract(
+      (const unsigned char*)sealed_salt, sizeof(sealed_salt) - 1,
+      sealing_key.key, sizeof(sealing_key.key), key->prk);
+  memset(&sealing_key, 0, sizeof(sealing_key));
+  return 0;
+}
+
+void
+sealed_key_clear(struct sealed_key* key) {
+  memset(key, 0, sizeof(*key));
+}
+
+uint64_t
+sealed_size(uint64_t length, size_t chunk_size) {
+  uint64_t chunks = length ? (length + chunk_size - 1) / chunk_size : 1;
+  return SEALED_HEADER_SIZE + length + chunks * SEALED_TAG_SIZE;
+}
+
+int
+sealed_create(
+    struct sealed_object* obj, const struct sealed_key* key,
+    size_t chunk_size) {
+  if (chunk_size == 0 || chunk_size > SEALED_CHUNK_MAX) return -1;
+
+  memset(&obj->header, 0, sizeof(obj->header));
+  memcpy(obj->header.magic, sealed_magic, sizeof(sealed_magic));
+  obj->header.chunk_size = chunk_size;
+  if (SYSCALL_3(SYS_getrandom, obj->header.id, SEALED_ID_SIZE, 0) !=
+      SEALED_ID_SIZE)
+    return -1;
+
+  object_key(obj, key);
+  obj->chunks = 0;
+  obj->size   = 0;
+  return 0;
+}
+
+int
+sealed_open(
+    struct sealed_object* obj, const struct sealed_key* key,
+    const void* header, uint64_t size) {
+  uint64_t body, rest;
+
+  if (size < SEALED_HEADER_SIZE + SEALED_TAG_SIZE ||
+      open_header(obj, key, header) != 0)
+    return -1;
+
+  // every chunk but the last is full, and the last has its tag at least
+  body        = size - SEALED_HEADER_SIZE;
+  obj->chunks = body / chunk_stride(obj);
+  rest        = body % chunk_stride(obj);
+  if (rest) {
+    if (rest < SEALED_TAG_SIZE) {
+      sealed_close(obj);
+      return -1;
+    }
+    obj->chunks++;
+  }
+  obj->size = size;
+  return 0;
+}
+
+void
+sealed_close(struct sealed_object* obj) {
+  memset(obj, 0, sizeof(*obj));
+}
+
+uint64_t
+sealed_chunk_offset(const struct sealed_object* obj, uint64_t index) {
+  return SEALED_HEADER_SIZE + index * chunk_stride(obj);
+}
+
+uint64_t
+sealed_length(const struct sealed_object* obj) {
+  return obj->size - SEALED_HEADER_SIZE - obj->chunks * SEALED_TAG_SIZE;
+}
+
+void
+sealed_seal_chunk(
+    const struct sealed_object* obj, uint64_t index, int last, const void* in,
+    size_t len, void* out) {
+  uint8_t nonce[12];
+
+  chunk_nonce(index, last, nonce);
+  chacha20poly1305_encrypt(
+      obj->key, nonce, (const uint8_t*)&obj->header, sizeof(obj->header),
+      (const uint8_t*)in, len, (uint8_t*)out, (uint8_t*)out + len);
+}
+
+ssize_t
+sealed_open_chunk(
+    const struct sealed_object* obj, uint64_t index, const void* in,
+    size_t in_len, void* out) {
+  int last = index + 1 == obj->chunks;
+  size_t len;
+
+  if (index >= obj->chunks) return -1;
+  len = last ? obj->size - sealed_chunk_offset(obj, index) - SEALED_TAG_SIZE
+             : obj->header.chunk_size;
+  if (in_len != len + SEALED_TAG_SIZE ||
+      open_chunk(obj, index, last, (const uint8_t*)in, len, (uint8_t*)out) != 0)
+    return -1;
+  return len;
+}
+
+int
+sealed_seal(
+    const struct sealed_key* key, size_t chunk_size, const void* in,
+    size_t len, void* out) {
+  struct sealed_object obj;
+  const uint8_t* src = (const uint8_t*)in;
+  uint8_t* dst       = (uint8_t*)out;
+  uint64_t index     = 0;
+
+  if (sealed_create(&obj, key, chunk_size) != 0) return -1;
+  memcpy(dst, &obj.header, SEALED_HEADER_SIZE);
+  dst += SEALED_HEADER_SIZE;
+
+  do {
+    size_t n = len < chunk_size ? len : chunk_size;
+    sealed_seal_chunk(&obj, index++, n == len, src, n, dst);
+    src += n;
+    dst += n + SEALED_TAG_SIZE;
+    len -= n;
+  } while (len);
+
+  sealed_close(&obj);
+  return 0;
+}
+
+ssize_t
+sealed_unseal(
+    const struct sealed_key* key, const void* in, size_t in_len, void* out,
+    size_t out_len) {
+  struct sealed_object obj;
+  const uint8_t* src = (const uint8_t*)in;
+  uint8_t* dst       = (uint8_t*)out;
+  uint64_t index, length;
+
+  if (sealed_open(&obj, key, in, in_len) != 0) return -1;
+  length = sealed_length(&obj);
+  if (length > out_len) {
+    sealed_close(&obj);
+    return -1;
+  }
+
+  src += SEALED_HEADER_SIZE;
+  for (index = 0; index < obj.chunks; index++) {
+    size_t n = index + 1 == obj.chunks
+                   ? in_len - sealed_chunk_offset(&obj, index)
+                   : chunk_stride(&obj);
+    ssize_t got = sealed_open_chunk(&obj, index, src, n, dst);
+    if (got < 0) {
+      memset(out, 0, length);
+      sealed_close(&obj);
+      return -1;
+    }
+    src += n;
+    dst += got;
+  }
+
+  sealed_close(&obj);
+  return length;
+}
+
+int
+sealed_writer_open(
+    struct sealed_writer* w, const struct sealed_key* key, int fd,
+    size_t chunk_size) {
+  if (sealed_create(&w->obj, key, chunk_size) != 0) return -1;
+  w->chunk = (uint8_t*)malloc(chunk_size + SEALED_TAG_SIZE);
+  if (!w->chunk) {
+    sealed_close(&w->obj);
+    return -1;
+  }
+  if (edge_stream_open(&w->stream, fd, EDGE_STREAM_EGRESS, 0) != 0) {
+    free(w->chunk);
+    sealed_close(&w->obj);
+    return -1;
+  }
+  w->index = 0;
+  w->fill  = 0;
+  return edge_stream_write(&w->stream, &w->obj.header, SEALED_HEADER_SIZE) ==
+                 SEALED_HEADER_SIZE
+             ? 0
+             : -1;
+}
+
+static int
+write_chunk(struct sealed_writer* w, const void* data, size_t len, int last) {
+  sealed_seal_chunk(&w->obj, w->index++, last, data, len, w->chunk);
+  return edge_stream_write(&w->stream, w->chunk, len + SEALED_TAG_SIZE) ==
+                 (ssize_t)(len + SEALED_TAG_SIZE)
+             ? 0
+             : -1;
+}
+
+ssize_t
+sealed_writer_write(struct sealed_writer* w, const void* data, size_t len) {
+  size_t chunk_size  = w->obj.header.chunk_size;
+  const uint8_t* src = (const uint8_t*)data;
+  size_t done        = 0;
+
+  /* a full chunk is only sealed once more data arrives: until then it
+   * could still be the last one */
+  while (done < len) {
+    size_t n;
+
+    if (w->fill == chunk_size) {
+      if (write_chunk(w, w->chunk, chunk_size, 0) != 0) return -1;
+      w->fill = 0;
+    }
+    if (w->fill == 0 && len - done > chunk_size) {
+      // whole chunks are sealed straight from the caller's buffer
+      if (write_chunk(w, src + done, chunk_size, 0) != 0) return -1;
+      done += chunk_size;
+      continue;
+    }
+
+    n = chunk_size - w->fill < len - done ? chunk_size - w->fill : len - done;
+    memcpy(w->chunk + w->fill, src + done, n);
+    w->fill += n;
+    done += n;
+  }
+  return done;
+}
+
+int
+sealed_writer_close(struct sealed_writer* w) {
+  int ret = write_chunk(w, w->chunk, w->fill, 1);
+
+  if (edge_stream_close(&w->stream) != 0) ret = -1;
+  free(w->chunk);
+  sealed_close(&w->obj);
+  return ret;
+}
+
+int
+sealed_reader_open(
+    struct sealed_reader* r, const struct sealed_key* key, int fd) {
+  uint8_t header[SEALED_HEADER_SIZE];
+
+  if (edge_stream_open(&r->stream, fd, EDGE_STREAM_INGEST, 0) != 0) return -1;
+  if (edge_stream_read(&r->stream, header, sizeof(header)) != sizeof(header) ||
+      open_header(&r->obj, key, header) != 0) {
+    edge_stream_close(&r->stream);
+    return -1;
+  }
+
+  r->chunk = (uint8_t*)malloc(chunk_stride(&r->obj));
+  if (!r->chunk) {
+    edge_stream_close(&r->stream);
+    sealed_close(&r->obj);
+    return -1;
+  }
+  r->index  = 0;
+  r->pos    = 0;
+  r->len    = 0;
+  r->peeked = 0;
+  r->end    = 0;
+  return 0;
+}
+
+/* Reads and opens the next chunk, into dst if it is given, else into
+ * r->chunk. Only the end of the stream tells whether a full chunk is the
+ * last one, so the byte after it is read ahead. */
+static ssize_t
+next_chunk(struct sealed_reader* r, uint8_t* dst) {
+  size_t stride = chunk_stride(&r->obj);
+  size_t got    = 0;
+  ssize_t n;
+  int last;
+
+  if (r->peeked) {
+    r->chunk[got++] = r->peek;
+    r->peeked       = 0;
+  }
+  n = edge_stream_read(&r->stream, r->chunk + got, stride - got);
+  if (n < 0) return -1;
+  got += n;
+
+  last = got < stride;
+  if (!last) {
+    n = edge_stream_read(&r->stream, &r->peek, 1);
+    if (n < 0) return -1;
+    last      = n == 0;
+    r->peeked = n == 1;
+  }
+
+  if (got < SEALED_TAG_SIZE ||
+      open_chunk(
+          &r->obj, r->index, last, r->chunk, got - SEALED_TAG_SIZE,
+          dst ? dst : r->chunk) != 0)
+    return -1;
+
+  r->index++;
+  r->end = last;
+  return got - SEALED_TAG_SIZE;
+}
+
+ssize_t
+sealed_reader_read(struct sealed_reader* r, void* buf, size_t len) {
+  uint8_t* dst = (uint8_t*)buf;
+  size_t done  = 0;
+
+  while (done < len) {
+    ssize_t n;
+
+    if (r->pos < r->len) {
+      size_t copy = r->len - r->pos < len - done ? r->len - r->pos : len - done;
+      memcpy(dst + done, r->chunk + r->pos, copy);
+      r->pos += copy;
+      done += copy;
+      continue;
+    }
+    if (r->end) break;
+
+    // chunks that fit are opened straight into the caller's buffer
+    if (len - done >= r->obj.header.chunk_size) {
+      n = next_chunk(r, dst + done);
+      if (n < 0) return -1;
+      done += n;
+    } else {
+      n = next_chunk(r, NULL);
+      if (n < 0) return -1;
+      r->pos = 0;
+      r->len = n;
+    }
+  }
+  return done;
+}
+
+int
+sealed_reader_close(struct sealed_reader* r) {
+  int ret = edge_stream_close(&r->stream);
+
+  memset(r->chunk, 0, chunk_stride(&r->obj));
+  free(r->chunk);
+  sealed_close(&r->obj);
+  return ret;
+}
+
+int
+sealed_open_file(
+    struct sealed_object* obj, const struct sealed_key* key, int fd) {
+  uint8_t header[SEALED_HEADER_SIZE];
+  intptr_t size = SYSCALL_3(SYS_lseek, fd, 0, SEEK_END);
+
+  if (size < 0 ||
+      (intptr_t)SYSCALL_4(SYS_pread64, fd, header, sizeof(header), 0) !=
+          sizeof(header))
+    return -1;
+  return sealed_open(obj, key, header, size);
+}
+
+ssize_t
+sealed_read_chunk(
+    const struct sealed_object* obj, int fd, uint64_t index, void* out) {
+  size_t len;
+
+  if (index >= obj->chunks) return -1;
+  len = index + 1 == obj->chunks
+            ? obj->size - sealed_chunk_offset(obj, index)
+            : chunk_stride(obj);
+  if ((intptr_t)SYSCALL_4(
+          SYS_pread64, fd, out, len, sealed_chunk_offset(obj, index)) !=
+      (intptr_t)len)
+    return -1;
+  return sealed_open_chunk(obj, index, out, len, out);
+}
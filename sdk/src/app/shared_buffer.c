@@ -0,0 +1,48 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "shared_buffer.h"
+#include "edge_shared.h"
+#include "syscall.h"
+#include "syscall_nums.h"
+
+void*
+shared_buffer_alloc(size_t size) {
+  return edge_shared_reserve(size);
+}
+
+int
+shared_buffer_free(void* buf, size_t size) {
+  return edge_shared_release(buf, size);
+}
+
+ssize_t
+recv_into_shared(int fd, void* buf, size_t len, int flags) {
+  return shared_io(SYS_recvfrom, fd, buf, len, flags);
+}
+
+ssize_t
+read_into_shared(int fd, void* buf, size_t len) {
+  return shared_io(SYS_read, fd, buf, len, 0);
+}
+
+ssize_t
+send_from_shared(int fd, const void* buf, size_t len, int flags) {
+  return shared_io(SYS_sendto, fd, (void*)buf, len, flags);
+}
+
+ssize_t
+write_from_shared(int fd, const void* buf, size_t len) {
+  return shared_io(SYS_write, fd, (void*)buf, len, 0);
+}
+
+int
+shared_buffer_import(void* dst, const void* src, size_t len) {
+  edge_data_offset offset;
+
+  if (edge_shared_offset(src, len, &offset) != 0) return -1;
+
+  /* the runtime does the copy, see handle_copy_from_shared */
+  return copy_from_shared(dst, offset, len) ? -1 : 0;
+}
@@ -0,0 +1,220 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifdef KEYSTONE_SIM
+#include <setjmp.h>
+#include <string.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "edge_common.h"
+#include "edge_syscall.h"
+#include "eapp_utils.h"
+#include "shared/keystone_sim.h"
+#include "syscall.h"
+#include "syscall_nums.h"
+
+/* Host-side stand-in for Eyrie, see shared/keystone_sim.h. The calls below
+ * follow runtime/call/syscall.c, minus the copies in and out of enclave
+ * memory, which the simulation does not have. */
+
+static struct keystone_sim_ctx* sim;
+static jmp_buf sim_exit;
+static uintptr_t sim_retval;
+static size_t sim_pinned;
+
+uintptr_t
+keystone_sim_run(
+    struct keystone_sim_ctx* ctx, int (*entry)(int, char**), int argc,
+    char** argv) {
+  sim        = ctx;
+  sim_pinned = 0;
+  if (setjmp(sim_exit) == 0) sim_retval = entry(argc, argv);
+  return sim_retval;
+}
+
+static void __attribute__((noreturn))
+sim_exit_enclave(uintptr_t retval) {
+  sim_retval = retval;
+  longjmp(sim_exit, 1);
+}
+
+void
+EAPP_RETURN(unsigned long rval) {
+  sim_exit_enclave(rval);
+}
+
+/* hands the call set up at the start of the buffer to the host */
+static int
+sim_stop(void) {
+  struct edge_call* edge_call = (struct edge_call*)sim->shared_buffer;
+
+  if (sim->stop(sim->device) != 0) sim_exit_enclave(-1);
+  return edge_call->return_data.call_status == CALL_STATUS_OK ? 0 : -1;
+}
+
+static int
+sim_setup_call(unsigned long call_id, uintptr_t args, size_t args_len) {
+  struct edge_call* edge_call = (struct edge_call*)sim->shared_buffer;
+  uintptr_t base              = (uintptr_t)sim->shared_buffer;
+
+  if (args < base + sizeof(struct edge_call) ||
+      args > base + sim->shared_size - sim_pinned ||
+      args_len > base + sim->shared_size - sim_pinned - args)
+    return -1;
+
+  edge_call->call_id         = call_id;
+  edge_call->call_arg_offset = args - base;
+  edge_call->call_arg_size   = args_len;
+  return 0;
+}
+
+static uintptr_t
+sim_ocall(
+    unsigned long call_id, void* data, size_t data_len, void* return_buffer,
+    size_t return_len) {
+  struct edge_call* edge_call = (struct edge_call*)sim->shared_buffer;
+  uintptr_t args = (uintptr_t)sim->shared_buffer + sizeof(struct edge_call);
+  size_t ret_len;
+
+  if (sim_setup_call(call_id, args, data_len) != 0) return 1;
+  memcpy((void*)args, data, data_len);
+
+  if (sim_stop() != 0) return 1;
+  if (return_len == 0) return 0;
+
+  ret_len = edge_call->return_data.call_ret_size;
+  if (edge_call->return_data.call_ret_offset > sim->shared_size ||
+      ret_len > sim->shared_size - edge_call->return_data.call_ret_offset)
+    return 1;
+
+  memcpy(
+      return_buffer,
+      (char*)sim->shared_buffer + edge_call->return_data.call_ret_offset,
+      ret_len > return_len ? return_len : ret_len);
+  return 0;
+}
+
+static uintptr_t
+sim_shared_io(unsigned long op, int fd, void* buf, size_t len, int flags) {
+  uintptr_t pinned = (uintptr_t)sim->shared_buffer + sim->shared_size - sim_pinned;
+
+  if ((uintptr_t)buf < pinned || len > sim_pinned ||
+      (uintptr_t)buf - pinned > sim_pinned - len)
+    return -1;
+
+  switch (op) {
+    case SYS_read:
+      return read(fd, buf, len);
+    case SYS_write:
+      return write(fd, buf, len);
+    case SYS_recvfrom:
+      return recv(fd, buf, len, flags);
+    case SYS_sendto:
+      return send(fd, buf, len, flags);
+  }
+  return -1;
+}
+
+/* Streams go to the host as an edge syscall, as in the runtime */
+static uintptr_t
+sim_stream(unsigned long op, int fd, void* ring, size_t half_size, int arg) {
+  struct edge_call* edge_call = (struct edge_call*)sim->shared_buffer;
+  uintptr_t base              = (uintptr_t)sim->shared_buffer;
+  uintptr_t pinned            = base + sim->shared_size - sim_pinned;
+  uintptr_t data              = base + sizeof(struct edge_call);
+  struct edge_syscall* edge_syscall = (struct edge_syscall*)data;
+  sargs_STREAM* args                = (sargs_STREAM*)edge_syscall->data;
+  size_t ret_offset;
+
+  if (half_size > sim_pinned || (uintptr_t)ring < pinned ||
+      EDGE_STREAM_RING_SIZE(half_size) > sim_pinned ||
+      (uintptr_t)ring - pinned > sim_pinned - EDGE_STREAM_RING_SIZE(half_size))
+    return -1;
+
+  edge_syscall->syscall_num = EDGE_SYSCALL_STREAM;
+  args->op                  = op;
+  args->fd                  = fd;
+  args->arg                 = arg;
+  args->offset              = (uintptr_t)ring - base;
+  args->half_size           = half_size;
+  if (sim_setup_call(
+          EDGECALL_SYSCALL, data,
+          sizeof(struct edge_syscall) + sizeof(sargs_STREAM)) != 0 ||
+      sim_stop() != 0)
+    return -1;
+
+  ret_offset = edge_call->return_data.call_ret_offset;
+  if (edge_call->return_data.call_ret_size < sizeof(int64_t) ||
+      ret_offset > sim->shared_size - sizeof(int64_t))
+    return -1;
+  return *(int64_t*)(base + ret_offset);
+}
+
+/* A fixed key so that sealing code paths run; it is not secret */
+static uintptr_t
+sim_sealing_key(
+    struct sealing_key* key, size_t key_size, const unsigned char* ident,
+    size_t ident_size) {
+  size_t i;
+
+  if (key_size != sizeof(struct sealing_key)) return -1;
+
+  memset(key, 0, sizeof(*key));
+  for (i = 0; i < SEALING_KEY_SIZE; i++)
+    key->key[i] = (unsigned char)(0x5a ^ i ^ (ident_size ? ident[i % ident_size] : 0));
+  return 0;
+}
+
+uintptr_t
+keystone_sim_syscall(
+    uintptr_t which, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2,
+    uintptr_t arg3, uintptr_t arg4) {
+  switch (which) {
+    case RUNTIME_SYSCALL_EXIT:
+      sim_exit_enclave(arg0);
+    case RUNTIME_SYSCALL_OCALL:
+      return sim_ocall(arg0, (void*)arg1, arg2, (void*)arg3, arg4);
+    case RUNTIME_SYSCALL_MAP_SHARED:
+      *(size_t*)arg0 = sim->shared_size;
+      return (uintptr_t)sim->shared_buffer;
+    case RUNTIME_SYSCALL_OCALL_SHARED:
+      if (sim_setup_call(arg0, arg1, arg2) != 0) return 1;
+      return sim_stop() != 0;
+    case RUNTIME_SYSCALL_PIN_SHARED:
+      if (arg0 > sim->shared_size || sim->shared_size - arg0 < 4096) return 1;
+      sim_pinned = arg0;
+      return 0;
+    case RUNTIME_SYSCALL_SHARED_IO:
+      return sim_shared_io(arg0, (int)arg1, (void*)arg2, arg3, (int)arg4);
+    case RUNTIME_SYSCALL_STREAM:
+      return sim_stream(arg0, (int)arg1, (void*)arg2, arg3, (int)arg4);
+    case RUNTIME_SYSCALL_SHAREDCOPY:
+      if (arg1 > sim->shared_size || arg2 > sim->shared_size - arg1) return 1;
+      memcpy((void*)arg0, (char*)sim->shared_buffer + arg1, arg2);
+      return 0;
+    case RUNTIME_SYSCALL_GET_SEALING_KEY:
+      return sim_sealing_key(
+          (struct sealing_key*)arg0, arg1, (const unsigned char*)arg2, arg3);
+    /* the proxied IO that sealed storage uses, on the host's descriptors */
+    case SYS_getrandom:
+      return getrandom((void*)arg0, arg1, arg2);
+    case SYS_lseek:
+      return lseek((int)arg0, arg1, (int)arg2);
+    case SYS_pread64:
+      return pread((int)arg0, (void*)arg1, arg2, arg3);
+    case SYS_pwrite64:
+      return pwrite((int)arg0, (const void*)arg1, arg2, arg3);
+    case RUNTIME_SYSCALL_MMAP_HASHES:
+      /* mappings come from the host kernel and are not checked */
+      return 0;
+    case RUNTIME_SYSCALL_ATTEST_ENCLAVE:
+      /* there is no security monitor to sign a report */
+    default:
+      return -1;
+  }
+}
+
+#endif /* KEYSTONE_SIM */
@@ -0,0 +1,142 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <string.h>
+#include "stream.h"
+#include "shared_buffer.h"
+#include "syscall.h"
+
+static struct edge_stream_half*
+current(struct edge_stream* s) {
+  return &s->ring->half[s->half];
+}
+
+static unsigned char*
+current_data(struct edge_stream* s) {
+  return s->ring->data + s->half * s->half_size;
+}
+
+/* Waits until the host has handed the current half over */
+static int
+acquire(struct edge_stream* s, uint32_t state) {
+  while (__atomic_load_n(&current(s)->state, __ATOMIC_ACQUIRE) != state) {
+    if (stream_call(EDGE_STREAM_WAIT, s->fd, s->ring, s->half_size, s->half) != 0)
+      return -1;
+  }
+  return 0;
+}
+
+/* Hands the current half to the host and moves on to the other one */
+static void
+release(struct edge_stream* s, uint32_t state) {
+  __atomic_store_n(&current(s)->state, state, __ATOMIC_RELEASE);
+  s->half ^= 1;
+  s->pos = 0;
+}
+
+int
+edge_stream_open(struct edge_stream* s, int fd, int dir, size_t half_size) {
+  if (half_size == 0) half_size = EDGE_STREAM_DEFAULT_HALF;
+  half_size = (half_size + 7) & ~(size_t)7;
+
+  s->ring = shared_buffer_alloc(EDGE_STREAM_RING_SIZE(half_size));
+  if (!s->ring) return -1;
+
+  memset(s->ring, 0, sizeof(*s->ring));
+  s->half_size = half_size;
+  s->fd        = fd;
+  s->dir       = dir;
+  s->half      = 0;
+  s->pos       = 0;
+  s->end       = 0;
+
+  if (stream_call(EDGE_STREAM_OPEN, fd, s->ring, half_size, dir) != 0) {
+    shared_buffer_free(s->ring, EDGE_STREAM_RING_SIZE(half_size));
+    return -1;
+  }
+  return 0;
+}
+
+ssize_t
+edge_stream_read(struct edge_stream* s, void* buf, size_t len) {
+  unsigned char* dst = (unsigned char*)buf;
+  size_t done        = 0;
+
+  if (s->dir != EDGE_STREAM_INGEST) return -1;
+
+  while (done < len && !s->end) {
+    uint64_t avail;
+    int last;
+
+    if (acquire(s, EDGE_STREAM_FULL) != 0) return -1;
+
+    /* the host can still change these, so they are checked on every pass */
+    avail = current(s)->len;
+    last  = current(s)->flags & EDGE_STREAM_END;
+    if (avail > s->half_size || (last && s->ring->error)) return -1;
+
+    if (s->pos < avail) {
+      size_t n = avail - s->pos < len - done ? avail - s->pos : len - done;
+      memcpy(dst + done, current_data(s) + s->pos, n);
+      done += n;
+      s->pos += n;
+    }
+    if (s->pos >= avail) {
+      if (last)
+        s->end = 1;
+      else
+        release(s, EDGE_STREAM_EMPTY);
+    }
+  }
+  return done;
+}
+
+ssize_t
+edge_stream_write(struct edge_stream* s, const void* buf, size_t len) {
+  const unsigned char* src = (const unsigned char*)buf;
+  size_t done              = 0;
+
+  if (s->dir != EDGE_STREAM_EGRESS) return -1;
+
+  while (done < len) {
+    size_t n;
+
+    if (acquire(s, EDGE_STREAM_EMPTY) != 0 || s->ring->error) return -1;
+
+    n = s->half_size - s->pos < len - done ? s->half_size - s->pos : len - done;
+    memcpy(current_data(s) + s->pos, src + done, n);
+    done += n;
+    s->pos += n;
+
+    if (s->pos == s->half_size) {
+      current(s)->len   = s->pos;
+      current(s)->flags = 0;
+      release(s, EDGE_STREAM_FULL);
+    }
+  }
+  return done;
+}
+
+int
+edge_stream_close(struct edge_stream* s) {
+  int ret = 0;
+
+  if (s->dir == EDGE_STREAM_EGRESS) {
+    /* an empty last half still tells the host thread to finish */
+    if (acquire(s, EDGE_STREAM_EMPTY) != 0) {
+      ret = -1;
+    } else {
+      current(s)->len   = s->pos;
+      current(s)->flags = EDGE_STREAM_END;
+      release(s, EDGE_STREAM_FULL);
+    }
+  }
+
+  if (stream_call(EDGE_STREAM_CLOSE, s->fd, s->ring, s->half_size, 0) != 0)
+    ret = -1;
+  if (shared_buffer_free(s->ring, EDGE_STREAM_RING_SIZE(s->half_size)) != 0)
+    ret = -1;
+  s->ring = NULL;
+  return ret;
+}
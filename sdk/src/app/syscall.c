@@ -14,6 +14,41 @@ ocall(
       call_id, data, data_len, return_buffer, return_len);
 }
 
+uintptr_t
+map_shared(size_t* size) {
+  return SYSCALL_1(RUNTIME_SYSCALL_MAP_SHARED, size);
+}
+
+int
+ocall_shared(unsigned long call_id, void* args, size_t args_len) {
+  return SYSCALL_3(RUNTIME_SYSCALL_OCALL_SHARED, call_id, args, args_len);
+}
+
+int
+pin_shared(size_t size) {
+  return SYSCALL_1(RUNTIME_SYSCALL_PIN_SHARED, size);
+}
+
+intptr_t
+shared_io(unsigned long op, int fd, void* buf, size_t len, int flags) {
+  return SYSCALL_5(RUNTIME_SYSCALL_SHARED_IO, op, fd, buf, len, flags);
+}
+
+int
+stream_call(unsigned long op, int fd, void* ring, size_t half_size, int arg) {
+  return SYSCALL_5(RUNTIME_SYSCALL_STREAM, op, fd, ring, half_size, arg);
+}
+
+int
+mmap_hashes(void* addr, size_t length, const void* hashes) {
+  return SYSCALL_3(RUNTIME_SYSCALL_MMAP_HASHES, addr, length, hashes);
+}
+
+int
+profile_flush(void) {
+  return SYSCALL_0(RUNTIME_SYSCALL_PROFILE_FLUSH);
+}
+
 int
 copy_from_shared(void* dst, uintptr_t offset, size_t data_len) {
   return SYSCALL_3(RUNTIME_SYSCALL_SHAREDCOPY, dst, offset, data_len);
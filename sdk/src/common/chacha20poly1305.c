@@ -0,0 +1,488 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <string.h>
+#include "common/chacha20poly1305.h"
+
+// Poly1305 follows Andrew Moon's poly1305-donna: three 44-bit limbs where
+// the compiler has 128-bit products, five 26-bit limbs otherwise.
+
+#define ROTL32(x, y) (((x) << (y)) | ((x) >> (32 - (y))))
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CHACHA_WORD_XOR 1
+typedef uint64_t __attribute__((__may_alias__)) word64_t;
+#endif
+
+static uint32_t
+load32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static void
+store32(uint8_t* p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static void
+store64(uint8_t* p, uint64_t v) {
+  store32(p, v);
+  store32(p + 4, v >> 32);
+}
+
+#define QUARTERROUND(a, b, c, d) \
+  a += b;                        \
+  d ^= a;                        \
+  d = ROTL32(d, 16);             \
+  c += d;                        \
+  b ^= c;                        \
+  b = ROTL32(b, 12);             \
+  a += b;                        \
+  d ^= a;                        \
+  d = ROTL32(d, 8);              \
+  c += d;                        \
+  b ^= c;                        \
+  b = ROTL32(b, 7)
+
+// One 64-byte block of key stream, as words
+static void
+chacha20_block(const uint32_t in[16], uint32_t out[16]) {
+  uint32_t x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3];
+  uint32_t x4 = in[4], x5 = in[5], x6 = in[6], x7 = in[7];
+  uint32_t x8 = in[8], x9 = in[9], x10 = in[10], x11 = in[11];
+  uint32_t x12 = in[12], x13 = in[13], x14 = in[14], x15 = in[15];
+  int i;
+
+  for (i = 0; i < 10; i++) {
+    QUARTERROUND(x0, x4, x8, x12);
+    QUARTERROUND(x1, x5, x9, x13);
+    QUARTERROUND(x2, x6, x10, x14);
+    QUARTERROUND(x3, x7, x11, x15);
+    QUARTERROUND(x0, x5, x10, x15);
+    QUARTERROUND(x1, x6, x11, x12);
+    QUARTERROUND(x2, x7, x8, x13);
+    QUARTERROUND(x3, x4, x9, x14);
+  }
+
+  out[0]  = x0 + in[0];
+  out[1]  = x1 + in[1];
+  out[2]  = x2 + in[2];
+  out[3]  = x3 + in[3];
+  out[4]  = x4 + in[4];
+  out[5]  = x5 + in[5];
+  out[6]  = x6 + in[6];
+  out[7]  = x7 + in[7];
+  out[8]  = x8 + in[8];
+  out[9]  = x9 + in[9];
+  out[10] = x10 + in[10];
+  out[11] = x11 + in[11];
+  out[12] = x12 + in[12];
+  out[13] = x13 + in[13];
+  out[14] = x14 + in[14];
+  out[15] = x15 + in[15];
+}
+
+void
+chacha20_xor(
+    const uint8_t key[32], const uint8_t nonce[12], uint32_t counter,
+    const uint8_t* in, uint8_t* out, size_t len) {
+  uint32_t state[16], stream[16];
+  uint8_t bytes[64];
+  size_t i;
+
+  state[0] = 0x61707865;
+  state[1] = 0x3320646e;
+  state[2] = 0x79622d32;
+  state[3] = 0x6b206574;
+  for (i = 0; i < 8; i++) state[4 + i] = load32(key + 4 * i);
+  state[12] = counter;
+  state[13] = load32(nonce);
+  state[14] = load32(nonce + 4);
+  state[15] = load32(nonce + 8);
+
+  for (; len >= 64; len -= 64, in += 64, out += 64) {
+    chacha20_block(state, stream);
+    state[12]++;
+#ifdef CHACHA_WORD_XOR
+    // the words of a little-endian key stream line up with the bytes
+    if ((((uintptr_t)in | (uintptr_t)out) & 7) == 0) {
+      for (i = 0; i < 8; i++)
+        ((word64_t*)out)[i] = ((const word64_t*)in)[i] ^
+                              ((uint64_t)stream[2 * i + 1] << 32 | stream[2 * i]);
+      continue;
+    }
+#endif
+    for (i = 0; i < 16; i++)
+      store32(out + 4 * i, load32(in + 4 * i) ^ stream[i]);
+  }
+
+  if (len) {
+    chacha20_block(state, stream);
+    for (i = 0; i < 16; i++) store32(bytes + 4 * i, stream[i]);
+    for (i = 0; i < len; i++) out[i] = in[i] ^ bytes[i];
+  }
+}
+
+#ifdef __SIZEOF_INT128__
+
+typedef unsigned __int128 uint128_t;
+
+static uint64_t
+load64(const uint8_t* p) {
+  return (uint64_t)load32(p) | (uint64_t)load32(p + 4) << 32;
+}
+
+#define MASK44 0xfffffffffffULL
+#define MASK42 0x3ffffffffffULL
+
+void
+poly1305_init(poly1305_ctx_t* ctx, const uint8_t key[32]) {
+  uint64_t t0 = load64(key), t1 = load64(key + 8);
+
+  // r is clamped as the RFC asks
+  ctx->r[0]   = t0 & 0xffc0fffffffULL;
+  ctx->r[1]   = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+  ctx->r[2]   = (t1 >> 24) & 0x00ffffffc0fULL;
+  ctx->h[0]   = ctx->h[1] = ctx->h[2] = 0;
+  ctx->pad[0] = load64(key + 16);
+  ctx->pad[1] = load64(key + 24);
+  ctx->leftover = 0;
+  ctx->final    = 0;
+}
+
+static void
+poly1305_blocks(poly1305_ctx_t* ctx, const uint8_t* m, size_t len) {
+  const uint64_t hibit = ctx->final ? 0 : (1ULL << 40);
+  uint64_t r0 = ctx->r[0], r1 = ctx->r[1], r2 = ctx->r[2];
+  uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+  uint64_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2];
+  uint128_t d0, d1, d2;
+  uint64_t c, t0, t1;
+
+  for (; len >= 16; len -= 16, m += 16) {
+    t0 = load64(m);
+    t1 = load64(m + 8);
+    h0 += t0 & MASK44;
+    h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+    h2 += ((t1 >> 24) & MASK42) | hibit;
+
+    d0 = (uint128_t)h0 * r0 + (uint128_t)h1 * s2 + (uint128_t)h2 * s1;
+    d1 = (uint128_t)h0 * r1 + (uint128_t)h1 * r0 + (uint128_t)h2 * s2;
+    d2 = (uint128_t)h0 * r2 + (uint128_t)h1 * r1 + (uint128_t)h2 * r0;
+
+    c  = (uint64_t)(d0 >> 44);
+    h0 = (uint64_t)d0 & MASK44;
+    d1 += c;
+    c  = (uint64_t)(d1 >> 44);
+    h1 = (uint64_t)d1 & MASK44;
+    d2 += c;
+    c  = (uint64_t)(d2 >> 42);
+    h2 = (uint64_t)d2 & MASK42;
+    h0 += c * 5;
+    c  = h0 >> 44;
+    h0 &= MASK44;
+    h1 += c;
+  }
+
+  ctx->h[0] = h0;
+  ctx->h[1] = h1;
+  ctx->h[2] = h2;
+}
+
+static void
+poly1305_finish(poly1305_ctx_t* ctx, uint8_t tag[16]) {
+  uint64_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2];
+  uint64_t g0, g1, g2, c, mask;
+
+  // carry all the way, then compute h - p and keep it if it is positive
+  c = h1 >> 44;
+  h1 &= MASK44;
+  h2 += c;
+  c = h2 >> 42;
+  h2 &= MASK42;
+  h0 += c * 5;
+  c = h0 >> 44;
+  h0 &= MASK44;
+  h1 += c;
+  c = h1 >> 44;
+  h1 &= MASK44;
+  h2 += c;
+  c = h2 >> 42;
+  h2 &= MASK42;
+  h0 += c * 5;
+  c = h0 >> 44;
+  h0 &= MASK44;
+  h1 += c;
+
+  g0 = h0 + 5;
+  c  = g0 >> 44;
+  g0 &= MASK44;
+  g1 = h1 + c;
+  c  = g1 >> 44;
+  g1 &= MASK44;
+  g2 = h2 + c - (1ULL << 42);
+
+  mask = (g2 >> 63) - 1;
+  h0   = (h0 & ~mask) | (g0 & mask);
+  h1   = (h1 & ~mask) | (g1 & mask);
+  h2   = (h2 & ~mask) | (g2 & mask);
+
+  // h + pad, mod 2^128
+  h0 += ctx->pad[0] & MASK44;
+  c = h0 >> 44;
+  h0 &= MASK44;
+  h1 += (((ctx->pad[0] >> 44) | (ctx->pad[1] << 20)) & MASK44) + c;
+  c = h1 >> 44;
+  h1 &= MASK44;
+  h2 += ((ctx->pad[1] >> 24) & MASK42) + c;
+  h2 &= MASK42;
+
+  store64(tag, h0 | (h1 << 44));
+  store64(tag + 8, (h1 >> 20) | (h2 << 24));
+}
+
+#else
+
+#define MASK26 0x3ffffff
+
+void
+poly1305_init(poly1305_ctx_t* ctx, const uint8_t key[32]) {
+  int i;
+
+  // r is clamped as the RFC asks
+  ctx->r[0] = load32(key) & 0x3ffffff;
+  ctx->r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+  ctx->r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+  ctx->r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+  ctx->r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+  for (i = 0; i < 5; i++) ctx->h[i] = 0;
+  for (i = 0; i < 4; i++) ctx->pad[i] = load32(key + 16 + 4 * i);
+  ctx->leftover = 0;
+  ctx->final    = 0;
+}
+
+static void
+poly1305_blocks(poly1305_ctx_t* ctx, const uint8_t* m, size_t len) {
+  const uint32_t hibit = ctx->final ? 0 : (1UL << 24);
+  uint32_t r0 = ctx->r[0], r1 = ctx->r[1], r2 = ctx->r[2], r3 = ctx->r[3],
+           r4 = ctx->r[4];
+  uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+  uint32_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3],
+           h4 = ctx->h[4];
+  uint64_t d0, d1, d2, d3, d4;
+  uint32_t c;
+
+  for (; len >= 16; len -= 16, m += 16) {
+    h0 += load32(m) & MASK26;
+    h1 += (load32(m + 3) >> 2) & MASK26;
+    h2 += (load32(m + 6) >> 4) & MASK26;
+    h3 += (load32(m + 9) >> 6) & MASK26;
+    h4 += (load32(m + 12) >> 8) | hibit;
+
+    d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 +
+         (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+    d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 +
+         (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+    d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 +
+         (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+    d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 +
+         (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+    d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 +
+         (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+    c  = (uint32_t)(d0 >> 26);
+    h0 = (uint32_t)d0 & MASK26;
+    d1 += c;
+    c  = (uint32_t)(d1 >> 26);
+    h1 = (uint32_t)d1 & MASK26;
+    d2 += c;
+    c  = (uint32_t)(d2 >> 26);
+    h2 = (uint32_t)d2 & MASK26;
+    d3 += c;
+    c  = (uint32_t)(d3 >> 26);
+    h3 = (uint32_t)d3 & MASK26;
+    d4 += c;
+    c  = (uint32_t)(d4 >> 26);
+    h4 = (uint32_t)d4 & MASK26;
+    h0 += c * 5;
+    c  = h0 >> 26;
+    h0 &= MASK26;
+    h1 += c;
+  }
+
+  ctx->h[0] = h0;
+  ctx->h[1] = h1;
+  ctx->h[2] = h2;
+  ctx->h[3] = h3;
+  ctx->h[4] = h4;
+}
+
+static void
+poly1305_finish(poly1305_ctx_t* ctx, uint8_t tag[16]) {
+  uint32_t h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3],
+           h4 = ctx->h[4];
+  uint32_t g0, g1, g2, g3, g4, c, mask;
+  uint64_t f;
+
+  // carry all the way, then compute h - p and keep it if it is positive
+  c = h1 >> 26;
+  h1 &= MASK26;
+  h2 += c;
+  c = h2 >> 26;
+  h2 &= MASK26;
+  h3 += c;
+  c = h3 >> 26;
+  h3 &= MASK26;
+  h4 += c;
+  c = h4 >> 26;
+  h4 &= MASK26;
+  h0 += c * 5;
+  c = h0 >> 26;
+  h0 &= MASK26;
+  h1 += c;
+
+  g0 = h0 + 5;
+  c  = g0 >> 26;
+  g0 &= MASK26;
+  g1 = h1 + c;
+  c  = g1 >> 26;
+  g1 &= MASK26;
+  g2 = h2 + c;
+  c  = g2 >> 26;
+  g2 &= MASK26;
+  g3 = h3 + c;
+  c  = g3 >> 26;
+  g3 &= MASK26;
+  g4 = h4 + c - (1UL << 26);
+
+  mask = (g4 >> 31) - 1;
+  h0   = (h0 & ~mask) | (g0 & mask);
+  h1   = (h1 & ~mask) | (g1 & mask);
+  h2   = (h2 & ~mask) | (g2 & mask);
+  h3   = (h3 & ~mask) | (g3 & mask);
+  h4   = (h4 & ~mask) | (g4 & mask);
+
+  // h + pad, mod 2^128
+  h0 = h0 | (h1 << 26);
+  h1 = (h1 >> 6) | (h2 << 20);
+  h2 = (h2 >> 12) | (h3 << 14);
+  h3 = (h3 >> 18) | (h4 << 8);
+
+  f  = (uint64_t)h0 + ctx->pad[0];
+  h0 = (uint32_t)f;
+  f  = (uint64_t)h1 + ctx->pad[1] + (f >> 32);
+  h1 = (uint32_t)f;
+  f  = (uint64_t)h2 + ctx->pad[2] + (f >> 32);
+  h2 = (uint32_t)f;
+  f  = (uint64_t)h3 + ctx->pad[3] + (f >> 32);
+  h3 = (uint32_t)f;
+
+  store32(tag, h0);
+  store32(tag + 4, h1);
+  store32(tag + 8, h2);
+  store32(tag + 12, h3);
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+void
+poly1305_update(poly1305_ctx_t* ctx, const uint8_t* data, size_t len) {
+  size_t n;
+
+  if (ctx->leftover) {
+    n = 16 - ctx->leftover < len ? 16 - ctx->leftover : len;
+    memcpy(ctx->buffer + ctx->leftover, data, n);
+    ctx->leftover += n;
+    data += n;
+    len -= n;
+    if (ctx->leftover < 16) return;
+    poly1305_blocks(ctx, ctx->buffer, 16);
+    ctx->leftover = 0;
+  }
+
+  n = len & ~(size_t)15;
+  if (n) {
+    poly1305_blocks(ctx, data, n);
+    data += n;
+    len -= n;
+  }
+
+  if (len) {
+    memcpy(ctx->buffer, data, len);
+    ctx->leftover = len;
+  }
+}
+
+void
+poly1305_final(poly1305_ctx_t* ctx, uint8_t tag[16]) {
+  // a short last block is padded with a one and zeros
+  if (ctx->leftover) {
+    ctx->buffer[ctx->leftover] = 1;
+    memset(ctx->buffer + ctx->leftover + 1, 0, 15 - ctx->leftover);
+    ctx->final = 1;
+    poly1305_blocks(ctx, ctx->buffer, 16);
+  }
+  poly1305_finish(ctx, tag);
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+// Zeros up to the next multiple of 16
+static void
+poly1305_pad16(poly1305_ctx_t* ctx, size_t len) {
+  static const uint8_t zeros[16];
+  if (len % 16) poly1305_update(ctx, zeros, 16 - len % 16);
+}
+
+// The tag over aad and the ciphertext, with the one-time key from block 0
+static void
+chacha20poly1305_tag(
+    const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad,
+    size_t aad_len, const uint8_t* ciphertext, size_t len, uint8_t tag[16]) {
+  static const uint8_t zeros[32];
+  uint8_t otk[32], lengths[16];
+  poly1305_ctx_t ctx;
+
+  chacha20_xor(key, nonce, 0, zeros, otk, sizeof(otk));
+  poly1305_init(&ctx, otk);
+  memset(otk, 0, sizeof(otk));
+
+  poly1305_update(&ctx, aad, aad_len);
+  poly1305_pad16(&ctx, aad_len);
+  poly1305_update(&ctx, ciphertext, len);
+  poly1305_pad16(&ctx, len);
+  store64(lengths, aad_len);
+  store64(lengths + 8, len);
+  poly1305_update(&ctx, lengths, sizeof(lengths));
+  poly1305_final(&ctx, tag);
+}
+
+void
+chacha20poly1305_encrypt(
+    const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad,
+    size_t aad_len, const uint8_t* in, size_t len, uint8_t* out,
+    uint8_t tag[16]) {
+  chacha20_xor(key, nonce, 1, in, out, len);
+  chacha20poly1305_tag(key, nonce, aad, aad_len, out, len, tag);
+}
+
+int
+chacha20poly1305_decrypt(
+    const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad,
+    size_t aad_len, const uint8_t* in, size_t len, const uint8_t tag[16],
+    uint8_t* out) {
+  uint8_t expected[16];
+  uint8_t diff = 0;
+  int i;
+
+  chacha20poly1305_tag(key, nonce, aad, aad_len, in, len, expected);
+  for (i = 0; i < 16; i++) diff |= expected[i] ^ tag[i];
+  if (diff) return -1;
+
+  chacha20_xor(key, nonce, 1, in, out, len);
+  return 0;
+}
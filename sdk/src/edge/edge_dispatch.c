@@ -3,12 +3,15 @@
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
 #include "edge_call.h"
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef IO_SYSCALL_WRAPPING
 #include "edge_syscall.h"
 #endif /*  IO_SYSCALL_WRAPPING */
 
-edgecallwrapper edge_call_table[MAX_EDGE_CALL];
+edgecallwrapper* edge_call_table;
+size_t edge_call_table_size;
 
 /* Registered handler for incoming edge calls */
 void
@@ -24,7 +27,7 @@ incoming_call_dispatch(void* buffer) {
 #endif /*  IO_SYSCALL_WRAPPING */
 
   /* Otherwise try to lookup the call in the table */
-  if (edge_call->call_id > MAX_EDGE_CALL ||
+  if (edge_call->call_id >= edge_call_table_size ||
       edge_call_table[edge_call->call_id] == NULL) {
     /* Fatal error */
     goto fatal_error;
@@ -39,8 +42,24 @@ fatal_error:
 
 int
 register_call(unsigned long call_id, edgecallwrapper func) {
-  if (call_id > MAX_EDGE_CALL) {
-    return -1;
+  if (call_id >= edge_call_table_size) {
+    size_t size = edge_call_table_size ? edge_call_table_size : 16;
+    edgecallwrapper* table;
+
+    while (size <= call_id) {
+      if (size > SIZE_MAX / 2 / sizeof(edgecallwrapper)) return -1;
+      size *= 2;
+    }
+
+    table = (edgecallwrapper*)realloc(
+        edge_call_table, size * sizeof(edgecallwrapper));
+    if (!table) return -1;
+
+    memset(
+        table + edge_call_table_size, 0,
+        (size - edge_call_table_size) * sizeof(edgecallwrapper));
+    edge_call_table      = table;
+    edge_call_table_size = size;
   }
 
   edge_call_table[call_id] = func;
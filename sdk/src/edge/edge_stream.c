@@ -0,0 +1,278 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "edge_syscall.h"
+
+/* Host side of EDGE_SYSCALL_STREAM. Every open stream gets a thread that
+ * moves data between its descriptor and the ring while the enclave runs.
+ * The enclave flips the state of a half without telling the host, so the
+ * thread polls for it, backing off while the enclave is busy. Waits the
+ * enclave asks for are answered as soon as the thread has flipped the
+ * half. */
+
+#define EDGE_STREAM_MAX 8
+#define EDGE_STREAM_POLL_MIN_NS 10000
+#define EDGE_STREAM_POLL_MAX_NS 1000000
+
+struct host_stream {
+  int used;
+  int fd;
+  int dir;
+  edge_data_offset offset;
+  struct edge_stream_ring* ring;
+  size_t half_size;
+  pthread_t thread;
+  int closing;
+  int finished;
+};
+
+static struct host_stream streams[EDGE_STREAM_MAX];
+static pthread_mutex_t streams_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t streams_cond  = PTHREAD_COND_INITIALIZER;
+
+static uint32_t
+half_state(struct host_stream* s, int i) {
+  return __atomic_load_n(&s->ring->half[i].state, __ATOMIC_ACQUIRE);
+}
+
+static void
+set_half_state(struct host_stream* s, int i, uint32_t state) {
+  pthread_mutex_lock(&streams_lock);
+  __atomic_store_n(&s->ring->half[i].state, state, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&streams_cond);
+  pthread_mutex_unlock(&streams_lock);
+}
+
+/* Waits for the enclave to hand half i over; 0 if the stream is closing */
+static int
+await_half(struct host_stream* s, int i, uint32_t state) {
+  struct timespec delay = {0, EDGE_STREAM_POLL_MIN_NS};
+
+  while (half_state(s, i) != state) {
+    if (__atomic_load_n(&s->closing, __ATOMIC_ACQUIRE)) return 0;
+    nanosleep(&delay, NULL);
+    if (delay.tv_nsec < EDGE_STREAM_POLL_MAX_NS) delay.tv_nsec *= 2;
+  }
+  return 1;
+}
+
+static unsigned char*
+half_data(struct host_stream* s, int i) {
+  return s->ring->data + i * s->half_size;
+}
+
+static void
+pump_ingest(struct host_stream* s) {
+  int i = 0;
+
+  for (;;) {
+    size_t len = 0;
+    int end    = 0;
+
+    if (!await_half(s, i, EDGE_STREAM_EMPTY)) return;
+
+    while (len < s->half_size) {
+      ssize_t n = read(s->fd, half_data(s, i) + len, s->half_size - len);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        if (n < 0) s->ring->error = errno;
+        end = 1;
+        break;
+      }
+      len += n;
+    }
+
+    s->ring->half[i].len   = len;
+    s->ring->half[i].flags = end ? EDGE_STREAM_END : 0;
+    set_half_state(s, i, EDGE_STREAM_FULL);
+    if (end) return;
+    i ^= 1;
+  }
+}
+
+static void
+pump_egress(struct host_stream* s) {
+  int i = 0;
+
+  for (;;) {
+    size_t len, done = 0;
+    int end;
+
+    if (!await_half(s, i, EDGE_STREAM_FULL)) return;
+
+    /* the enclave does not touch a full half, but it is untrusted memory
+     * all the same */
+    len = s->ring->half[i].len;
+    end = s->ring->half[i].flags & EDGE_STREAM_END;
+    if (len > s->half_size) {
+      s->ring->error = EINVAL;
+      len = 0;
+      end = 1;
+    }
+
+    while (done < len && !s->ring->error) {
+      ssize_t n = write(s->fd, half_data(s, i) + done, len - done);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        s->ring->error = n < 0 ? errno : EIO;
+        break;
+      }
+      done += n;
+    }
+
+    set_half_state(s, i, EDGE_STREAM_EMPTY);
+    if (end) return;
+    i ^= 1;
+  }
+}
+
+static void*
+pump(void* arg) {
+  struct host_stream* s = (struct host_stream*)arg;
+
+  if (s->dir == EDGE_STREAM_INGEST)
+    pump_ingest(s);
+  else
+    pump_egress(s);
+
+  pthread_mutex_lock(&streams_lock);
+  s->finished = 1;
+  pthread_cond_broadcast(&streams_cond);
+  pthread_mutex_unlock(&streams_lock);
+  return NULL;
+}
+
+static struct host_stream*
+find_stream(edge_data_offset offset, size_t half_size) {
+  struct host_stream* s = NULL;
+  int i;
+
+  pthread_mutex_lock(&streams_lock);
+  for (i = 0; i < EDGE_STREAM_MAX; i++) {
+    if (streams[i].used && streams[i].offset == offset &&
+        streams[i].half_size == half_size)
+      s = &streams[i];
+  }
+  pthread_mutex_unlock(&streams_lock);
+  return s;
+}
+
+static int64_t
+stream_open(sargs_STREAM* args, struct edge_stream_ring* ring) {
+  struct host_stream* s = NULL;
+  int i;
+
+  if (args->half_size == 0 ||
+      (args->arg != EDGE_STREAM_INGEST && args->arg != EDGE_STREAM_EGRESS))
+    return -1;
+
+  pthread_mutex_lock(&streams_lock);
+  for (i = 0; i < EDGE_STREAM_MAX; i++) {
+    struct host_stream* o = &streams[i];
+    /* rings of open streams must not overlap */
+    if (o->used &&
+        o->offset < args->offset + EDGE_STREAM_RING_SIZE(args->half_size) &&
+        args->offset < o->offset + EDGE_STREAM_RING_SIZE(o->half_size))
+      break;
+    if (!o->used && !s) s = o;
+  }
+  if (i < EDGE_STREAM_MAX || !s) {
+    pthread_mutex_unlock(&streams_lock);
+    return -1;
+  }
+
+  s->used      = 1;
+  s->fd        = args->fd;
+  s->dir       = args->arg;
+  s->offset    = args->offset;
+  s->ring      = ring;
+  s->half_size = args->half_size;
+  s->closing   = 0;
+  s->finished  = 0;
+  ring->error  = 0;
+  if (pthread_create(&s->thread, NULL, pump, s) != 0) {
+    s->used = 0;
+    pthread_mutex_unlock(&streams_lock);
+    return -1;
+  }
+  pthread_mutex_unlock(&streams_lock);
+  return 0;
+}
+
+/* Returns once half i is in the given state (0), or -1 if the thread has
+ * stopped without getting it there */
+static int64_t
+stream_wait(struct host_stream* s, int i, uint32_t state) {
+  int64_t ret = 0;
+
+  pthread_mutex_lock(&streams_lock);
+  while (half_state(s, i) != state) {
+    if (s->finished) {
+      ret = -1;
+      break;
+    }
+    pthread_cond_wait(&streams_cond, &streams_lock);
+  }
+  pthread_mutex_unlock(&streams_lock);
+  return ret;
+}
+
+static int64_t
+stream_close(struct host_stream* s) {
+  int64_t ret;
+
+  __atomic_store_n(&s->closing, 1, __ATOMIC_RELEASE);
+  pthread_join(s->thread, NULL);
+  ret = s->ring->error ? -1 : 0;
+
+  pthread_mutex_lock(&streams_lock);
+  s->used = 0;
+  pthread_mutex_unlock(&streams_lock);
+  return ret;
+}
+
+void
+edge_stream_release_all(void) {
+  int i, used;
+
+  for (i = 0; i < EDGE_STREAM_MAX; i++) {
+    pthread_mutex_lock(&streams_lock);
+    used = streams[i].used;
+    pthread_mutex_unlock(&streams_lock);
+    if (used) stream_close(&streams[i]);
+  }
+}
+
+int64_t
+incoming_stream(sargs_STREAM* args) {
+  struct host_stream* s;
+  uintptr_t ring;
+
+  if (args->half_size > _shared_len ||
+      edge_call_get_ptr_from_offset(
+          args->offset, EDGE_STREAM_RING_SIZE(args->half_size), &ring) != 0)
+    return -1;
+
+  if (args->op == EDGE_STREAM_OPEN)
+    return stream_open(args, (struct edge_stream_ring*)ring);
+
+  s = find_stream(args->offset, args->half_size);
+  if (!s) return -1;
+
+  switch (args->op) {
+    case EDGE_STREAM_WAIT:
+      if (args->arg != 0 && args->arg != 1) return -1;
+      /* ingest waits for data, egress for room */
+      return stream_wait(
+          s, args->arg,
+          s->dir == EDGE_STREAM_INGEST ? EDGE_STREAM_FULL : EDGE_STREAM_EMPTY);
+    case EDGE_STREAM_CLOSE:
+      return stream_close(s);
+  }
+  return -1;
+}
@@ -1,11 +1,114 @@
+#define _GNU_SOURCE
 #include "edge_syscall.h"
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <sys/sendfile.h>
+#include <sys/uio.h>
+
+/* Appends a batch of profiler samples to $KEYSTONE_PROFILE (keystone.prof
+ * by default) and returns the number of samples written */
+static int64_t
+incoming_profile(sargs_PROFILE* args, size_t len) {
+  const char* path = getenv("KEYSTONE_PROFILE");
+  size_t size;
+  int64_t ret = -1;
+  int fd;
+
+  if (len < sizeof(sargs_PROFILE) || args->magic != PROFILE_MAGIC ||
+      args->version != PROFILE_VERSION)
+    return -1;
+  size = sizeof(sargs_PROFILE) + args->count * PROFILE_SAMPLE_SIZE(args->depth);
+  if (size > len) return -1;
+
+  fd = open(
+      path ? path : "keystone.prof", O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+      0644);
+  if (fd < 0) return -1;
+  if (write(fd, args, size) == (ssize_t)size) ret = args->count;
+  close(fd);
+  return ret;
+}
+
+/* Runs sendmsg/recvmsg/sendmmsg/recvmmsg on the messages packed after args
+ * (see sargs_msg) and writes the results back into the entries */
+static int64_t
+incoming_msgs(unsigned long syscall_num, sargs_SYS_sendmmsg* args) {
+  unsigned char* pos = args->msgs;
+  unsigned char* end = args->msgs + args->msgs_len;
+  int recv = (syscall_num == SYS_recvmsg || syscall_num == SYS_recvmmsg);
+  int single = (syscall_num == SYS_sendmsg || syscall_num == SYS_recvmsg);
+  unsigned int vlen = args->vlen;
+  struct mmsghdr* msgs;
+  struct iovec* iovs;
+  int64_t ret = -1;
+  unsigned int i, done = 0;
+
+  if ((single && vlen != 1) || vlen > UIO_MAXIOV) return -1;
+
+  msgs = (struct mmsghdr*)calloc(vlen ? vlen : 1, sizeof(*msgs));
+  iovs = (struct iovec*)calloc(vlen ? vlen : 1, sizeof(*iovs));
+  if (!msgs || !iovs) goto done;
+
+  for (i = 0; i < vlen; i++) {
+    sargs_msg* entry = (sargs_msg*)pos;
+    if (pos + sizeof(sargs_msg) > end ||
+        pos + SARGS_MSG_SIZE(entry->namecap, entry->cap) > end ||
+        entry->len > entry->cap || entry->namelen > entry->namecap)
+      goto done;
+
+    iovs[i].iov_base = entry->buf + SARGS_MSG_PAD(entry->namecap);
+    iovs[i].iov_len  = recv ? entry->cap : entry->len;
+    msgs[i].msg_hdr.msg_name    = entry->namecap ? entry->buf : NULL;
+    msgs[i].msg_hdr.msg_namelen = recv ? entry->namecap : entry->namelen;
+    msgs[i].msg_hdr.msg_iov     = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+    pos += SARGS_MSG_SIZE(entry->namecap, entry->cap);
+  }
+
+  switch (syscall_num) {
+    case (SYS_sendmsg):
+      ret = sendmsg(args->sockfd, &msgs[0].msg_hdr, args->flags);
+      break;
+    case (SYS_recvmsg):
+      ret = recvmsg(args->sockfd, &msgs[0].msg_hdr, args->flags);
+      break;
+    case (SYS_sendmmsg):
+      ret = sendmmsg(args->sockfd, msgs, vlen, args->flags);
+      break;
+    case (SYS_recvmmsg):
+      ret = recvmmsg(
+          args->sockfd, msgs, vlen, args->flags,
+          args->timeout_is_null ? NULL : &args->timeout);
+      break;
+  }
+
+  if (ret < 0) goto done;
+  if (single) {
+    msgs[0].msg_len = ret;
+    done            = 1;
+  } else {
+    done = ret;
+  }
+
+  for (i = 0, pos = args->msgs; i < done; i++) {
+    sargs_msg* entry = (sargs_msg*)pos;
+    entry->len       = msgs[i].msg_len;
+    entry->namelen   = msgs[i].msg_hdr.msg_namelen;
+    entry->flags     = msgs[i].msg_hdr.msg_flags;
+    pos += SARGS_MSG_SIZE(entry->namecap, entry->cap);
+  }
+
+done:
+  free(msgs);
+  free(iovs);
+  return ret;
+}
+
 // Special edge-call handler for syscall proxying
 void
 incoming_syscall(struct edge_call* edge_call) {
@@ -70,6 +173,17 @@ incoming_syscall(struct edge_call* edge_call) {
       sargs_SYS_read* read_args = (sargs_SYS_read*)syscall_info->data;
       ret = read(read_args->fd, read_args->buf, read_args->len);
       break;
+    case (SYS_pread64):;
+      sargs_SYS_pread64* pread_args = (sargs_SYS_pread64*)syscall_info->data;
+      ret = pread(
+          pread_args->fd, pread_args->buf, pread_args->len, pread_args->offset);
+      break;
+    case (SYS_pwrite64):;
+      sargs_SYS_pwrite64* pwrite_args = (sargs_SYS_pwrite64*)syscall_info->data;
+      ret = pwrite(
+          pwrite_args->fd, pwrite_args->buf, pwrite_args->len,
+          pwrite_args->offset);
+      break;
     case (SYS_sync):;
       sync();
       ret = 0;
@@ -166,6 +280,50 @@ incoming_syscall(struct edge_call* edge_call) {
       ret = sendto(sendto_args->sockfd, sendto_args->buf, sendto_args->len, sendto_args->flags, 
                       dest_addr, dest_addrlen);
       break;
+    case (SYS_sendmsg):
+    case (SYS_recvmsg):
+    case (SYS_sendmmsg):
+    case (SYS_recvmmsg):;
+      ret = incoming_msgs(
+          syscall_info->syscall_num, (sargs_SYS_sendmmsg*)syscall_info->data);
+      break;
+    case (EDGE_SYSCALL_SHARED_IO):;
+      sargs_SHARED_IO* io_args = (sargs_SHARED_IO*)syscall_info->data;
+      uintptr_t io_buf;
+      if (edge_call_get_ptr_from_offset(
+              io_args->offset, io_args->len, &io_buf) != 0) {
+        ret = -1;
+        break;
+      }
+      switch (io_args->op) {
+        case (SYS_read):
+          ret = read(io_args->fd, (void*)io_buf, io_args->len);
+          break;
+        case (SYS_write):
+          ret = write(io_args->fd, (void*)io_buf, io_args->len);
+          break;
+        case (SYS_recvfrom):
+          ret = recv(io_args->fd, (void*)io_buf, io_args->len, io_args->flags);
+          break;
+        case (SYS_sendto):
+          ret = send(io_args->fd, (void*)io_buf, io_args->len, io_args->flags);
+          break;
+        default:
+          ret = -1;
+      }
+      break;
+    case (EDGE_SYSCALL_STREAM):;
+      if (args_size < sizeof(struct edge_syscall) + sizeof(sargs_STREAM)) {
+        ret = -1;
+        break;
+      }
+      ret = incoming_stream((sargs_STREAM*)syscall_info->data);
+      break;
+    case (EDGE_SYSCALL_PROFILE):;
+      ret = incoming_profile(
+          (sargs_PROFILE*)syscall_info->data,
+          args_size - sizeof(struct edge_syscall));
+      break;
     case (SYS_sendfile):; 
       sargs_SYS_sendfile *sendfile_args = (sargs_SYS_sendfile *) syscall_info->data; 
       ret = sendfile(sendfile_args->out_fd, sendfile_args->in_fd, &sendfile_args->offset, sendfile_args->count);
@@ -19,6 +19,7 @@ fstatFileSize(int filep) {
 ElfFile::ElfFile(std::string filename) {
   fileSize = 0;
   ptr      = NULL;
+  valid    = false;
   filep    = open(filename.c_str(), O_RDONLY);
 
   if (filep < 0) {
@@ -49,6 +50,7 @@ ElfFile::ElfFile(std::string filename) {
   }
 
   maxVaddr = ROUND_UP(maxVaddr, PAGE_BITS);
+  valid    = true;
 }
 
 ElfFile::~ElfFile() {
@@ -56,4 +58,49 @@ ElfFile::~ElfFile() {
   munmap(ptr, fileSize);
 }
 
+bool
+ElfFile::isValid() {
+  return valid;
+}
+
+size_t
+ElfFile::getNumProgramHeaders(void) {
+  return elf_getNumProgramHeaders(&elf);
+}
+
+size_t
+ElfFile::getProgramHeaderType(size_t ph) {
+  return elf_getProgramHeaderType(&elf, ph);
+}
+
+size_t
+ElfFile::getProgramHeaderFileSize(size_t ph) {
+  return elf_getProgramHeaderFileSize(&elf, ph);
+}
+
+size_t
+ElfFile::getProgramHeaderMemorySize(size_t ph) {
+  return elf_getProgramHeaderMemorySize(&elf, ph);
+}
+
+size_t
+ElfFile::getProgramHeaderFlags(size_t ph) {
+  return elf_getProgramHeaderFlags(&elf, ph);
+}
+
+uintptr_t
+ElfFile::getProgramHeaderVaddr(size_t ph) {
+  return elf_getProgramHeaderVaddr(&elf, ph);
+}
+
+uintptr_t
+ElfFile::getEntryPoint() {
+  return elf_getEntryPoint(&elf);
+}
+
+void*
+ElfFile::getProgramSegment(size_t ph) {
+  return elf_getProgramSegment(&elf, ph);
+}
+
 }  // namespace Keystone
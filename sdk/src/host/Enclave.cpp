@@ -3,49 +3,136 @@
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
 #include "Enclave.hpp"
-#include <math.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <set>
 extern "C" {
 #include "common/sha3.h"
+#include "edge/edge_syscall.h"
 #include "shared/keystone_user.h"
 }
 #include "ElfFile.hpp"
+#include "SharedRegion.hpp"
 #include "hash_util.hpp"
 
 namespace Keystone {
 
 Enclave::Enclave() {
+  timePage  = NULL;
+  stoppedAt = 0;
+  memset(&initProfile, 0, sizeof(initProfile));
+}
+
+static uint64_t
+monotonic_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* nanoseconds since *start, which moves on to now */
+static uint64_t
+lap_ns(uint64_t* start) {
+  uint64_t now     = monotonic_ns();
+  uint64_t elapsed = now - *start;
+  *start           = now;
+  return elapsed;
 }
 
 Enclave::~Enclave() {
   destroy();
 }
 
+#if __riscv_xlen == 32
+/* Sv32: root -> 4 MiB leaf tables */
+static const unsigned int ptLevelBits[] = {22};
+#else
+/* Sv39: root -> 1 GiB -> 2 MiB leaf tables */
+static const unsigned int ptLevelBits[] = {30, 21};
+#endif
+#define PT_NLEVELS (sizeof(ptLevelBits) / sizeof(ptLevelBits[0]))
+
+/* Records the non-root page tables needed to map [start, end). The root
+ * page table is statically allocated in the loader. */
+static void
+add_page_table_range(std::set<uintptr_t>* tables, uintptr_t start, uintptr_t end) {
+  if (start >= end) return;
+  for (size_t lvl = 0; lvl < PT_NLEVELS; lvl++) {
+    for (uintptr_t idx = start >> ptLevelBits[lvl];
+         idx <= ((end - 1) >> ptLevelBits[lvl]); idx++)
+      tables[lvl].insert(idx);
+  }
+}
+
+/* Pages that loadElf() in the runtime allocates out of freemem for an
+ * image: the unaligned head page of each segment and every page holding
+ * .bss. Images in a shared region also get private copies of writable
+ * pages, since the region itself is read-only. */
+static uint64_t
+loaded_elf_pages(ElfFile* elfFile, bool shared, std::set<uintptr_t>* tables) {
+  uint64_t pages = 0;
+
+  for (size_t i = 0; i < elfFile->getNumProgramHeaders(); i++) {
+    if (elfFile->getProgramHeaderType(i) != PT_LOAD) continue;
+
+    uintptr_t start     = elfFile->getProgramHeaderVaddr(i);
+    uintptr_t fileEnd   = start + elfFile->getProgramHeaderFileSize(i);
+    uintptr_t memoryEnd = start + elfFile->getProgramHeaderMemorySize(i);
+    uintptr_t va        = start;
+
+    add_page_table_range(tables, start, memoryEnd);
+
+    if (va & (PAGE_SIZE - 1)) {
+      pages++;
+      va = PAGE_DOWN(va) + PAGE_SIZE;
+    }
+
+    /* full file pages are mapped in place */
+    uintptr_t inPlaceEnd = (fileEnd > va) ? PAGE_DOWN(fileEnd) : va;
+    if (shared && (elfFile->getProgramHeaderFlags(i) & PF_W))
+      pages += (inPlaceEnd - va) / PAGE_SIZE;
+
+    if (memoryEnd > inPlaceEnd)
+      pages += (PAGE_UP(memoryEnd) - inPlaceEnd) / PAGE_SIZE;
+  }
+  return pages;
+}
+
+/* Number of EPM pages on top of the requested freemem: the images copied
+ * in by the host, plus what the loader and the runtime carve out of
+ * freemem before the eapp starts (segment pages, user stack, and page
+ * tables), so that the whole freemem size remains available at runtime. */
 uint64_t
-calculate_required_pages(ElfFile** elfFiles, size_t numElfFiles) {
+calculate_required_pages(
+    ElfFile* runtimeFile, ElfFile* loaderFile, ElfFile* eappFile,
+    Params& params, bool sharedEapp) {
+  std::set<uintptr_t> tables[PT_NLEVELS];
   uint64_t req_pages = 0;
 
-  for (int i = 0; i < numElfFiles; i++) {
-    ElfFile* elfFile = elfFiles[i];
-    req_pages += ceil(elfFile->getFileSize() / PAGE_SIZE);
-  }
-  /* FIXME: calculate the required number of pages for the page table.
-   * We actually don't know how many page tables the enclave might need,
-   * because the SDK never knows how its memory will be aligned.
-   * Ideally, this should be managed by the driver.
-   * For now, we naively allocate enough pages so that we can temporarily get
-   * away from this problem.
-   * 15 pages will be more than sufficient to cover several hundreds of
-   * megabytes of enclave/runtime. */
-  /* FIXME Part 2: now that loader does loading, .bss sections also eat up
-   * space. Eapp dev must make FREEMEM big enough to fit this!!
-   * Possible fix -- re-add exact .bss calculations?
-   */
-
-  /* Add one page each for bss segments of runtime and eapp */ 
-  // TODO: add space for stack?
-  req_pages += 16;
+  req_pages += PAGE_UP(loaderFile->getFileSize()) / PAGE_SIZE;
+  req_pages += PAGE_UP(runtimeFile->getFileSize()) / PAGE_SIZE;
+  if (!sharedEapp)
+    req_pages += PAGE_UP(eappFile->getFileSize()) / PAGE_SIZE;
+
+  if (runtimeFile->isValid())
+    req_pages += loaded_elf_pages(runtimeFile, false, tables);
+  if (eappFile->isValid())
+    req_pages += loaded_elf_pages(eappFile, sharedEapp, tables);
+
+  req_pages += DEFAULT_STACK_SIZE / PAGE_SIZE;
+  add_page_table_range(
+      tables, DEFAULT_STACK_START - DEFAULT_STACK_SIZE, DEFAULT_STACK_START);
+  add_page_table_range(
+      tables, DEFAULT_UNTRUSTED_PTR,
+      DEFAULT_UNTRUSTED_PTR + PAGE_UP(params.getUntrustedSize()));
+  if (sharedEapp)
+    add_page_table_range(
+        tables, DEFAULT_SHARED_PTR,
+        DEFAULT_SHARED_PTR + PAGE_UP(eappFile->getFileSize()));
+
+  for (size_t lvl = 0; lvl < PT_NLEVELS; lvl++)
+    req_pages += tables[lvl].size();
+
   return req_pages;
 }
 
@@ -117,8 +204,13 @@ static void measureElfFile(hash_ctx_t* hash_ctx, ElfFile* file) {
   }
 }
 
+/* If sharedEapp is set, the eapp is expected to be loaded from a
+ * SharedRegion: the EPM holds no eapp pages and the region's own
+ * measurement is appended instead. */
 Error
-Enclave::measure(char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath) {
+Enclave::measure(
+    char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath,
+    bool sharedEapp) {
   hash_ctx_t hash_ctx;
   hash_init(&hash_ctx);
 
@@ -127,16 +219,25 @@ Enclave::measure(char* hash, const char* eapppath, const char* runtimepath, cons
   ElfFile* eapp = new ElfFile(eapppath);
 
   uintptr_t sizes[3] = { PAGE_UP(loader->getFileSize()), PAGE_UP(runtime->getFileSize()),
-                          PAGE_UP(eapp->getFileSize()) };
+                          sharedEapp ? 0 : PAGE_UP(eapp->getFileSize()) };
   hash_extend(&hash_ctx, (void*) sizes, sizeof(sizes));
 
   measureElfFile(&hash_ctx, loader);
   delete loader;
   measureElfFile(&hash_ctx, runtime);
   delete runtime;
-  measureElfFile(&hash_ctx, eapp);
+  if (!sharedEapp)
+    measureElfFile(&hash_ctx, eapp);
   delete eapp;
 
+  if (sharedEapp) {
+    char sharedHash[MDSIZE];
+    Error ret = SharedRegion::measure(sharedHash, eapppath);
+    if (ret != Error::Success)
+      return ret;
+    hash_extend(&hash_ctx, (void*) sharedHash, MDSIZE);
+  }
+
   hash_finalize(hash, &hash_ctx);
 
   return Error::Success;
@@ -153,6 +254,8 @@ Enclave::init(
     uintptr_t alternatePhysAddr) {
   params = _params;
 
+  if (params.isInProcessSimulation()) return initSimulated(eapppath);
+
   pMemory = new PhysicalEnclaveMemory();
   pDevice = new KeystoneDevice();
 
@@ -165,18 +268,25 @@ Enclave::init(
     return Error::DeviceInitFailure;
   }
 
-  ElfFile* elfFiles[3] = {enclaveFile, runtimeFile, loaderFile};
-  size_t requiredPages = calculate_required_pages(elfFiles, 3);
+  /* a shared eapp lives in its own region, not in the EPM */
+  bool sharedEapp = (params.getSharedRegion() != SHARED_REGION_NONE);
+
+  size_t requiredPages = calculate_required_pages(
+      runtimeFile, loaderFile, enclaveFile, params, sharedEapp);
 
+  uint64_t phaseStart = monotonic_ns();
   if (!prepareEnclaveMemory(requiredPages, alternatePhysAddr)) {
     destroy();
     return Error::DeviceError;
   }
+  initProfile.create = lap_ns(&phaseStart);
+
   if (!pMemory->allocUtm(params.getUntrustedSize())) {
     ERROR("failed to init untrusted memory - ioctl() failed");
     destroy();
     return Error::DeviceError;
   }
+  initProfile.utm = lap_ns(&phaseStart);
 	
   /* Copy loader into beginning of enclave memory */
   copyFile((uintptr_t) loaderFile->getPtr(), loaderFile->getFileSize());
@@ -185,16 +295,21 @@ Enclave::init(
   copyFile((uintptr_t) runtimeFile->getPtr(), runtimeFile->getFileSize());
 
   pMemory->startEappMem();
-  copyFile((uintptr_t) enclaveFile->getPtr(), enclaveFile->getFileSize());
+  if (!sharedEapp)
+    copyFile((uintptr_t) enclaveFile->getPtr(), enclaveFile->getFileSize());
 
   pMemory->startFreeMem();
+  initProfile.copy = lap_ns(&phaseStart);
 
   if (pDevice->finalize(
           pMemory->getRuntimePhysAddr(), pMemory->getEappPhysAddr(),
-          pMemory->getFreePhysAddr(), params.getFreeMemSize()) != Error::Success) {
+          pMemory->getFreePhysAddr(), params.getFreeMemSize(),
+          params.getSharedRegion()) != Error::Success) {
     destroy();
     return Error::DeviceError;
   }
+  initProfile.finalize = lap_ns(&phaseStart);
+
   if (!mapUntrusted(params.getUntrustedSize())) {
     ERROR(
         "failed to finalize enclave - cannot obtain the untrusted buffer "
@@ -202,6 +317,7 @@ Enclave::init(
     destroy();
     return Error::DeviceMemoryMapError;
   }
+  initProfile.map = lap_ns(&phaseStart);
 
   /* ELF files are no longer needed */
   delete enclaveFile;
@@ -210,6 +326,29 @@ Enclave::init(
   return Error::Success;
 }
 
+/* The eapp is a host shared object that runs in this process; there is no
+ * runtime, loader or EPM to set up, see SimulatedKeystoneDevice. */
+Error
+Enclave::initSimulated(const char* eapppath) {
+#ifndef KEYSTONE_SIM
+  ERROR("simulation needs an SDK built with KEYSTONE_SIM");
+  return Error::DeviceInitFailure;
+#else
+  pMemory = new SimulatedEnclaveMemory();
+  pDevice = new SimulatedKeystoneDevice(eapppath);
+
+  if (!pDevice->initDevice(params)) {
+    destroy();
+    return Error::FileInitFailure;
+  }
+  if (!mapUntrusted(params.getUntrustedSize())) {
+    destroy();
+    return Error::DeviceMemoryMapError;
+  }
+  return Error::Success;
+#endif /* KEYSTONE_SIM */
+}
+
 bool
 Enclave::mapUntrusted(size_t size) {
   if (size == 0) {
@@ -224,22 +363,108 @@ Enclave::mapUntrusted(size_t size) {
 
   shared_buffer_size = size;
 
+  /* the runtime reads the clock from the last page, see time_page.h */
+  if (params.hasTimePage() && size >= 2 * KEYSTONE_TIME_PAGE_SIZE) {
+    shared_buffer_size -= KEYSTONE_TIME_PAGE_SIZE;
+    timePage = (struct keystone_time_page*)((char*)shared_buffer + shared_buffer_size);
+    memset(timePage, 0, sizeof(*timePage));
+    timePage->magic = KEYSTONE_TIME_PAGE_MAGIC;
+  }
+
   return true;
 }
 
+static uint64_t
+read_ticks() {
+#if defined(__riscv)
+  uint64_t ticks;
+#if __riscv_xlen == 32
+  uint32_t hi, lo, hi2;
+  do {
+    asm volatile("rdtimeh %0" : "=r"(hi));
+    asm volatile("rdtime %0" : "=r"(lo));
+    asm volatile("rdtimeh %0" : "=r"(hi2));
+  } while (hi != hi2);
+  ticks = ((uint64_t)hi << 32) | lo;
+#else
+  asm volatile("rdtime %0" : "=r"(ticks));
+#endif
+  return ticks;
+#else
+  return 0;
+#endif
+}
+
+/* frequency of the time CSR, 0 if unknown */
+static uint64_t
+read_timebase() {
+#if defined(__riscv)
+  static uint64_t timebase;
+  unsigned char be[4];
+
+  if (timebase) return timebase;
+
+  FILE* f = fopen("/sys/firmware/devicetree/base/cpus/timebase-frequency", "rb");
+  if (!f) return 0;
+  if (fread(be, 1, sizeof(be), f) == sizeof(be))
+    timebase = ((uint64_t)be[0] << 24) | (be[1] << 16) | (be[2] << 8) | be[3];
+  fclose(f);
+  return timebase;
+#else
+  return 0;
+#endif
+}
+
+/* Refreshes the time page right before the enclave runs. The offset to
+ * CLOCK_REALTIME is recomputed every time so that wall clock adjustments
+ * on the host are picked up at the next resume. */
+void
+Enclave::publishTime(bool resume) {
+  struct timespec now;
+  uint64_t hz;
+
+  if (!timePage || !(hz = read_timebase())) return;
+
+  uint64_t ticks = read_ticks();
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  uint64_t monoNs = (ticks / hz) * 1000000000ULL + (ticks % hz) * 1000000000ULL / hz;
+  uint64_t realNs = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+  timePage->timebase_hz        = hz;
+  timePage->realtime_offset_ns = (int64_t)(realNs - monoNs);
+  if (resume)
+    timePage->stopped_ticks += ticks - stoppedAt;
+  else
+    timePage->start_ticks = ticks;
+}
+
+/* The driver stamps the stop as soon as the SM returns, which for
+ * asynchronous runs can be well before the host gets to handle it */
+void
+Enclave::markStopped() {
+  stoppedAt = pDevice->getStopTicks();
+  if (!stoppedAt) stoppedAt = read_ticks();
+}
+
 Error
 Enclave::destroy() {
+  /* stream threads must be done with the shared buffer first */
+  edge_stream_release_all();
   return pDevice->destroy();
 }
 
 Error
 Enclave::run(uintptr_t* retval) {
+  publishTime(false);
   Error ret = pDevice->run(retval);
   while (ret == Error::EdgeCallHost || ret == Error::EnclaveInterrupted) {
     /* enclave is stopped in the middle. */
+    markStopped();
     if (ret == Error::EdgeCallHost && oFuncDispatch != NULL) {
       oFuncDispatch(getSharedBuffer());
     }
+    publishTime(true);
     ret = pDevice->resume(retval);
   }
 
@@ -252,6 +477,50 @@ Enclave::run(uintptr_t* retval) {
   return Error::Success;
 }
 
+Error
+Enclave::runAsync() {
+  publishTime(false);
+  if (pDevice->runAsync(false) != Error::Success) {
+    ERROR("failed to run enclave - ioctl() failed");
+    destroy();
+    return Error::DeviceError;
+  }
+  return Error::Success;
+}
+
+Error
+Enclave::handleEvent(uintptr_t* retval) {
+  Error ret = pDevice->getEvent(retval);
+
+  if (ret == Error::EdgeCallHost || ret == Error::EnclaveInterrupted) {
+    /* enclave is stopped in the middle. */
+    markStopped();
+    if (ret == Error::EdgeCallHost && oFuncDispatch != NULL) {
+      oFuncDispatch(getSharedBuffer());
+    }
+    publishTime(true);
+    if (pDevice->runAsync(true) != Error::Success) {
+      ERROR("failed to resume enclave - ioctl() failed");
+      destroy();
+      return Error::DeviceError;
+    }
+    return ret;
+  }
+
+  if (ret != Error::Success) {
+    ERROR("failed to run enclave - ioctl() failed");
+    destroy();
+    return Error::DeviceError;
+  }
+
+  return Error::Success;
+}
+
+int
+Enclave::getPollFd() {
+  return pDevice->getPollFd();
+}
+
 void*
 Enclave::getSharedBuffer() {
   return shared_buffer;
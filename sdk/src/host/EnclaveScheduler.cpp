@@ -0,0 +1,161 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "EnclaveScheduler.hpp"
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Keystone {
+
+EnclaveScheduler::EnclaveScheduler(size_t numThreads) {
+  outstanding = 0;
+  stopping    = false;
+
+  if (pipe(wakeFds)) {
+    PERROR("cannot create the scheduler wake pipe");
+    wakeFds[0] = wakeFds[1] = -1;
+  } else {
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+  }
+
+  if (numThreads == 0) numThreads = 1;
+
+  poller = std::thread(&EnclaveScheduler::pollLoop, this);
+  for (size_t i = 0; i < numThreads; i++)
+    workers.push_back(std::thread(&EnclaveScheduler::workerLoop, this));
+}
+
+EnclaveScheduler::~EnclaveScheduler() {
+  wait();
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  readyCond.notify_all();
+  wakePoller();
+
+  poller.join();
+  for (auto& worker : workers) worker.join();
+
+  if (wakeFds[0] >= 0) {
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+  }
+}
+
+void
+EnclaveScheduler::wakePoller() {
+  char c = 0;
+  if (wakeFds[1] >= 0 && write(wakeFds[1], &c, 1) < 0) {
+    /* the pipe is full, so the poller is already going to wake up */
+  }
+}
+
+/* enclaves without a pollable fd (e.g., the mock device) are always ready */
+void
+EnclaveScheduler::enqueueLocked(Job* job) {
+  if (job->enclave->getPollFd() < 0) {
+    readyQueue.push_back(job);
+    readyCond.notify_one();
+  } else {
+    running.push_back(job);
+    wakePoller();
+  }
+}
+
+Error
+EnclaveScheduler::submit(Enclave* enclave, DoneFunc done) {
+  Error ret = enclave->runAsync();
+  if (ret != Error::Success) return ret;
+
+  std::lock_guard<std::mutex> guard(lock);
+  outstanding++;
+  enqueueLocked(new Job{enclave, done});
+  return Error::Success;
+}
+
+void
+EnclaveScheduler::wait() {
+  std::unique_lock<std::mutex> guard(lock);
+  idleCond.wait(guard, [this] { return outstanding == 0; });
+}
+
+void
+EnclaveScheduler::pollLoop() {
+  std::vector<struct pollfd> fds;
+  std::vector<Job*> jobs;
+
+  while (true) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (stopping) return;
+      jobs = running;
+    }
+
+    fds.resize(jobs.size() + 1);
+    fds[0] = {wakeFds[0], POLLIN, 0};
+    for (size_t i = 0; i < jobs.size(); i++)
+      fds[i + 1] = {jobs[i]->enclave->getPollFd(), POLLIN, 0};
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      PERROR("scheduler poll failed");
+      return;
+    }
+
+    if (fds[0].revents) {
+      char buf[64];
+      while (read(wakeFds[0], buf, sizeof(buf)) > 0) {
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < jobs.size(); i++) {
+      if (!fds[i + 1].revents) continue;
+      for (auto it = running.begin(); it != running.end(); it++) {
+        if (*it == jobs[i]) {
+          running.erase(it);
+          break;
+        }
+      }
+      readyQueue.push_back(jobs[i]);
+      readyCond.notify_one();
+    }
+  }
+}
+
+void
+EnclaveScheduler::workerLoop() {
+  while (true) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      readyCond.wait(guard, [this] { return stopping || !readyQueue.empty(); });
+      if (readyQueue.empty()) return;
+      job = readyQueue.front();
+      readyQueue.pop_front();
+    }
+
+    uintptr_t retval = 0;
+    Error ret        = job->enclave->handleEvent(&retval);
+
+    if (ret == Error::EdgeCallHost || ret == Error::EnclaveInterrupted) {
+      /* resumed, wait for the next stop */
+      std::lock_guard<std::mutex> guard(lock);
+      enqueueLocked(job);
+      continue;
+    }
+
+    if (job->done) job->done(job->enclave, ret, retval);
+    delete job;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (--outstanding == 0) idleCond.notify_all();
+  }
+}
+
+}  // namespace Keystone
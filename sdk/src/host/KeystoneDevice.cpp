@@ -7,7 +7,10 @@
 
 namespace Keystone {
 
-KeystoneDevice::KeystoneDevice() { eid = -1; }
+KeystoneDevice::KeystoneDevice() {
+  eid       = -1;
+  stopTicks = 0;
+}
 
 Error
 KeystoneDevice::create(uint64_t minPages) {
@@ -41,13 +44,14 @@ KeystoneDevice::initUTM(size_t size) {
 Error
 KeystoneDevice::finalize(
     uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-    uintptr_t freeRequested) {
+    uintptr_t freeRequested, uintptr_t sharedRegion) {
   struct keystone_ioctl_create_enclave encl;
-  encl.eid            = eid;
-  encl.runtime_paddr  = runtimePhysAddr;
-  encl.user_paddr     = eappPhysAddr;
-  encl.free_paddr     = freePhysAddr;
-  encl.free_requested = freeRequested;
+  encl.eid              = eid;
+  encl.runtime_paddr    = runtimePhysAddr;
+  encl.user_paddr       = eappPhysAddr;
+  encl.free_paddr       = freePhysAddr;
+  encl.free_requested   = freeRequested;
+  encl.shared_region_id = sharedRegion;
 
   if (ioctl(fd, KEYSTONE_IOC_FINALIZE_ENCLAVE, &encl)) {
     perror("ioctl error");
@@ -74,6 +78,34 @@ KeystoneDevice::destroy() {
   return Error::Success;
 }
 
+Error
+KeystoneDevice::createSharedRegion(
+    const void* image, size_t size, uintptr_t* sharedRegion) {
+  struct keystone_ioctl_shared_region region;
+  region.image_ptr  = (uintptr_t)image;
+  region.image_size = size;
+
+  if (ioctl(fd, KEYSTONE_IOC_CREATE_SHARED_REGION, &region)) {
+    perror("ioctl error");
+    return Error::IoctlErrorCreate;
+  }
+
+  *sharedRegion = region.sid;
+  return Error::Success;
+}
+
+Error
+KeystoneDevice::destroySharedRegion(uintptr_t sharedRegion) {
+  struct keystone_ioctl_shared_region region;
+  region.sid = sharedRegion;
+
+  if (ioctl(fd, KEYSTONE_IOC_DESTROY_SHARED_REGION, &region)) {
+    perror("ioctl error");
+    return Error::IoctlErrorDestroy;
+  }
+  return Error::Success;
+}
+
 Error
 KeystoneDevice::__run(bool resume, uintptr_t* ret) {
   struct keystone_ioctl_run_enclave encl;
@@ -94,20 +126,26 @@ KeystoneDevice::__run(bool resume, uintptr_t* ret) {
     return error;
   }
 
-  switch (encl.error) {
+  return runResult(&encl, error, resume ? "resume" : "run", ret);
+}
+
+Error
+KeystoneDevice::runResult(
+    struct keystone_ioctl_run_enclave* encl, Error error, const char* op,
+    uintptr_t* ret) {
+  stopTicks = encl->stop_ticks;
+  switch (encl->error) {
     case SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST:
       return Error::EdgeCallHost;
     case SBI_ERR_SM_ENCLAVE_INTERRUPTED:
       return Error::EnclaveInterrupted;
     case SBI_ERR_SM_ENCLAVE_SUCCESS:
       if (ret) {
-        *ret = encl.value;
+        *ret = encl->value;
       }
       return Error::Success;
     default:
-      ERROR(
-          "Unknown SBI error (%d) returned by %s_enclave\n", encl.error,
-          resume ? "resume" : "run");
+      ERROR("Unknown SBI error (%d) returned by %s_enclave\n", encl->error, op);
       return error;
   }
 }
@@ -122,6 +160,35 @@ KeystoneDevice::resume(uintptr_t* ret) {
   return __run(true, ret);
 }
 
+Error
+KeystoneDevice::runAsync(bool resume) {
+  struct keystone_ioctl_run_enclave encl;
+  encl.eid = eid;
+
+  if (ioctl(
+          fd,
+          resume ? KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC
+                 : KEYSTONE_IOC_RUN_ENCLAVE_ASYNC,
+          &encl)) {
+    perror("ioctl error");
+    return resume ? Error::IoctlErrorResume : Error::IoctlErrorRun;
+  }
+  return Error::Success;
+}
+
+Error
+KeystoneDevice::getEvent(uintptr_t* ret) {
+  struct keystone_ioctl_run_enclave encl;
+  encl.eid = eid;
+
+  if (ioctl(fd, KEYSTONE_IOC_ENCLAVE_EVENT, &encl)) {
+    perror("ioctl error");
+    return Error::IoctlErrorRun;
+  }
+
+  return runResult(&encl, Error::IoctlErrorRun, "async", ret);
+}
+
 void*
 KeystoneDevice::map(uintptr_t addr, size_t size) {
   assert(fd >= 0);
@@ -156,7 +223,19 @@ MockKeystoneDevice::initUTM(size_t size) {
 Error
 MockKeystoneDevice::finalize(
     uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-    uintptr_t freeRequested) {
+    uintptr_t freeRequested, uintptr_t sharedRegion) {
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::createSharedRegion(
+    const void* image, size_t size, uintptr_t* sharedRegion) {
+  *sharedRegion = 0;
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::destroySharedRegion(uintptr_t sharedRegion) {
   return Error::Success;
 }
 
@@ -175,6 +254,16 @@ MockKeystoneDevice::resume(uintptr_t* ret) {
   return Error::Success;
 }
 
+Error
+MockKeystoneDevice::runAsync(bool resume) {
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::getEvent(uintptr_t* ret) {
+  return Error::Success;
+}
+
 bool
 MockKeystoneDevice::initDevice(Params params) {
   return true;
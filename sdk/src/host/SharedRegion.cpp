@@ -0,0 +1,97 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "SharedRegion.hpp"
+#include "ElfFile.hpp"
+#include "hash_util.hpp"
+
+namespace Keystone {
+
+SharedRegion::SharedRegion() {
+  pDevice = NULL;
+  id      = SHARED_REGION_NONE;
+}
+
+SharedRegion::~SharedRegion() {
+  destroy();
+}
+
+/* Matches the hash the SM computes when the region is created:
+ * the page-rounded size followed by every (zero-padded) page */
+Error
+SharedRegion::measure(char* hash, const char* eapppath) {
+  hash_ctx_t hash_ctx;
+  ElfFile* eapp = new ElfFile(eapppath);
+
+  if (!eapp->getPtr()) {
+    delete eapp;
+    return Error::FileInitFailure;
+  }
+
+  uintptr_t fptr = (uintptr_t)eapp->getPtr();
+  uintptr_t fend = fptr + (uintptr_t)eapp->getFileSize();
+  uintptr_t size = PAGE_UP(eapp->getFileSize());
+
+  hash_init(&hash_ctx);
+  hash_extend(&hash_ctx, (void*)&size, sizeof(size));
+  for (; fptr < fend; fptr += PAGE_SIZE) {
+    if (fend - fptr < PAGE_SIZE) {
+      char page[PAGE_SIZE];
+      memset(page, 0, PAGE_SIZE);
+      memcpy(page, (const void*)fptr, (size_t)(fend - fptr));
+      hash_extend_page(&hash_ctx, (void*)page);
+    } else {
+      hash_extend_page(&hash_ctx, (void*)fptr);
+    }
+  }
+  hash_finalize(hash, &hash_ctx);
+
+  delete eapp;
+  return Error::Success;
+}
+
+Error
+SharedRegion::init(const char* eapppath) {
+  Params params;
+  ElfFile* eapp = new ElfFile(eapppath);
+
+  if (!eapp->getPtr()) {
+    delete eapp;
+    return Error::FileInitFailure;
+  }
+
+  pDevice = new KeystoneDevice();
+  if (!pDevice->initDevice(params)) {
+    delete eapp;
+    return Error::DeviceInitFailure;
+  }
+
+  Error ret =
+      pDevice->createSharedRegion(eapp->getPtr(), eapp->getFileSize(), &id);
+  delete eapp;
+
+  if (ret != Error::Success) {
+    id = SHARED_REGION_NONE;
+  }
+  return ret;
+}
+
+Error
+SharedRegion::destroy() {
+  Error ret = Error::Success;
+
+  if (id != SHARED_REGION_NONE) {
+    ret = pDevice->destroySharedRegion(id);
+    if (ret != Error::Success) {
+      return ret;
+    }
+    id = SHARED_REGION_NONE;
+  }
+
+  delete pDevice;
+  pDevice = NULL;
+  return ret;
+}
+
+}  // namespace Keystone
@@ -0,0 +1,206 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifdef KEYSTONE_SIM
+#include <dlfcn.h>
+#include <sys/eventfd.h>
+
+#include "KeystoneDevice.hpp"
+#include "shared/time_page.h"
+
+namespace Keystone {
+
+SimulatedKeystoneDevice::SimulatedKeystoneDevice(const char* eapppath)
+    : eappPath(eapppath) {
+  handle       = NULL;
+  entry        = NULL;
+  simRun       = NULL;
+  sharedBuffer = NULL;
+  state        = State::Idle;
+  destroying   = false;
+  retval       = 0;
+  eventFd      = -1;
+}
+
+SimulatedKeystoneDevice::~SimulatedKeystoneDevice() {
+  destroy();
+}
+
+bool
+SimulatedKeystoneDevice::initDevice(Params params) {
+  handle = dlopen(eappPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    ERROR("cannot load simulated eapp: %s", dlerror());
+    return false;
+  }
+
+  entry = reinterpret_cast<int (*)(int, char**)>(dlsym(handle, "main"));
+  if (!entry) {
+    ERROR("simulated eapp %s has no main()", eappPath.c_str());
+    return false;
+  }
+  /* only there if the eapp uses the SDK app library */
+  simRun = reinterpret_cast<keystone_sim_run_t>(dlsym(handle, KEYSTONE_SIM_RUN));
+
+  eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  return eventFd >= 0;
+}
+
+Error
+SimulatedKeystoneDevice::create(uint64_t minPages) {
+  eid = -1;
+  return Error::Success;
+}
+
+uintptr_t
+SimulatedKeystoneDevice::initUTM(size_t size) {
+  return 0;
+}
+
+Error
+SimulatedKeystoneDevice::finalize(
+    uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
+    uintptr_t freeRequested, uintptr_t sharedRegion) {
+  return Error::Success;
+}
+
+Error
+SimulatedKeystoneDevice::createSharedRegion(
+    const void* image, size_t size, uintptr_t* sharedRegion) {
+  *sharedRegion = 0;
+  return Error::Success;
+}
+
+Error
+SimulatedKeystoneDevice::destroySharedRegion(uintptr_t sharedRegion) {
+  return Error::Success;
+}
+
+void*
+SimulatedKeystoneDevice::map(uintptr_t addr, size_t size) {
+  sharedBuffer = calloc(size, 1);
+  if (!sharedBuffer) return NULL;
+
+  /* the eapp sees the buffer the way Eyrie does, see Enclave::mapUntrusted */
+  ctx.shared_buffer = sharedBuffer;
+  ctx.shared_size   = size;
+  if (size >= 2 * KEYSTONE_TIME_PAGE_SIZE)
+    ctx.shared_size -= KEYSTONE_TIME_PAGE_SIZE;
+  ctx.stop   = stop;
+  ctx.device = this;
+  return sharedBuffer;
+}
+
+void
+SimulatedKeystoneDevice::setState(State next) {
+  uint64_t one = 1;
+
+  std::lock_guard<std::mutex> guard(lock);
+  state = next;
+  cond.notify_all();
+  if (next != State::Running && write(eventFd, &one, sizeof(one)) < 0)
+    PERROR("cannot signal the poll fd");
+}
+
+/* called on the eapp thread for every edge call */
+int
+SimulatedKeystoneDevice::stop(void* device) {
+  SimulatedKeystoneDevice* self = static_cast<SimulatedKeystoneDevice*>(device);
+
+  self->setState(State::Stopped);
+
+  std::unique_lock<std::mutex> guard(self->lock);
+  self->cond.wait(guard, [self] { return self->state == State::Running; });
+  return self->destroying ? 1 : 0;
+}
+
+void
+SimulatedKeystoneDevice::threadMain() {
+  char* argv[] = {const_cast<char*>(eappPath.c_str()), NULL};
+
+  if (simRun)
+    retval = simRun(&ctx, entry, 1, argv);
+  else
+    retval = entry(1, argv);
+  setState(State::Exited);
+}
+
+/* waits for the eapp to stop and reports why, like the driver */
+Error
+SimulatedKeystoneDevice::result(uintptr_t* ret) {
+  uint64_t events;
+
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    cond.wait(guard, [this] { return state != State::Running; });
+  }
+  if (read(eventFd, &events, sizeof(events)) < 0 && errno != EAGAIN)
+    return Error::DeviceError;
+
+  if (state == State::Stopped) return Error::EdgeCallHost;
+
+  thread.join();
+  if (ret) *ret = retval;
+  return Error::Success;
+}
+
+Error
+SimulatedKeystoneDevice::runAsync(bool resume) {
+  if (!resume) {
+    if (state != State::Idle || !entry || !sharedBuffer) return Error::DeviceError;
+    setState(State::Running);
+    thread = std::thread(&SimulatedKeystoneDevice::threadMain, this);
+    return Error::Success;
+  }
+
+  if (state != State::Stopped) return Error::DeviceError;
+  setState(State::Running);
+  return Error::Success;
+}
+
+Error
+SimulatedKeystoneDevice::getEvent(uintptr_t* ret) {
+  return result(ret);
+}
+
+Error
+SimulatedKeystoneDevice::run(uintptr_t* ret) {
+  Error error = runAsync(false);
+  return error == Error::Success ? result(ret) : error;
+}
+
+Error
+SimulatedKeystoneDevice::resume(uintptr_t* ret) {
+  Error error = runAsync(true);
+  return error == Error::Success ? result(ret) : error;
+}
+
+Error
+SimulatedKeystoneDevice::destroy() {
+  /* an eapp stopped in an edge call exits from it */
+  if (thread.joinable()) {
+    std::unique_lock<std::mutex> guard(lock);
+    destroying = true;
+    if (state == State::Stopped) {
+      state = State::Running;
+      cond.notify_all();
+    }
+    guard.unlock();
+    thread.join();
+  }
+  state = State::Idle;
+
+  if (handle) dlclose(handle);
+  if (sharedBuffer) free(sharedBuffer);
+  if (eventFd >= 0) close(eventFd);
+  handle       = NULL;
+  entry        = NULL;
+  sharedBuffer = NULL;
+  eventFd      = -1;
+  return Error::Success;
+}
+
+}  // namespace Keystone
+
+#endif /* KEYSTONE_SIM */
@@ -0,0 +1,220 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <ReportVerifier.hpp>
+#include <cstring>
+#include "ed25519/ed25519.h"
+
+ReportVerifier::ReportVerifier(size_t cache_size)
+    : cache_size(cache_size), hits(0), misses(0) {}
+
+/* The signature is part of the key, so that a cached SM report passes only
+ * with the signature that was checked, as without the cache */
+std::string
+ReportVerifier::smKey(const Report& report, const byte* dev_public_key) {
+  std::string key(reinterpret_cast<const char*>(dev_public_key), PUBLIC_KEY_SIZE);
+  key.append(
+      reinterpret_cast<const char*>(&report.report.sm),
+      sizeof(struct sm_report_t));
+  return key;
+}
+
+bool
+ReportVerifier::isCached(const std::string& key) {
+  auto entry = cache.find(key);
+
+  if (entry == cache.end()) {
+    misses++;
+    return false;
+  }
+  lru.splice(lru.begin(), lru, entry->second);
+  hits++;
+  return true;
+}
+
+void
+ReportVerifier::addToCache(const std::string& key) {
+  if (!cache_size || cache.count(key)) return;
+
+  if (cache.size() == cache_size) {
+    cache.erase(lru.back());
+    lru.pop_back();
+  }
+  lru.push_front(key);
+  cache[key] = lru.begin();
+}
+
+static bool
+dataLengthValid(const struct report_t& report) {
+  return report.enclave.data_len <= ATTEST_DATA_MAXLEN;
+}
+
+static size_t
+enclaveSignedSize(const struct report_t& report) {
+  return MDSIZE + sizeof(uint64_t) + report.enclave.data_len;
+}
+
+int
+ReportVerifier::checkSignaturesOnly(
+    const Report& report, const byte* dev_public_key) {
+  const struct report_t& r = report.report;
+  std::string key          = smKey(report, dev_public_key);
+  bool sm_cached;
+
+  if (!dataLengthValid(r)) return 0;
+
+  {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    sm_cached = isCached(key);
+  }
+
+  if (!sm_cached) {
+    if (!ed25519_verify(
+            r.sm.signature, reinterpret_cast<const byte*>(&r.sm),
+            MDSIZE + PUBLIC_KEY_SIZE, dev_public_key))
+      return 0;
+    std::lock_guard<std::mutex> lock(cache_lock);
+    addToCache(key);
+  }
+
+  return ed25519_verify(
+      r.enclave.signature, reinterpret_cast<const byte*>(&r.enclave),
+      enclaveSignedSize(r), r.sm.public_key);
+}
+
+int
+ReportVerifier::verify(
+    const Report& report, const byte* expected_enclave_hash,
+    const byte* expected_sm_hash, const byte* dev_public_key) {
+  if (memcmp(expected_enclave_hash, report.report.enclave.hash, MDSIZE) ||
+      memcmp(expected_sm_hash, report.report.sm.hash, MDSIZE))
+    return 0;
+  return checkSignaturesOnly(report, dev_public_key);
+}
+
+int
+ReportVerifier::checkSignaturesOnly(
+    const std::vector<const Report*>& reports, const byte* dev_public_key,
+    std::vector<int>* valid) {
+  size_t n = reports.size();
+  std::vector<std::string> keys(n);
+  /* for each report, the SM report to check, or -1 if it is cached */
+  std::vector<long> sm_of(n, -1);
+  std::unordered_map<std::string, size_t> sm_index;
+  std::vector<const struct report_t*> sm_reports;
+  std::vector<int> sm_valid;
+  std::vector<const byte*> signatures, messages, public_keys;
+  std::vector<size_t> message_lens;
+  std::vector<int> sig_valid;
+  size_t enclave_sig = 0, i;
+  int all = 1;
+
+  valid->assign(n, 0);
+
+  /* the uncached SM reports, each once */
+  {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    for (i = 0; i < n; i++) {
+      const struct report_t& r = reports[i]->report;
+
+      keys[i] = smKey(*reports[i], dev_public_key);
+      if (!dataLengthValid(r) || isCached(keys[i])) continue;
+
+      auto found = sm_index.find(keys[i]);
+      if (found != sm_index.end()) {
+        sm_of[i] = found->second;
+        continue;
+      }
+      sm_of[i] = sm_index[keys[i]] = sm_reports.size();
+      sm_reports.push_back(&r);
+    }
+  }
+
+  /* SM signatures are checked one by one, as the batch check can accept
+   * signatures that ed25519_verify() rejects and the cache would keep
+   * such an SM report for good. There are few, one per device boot. */
+  for (const struct report_t* r : sm_reports) {
+    sm_valid.push_back(ed25519_verify(
+        r->sm.signature, reinterpret_cast<const byte*>(&r->sm),
+        MDSIZE + PUBLIC_KEY_SIZE, dev_public_key));
+  }
+
+  for (i = 0; i < n; i++) {
+    const struct report_t& r = reports[i]->report;
+
+    if (!dataLengthValid(r)) continue;
+    signatures.push_back(r.enclave.signature);
+    messages.push_back(reinterpret_cast<const byte*>(&r.enclave));
+    message_lens.push_back(enclaveSignedSize(r));
+    public_keys.push_back(r.sm.public_key);
+  }
+
+  sig_valid.resize(signatures.size());
+  ed25519_verify_batch(
+      signatures.data(), messages.data(), message_lens.data(),
+      public_keys.data(), signatures.size(), sig_valid.data());
+
+  {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    for (auto& sm : sm_index)
+      if (sm_valid[sm.second]) addToCache(sm.first);
+  }
+
+  for (i = 0; i < n; i++) {
+    const struct report_t& r = reports[i]->report;
+
+    if (dataLengthValid(r)) {
+      (*valid)[i] =
+          sig_valid[enclave_sig++] && (sm_of[i] < 0 || sm_valid[sm_of[i]]);
+    }
+    all &= (*valid)[i];
+  }
+  return all;
+}
+
+int
+ReportVerifier::verify(
+    const std::vector<const Report*>& reports,
+    const byte* expected_enclave_hash, const byte* expected_sm_hash,
+    const byte* dev_public_key, std::vector<int>* valid) {
+  std::vector<const Report*> matching;
+  std::vector<size_t> index;
+  std::vector<int> matching_valid;
+  size_t i;
+  int all = 1;
+
+  for (i = 0; i < reports.size(); i++) {
+    if (!memcmp(expected_enclave_hash, reports[i]->report.enclave.hash, MDSIZE) &&
+        !memcmp(expected_sm_hash, reports[i]->report.sm.hash, MDSIZE)) {
+      matching.push_back(reports[i]);
+      index.push_back(i);
+    } else {
+      all = 0;
+    }
+  }
+
+  valid->assign(reports.size(), 0);
+  all &= checkSignaturesOnly(matching, dev_public_key, &matching_valid);
+  for (i = 0; i < matching.size(); i++) (*valid)[index[i]] = matching_valid[i];
+  return all;
+}
+
+size_t
+ReportVerifier::getCacheHits() {
+  std::lock_guard<std::mutex> lock(cache_lock);
+  return hits;
+}
+
+size_t
+ReportVerifier::getCacheMisses() {
+  std::lock_guard<std::mutex> lock(cache_lock);
+  return misses;
+}
+
+void
+ReportVerifier::clearCache() {
+  std::lock_guard<std::mutex> lock(cache_lock);
+  cache.clear();
+  lru.clear();
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+#include "common/sha3.h"
+#include "ed25519/ed25519.h"
+#include "ed25519/ge.h"
+#include "ed25519/sc.h"
+
+/*
+Batch verification: with random z_i, every signature (R_i, s_i) on m_i
+under A_i is valid iff
+
+  (sum z_i s_i) B - sum z_i R_i - sum (z_i h_i) A_i = 0
+
+up to a chance of 2^-128, which is checked with one multi-scalar
+multiplication whose doublings all signatures share. Signatures under the
+same key share its term. A batch that fails is verified one by one to
+find the culprits.
+
+The z_i are 128 bits of a hash over the whole batch, so they are fixed only
+once every signature in it is. As with other batch verifiers, a signer can
+make a signature that is off by a small-order point and passes in some
+batches but not on its own; only the holder of the key can do that.
+*/
+
+#define BATCH_SIZE 64
+
+struct batch {
+  size_t n, keys;
+  size_t index[BATCH_SIZE];
+  size_t key_of[BATCH_SIZE];
+  unsigned char h[BATCH_SIZE][64];
+  /* -R_0..-R_n-1, then -A for each key */
+  ge_p3 points[2 * BATCH_SIZE];
+  unsigned char scalars[2 * BATCH_SIZE][32];
+  ge_cached tables[2 * BATCH_SIZE][8];
+  signed char slides[2 * BATCH_SIZE][256];
+  const unsigned char* key_bytes[BATCH_SIZE];
+};
+
+/* the encodings ge_tobytes() produces: y < p, and no sign on x = 0 */
+static int
+canonical_point(const unsigned char* s) {
+  static const unsigned char one[32] = {1};
+  static const unsigned char minus_one[32] = {
+      0xec, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f};
+  unsigned char y[32];
+  int i;
+
+  memcpy(y, s, 32);
+  y[31] &= 0x7f;
+  /* p = 2^255 - 19 */
+  if (y[31] == 0x7f && y[0] >= 0xed) {
+    for (i = 1; i < 31 && y[i] == 0xff; ++i)
+      ;
+    if (i == 31) return 0;
+  }
+  if ((s[31] & 0x80) && (!memcmp(y, one, 32) || !memcmp(y, minus_one, 32)))
+    return 0;
+  return 1;
+}
+
+static int
+is_identity(const ge_p2* p) {
+  fe t;
+
+  fe_sub(t, p->Y, p->Z);
+  return !fe_isnonzero(p->X) && !fe_isnonzero(t);
+}
+
+/* verifies the signatures in b at once; returns 1 if they are all valid */
+static int
+batch_check(
+    struct batch* b, const unsigned char* const* signatures) {
+  unsigned char seed[64], z[64], b_scalar[32];
+  sha3_ctx_t hash;
+  size_t i, k;
+  ge_p2 r;
+
+  sha3_init(&hash, 64);
+  for (i = 0; i < b->n; ++i) {
+    sha3_update(&hash, b->h[i], 64);
+    sha3_update(&hash, signatures[b->index[i]] + 32, 32);
+  }
+  sha3_final(seed, &hash);
+
+  memset(b_scalar, 0, 32);
+  for (k = 0; k < b->keys; ++k) memset(b->scalars[b->n + k], 0, 32);
+
+  for (i = 0; i < b->n; ++i) {
+    unsigned char counter[8];
+    size_t j = i;
+
+    for (k = 0; k < 8; ++k, j >>= 8) counter[k] = j;
+    sha3_init(&hash, 64);
+    sha3_update(&hash, seed, 64);
+    sha3_update(&hash, counter, 8);
+    sha3_final(z, &hash);
+    memset(z + 16, 0, 16);
+
+    /* -R_i gets z_i, B gets sum z_i s_i and -A gets sum z_i h_i */
+    memcpy(b->scalars[i], z, 32);
+    sc_muladd(b_scalar, z, signatures[b->index[i]] + 32, b_scalar);
+    k = b->n + b->key_of[i];
+    sc_muladd(b->scalars[k], z, b->h[i], b->scalars[k]);
+  }
+
+  ge_multi_scalarmult_vartime(
+      &r, b_scalar, (const unsigned char(*)[32])b->scalars, b->points,
+      b->n + b->keys, b->tables, b->slides);
+  return is_identity(&r);
+}
+
+int
+ed25519_verify_batch(
+    const unsigned char* const* signatures,
+    const unsigned char* const* messages, const size_t* message_lens,
+    const unsigned char* const* public_keys, size_t count, int* valid) {
+  struct batch* b = malloc(sizeof(*b));
+  size_t start, i, k;
+  int all = 1;
+
+  for (start = 0; start < count; start += BATCH_SIZE) {
+    size_t end = count - start < BATCH_SIZE ? count : start + BATCH_SIZE;
+
+    if (b) {
+      b->n    = 0;
+      b->keys = 0;
+    }
+    for (i = start; i < end; ++i) {
+      const unsigned char* sig = signatures[i];
+      sha3_ctx_t hash;
+      size_t n;
+
+      valid[i] = 0;
+      if (!b) continue;
+
+      n = b->n;
+      if ((sig[63] & 224) || !canonical_point(sig) ||
+          ge_frombytes_negate_vartime(&b->points[n], sig) != 0)
+        continue;
+
+      /* keys are mostly the same, so a lookup beats decoding them */
+      for (k = 0; k < b->keys; ++k)
+        if (!memcmp(b->key_bytes[k], public_keys[i], 32)) break;
+      if (k == b->keys) {
+        /* the key points go after all of the R points */
+        if (ge_frombytes_negate_vartime(
+                &b->points[BATCH_SIZE + k], public_keys[i]) != 0)
+          continue;
+        b->key_bytes[k] = public_keys[i];
+        b->keys++;
+      }
+
+      sha3_init(&hash, 64);
+      sha3_update(&hash, sig, 32);
+      sha3_update(&hash, public_keys[i], 32);
+      sha3_update(&hash, messages[i], message_lens[i]);
+      sha3_final(b->h[n], &hash);
+      sc_reduce(b->h[n]);
+
+      b->index[n]  = i;
+      b->key_of[n] = k;
+      b->n++;
+    }
+
+    if (!b) {
+      for (i = start; i < end; ++i) {
+        valid[i] = ed25519_verify(
+            signatures[i], messages[i], message_lens[i], public_keys[i]);
+        all &= valid[i];
+      }
+      continue;
+    }
+
+    /* the rest would not verify on their own either */
+    if (b->n != end - start) all = 0;
+    if (!b->n) continue;
+
+    /* the key points follow the R points directly */
+    memmove(&b->points[b->n], &b->points[BATCH_SIZE], b->keys * sizeof(ge_p3));
+    if (batch_check(b, signatures)) {
+      for (i = 0; i < b->n; ++i) valid[b->index[i]] = 1;
+      continue;
+    }
+
+    /* somewhere in here is a bad signature */
+    for (i = 0; i < b->n; ++i) {
+      size_t j = b->index[i];
+      valid[j] = ed25519_verify(
+          signatures[j], messages[j], message_lens[j], public_keys[j]);
+      all &= valid[j];
+    }
+  }
+
+  free(b);
+  return all;
+}
@@ -57,6 +57,28 @@ slide(signed char* r, const unsigned char* a) {
     }
 }
 
+/*
+Ai = A,3A,5A,...,15A
+*/
+
+static void
+odd_multiples(ge_cached* Ai, const ge_p3* A) {
+  ge_p1p1 t;
+  ge_p3 u;
+  ge_p3 A2;
+  int i;
+
+  ge_p3_to_cached(&Ai[0], A);
+  ge_p3_dbl(&t, A);
+  ge_p1p1_to_p3(&A2, &t);
+
+  for (i = 1; i < 8; i++) {
+    ge_add(&t, &A2, &Ai[i - 1]);
+    ge_p1p1_to_p3(&u, &t);
+    ge_p3_to_cached(&Ai[i], &u);
+  }
+}
+
 /*
 r = a * A + b * B
 where a = a[0]+256*a[1]+...+256^31 a[31].
@@ -72,34 +94,10 @@ ge_double_scalarmult_vartime(
   ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
   ge_p1p1 t;
   ge_p3 u;
-  ge_p3 A2;
   int i;
   slide(aslide, a);
   slide(bslide, b);
-  ge_p3_to_cached(&Ai[0], A);
-  ge_p3_dbl(&t, A);
-  ge_p1p1_to_p3(&A2, &t);
-  ge_add(&t, &A2, &Ai[0]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[1], &u);
-  ge_add(&t, &A2, &Ai[1]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[2], &u);
-  ge_add(&t, &A2, &Ai[2]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[3], &u);
-  ge_add(&t, &A2, &Ai[3]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[4], &u);
-  ge_add(&t, &A2, &Ai[4]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[5], &u);
-  ge_add(&t, &A2, &Ai[5]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[6], &u);
-  ge_add(&t, &A2, &Ai[6]);
-  ge_p1p1_to_p3(&u, &t);
-  ge_p3_to_cached(&Ai[7], &u);
+  odd_multiples(Ai, A);
   ge_p2_0(r);
 
   for (i = 255; i >= 0; --i) {
@@ -131,6 +129,60 @@ ge_double_scalarmult_vartime(
   }
 }
 
+/*
+r = b * B + a[0] * A[0] + ... + a[n-1] * A[n-1]
+where each a[i] is 32 bytes as above, all doublings are shared, and
+Ai holds 8 * n and aslide 256 * n entries of scratch.
+*/
+
+void
+ge_multi_scalarmult_vartime(
+    ge_p2* r, const unsigned char* b, const unsigned char (*a)[32],
+    const ge_p3* A, size_t n, ge_cached (*Ai)[8], signed char (*aslide)[256]) {
+  signed char bslide[256];
+  ge_p1p1 t;
+  ge_p3 u;
+  size_t j;
+  int i, top;
+
+  slide(bslide, b);
+  for (i = 255; i >= 0 && !bslide[i]; --i)
+    ;
+  top = i;
+  for (j = 0; j < n; j++) {
+    slide(aslide[j], a[j]);
+    odd_multiples(Ai[j], &A[j]);
+    for (i = 255; i > top && !aslide[j][i]; --i)
+      ;
+    top = i;
+  }
+
+  ge_p2_0(r);
+  for (i = top; i >= 0; --i) {
+    ge_p2_dbl(&t, r);
+
+    for (j = 0; j < n; j++) {
+      if (aslide[j][i] > 0) {
+        ge_p1p1_to_p3(&u, &t);
+        ge_add(&t, &u, &Ai[j][aslide[j][i] / 2]);
+      } else if (aslide[j][i] < 0) {
+        ge_p1p1_to_p3(&u, &t);
+        ge_sub(&t, &u, &Ai[j][(-aslide[j][i]) / 2]);
+      }
+    }
+
+    if (bslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+    } else if (bslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+    }
+
+    ge_p1p1_to_p2(r, &t);
+  }
+}
+
 static const fe d = {-10913610, 13857413, -15372611, 6949391,   114729,
                      -8787816,  -6275908, -3247719,  -18696448, -12055116};
 
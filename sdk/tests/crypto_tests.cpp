@@ -0,0 +1,264 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "gtest/gtest.h"
+extern "C" {
+#include "common/chacha20poly1305.h"
+#include "common/hkdf_sha3_512.h"
+#include "common/sha3.h"
+}
+
+/* Test vectors from RFC 8439 */
+
+static std::vector<uint8_t>
+from_hex(const char* hex) {
+  std::vector<uint8_t> bytes;
+  for (; hex[0] && hex[1]; hex += 2) {
+    unsigned int byte;
+    sscanf(hex, "%2x", &byte);
+    bytes.push_back(byte);
+  }
+  return bytes;
+}
+
+static const char sunscreen[] =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+    "tip for the future, sunscreen would be it.";
+
+TEST(ChaCha20, Encrypt) {
+  // section 2.4.2
+  std::vector<uint8_t> key = from_hex(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+  std::vector<uint8_t> nonce = from_hex("000000000000004a00000000");
+  std::vector<uint8_t> expected = from_hex(
+      "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+      "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+      "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+      "5af90bbf74a35be6b40b8eedf2785e42874d");
+  std::vector<uint8_t> out(sizeof(sunscreen) - 1);
+
+  chacha20_xor(
+      key.data(), nonce.data(), 1, (const uint8_t*)sunscreen, out.data(),
+      out.size());
+  EXPECT_EQ(out, expected);
+
+  // in place, and from an odd offset
+  std::vector<uint8_t> buf(out.size() + 1);
+  memcpy(buf.data() + 1, sunscreen, out.size());
+  chacha20_xor(
+      key.data(), nonce.data(), 1, buf.data() + 1, buf.data() + 1,
+      out.size());
+  EXPECT_EQ(0, memcmp(buf.data() + 1, expected.data(), out.size()));
+}
+
+TEST(Poly1305, Tag) {
+  // section 2.5.2
+  std::vector<uint8_t> key = from_hex(
+      "85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+  std::vector<uint8_t> expected =
+      from_hex("a8061dc1305136c6c22b8baf0c0127a9");
+  const char msg[] = "Cryptographic Forum Research Group";
+  uint8_t tag[16];
+  poly1305_ctx_t ctx;
+
+  poly1305_init(&ctx, key.data());
+  poly1305_update(&ctx, (const uint8_t*)msg, sizeof(msg) - 1);
+  poly1305_final(&ctx, tag);
+  EXPECT_EQ(0, memcmp(tag, expected.data(), 16));
+
+  // the same, fed in pieces
+  poly1305_init(&ctx, key.data());
+  poly1305_update(&ctx, (const uint8_t*)msg, 5);
+  poly1305_update(&ctx, (const uint8_t*)msg + 5, 17);
+  poly1305_update(&ctx, (const uint8_t*)msg + 22, sizeof(msg) - 23);
+  poly1305_final(&ctx, tag);
+  EXPECT_EQ(0, memcmp(tag, expected.data(), 16));
+}
+
+class ChaCha20Poly1305 : public ::testing::Test {
+ protected:
+  // section 2.8.2
+  std::vector<uint8_t> key = from_hex(
+      "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+  std::vector<uint8_t> nonce = from_hex("070000004041424344454647");
+  std::vector<uint8_t> aad   = from_hex("50515253c0c1c2c3c4c5c6c7");
+  std::vector<uint8_t> ciphertext = from_hex(
+      "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+      "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+      "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+      "3ff4def08e4b7a9de576d26586cec64b6116");
+  std::vector<uint8_t> tag = from_hex("1ae10b594f09e26a7e902ecbd0600691");
+};
+
+TEST_F(ChaCha20Poly1305, Encrypt) {
+  std::vector<uint8_t> out(ciphertext.size());
+  uint8_t out_tag[16];
+
+  chacha20poly1305_encrypt(
+      key.data(), nonce.data(), aad.data(), aad.size(),
+      (const uint8_t*)sunscreen, out.size(), out.data(), out_tag);
+  EXPECT_EQ(out, ciphertext);
+  EXPECT_EQ(0, memcmp(out_tag, tag.data(), 16));
+}
+
+TEST_F(ChaCha20Poly1305, Decrypt) {
+  std::vector<uint8_t> out(ciphertext.size());
+
+  ASSERT_EQ(
+      0, chacha20poly1305_decrypt(
+             key.data(), nonce.data(), aad.data(), aad.size(),
+             ciphertext.data(), ciphertext.size(), tag.data(), out.data()));
+  EXPECT_EQ(0, memcmp(out.data(), sunscreen, out.size()));
+}
+
+TEST_F(ChaCha20Poly1305, Forgeries) {
+  std::vector<uint8_t> out(ciphertext.size(), 0xaa);
+  std::vector<uint8_t> untouched(out);
+
+  ciphertext[10] ^= 1;
+  EXPECT_EQ(
+      -1, chacha20poly1305_decrypt(
+              key.data(), nonce.data(), aad.data(), aad.size(),
+              ciphertext.data(), ciphertext.size(), tag.data(), out.data()));
+  ciphertext[10] ^= 1;
+
+  aad[0] ^= 1;
+  EXPECT_EQ(
+      -1, chacha20poly1305_decrypt(
+              key.data(), nonce.data(), aad.data(), aad.size(),
+              ciphertext.data(), ciphertext.size(), tag.data(), out.data()));
+  aad[0] ^= 1;
+
+  tag[15] ^= 0x80;
+  EXPECT_EQ(
+      -1, chacha20poly1305_decrypt(
+              key.data(), nonce.data(), aad.data(), aad.size(),
+              ciphertext.data(), ciphertext.size(), tag.data(), out.data()));
+  tag[15] ^= 0x80;
+
+  EXPECT_EQ(
+      -1, chacha20poly1305_decrypt(
+              key.data(), nonce.data(), aad.data(), aad.size(),
+              ciphertext.data(), ciphertext.size() - 1, tag.data(),
+              out.data()));
+
+  // out is only written once the tag matches
+  EXPECT_EQ(out, untouched);
+}
+
+TEST(HKDF_SHA3_512, ExtractExpand) {
+  // the inputs of RFC 5869 test case 1, with SHA3-512
+  std::vector<uint8_t> ikm(22, 0x0b);
+  std::vector<uint8_t> salt = from_hex("000102030405060708090a0b0c");
+  std::vector<uint8_t> info = from_hex("f0f1f2f3f4f5f6f7f8f9");
+  std::vector<uint8_t> expected_prk = from_hex(
+      "e1c543094f64f3d6c6658a94a94e3818ba13d0b3e77074b80f88f32e6b8433b7"
+      "03536cb500753967fae2ea977e11e4dd4f45389807cdf255b395e46807c87d5d");
+  std::vector<uint8_t> expected_okm = from_hex(
+      "40e9f17e9bf2ef99425c2b23ccdf20a018ea5513f9ae68e1ea8c626deb57dfa4"
+      "d56c27ccf2a2a24488a5");
+  std::vector<uint8_t> prk(64), okm(expected_okm.size());
+
+  hkdf_extract(salt.data(), salt.size(), ikm.data(), ikm.size(), prk.data());
+  EXPECT_EQ(prk, expected_prk);
+
+  ASSERT_EQ(
+      0, hkdf_expand(
+             prk.data(), prk.size(), info.data(), info.size(), okm.data(),
+             okm.size()));
+  EXPECT_EQ(okm, expected_okm);
+
+  okm.assign(okm.size(), 0);
+  ASSERT_EQ(
+      0, hkdf_sha3_512(
+             salt.data(), salt.size(), ikm.data(), ikm.size(), info.data(),
+             info.size(), okm.data(), okm.size()));
+  EXPECT_EQ(okm, expected_okm);
+}
+
+static std::vector<uint8_t>
+sha3_of(const void* data, size_t len, int mdlen) {
+  std::vector<uint8_t> md(mdlen);
+  sha3(data, len, md.data(), mdlen);
+  return md;
+}
+
+TEST(SHA3, Vectors) {
+  // FIPS 202 examples
+  EXPECT_EQ(
+      sha3_of("", 0, 28),
+      from_hex("6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7"));
+  EXPECT_EQ(
+      sha3_of("abc", 3, 32),
+      from_hex(
+          "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532"));
+  EXPECT_EQ(
+      sha3_of("abc", 3, 48),
+      from_hex(
+          "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b2"
+          "98d88cea927ac7f539f1edf228376d25"));
+  EXPECT_EQ(
+      sha3_of("", 0, 64),
+      from_hex(
+          "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a6"
+          "15b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26"));
+
+  // 200 bytes of 0xa3: more than a block for both
+  std::vector<uint8_t> a3(200, 0xa3);
+  EXPECT_EQ(
+      sha3_of(a3.data(), a3.size(), 32),
+      from_hex(
+          "79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787"));
+  EXPECT_EQ(
+      sha3_of(a3.data(), a3.size(), 64),
+      from_hex(
+          "e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca8"
+          "1b7c13c30adf52a3659584739a2df46be589c51ca1a4a8416df6545a1ce8ba00"));
+}
+
+TEST(SHA3, Updates) {
+  // lanes at a time when the input lines up, bytes otherwise: the hash has
+  // to be the same however the input is aligned and split
+  std::vector<uint64_t> storage(3 * 4096 / 8 + 2);
+  uint8_t* pages = (uint8_t*)storage.data();
+  std::vector<uint8_t> data(3 * 4096);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 31 + 7;
+
+  for (int mdlen : {32, 64, 17}) {
+    std::vector<uint8_t> expected = sha3_of(data.data(), data.size(), mdlen);
+
+    for (size_t offset = 0; offset < 9; offset++) {
+      memcpy(pages + offset, data.data(), data.size());
+      for (size_t first : {0, 1, 8, 13, 72, 4096}) {
+        sha3_ctx_t ctx;
+        std::vector<uint8_t> md(mdlen);
+
+        sha3_init(&ctx, mdlen);
+        sha3_update(&ctx, pages + offset, first);
+        for (size_t done = first; done < data.size(); done += 4096)
+          sha3_update(
+              &ctx, pages + offset + done,
+              std::min<size_t>(4096, data.size() - done));
+        sha3_final(md.data(), &ctx);
+        EXPECT_EQ(md, expected) << mdlen << " " << offset << " " << first;
+      }
+    }
+
+    sha3_ctx_t ctx;
+    std::vector<uint8_t> md(mdlen);
+    sha3_init(&ctx, mdlen);
+    for (uint8_t byte : data) sha3_update(&ctx, &byte, 1);
+    sha3_final(md.data(), &ctx);
+    EXPECT_EQ(md, expected);
+  }
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
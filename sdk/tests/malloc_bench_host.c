@@ -0,0 +1,55 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Runs examples/tests/malloc/malloc-bench.c as a host program, with the
+ * eapp allocator (BenchMalloc) or tiny-malloc (BenchMallocTiny). This
+ * stands in for the eapp environment: a static zone at __malloc_start, no
+ * mmap as in the tests' runtime, and ocalls that print. The numbers show
+ * how the allocators compare, not how fast they are in an enclave. */
+
+#define BENCH_ZONE_SIZE (64UL << 20)
+
+char __malloc_start[BENCH_ZONE_SIZE] __attribute__((aligned(4096)));
+
+void
+eapp_entry(void);
+
+uintptr_t
+keystone_sim_syscall(
+    uintptr_t which, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2,
+    uintptr_t arg3, uintptr_t arg4) {
+  return -1;
+}
+
+int
+ocall(
+    unsigned long call_id, void* data, size_t data_len, void* return_buffer,
+    size_t return_len) {
+  fputs((const char*)data, stdout);
+  return 0;
+}
+
+void
+EAPP_RETURN(unsigned long rval) {
+  exit(rval);
+}
+
+unsigned long
+read_cycles(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000UL + now.tv_nsec;
+}
+
+int
+main() {
+  eapp_entry();
+  return 0;
+}
@@ -0,0 +1,24 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __MALLOC_BENCH_HOST_H__
+#define __MALLOC_BENCH_HOST_H__
+
+/* Forced into every source of BenchMalloc and BenchMallocTiny, so the
+ * allocator under test does not take the place of the host's malloc */
+#define malloc bench_malloc
+#define free bench_free
+#define realloc bench_realloc
+#define memalign bench_memalign
+#define valloc bench_valloc
+#define pvalloc bench_pvalloc
+#define calloc bench_calloc
+#define cfree bench_cfree
+#define malloc_trim bench_malloc_trim
+#define malloc_usable_size bench_malloc_usable_size
+#define malloc_stats bench_malloc_stats
+#define mallopt bench_mallopt
+#define mallinfo bench_mallinfo
+
+#endif  // __MALLOC_BENCH_HOST_H__
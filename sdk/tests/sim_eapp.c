@@ -0,0 +1,21 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+/* Eapp for sim_tests.cpp, built as a shared object with add_sim_eapp */
+#include <string.h>
+
+#include "syscall.h"
+
+#define OCALL_REVERSE 1
+
+int
+main() {
+  char msg[]   = "keystone";
+  char reply[] = "........";
+
+  if (ocall(OCALL_REVERSE, msg, sizeof(msg), reply, sizeof(reply)) != 0)
+    return 1;
+  return memcmp(reply, "enotsyek", sizeof(reply)) == 0 ? 42 : 2;
+}
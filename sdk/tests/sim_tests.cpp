@@ -0,0 +1,81 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+#include <keystone.h>
+
+#include <cstring>
+#include <utility>
+
+#include "edge/edge_call.h"
+#include "gtest/gtest.h"
+
+#define OCALL_REVERSE 1
+
+using Keystone::Enclave;
+using Keystone::Error;
+using Keystone::Params;
+
+static void
+reverse_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  uintptr_t call_args;
+  size_t args_len;
+
+  if (edge_call_args_ptr(edge_call, &call_args, &args_len) != 0 ||
+      args_len == 0) {
+    edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+    return;
+  }
+
+  char* str = reinterpret_cast<char*>(call_args);
+  size_t len = strnlen(str, args_len - 1);
+  for (size_t i = 0; i < len / 2; i++) std::swap(str[i], str[len - 1 - i]);
+
+  if (edge_call_setup_ret(edge_call, str, args_len)) {
+    edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+  } else {
+    edge_call->return_data.call_status = CALL_STATUS_OK;
+  }
+}
+
+TEST(Simulation, RunsEappInProcess) {
+  /* Runs a host build of sim_eapp.c, which makes one ocall and returns 42
+   * if the host answered it
+   * */
+  Enclave enclave;
+  Params params;
+  uintptr_t retval = 0;
+
+  params.setUntrustedSize(64 * 1024);
+  params.setInProcessSimulation(true);
+
+  ASSERT_EQ(Error::Success, enclave.init(SIM_EAPP, "unused", "unused", params));
+
+  enclave.registerOcallDispatch(incoming_call_dispatch);
+  register_call(OCALL_REVERSE, reverse_wrapper);
+  edge_call_init_internals(
+      (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize());
+
+  EXPECT_EQ(Error::Success, enclave.run(&retval));
+  EXPECT_EQ(42u, retval);
+  EXPECT_EQ(Error::Success, enclave.destroy());
+}
+
+TEST(Simulation, MissingEapp) {
+  Enclave enclave;
+  Params params;
+
+  params.setInProcessSimulation(true);
+
+  EXPECT_EQ(
+      Error::FileInitFailure,
+      enclave.init("fake_file.so", "unused", "unused", params));
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "ReportVerifier.hpp"
+#include "verifier_test_util.hpp"
+
+/* Reports per second checked by Report::checkSignaturesOnly() and by a
+ * ReportVerifier, one at a time, in batches and in batches on all cores.
+ * All reports come from one device, as for a service that a fleet of
+ * enclaves on few devices reports to. */
+
+#define REPORTS 4096
+#define BATCH 64
+
+static TestDevice device(1);
+static std::vector<Report> reports;
+
+static double
+seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static void
+report_rate(const char* what, size_t checked, double seconds) {
+  printf("%-28s %10.0f reports/s\n", what, checked / seconds);
+}
+
+/* checks reports [begin, end) in batches; returns how many passed */
+static size_t
+check_batches(ReportVerifier* verifier, size_t begin, size_t end) {
+  std::vector<const Report*> batch;
+  std::vector<int> valid;
+  size_t passed = 0;
+
+  for (size_t i = begin; i < end; i += BATCH) {
+    batch.clear();
+    for (size_t j = i; j < end && j < i + BATCH; j++) batch.push_back(&reports[j]);
+    verifier->checkSignaturesOnly(batch, device.dev_public_key, &valid);
+    for (int v : valid) passed += v;
+  }
+  return passed;
+}
+
+int
+main() {
+  ReportVerifier verifier;
+  unsigned int threads = std::thread::hardware_concurrency();
+  size_t passed = 0;
+
+  for (int i = 0; i < REPORTS; i++) reports.push_back(device.report(0, i));
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto& report : reports)
+    passed += report.checkSignaturesOnly(device.dev_public_key);
+  report_rate("Report", REPORTS, seconds_since(start));
+
+  start = std::chrono::steady_clock::now();
+  for (auto& report : reports)
+    passed += verifier.checkSignaturesOnly(report, device.dev_public_key);
+  report_rate("ReportVerifier", REPORTS, seconds_since(start));
+
+  start = std::chrono::steady_clock::now();
+  passed += check_batches(&verifier, 0, REPORTS);
+  report_rate("ReportVerifier, batches", REPORTS, seconds_since(start));
+
+  if (!threads) threads = 1;
+  std::vector<std::thread> workers;
+  std::vector<size_t> worker_passed(threads);
+  start = std::chrono::steady_clock::now();
+  for (unsigned int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      worker_passed[t] = check_batches(
+          &verifier, REPORTS * t / threads, REPORTS * (t + 1) / threads);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  double elapsed = seconds_since(start);
+  for (size_t p : worker_passed) passed += p;
+  char what[64];
+  snprintf(what, sizeof(what), "ReportVerifier, %u threads", threads);
+  report_rate(what, REPORTS, elapsed);
+
+  if (passed != 4 * REPORTS) {
+    printf("%zu of %d reports failed\n", 4 * REPORTS - passed, 4 * REPORTS);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <cstring>
+#include "Report.hpp"
+#include "ed25519/ed25519.h"
+
+/* A device, its SM and an enclave with keys made up from a seed, to sign
+ * test reports with */
+class TestDevice {
+ public:
+  enum {
+    SM_SIGNATURE = 1,
+    SM_HASH,
+    SM_PUBLIC_KEY,
+    ENCLAVE_SIGNATURE,
+    ENCLAVE_DATA,
+    TAMPERINGS
+  };
+
+  byte dev_public_key[PUBLIC_KEY_SIZE];
+  byte dev_private_key[64];
+  byte sm_public_key[PUBLIC_KEY_SIZE];
+  byte sm_private_key[64];
+  byte sm_hash[MDSIZE];
+  byte enclave_hash[MDSIZE];
+
+  explicit TestDevice(int seed) {
+    byte key_seed[32];
+
+    memset(key_seed, seed, sizeof(key_seed));
+    ed25519_create_keypair(dev_public_key, dev_private_key, key_seed);
+    key_seed[0] ^= 0xff;
+    ed25519_create_keypair(sm_public_key, sm_private_key, key_seed);
+    memset(sm_hash, 0x50 + seed, MDSIZE);
+    memset(enclave_hash, 0xe0 + seed, MDSIZE);
+  }
+
+  /* A report with nonce as its data, broken as tamper says after signing */
+  Report report(int tamper, int nonce) {
+    struct report_t r;
+    Report report;
+
+    memset(&r, 0, sizeof(r));
+    memcpy(r.sm.hash, sm_hash, MDSIZE);
+    memcpy(r.sm.public_key, sm_public_key, PUBLIC_KEY_SIZE);
+    ed25519_sign(
+        r.sm.signature, reinterpret_cast<byte*>(&r.sm),
+        MDSIZE + PUBLIC_KEY_SIZE, dev_public_key, dev_private_key);
+
+    memcpy(r.enclave.hash, enclave_hash, MDSIZE);
+    r.enclave.data_len = sizeof(nonce);
+    memcpy(r.enclave.data, &nonce, sizeof(nonce));
+    ed25519_sign(
+        r.enclave.signature, reinterpret_cast<byte*>(&r.enclave),
+        MDSIZE + sizeof(uint64_t) + r.enclave.data_len, sm_public_key,
+        sm_private_key);
+    memcpy(r.dev_public_key, dev_public_key, PUBLIC_KEY_SIZE);
+
+    switch (tamper) {
+      case SM_SIGNATURE:
+        r.sm.signature[3] ^= 1;
+        break;
+      case SM_HASH:
+        r.sm.hash[0] ^= 1;
+        break;
+      case SM_PUBLIC_KEY:
+        r.sm.public_key[7] ^= 1;
+        break;
+      case ENCLAVE_SIGNATURE:
+        r.enclave.signature[40] ^= 1;
+        break;
+      case ENCLAVE_DATA:
+        r.enclave.data[0] ^= 1;
+        break;
+    }
+
+    report.fromBytes(reinterpret_cast<byte*>(&r));
+    return report;
+  }
+};
@@ -0,0 +1,158 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "ReportVerifier.hpp"
+#include "gtest/gtest.h"
+#include "verifier_test_util.hpp"
+
+TEST(ReportVerifier, SameAsReport) {
+  TestDevice device(1);
+  ReportVerifier verifier;
+
+  for (int tamper = 0; tamper < TestDevice::TAMPERINGS; tamper++) {
+    Report report = device.report(tamper, tamper);
+    int expected  = report.checkSignaturesOnly(device.dev_public_key);
+
+    EXPECT_EQ(tamper == 0, expected) << tamper;
+    EXPECT_EQ(
+        expected, verifier.checkSignaturesOnly(report, device.dev_public_key))
+        << tamper;
+    // and again, from the cache
+    EXPECT_EQ(
+        expected, verifier.checkSignaturesOnly(report, device.dev_public_key))
+        << tamper;
+  }
+}
+
+TEST(ReportVerifier, CachesSmReports) {
+  TestDevice device(2);
+  ReportVerifier verifier;
+
+  EXPECT_TRUE(verifier.checkSignaturesOnly(device.report(0, 1), device.dev_public_key));
+  EXPECT_EQ(0u, verifier.getCacheHits());
+  EXPECT_EQ(1u, verifier.getCacheMisses());
+
+  EXPECT_TRUE(verifier.checkSignaturesOnly(device.report(0, 2), device.dev_public_key));
+  EXPECT_EQ(1u, verifier.getCacheHits());
+
+  // a cached SM report does not vouch for another device
+  TestDevice other(3);
+  EXPECT_FALSE(verifier.checkSignaturesOnly(device.report(0, 3), other.dev_public_key));
+  EXPECT_EQ(1u, verifier.getCacheHits());
+
+  // nor for its SM report with another signature
+  Report forged = device.report(TestDevice::SM_SIGNATURE, 4);
+  EXPECT_FALSE(verifier.checkSignaturesOnly(forged, device.dev_public_key));
+  EXPECT_EQ(1u, verifier.getCacheHits());
+
+  verifier.clearCache();
+  EXPECT_TRUE(verifier.checkSignaturesOnly(device.report(0, 5), device.dev_public_key));
+  EXPECT_EQ(1u, verifier.getCacheHits());
+}
+
+TEST(ReportVerifier, EvictsLeastRecentlyUsed) {
+  TestDevice a(4), b(5);
+  ReportVerifier verifier(1);
+
+  EXPECT_TRUE(verifier.checkSignaturesOnly(a.report(0, 1), a.dev_public_key));
+  EXPECT_TRUE(verifier.checkSignaturesOnly(b.report(0, 1), b.dev_public_key));
+  EXPECT_TRUE(verifier.checkSignaturesOnly(a.report(0, 2), a.dev_public_key));
+  EXPECT_EQ(0u, verifier.getCacheHits());
+  EXPECT_TRUE(verifier.checkSignaturesOnly(a.report(0, 3), a.dev_public_key));
+  EXPECT_EQ(1u, verifier.getCacheHits());
+}
+
+TEST(ReportVerifier, Verify) {
+  TestDevice device(6);
+  ReportVerifier verifier;
+  Report report = device.report(0, 1);
+  byte other_hash[MDSIZE] = {0};
+
+  EXPECT_TRUE(verifier.verify(
+      report, device.enclave_hash, device.sm_hash, device.dev_public_key));
+  EXPECT_FALSE(verifier.verify(
+      report, other_hash, device.sm_hash, device.dev_public_key));
+  EXPECT_FALSE(verifier.verify(
+      report, device.enclave_hash, other_hash, device.dev_public_key));
+}
+
+TEST(ReportVerifier, Batch) {
+  TestDevice device(7);
+  ReportVerifier verifier;
+  std::vector<Report> reports;
+  std::vector<const Report*> pointers;
+  std::vector<int> valid;
+
+  // more than one ed25519 batch, with a bad report here and there
+  for (int i = 0; i < 150; i++)
+    reports.push_back(
+        device.report(i % 37 == 5 ? 1 + i % (TestDevice::TAMPERINGS - 1) : 0, i));
+  for (auto& report : reports) pointers.push_back(&report);
+
+  EXPECT_FALSE(
+      verifier.checkSignaturesOnly(pointers, device.dev_public_key, &valid));
+  ASSERT_EQ(reports.size(), valid.size());
+  for (size_t i = 0; i < reports.size(); i++)
+    EXPECT_EQ(reports[i].checkSignaturesOnly(device.dev_public_key), valid[i])
+        << i;
+
+  // with the SM report cached now
+  EXPECT_FALSE(
+      verifier.checkSignaturesOnly(pointers, device.dev_public_key, &valid));
+  for (size_t i = 0; i < reports.size(); i++)
+    EXPECT_EQ(reports[i].checkSignaturesOnly(device.dev_public_key), valid[i])
+        << i;
+
+  EXPECT_FALSE(verifier.verify(
+      pointers, device.enclave_hash, device.sm_hash, device.dev_public_key,
+      &valid));
+  for (size_t i = 0; i < reports.size(); i++)
+    EXPECT_EQ(
+        reports[i].verify(
+            device.enclave_hash, device.sm_hash, device.dev_public_key),
+        valid[i])
+        << i;
+
+  pointers.clear();
+  for (int i = 0; i < 100; i++) pointers.push_back(&reports[0]);
+  EXPECT_TRUE(
+      verifier.checkSignaturesOnly(pointers, device.dev_public_key, &valid));
+}
+
+TEST(ReportVerifier, Threads) {
+  TestDevice device(8);
+  ReportVerifier verifier(4);
+  std::vector<Report> reports;
+  std::vector<std::thread> threads;
+  int results[8];
+
+  for (int i = 0; i < 64; i++) reports.push_back(device.report(0, i));
+
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      TestDevice own(100 + t);
+      std::vector<const Report*> pointers;
+      std::vector<int> valid;
+      int ok = 1;
+
+      for (auto& report : reports) pointers.push_back(&report);
+      for (int round = 0; round < 20; round++) {
+        ok &= verifier.checkSignaturesOnly(pointers, device.dev_public_key, &valid);
+        ok &= verifier.checkSignaturesOnly(own.report(0, round), own.dev_public_key);
+      }
+      results[t] = ok;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 0; t < 8; t++) EXPECT_TRUE(results[t]) << t;
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -46,7 +46,28 @@ unsigned long validate_and_hash_enclave(struct enclave* enclave){
     return SBI_ERR_SM_ENCLAVE_ILLEGAL_PTE;
   }
 
+  // the shared region was hashed when it was created, so only its
+  // measurement is folded into the enclave hash
+  if(enclave->shared_id != SHARED_REGION_NONE){
+    hash_extend(&ctx, shared_regions[enclave->shared_id].hash, MDSIZE);
+  }
+
   hash_finalize(enclave->hash, &ctx);
 
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
+
+unsigned long validate_and_hash_shared_region(struct shared_region* region){
+  hash_ctx ctx;
+  uintptr_t base = pmp_region_get_addr(region->pmp_rid);
+  uintptr_t size = pmp_region_get_size(region->pmp_rid);
+
+  hash_init(&ctx);
+  hash_extend(&ctx, (void*) &size, sizeof(size));
+  for (uintptr_t page = base; page < base + size; page += RISCV_PGSIZE) {
+    hash_extend_page(&ctx, (void*) page);
+  }
+  hash_finalize(region->hash, &ctx);
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
@@ -14,6 +14,7 @@
 #include <sbi/sbi_console.h>
 
 struct enclave enclaves[ENCL_MAX];
+struct shared_region shared_regions[SHARED_REGIONS_MAX];
 
 // Enclave IDs are unsigned ints, so we do not need to check if eid is
 // greater than or equal to 0
@@ -79,7 +80,10 @@ static inline void context_switch_to_enclave(struct sbi_trap_regs* regs,
   osm_pmp_set(PMP_NO_PERM);
   int memid;
   for(memid=0; memid < ENCLAVE_REGIONS_MAX; memid++) {
-    if(enclaves[eid].regions[memid].type != REGION_INVALID) {
+    if(enclaves[eid].regions[memid].type == REGION_SHARED) {
+      pmp_set_keystone(enclaves[eid].regions[memid].pmp_rid, PMP_R | PMP_X);
+    }
+    else if(enclaves[eid].regions[memid].type != REGION_INVALID) {
       pmp_set_keystone(enclaves[eid].regions[memid].pmp_rid, PMP_ALL_PERM);
     }
   }
@@ -154,22 +158,63 @@ void enclave_init_metadata(void){
     for(i=0; i < ENCLAVE_REGIONS_MAX; i++){
       enclaves[eid].regions[i].type = REGION_INVALID;
     }
+    enclaves[eid].shared_id = SHARED_REGION_NONE;
     /* Fire all platform specific init for each enclave */
     platform_init_enclave(&(enclaves[eid]));
   }
 
+  for(i=0; i < SHARED_REGIONS_MAX; i++){
+    shared_regions[i].state = SHARED_REGION_FREE;
+    shared_regions[i].refcount = 0;
+  }
+
 }
 
-static unsigned long clean_enclave_memory(uintptr_t utbase, uintptr_t utsize)
+/* sbi_memset() stores a byte at a time; EPM ranges are whole pages */
+static void zero_words(uintptr_t base, size_t size)
 {
+  uintptr_t* word = (uintptr_t*) base;
+  size_t i;
 
-  // This function is quite temporary. See issue #38
+  for(i = 0; i < size / sizeof(uintptr_t); i++)
+    word[i] = 0;
+}
 
-  // Zero out the untrusted memory region, since it may be in
-  // indeterminate state.
-  sbi_memset((void*)utbase, 0, utsize);
+static int page_is_zero(uintptr_t page, size_t size)
+{
+  uintptr_t* word = (uintptr_t*) page;
+  uintptr_t bits = 0;
+  size_t i;
 
-  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+  for(i = 0; i < size / sizeof(uintptr_t); i++)
+    bits |= word[i];
+  return bits == 0;
+}
+
+/* Zeroing contract for enclave memory (see issue #38):
+ *  - the SM makes sure the free memory is zero on create, after the EPM is
+ *    locked by PMP, so the runtime can rely on never-allocated pages being
+ *    zero;
+ *  - the SM scrubs the whole EPM on destroy, so memory handed back to the
+ *    OS never holds enclave data;
+ *  - the host owns the UTM and the image pages it copies in, and the SM
+ *    does not zero them.
+ * The driver hands out EPMs that are already zero (pool EPMs the SM
+ * scrubbed, buddy and CMA EPMs it zeroed itself), but the host could have
+ * written to them before create. So the SM reads the free memory and
+ * only zeroes the pages that are not clean, which for an honest host is
+ * none: a read pass instead of a write pass. */
+static void scrub_free_memory(struct enclave* encl)
+{
+  uintptr_t page = encl->params.free_base;
+  uintptr_t end = encl->params.dram_base + encl->params.dram_size;
+  size_t size;
+
+  for(; page < end; page += size){
+    size = end - page < RISCV_PGSIZE ? end - page : RISCV_PGSIZE;
+    if(!page_is_zero(page, size))
+      zero_words(page, size);
+  }
 }
 
 static unsigned long encl_alloc_eid(enclave_id* _eid)
@@ -206,6 +251,32 @@ static unsigned long encl_free_eid(enclave_id eid)
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
 
+/* Takes a reference on a ready shared region so that it cannot be
+ * destroyed while an enclave still maps it */
+static unsigned long shared_region_get(unsigned long sid, region_id* rid)
+{
+  unsigned long ret = SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  spin_lock(&encl_lock);
+  if(sid < SHARED_REGIONS_MAX &&
+     shared_regions[sid].state == SHARED_REGION_READY){
+    shared_regions[sid].refcount++;
+    *rid = shared_regions[sid].pmp_rid;
+    ret = SBI_ERR_SM_ENCLAVE_SUCCESS;
+  }
+  spin_unlock(&encl_lock);
+
+  return ret;
+}
+
+static void shared_region_put(unsigned long sid)
+{
+  spin_lock(&encl_lock);
+  if(sid < SHARED_REGIONS_MAX && shared_regions[sid].refcount > 0)
+    shared_regions[sid].refcount--;
+  spin_unlock(&encl_lock);
+}
+
 int get_enclave_region_index(enclave_id eid, enum enclave_region_type type){
   size_t i;
   for(i = 0;i < ENCLAVE_REGIONS_MAX; i++){
@@ -343,9 +414,11 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   uintptr_t utbase = create_args.utm_region.paddr;
   size_t utsize = create_args.utm_region.size;
 
+  unsigned long shared_id = create_args.shared_region_id;
+
   enclave_id eid;
   unsigned long ret;
-  int region, shared_region;
+  int region, shared_region, ro_region;
 
   /* Runtime parameters */
   if(!is_create_args_valid(&create_args))
@@ -381,9 +454,12 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   if(pmp_set_global(region, PMP_NO_PERM))
     goto free_shared_region;
 
-  // cleanup some memory regions for sanity See issue #38
-  clean_enclave_memory(utbase, utsize);
-
+  // attach the read-only region shared with other enclaves, if any
+  if(shared_id != SHARED_REGION_NONE){
+    ret = shared_region_get(shared_id, &ro_region);
+    if(ret)
+      goto unset_region;
+  }
 
   // initialize enclave metadata
   enclaves[eid].eid = eid;
@@ -392,6 +468,11 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   enclaves[eid].regions[0].type = REGION_EPM;
   enclaves[eid].regions[1].pmp_rid = shared_region;
   enclaves[eid].regions[1].type = REGION_UTM;
+  enclaves[eid].shared_id = shared_id;
+  if(shared_id != SHARED_REGION_NONE){
+    enclaves[eid].regions[2].pmp_rid = ro_region;
+    enclaves[eid].regions[2].type = REGION_SHARED;
+  }
 #if __riscv_xlen == 32
   enclaves[eid].encl_satp = ((base >> RISCV_PGSHIFT) | (SATP_MODE_SV32 << HGATP_MODE_SHIFT));
 #else
@@ -400,6 +481,9 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   enclaves[eid].n_thread = 0;
   enclaves[eid].params = params;
 
+  /* the EPM is already inaccessible to the host */
+  scrub_free_memory(&enclaves[eid]);
+
   /* Init enclave state (regs etc) */
   clean_state(&enclaves[eid].threads[0]);
 
@@ -407,7 +491,7 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
      it may modify the enclave struct */
   ret = platform_create_enclave(&enclaves[eid]);
   if (ret)
-    goto unset_region;
+    goto put_shared;
 
   /* Validate memory, prepare hash and signature for attestation */
   spin_lock(&encl_lock); // FIXME This should error for second enter.
@@ -428,6 +512,12 @@ unlock:
   spin_unlock(&encl_lock);
 // free_platform:
   platform_destroy_enclave(&enclaves[eid]);
+put_shared:
+  if(shared_id != SHARED_REGION_NONE){
+    shared_region_put(shared_id);
+    enclaves[eid].regions[2].type = REGION_INVALID;
+  }
+  enclaves[eid].shared_id = SHARED_REGION_NONE;
 unset_region:
   pmp_unset_global(region);
 free_shared_region:
@@ -454,8 +544,9 @@ unsigned long destroy_enclave(enclave_id eid)
                  && enclaves[eid].state <= STOPPED);
   /* update the enclave state first so that
    * no SM can run the enclave any longer */
-  if(destroyable)
+  if(destroyable){
     enclaves[eid].state = DESTROYING;
+  }
   spin_unlock(&encl_lock);
 
   if(!destroyable)
@@ -474,13 +565,14 @@ unsigned long destroy_enclave(enclave_id eid)
   region_id rid;
   for(i = 0; i < ENCLAVE_REGIONS_MAX; i++){
     if(enclaves[eid].regions[i].type == REGION_INVALID ||
-       enclaves[eid].regions[i].type == REGION_UTM)
+       enclaves[eid].regions[i].type == REGION_UTM ||
+       enclaves[eid].regions[i].type == REGION_SHARED)
       continue;
     //1.a Clear all pages
     rid = enclaves[eid].regions[i].pmp_rid;
     base = (void*) pmp_region_get_addr(rid);
     size = (size_t) pmp_region_get_size(rid);
-    sbi_memset((void*) base, 0, size);
+    zero_words((uintptr_t) base, size);
 
     //1.b free pmp region
     pmp_unset_global(rid);
@@ -492,6 +584,11 @@ unsigned long destroy_enclave(enclave_id eid)
   if(rid != -1)
     pmp_region_free_atomic(enclaves[eid].regions[rid].pmp_rid);
 
+  // 2.a drop the reference to the shared region (contents are kept)
+  if(enclaves[eid].shared_id != SHARED_REGION_NONE)
+    shared_region_put(enclaves[eid].shared_id);
+  enclaves[eid].shared_id = SHARED_REGION_NONE;
+
   enclaves[eid].encl_satp = 0;
   enclaves[eid].n_thread = 0;
   enclaves[eid].params = (struct runtime_params_t) {0};
@@ -505,6 +602,100 @@ unsigned long destroy_enclave(enclave_id eid)
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
 
+/*
+ * Creates a read-only region that can be attached to many enclaves.
+ * The host fills the region before the call; from here on the host has no
+ * access to it, and the contents are hashed exactly once.
+ */
+unsigned long create_shared_region(unsigned long *sidptr, uintptr_t base, size_t size)
+{
+  unsigned long sid;
+  unsigned long ret;
+  int region;
+
+  if(size == 0 || base + size <= base)
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  spin_lock(&encl_lock);
+  for(sid=0; sid < SHARED_REGIONS_MAX; sid++){
+    if(shared_regions[sid].state == SHARED_REGION_FREE)
+      break;
+  }
+  if(sid != SHARED_REGIONS_MAX)
+    shared_regions[sid].state = SHARED_REGION_ALLOCATED;
+  spin_unlock(&encl_lock);
+
+  if(sid == SHARED_REGIONS_MAX)
+    return SBI_ERR_SM_ENCLAVE_NO_FREE_RESOURCE;
+
+  ret = SBI_ERR_SM_ENCLAVE_PMP_FAILURE;
+  if(pmp_region_init_atomic(base, size, PMP_PRI_ANY, &region, 0))
+    goto free_sid;
+
+  if(pmp_set_global(region, PMP_NO_PERM))
+    goto free_region;
+
+  shared_regions[sid].pmp_rid = region;
+  shared_regions[sid].refcount = 0;
+
+  ret = validate_and_hash_shared_region(&shared_regions[sid]);
+  if(ret)
+    goto unset_region;
+
+  spin_lock(&encl_lock);
+  shared_regions[sid].state = SHARED_REGION_READY;
+  spin_unlock(&encl_lock);
+
+  *sidptr = sid;
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+
+unset_region:
+  pmp_unset_global(region);
+free_region:
+  pmp_region_free_atomic(region);
+free_sid:
+  spin_lock(&encl_lock);
+  shared_regions[sid].state = SHARED_REGION_FREE;
+  spin_unlock(&encl_lock);
+  return ret;
+}
+
+/*
+ * Destroys a shared region and gives the memory back to the host.
+ * Fails while any enclave still has the region attached.
+ */
+unsigned long destroy_shared_region(unsigned long sid)
+{
+  region_id rid;
+
+  if(sid >= SHARED_REGIONS_MAX)
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  spin_lock(&encl_lock);
+  if(shared_regions[sid].state != SHARED_REGION_READY){
+    spin_unlock(&encl_lock);
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+  }
+  if(shared_regions[sid].refcount > 0){
+    spin_unlock(&encl_lock);
+    return SBI_ERR_SM_ENCLAVE_SHARED_REGION_IN_USE;
+  }
+  shared_regions[sid].state = SHARED_REGION_ALLOCATED;
+  spin_unlock(&encl_lock);
+
+  // The region only ever holds host-provided code, so there is
+  // nothing secret to clear before handing it back.
+  rid = shared_regions[sid].pmp_rid;
+  pmp_unset_global(rid);
+  pmp_region_free_atomic(rid);
+
+  spin_lock(&encl_lock);
+  shared_regions[sid].state = SHARED_REGION_FREE;
+  spin_unlock(&encl_lock);
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
+
 unsigned long run_enclave(struct sbi_trap_regs *regs, enclave_id eid)
 {
   int runable;
@@ -661,6 +852,24 @@ err_unlock:
   return ret;
 }
 
+/* Tells the enclave where its shared region is; size is zero if none */
+unsigned long get_shared_region(uintptr_t region, enclave_id eid)
+{
+  struct keystone_sbi_pregion_t out = {0};
+  int memid;
+
+  memid = get_enclave_region_index(eid, REGION_SHARED);
+  if(memid != -1){
+    out.paddr = get_enclave_region_base(eid, memid);
+    out.size = get_enclave_region_size(eid, memid);
+  }
+
+  if(copy_from_sm(region, &out, sizeof(out)))
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
+
 unsigned long get_sealing_key(uintptr_t sealing_key, uintptr_t key_ident,
                                  size_t key_ident_size, enclave_id eid)
 {
@@ -20,6 +20,10 @@
 #define ATTEST_DATA_MAXLEN  1024
 /* TODO: does not support multithreaded enclave yet */
 #define MAX_ENCL_THREADS 1
+/* Number of read-only regions that can be shared across enclaves */
+#ifndef SHARED_REGIONS_MAX
+#define SHARED_REGIONS_MAX 4
+#endif
 
 typedef enum {
   INVALID = -1,
@@ -37,6 +41,7 @@ typedef unsigned int enclave_id;
  * EPM is the 'home' for the enclave, contains runtime code/etc
  * UTM is the untrusted shared pages
  * OTHER is managed by some other component (e.g. platform_)
+ * SHARED is a measured read-only region owned by the SM (see shared_region)
  * INVALID is an unused index
  */
 enum enclave_region_type{
@@ -44,6 +49,7 @@ enum enclave_region_type{
   REGION_EPM,
   REGION_UTM,
   REGION_OTHER,
+  REGION_SHARED,
 };
 
 struct enclave_region
@@ -67,6 +73,9 @@ struct enclave
   byte hash[MDSIZE];
   byte sign[SIGNATURE_SIZE];
 
+  /* attached shared region, or SHARED_REGION_NONE */
+  unsigned long shared_id;
+
   /* parameters */
   struct runtime_params_t params;
 
@@ -77,6 +86,24 @@ struct enclave
   struct platform_enclave_data ped;
 };
 
+typedef enum {
+  SHARED_REGION_FREE = 0,
+  SHARED_REGION_ALLOCATED,
+  SHARED_REGION_READY,
+} shared_region_state;
+
+/* A read-only region created once by the host, measured once by the SM
+ * and mapped read+execute into every enclave that attaches to it.
+ * The host loses access to the region as soon as it is created, so the
+ * hash stays valid until the region is destroyed. */
+struct shared_region
+{
+  region_id pmp_rid;
+  shared_region_state state;
+  unsigned int refcount;
+  byte hash[MDSIZE];
+};
+
 /* attestation reports */
 struct enclave_report
 {
@@ -112,13 +139,18 @@ unsigned long create_enclave(unsigned long *eid, struct keystone_sbi_create_t cr
 unsigned long destroy_enclave(enclave_id eid);
 unsigned long run_enclave(struct sbi_trap_regs *regs, enclave_id eid);
 unsigned long resume_enclave(struct sbi_trap_regs *regs, enclave_id eid);
+unsigned long create_shared_region(unsigned long *sid, uintptr_t base, size_t size);
+unsigned long destroy_shared_region(unsigned long sid);
 // callables from the enclave
 unsigned long exit_enclave(struct sbi_trap_regs *regs, enclave_id eid);
 unsigned long stop_enclave(struct sbi_trap_regs *regs, uint64_t request, enclave_id eid);
 unsigned long attest_enclave(uintptr_t report, uintptr_t data, uintptr_t size, enclave_id eid);
+unsigned long get_shared_region(uintptr_t region, enclave_id eid);
 // attestation
 unsigned long validate_and_hash_enclave(struct enclave* enclave);
+unsigned long validate_and_hash_shared_region(struct shared_region* region);
 // TODO: These functions are supposed to be internal functions.
+extern struct shared_region shared_regions[SHARED_REGIONS_MAX];
 void enclave_init_metadata(void);
 unsigned long copy_enclave_create_args(uintptr_t src, struct keystone_sbi_create_t* dest);
 int get_enclave_region_index(enclave_id eid, enum enclave_region_type type);
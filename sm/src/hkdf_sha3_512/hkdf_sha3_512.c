@@ -9,6 +9,9 @@
  *  Implements the key derivation function according to rfc5869
  *  (https://tools.ietf.org/html/rfc5869)
  *
+ *  The SDK keeps a copy of this file that differs only in using the
+ *  libc string functions; change both together.
+ *
  *  All Rights Reserved. See LICENSE for license details.
  */
 
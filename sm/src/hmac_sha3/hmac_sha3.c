@@ -9,6 +9,9 @@
  *  Implements HMAC using SHA3 according to rfc2104
  *  (https://tools.ietf.org/html/rfc2104)
  *
+ *  The SDK keeps a copy of this file that differs only in using the
+ *  libc string functions; change both together.
+ *
  *  All Rights Reserved. See LICENSE for license details.
  */
 
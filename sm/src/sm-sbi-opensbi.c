@@ -48,6 +48,12 @@ static int sbi_ecall_keystone_enclave_handler(unsigned long extid, unsigned long
       retval = sbi_sm_resume_enclave((struct sbi_trap_regs*) regs, regs->a0);
       __builtin_unreachable();
       break;
+    case SBI_SM_CREATE_SHARED_REGION:
+      retval = sbi_sm_create_shared_region(out_val, regs->a0, regs->a1);
+      break;
+    case SBI_SM_DESTROY_SHARED_REGION:
+      retval = sbi_sm_destroy_shared_region(regs->a0);
+      break;
     case SBI_SM_RANDOM:
       *out_val = sbi_sm_random();
       retval = 0;
@@ -58,6 +64,9 @@ static int sbi_ecall_keystone_enclave_handler(unsigned long extid, unsigned long
     case SBI_SM_GET_SEALING_KEY:
       retval = sbi_sm_get_sealing_key(regs->a0, regs->a1, regs->a2);
       break;
+    case SBI_SM_GET_SHARED_REGION:
+      retval = sbi_sm_get_shared_region(regs->a0);
+      break;
     case SBI_SM_STOP_ENCLAVE:
       retval = sbi_sm_stop_enclave((struct sbi_trap_regs*) regs, regs->a0);
       __builtin_unreachable();
@@ -33,6 +33,20 @@ unsigned long sbi_sm_destroy_enclave(unsigned long eid)
   return ret;
 }
 
+unsigned long sbi_sm_create_shared_region(unsigned long* sid, uintptr_t base, size_t size)
+{
+  unsigned long ret;
+  ret = create_shared_region(sid, base, size);
+  return ret;
+}
+
+unsigned long sbi_sm_destroy_shared_region(unsigned long sid)
+{
+  unsigned long ret;
+  ret = destroy_shared_region(sid);
+  return ret;
+}
+
 unsigned long sbi_sm_run_enclave(struct sbi_trap_regs *regs, unsigned long eid)
 {
   regs->a0 = run_enclave(regs, (unsigned int) eid);
@@ -86,6 +100,13 @@ unsigned long sbi_sm_get_sealing_key(uintptr_t sealing_key, uintptr_t key_ident,
   return ret;
 }
 
+unsigned long sbi_sm_get_shared_region(uintptr_t region)
+{
+  unsigned long ret;
+  ret = get_shared_region(region, cpu_get_enclave_id());
+  return ret;
+}
+
 unsigned long sbi_sm_random(void)
 {
   return (unsigned long) platform_random();
@@ -14,6 +14,12 @@ sbi_sm_create_enclave(unsigned long *out_val, uintptr_t create_args);
 unsigned long
 sbi_sm_destroy_enclave(unsigned long eid);
 
+unsigned long
+sbi_sm_create_shared_region(unsigned long *sid, uintptr_t base, size_t size);
+
+unsigned long
+sbi_sm_destroy_shared_region(unsigned long sid);
+
 unsigned long
 sbi_sm_run_enclave(struct sbi_trap_regs *regs, unsigned long eid);
 
@@ -32,6 +38,9 @@ sbi_sm_attest_enclave(uintptr_t report, uintptr_t data, uintptr_t size);
 unsigned long
 sbi_sm_get_sealing_key(uintptr_t seal_key, uintptr_t key_ident, size_t key_ident_size);
 
+unsigned long
+sbi_sm_get_shared_region(uintptr_t region);
+
 unsigned long
 sbi_sm_random(void);
 
@@ -121,6 +121,30 @@ static void test_get_enclave_region_index()
   assert_int_equal( get_enclave_region_index(0, REGION_OTHER), 2 );
 }
 
+static void test_shared_region_refcount()
+{
+  region_id rid;
+
+  enclave_init_metadata();
+
+  // regions that are not ready cannot be attached
+  assert_int_not_equal( shared_region_get(0, &rid), 0 );
+  assert_int_not_equal( shared_region_get(SHARED_REGIONS_MAX, &rid), 0 );
+
+  shared_regions[0].state = SHARED_REGION_READY;
+  shared_regions[0].pmp_rid = 5;
+
+  assert_int_equal( shared_region_get(0, &rid), 0 );
+  assert_int_equal( rid, 5 );
+  assert_int_equal( shared_regions[0].refcount, 1 );
+
+  // cannot be destroyed while attached
+  assert_int_equal( destroy_shared_region(0), SBI_ERR_SM_ENCLAVE_SHARED_REGION_IN_USE );
+
+  shared_region_put(0);
+  assert_int_equal( shared_regions[0].refcount, 0 );
+}
+
 int main()
 {
   const struct CMUnitTest tests[] = {
@@ -128,6 +152,7 @@ int main()
     cmocka_unit_test(test_context_switch_to_enclave),
     cmocka_unit_test(test_get_enclave_region_after_init),
     cmocka_unit_test(test_get_enclave_region_index),
+    cmocka_unit_test(test_shared_region_refcount),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);